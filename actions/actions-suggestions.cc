@@ -507,12 +507,21 @@ bool ActionsSuggestions::IsLowConfidenceInput(
     }
 
     // Run the regex based rules.
+    if (low_confidence_rules_.empty()) {
+      continue;
+    }
+    const std::unique_ptr<UniLib::PreparedText> prepared_message =
+        unilib_->PrepareText(message_unicode);
+    if (prepared_message == nullptr) {
+      TC3_LOG(ERROR) << "Could not prepare message for low confidence rules.";
+      continue;
+    }
     for (int low_confidence_rule = 0;
          low_confidence_rule < low_confidence_rules_.size();
          low_confidence_rule++) {
       const CompiledRule& rule = low_confidence_rules_[low_confidence_rule];
       const std::unique_ptr<UniLib::RegexMatcher> matcher =
-          rule.pattern->Matcher(message_unicode);
+          rule.pattern->Matcher(*prepared_message);
       int status = UniLib::RegexMatcher::kNoError;
       if (matcher->Find(&status) && status == UniLib::RegexMatcher::kNoError) {
         // Rule only applies to input-output pairs, so defer the check.
@@ -542,10 +551,16 @@ bool ActionsSuggestions::FilterConfidenceOutput(
     bool passes_post_check = true;
     const UnicodeText text_reply_unicode(
         UTF8ToUnicodeText(action.response_text, /*do_copy=*/false));
+    const std::unique_ptr<UniLib::PreparedText> prepared_text_reply =
+        unilib_->PrepareText(text_reply_unicode);
+    if (prepared_text_reply == nullptr) {
+      TC3_LOG(ERROR) << "Could not prepare text reply for post check rules.";
+      return false;
+    }
     for (const int rule_id : post_check_rules) {
       const std::unique_ptr<UniLib::RegexMatcher> matcher =
           low_confidence_rules_[rule_id].output_pattern->Matcher(
-              text_reply_unicode);
+              *prepared_text_reply);
       if (matcher == nullptr) {
         TC3_LOG(ERROR) << "Could not create matcher for post check rule.";
         return false;
@@ -1024,7 +1039,9 @@ AnnotationOptions ActionsSuggestions::AnnotationOptionsForMessage(
 
 void ActionsSuggestions::SuggestActionsFromAnnotations(
     const Conversation& conversation, const ActionSuggestionOptions& options,
-    const Annotator* annotator, std::vector<ActionSuggestion>* actions) const {
+    const Annotator* annotator, std::vector<ActionSuggestion>* actions,
+    bool* stopped_early) const {
+  *stopped_early = false;
   if (model_->annotation_actions_spec() == nullptr ||
       model_->annotation_actions_spec()->annotation_mapping() == nullptr ||
       model_->annotation_actions_spec()->annotation_mapping()->size() == 0) {
@@ -1070,9 +1087,21 @@ void ActionsSuggestions::SuggestActionsFromAnnotations(
       }
     }
 
+    if (options.deadline.Expired()) {
+      *stopped_early = true;
+      break;
+    }
+
     if (annotations.empty() && annotator != nullptr) {
-      annotations = annotator->Annotate(message.text,
-                                        AnnotationOptionsForMessage(message));
+      AnnotationOptions annotation_options =
+          AnnotationOptionsForMessage(message);
+      annotation_options.deadline = options.deadline;
+      int skipped_annotation_stages = 0;
+      annotations = annotator->Annotate(message.text, annotation_options,
+                                        &skipped_annotation_stages);
+      if (skipped_annotation_stages != 0) {
+        *stopped_early = true;
+      }
     }
     std::vector<ActionSuggestionAnnotation> action_annotations;
     action_annotations.reserve(annotations.size());
@@ -1209,16 +1238,30 @@ bool ActionsSuggestions::FillAnnotationFromMatchGroup(
 }
 
 bool ActionsSuggestions::SuggestActionsFromRules(
-    const Conversation& conversation,
-    std::vector<ActionSuggestion>* actions) const {
+    const Conversation& conversation, const Deadline& deadline,
+    std::vector<ActionSuggestion>* actions, bool* stopped_early) const {
+  *stopped_early = false;
   // Create actions based on rules checking the last message.
   const int message_index = conversation.messages.size() - 1;
   const std::string& message = conversation.messages.back().text;
   const UnicodeText message_unicode(
       UTF8ToUnicodeText(message, /*do_copy=*/false));
+  if (rules_.empty()) {
+    return true;
+  }
+  const std::unique_ptr<UniLib::PreparedText> prepared_message =
+      unilib_->PrepareText(message_unicode);
+  if (prepared_message == nullptr) {
+    TC3_LOG(ERROR) << "Could not prepare message for rules.";
+    return false;
+  }
   for (const CompiledRule& rule : rules_) {
+    if (deadline.Expired()) {
+      *stopped_early = true;
+      break;
+    }
     const std::unique_ptr<UniLib::RegexMatcher> matcher =
-        rule.pattern->Matcher(message_unicode);
+        rule.pattern->Matcher(*prepared_message);
     int status = UniLib::RegexMatcher::kNoError;
     while (matcher->Find(&status) && status == UniLib::RegexMatcher::kNoError) {
       for (const RulesModel_::Rule_::RuleActionSpec* rule_action :
@@ -1333,8 +1376,12 @@ bool ActionsSuggestions::GatherActionsSuggestions(
     return false;
   }
 
+  bool stopped_early = false;
   SuggestActionsFromAnnotations(conversation, options, annotator,
-                                &response->actions);
+                                &response->actions, &stopped_early);
+  if (stopped_early) {
+    response->skipped_stages |= ACTIONS_STAGE_ANNOTATIONS;
+  }
 
   int input_text_length = 0;
   int num_matching_locales = 0;
@@ -1378,8 +1425,14 @@ bool ActionsSuggestions::GatherActionsSuggestions(
   }
 
   std::unique_ptr<tflite::Interpreter> interpreter;
-  if (!SuggestActionsFromModel(conversation, num_messages, options, response,
-                               &interpreter)) {
+  if (options.deadline.Expired()) {
+    response->skipped_stages |= ACTIONS_STAGE_MODEL;
+    // Without the model, the sensitivity of the conversation is unknown.
+    if (preconditions_.suppress_on_sensitive_topic) {
+      response->actions.clear();
+    }
+  } else if (!SuggestActionsFromModel(conversation, num_messages, options,
+                                      response, &interpreter)) {
     TC3_LOG(ERROR) << "Could not run model.";
     return false;
   }
@@ -1390,17 +1443,28 @@ bool ActionsSuggestions::GatherActionsSuggestions(
     return true;
   }
 
-  if (!SuggestActionsFromLua(
-          conversation, model_executor_.get(), interpreter.get(),
-          annotator != nullptr ? annotator->entity_data_schema() : nullptr,
-          &response->actions)) {
+  if (options.deadline.Expired()) {
+    response->skipped_stages |= ACTIONS_STAGE_LUA;
+  } else if (!SuggestActionsFromLua(
+                 conversation, model_executor_.get(), interpreter.get(),
+                 annotator != nullptr ? annotator->entity_data_schema()
+                                      : nullptr,
+                 &response->actions)) {
     TC3_LOG(ERROR) << "Could not suggest actions from script.";
     return false;
   }
 
-  if (!SuggestActionsFromRules(conversation, &response->actions)) {
-    TC3_LOG(ERROR) << "Could not suggest actions from rules.";
-    return false;
+  if (options.deadline.Expired()) {
+    response->skipped_stages |= ACTIONS_STAGE_RULES;
+  } else {
+    if (!SuggestActionsFromRules(conversation, options.deadline,
+                                 &response->actions, &stopped_early)) {
+      TC3_LOG(ERROR) << "Could not suggest actions from rules.";
+      return false;
+    }
+    if (stopped_early) {
+      response->skipped_stages |= ACTIONS_STAGE_RULES;
+    }
   }
 
   if (preconditions_.suppress_on_low_confidence_input &&
@@ -31,6 +31,7 @@
 #include "annotator/annotator.h"
 #include "annotator/model-executor.h"
 #include "annotator/types.h"
+#include "utils/deadline.h"
 #include "utils/flatbuffers.h"
 #include "utils/i18n/locale.h"
 #include "utils/memory/mmap.h"
@@ -44,6 +45,11 @@ namespace libtextclassifier3 {
 // Options for suggesting actions.
 struct ActionSuggestionOptions {
   static ActionSuggestionOptions Default() { return ActionSuggestionOptions(); }
+
+  // Once the deadline expires, the remaining stages are skipped and the actions
+  // suggested so far are ranked and returned. The deadline also applies to
+  // the annotation of the messages.
+  Deadline deadline;
 };
 
 // Class for predicting actions following a conversation.
@@ -211,9 +217,13 @@ class ActionsSuggestions {
   AnnotationOptions AnnotationOptionsForMessage(
       const ConversationMessage& message) const;
 
+  // Stops before the next message once options.deadline expires, and sets
+  // 'stopped_early' to whether any message was left out or only partially
+  // annotated.
   void SuggestActionsFromAnnotations(
       const Conversation& conversation, const ActionSuggestionOptions& options,
-      const Annotator* annotator, std::vector<ActionSuggestion>* actions) const;
+      const Annotator* annotator, std::vector<ActionSuggestion>* actions,
+      bool* stopped_early) const;
 
   void SuggestActionsFromAnnotation(
       const int message_index, const ActionSuggestionAnnotation& annotation,
@@ -225,8 +235,12 @@ class ActionsSuggestions {
   std::vector<int> DeduplicateAnnotations(
       const std::vector<ActionSuggestionAnnotation>& annotations) const;
 
+  // Stops before the next rule once 'deadline' expires, and sets
+  // 'stopped_early' to whether any rule was left out.
   bool SuggestActionsFromRules(const Conversation& conversation,
-                               std::vector<ActionSuggestion>* actions) const;
+                               const Deadline& deadline,
+                               std::vector<ActionSuggestion>* actions,
+                               bool* stopped_early) const;
 
   bool SuggestActionsFromLua(
       const Conversation& conversation,
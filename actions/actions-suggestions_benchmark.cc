@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks ActionsSuggestions::SuggestActions with the bundled universal
+// model over conversations from the benchmark corpora.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "actions/actions-suggestions.h"
+#include "actions/types.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "utils/testing/benchmark-utils.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Returns the actions model shared by all the benchmarks, nullptr if the model
+// could not be loaded.
+const ActionsSuggestions* GetActionsSuggestions() {
+  static const ActionsSuggestions* actions_suggestions =
+      ActionsSuggestions::FromPath(
+          GetBenchmarkModelPath("actions_suggestions.universal.model"))
+          .release();
+  return actions_suggestions;
+}
+
+// Registers the arguments (corpus, number of messages) for the chat like
+// corpora.
+void ConversationArguments(benchmark::internal::Benchmark* b) {
+  for (const BenchmarkCorpus corpus :
+       {BenchmarkCorpus::SHORT_CHAT, BenchmarkCorpus::MULTI_SCRIPT}) {
+    for (const int num_messages : {1, 5, 20}) {
+      b->Args({static_cast<int>(corpus), num_messages});
+    }
+  }
+}
+
+// Builds a conversation between two users from the corpus messages.
+Conversation BuildConversation(const BenchmarkCorpus corpus,
+                               const int num_messages) {
+  Conversation conversation;
+  int64 reference_time_ms_utc = 1546300800000;
+  for (const std::string& text :
+       GenerateBenchmarkMessages(corpus, num_messages)) {
+    ConversationMessage message;
+    message.user_id = conversation.messages.size() % 2;
+    message.text = text;
+    message.reference_time_ms_utc = reference_time_ms_utc;
+    message.reference_timezone = "Europe/Zurich";
+    conversation.messages.push_back(message);
+    reference_time_ms_utc += 60 * 1000;
+  }
+  return conversation;
+}
+
+void BM_SuggestActions(benchmark::State& state) {
+  const ActionsSuggestions* actions_suggestions = GetActionsSuggestions();
+  if (actions_suggestions == nullptr) {
+    state.SkipWithError("Could not load actions model.");
+    return;
+  }
+  const BenchmarkCorpus corpus = static_cast<BenchmarkCorpus>(state.range(0));
+  state.SetLabel(BenchmarkCorpusName(corpus));
+  const Conversation conversation =
+      BuildConversation(corpus, /*num_messages=*/state.range(1));
+  ReportAllocationsPerCall(
+      state, [&] { actions_suggestions->SuggestActions(conversation); });
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    benchmark::DoNotOptimize(
+        actions_suggestions->SuggestActions(conversation));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SuggestActions)
+    ->Apply(ConversationArguments)
+    ->ThreadRange(1, 4);
+
+}  // namespace
+}  // namespace libtextclassifier3
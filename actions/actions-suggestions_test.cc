@@ -25,6 +25,7 @@
 #include "actions/zlib-utils.h"
 #include "annotator/collections.h"
 #include "annotator/types.h"
+#include "utils/testing/allocation-tracker.h"
 #include "utils/flatbuffers.h"
 #include "utils/flatbuffers_generated.h"
 #include "utils/hash/farmhash.h"
@@ -78,6 +79,19 @@ TEST_F(ActionsSuggestionsTest, SuggestActions) {
   EXPECT_EQ(response.actions.size(), 3 /* share_location + 2 smart replies*/);
 }
 
+// Guards against allocation regressions, the bounds leave ample headroom.
+TEST_F(ActionsSuggestionsTest, SuggestActionsAllocationsAreBounded) {
+  std::unique_ptr<ActionsSuggestions> actions_suggestions = LoadTestModel();
+  ScopedAllocationTracker tracker;
+  actions_suggestions->SuggestActions(
+      {{{/*user_id=*/1, "Where are you?", /*reference_time_ms_utc=*/0,
+         /*reference_timezone=*/"Europe/Zurich",
+         /*annotations=*/{}, /*locales=*/"en"}}});
+
+  EXPECT_LT(tracker.stats().num_allocations, 20000);
+  EXPECT_LT(tracker.stats().peak_bytes, 16 << 20);
+}
+
 TEST_F(ActionsSuggestionsTest, SuggestNoActionsForUnknownLocale) {
   std::unique_ptr<ActionsSuggestions> actions_suggestions = LoadTestModel();
   const ActionsSuggestionsResponse& response =
@@ -105,6 +119,66 @@ TEST_F(ActionsSuggestionsTest, SuggestActionsFromAnnotations) {
   EXPECT_EQ(response.actions.front().score, 1.0);
 }
 
+// A conversation that runs all the stages.
+Conversation AddressConversation() {
+  AnnotatedSpan annotation;
+  annotation.span = {6, 9};
+  annotation.classification = {ClassificationResult("address", 1.0)};
+  return {{{/*user_id=*/1, "Where are you?", /*reference_time_ms_utc=*/0,
+            /*reference_timezone=*/"Europe/Zurich",
+            /*annotations=*/{annotation}, /*locales=*/"en"}}};
+}
+
+TEST_F(ActionsSuggestionsTest, SkipsAllStagesOnceDeadlineExpired) {
+  std::unique_ptr<ActionsSuggestions> actions_suggestions = LoadTestModel();
+  ActionSuggestionOptions options;
+  options.deadline = Deadline::InMilliseconds(0);
+  const ActionsSuggestionsResponse response =
+      actions_suggestions->SuggestActions(AddressConversation(), options);
+  EXPECT_THAT(response.actions, testing::IsEmpty());
+  EXPECT_EQ(response.skipped_stages,
+            ACTIONS_STAGE_ANNOTATIONS | ACTIONS_STAGE_MODEL |
+                ACTIONS_STAGE_LUA | ACTIONS_STAGE_RULES);
+}
+
+TEST_F(ActionsSuggestionsTest, SkipsAllStagesOnceDeadlineCancelled) {
+  std::unique_ptr<ActionsSuggestions> actions_suggestions = LoadTestModel();
+  ActionSuggestionOptions options;
+  options.deadline = Deadline::Cancellable();
+  options.deadline.Cancel();
+  const ActionsSuggestionsResponse response =
+      actions_suggestions->SuggestActions(AddressConversation(), options);
+  EXPECT_THAT(response.actions, testing::IsEmpty());
+  EXPECT_EQ(response.skipped_stages,
+            ACTIONS_STAGE_ANNOTATIONS | ACTIONS_STAGE_MODEL |
+                ACTIONS_STAGE_LUA | ACTIONS_STAGE_RULES);
+}
+
+TEST_F(ActionsSuggestionsTest, SkipsNoStagesBeforeDeadline) {
+  std::unique_ptr<ActionsSuggestions> actions_suggestions = LoadTestModel();
+  const ActionsSuggestionsResponse expected =
+      actions_suggestions->SuggestActions(AddressConversation());
+  EXPECT_THAT(expected.actions,
+              testing::Contains(testing::Field(&ActionSuggestion::type,
+                                               "view_map")));
+
+  ActionSuggestionOptions options;
+  options.deadline = Deadline::Cancellable();
+  ActionsSuggestionsResponse response =
+      actions_suggestions->SuggestActions(AddressConversation(), options);
+  EXPECT_EQ(response.skipped_stages, 0);
+  ASSERT_EQ(response.actions.size(), expected.actions.size());
+  for (int i = 0; i < expected.actions.size(); i++) {
+    EXPECT_EQ(response.actions[i].type, expected.actions[i].type);
+  }
+
+  options.deadline = Deadline::InMilliseconds(/*timeout_ms=*/3600 * 1000);
+  response =
+      actions_suggestions->SuggestActions(AddressConversation(), options);
+  EXPECT_EQ(response.skipped_stages, 0);
+  EXPECT_EQ(response.actions.size(), expected.actions.size());
+}
+
 TEST_F(ActionsSuggestionsTest, SuggestActionsFromAnnotationsWithEntityData) {
   const std::string actions_model_string =
       ReadFile(GetModelPath() + kModelFileName);
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks ranking of responses with many actions by a lua snippet that
+// reads entity data fields of the actions.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "actions/lua-ranker.h"
+#include "actions/types.h"
+#include "utils/flatbuffers.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Entity data with a string and an integer field.
+std::string TestEntitySchema() {
+  flatbuffers::FlatBufferBuilder schema_builder;
+  std::vector<flatbuffers::Offset<reflection::Field>> fields = {
+      reflection::CreateField(
+          schema_builder,
+          /*name=*/schema_builder.CreateString("test"),
+          /*type=*/
+          reflection::CreateType(schema_builder,
+                                 /*base_type=*/reflection::String),
+          /*id=*/0,
+          /*offset=*/4),
+      reflection::CreateField(
+          schema_builder,
+          /*name=*/schema_builder.CreateString("rank"),
+          /*type=*/
+          reflection::CreateType(schema_builder,
+                                 /*base_type=*/reflection::Int),
+          /*id=*/1,
+          /*offset=*/6)};
+  std::vector<flatbuffers::Offset<reflection::Enum>> enums;
+  std::vector<flatbuffers::Offset<reflection::Object>> objects = {
+      reflection::CreateObject(
+          schema_builder,
+          /*name=*/schema_builder.CreateString("EntityData"),
+          /*fields=*/
+          schema_builder.CreateVectorOfSortedTables(&fields))};
+  schema_builder.Finish(reflection::CreateSchema(
+      schema_builder, schema_builder.CreateVectorOfSortedTables(&objects),
+      schema_builder.CreateVectorOfSortedTables(&enums),
+      /*(unused) file_ident=*/0,
+      /*(unused) file_ext=*/0,
+      /*root_table*/ objects[0]));
+  return std::string(
+      reinterpret_cast<const char*>(schema_builder.GetBufferPointer()),
+      schema_builder.GetSize());
+}
+
+constexpr char kRankerSnippet[] = R"(
+  function entitySorter(a, b)
+    local action_a = actions[a]
+    local action_b = actions[b]
+    if action_a.rank ~= action_b.rank then
+      return action_a.rank < action_b.rank
+    end
+    return action_a.test < action_b.test
+  end
+  local result = {}
+  for i=1,#actions do
+    result[i] = i
+  end
+  table.sort(result, entitySorter)
+  return result
+)";
+
+void BM_RankActionsByEntityData(benchmark::State& state) {
+  const std::string serialized_schema = TestEntitySchema();
+  const reflection::Schema* entity_data_schema =
+      flatbuffers::GetRoot<reflection::Schema>(serialized_schema.data());
+  ReflectiveFlatbufferBuilder builder(entity_data_schema);
+
+  const int num_actions = state.range(0);
+  std::vector<ActionSuggestion> actions(num_actions);
+  for (int i = 0; i < num_actions; i++) {
+    std::unique_ptr<ReflectiveFlatbuffer> buffer = builder.NewRoot();
+    buffer->Set("test", "value_" + std::to_string(i));
+    buffer->Set("rank", (i * 7919) % 13);
+    actions[i].type = "test";
+    actions[i].serialized_entity_data = buffer->Serialize();
+  }
+  const Conversation conversation = {{{/*user_id=*/1, "hello hello"}}};
+  const std::string ranker_snippet = kRankerSnippet;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    ActionsSuggestionsResponse response;
+    response.actions = actions;
+    state.ResumeTiming();
+    std::unique_ptr<ActionsSuggestionsLuaRanker> ranker =
+        ActionsSuggestionsLuaRanker::Create(
+            conversation, ranker_snippet, entity_data_schema,
+            /*annotations_entity_data_schema=*/nullptr, &response);
+    benchmark::DoNotOptimize(ranker->RankActions());
+  }
+  state.SetItemsProcessed(state.iterations() * num_actions);
+}
+BENCHMARK(BM_RankActionsByEntityData)->Arg(10)->Arg(100)->Arg(1000);
+
+}  // namespace
+}  // namespace libtextclassifier3
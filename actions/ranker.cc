@@ -16,25 +16,27 @@
 
 #include "actions/ranker.h"
 
-#include <functional>
-#include <set>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "actions/lua-ranker.h"
 #include "actions/zlib-utils.h"
 #include "annotator/types.h"
 #include "utils/base/logging.h"
+#include "utils/hash/farmhash.h"
 #include "utils/lua-utils.h"
 
 namespace libtextclassifier3 {
 namespace {
 
+bool IsHigherScoreOrType(const ActionSuggestion& a, const ActionSuggestion& b) {
+  return a.score > b.score || (a.score >= b.score && a.type < b.type);
+}
+
 void SortByScoreAndType(std::vector<ActionSuggestion>* actions) {
-  std::sort(actions->begin(), actions->end(),
-            [](const ActionSuggestion& a, const ActionSuggestion& b) {
-              return a.score > b.score ||
-                     (a.score >= b.score && a.type < b.type);
-            });
+  std::sort(actions->begin(), actions->end(), IsHigherScoreOrType);
 }
 
 template <typename T>
@@ -142,17 +144,6 @@ bool IsEquivalentActionSuggestion(const ActionSuggestion& action,
   return Compare(action, other) == 0;
 }
 
-// Checks whether any action is equivalent to the given one.
-bool IsAnyActionEquivalent(const ActionSuggestion& action,
-                           const std::vector<ActionSuggestion>& actions) {
-  for (const ActionSuggestion& other : actions) {
-    if (IsEquivalentActionSuggestion(action, other)) {
-      return true;
-    }
-  }
-  return false;
-}
-
 bool IsConflicting(const ActionSuggestionAnnotation& annotation,
                    const ActionSuggestionAnnotation& other) {
   // Two annotations are conflicting if they are different but refer to
@@ -161,34 +152,197 @@ bool IsConflicting(const ActionSuggestionAnnotation& annotation,
           TextSpansIntersect(annotation.span, other.span));
 }
 
-// Checks whether two action suggestions can be considered conflicting.
-bool IsConflictingActionSuggestion(const ActionSuggestion& action,
-                                   const ActionSuggestion& other) {
-  // Actions are considered conflicting, iff they refer to the same text span,
-  // but were not generated from the same annotation.
-  if (action.annotations.empty() || other.annotations.empty()) {
-    return false;
-  }
+uint64 CombineFingerprints(uint64 fingerprint, uint64 other) {
+  return tc3farmhash::Fingerprint(tc3farmhash::Uint128(fingerprint, other));
+}
+
+uint64 CombineFingerprints(uint64 fingerprint, const std::string& value) {
+  return CombineFingerprints(
+      fingerprint, tc3farmhash::Fingerprint64(value.data(), value.size()));
+}
+
+// Fingerprint of the fields compared by `CompareAnnotationsOnly`.
+uint64 AnnotationsFingerprint(const ActionSuggestion& action) {
+  uint64 fingerprint = tc3farmhash::Fingerprint(
+      static_cast<uint64>(action.annotations.size()));
   for (const ActionSuggestionAnnotation& annotation : action.annotations) {
-    for (const ActionSuggestionAnnotation& other_annotation :
-         other.annotations) {
-      if (IsConflicting(annotation, other_annotation)) {
+    fingerprint =
+        CombineFingerprints(fingerprint, annotation.span.message_index);
+    fingerprint = CombineFingerprints(fingerprint, annotation.span.span.first);
+    fingerprint = CombineFingerprints(fingerprint, annotation.span.span.second);
+    fingerprint = CombineFingerprints(fingerprint, annotation.name);
+    fingerprint =
+        CombineFingerprints(fingerprint, annotation.entity.collection);
+  }
+  return fingerprint;
+}
+
+// Fingerprint of the fields compared by `IsEquivalentActionSuggestion`.
+uint64 ActionFingerprint(const ActionSuggestion& action) {
+  uint64 fingerprint = AnnotationsFingerprint(action);
+  fingerprint = CombineFingerprints(fingerprint, action.type);
+  fingerprint = CombineFingerprints(fingerprint, action.response_text);
+  return CombineFingerprints(fingerprint, action.serialized_entity_data);
+}
+
+// Keeps the actions for which `keep` is set, in order.
+void KeepActions(const std::vector<bool>& keep,
+                 std::vector<ActionSuggestion>* actions) {
+  int num_kept = 0;
+  for (int i = 0; i < actions->size(); i++) {
+    if (!keep[i]) {
+      continue;
+    }
+    if (i != num_kept) {
+      (*actions)[num_kept] = std::move((*actions)[i]);
+    }
+    num_kept++;
+  }
+  actions->erase(actions->begin() + num_kept, actions->end());
+}
+
+// Removes the actions equivalent to an earlier one.
+void RemoveEquivalentActions(std::vector<ActionSuggestion>* actions) {
+  std::unordered_multimap<uint64, int> kept_actions;
+  std::vector<bool> keep(actions->size(), false);
+  for (int i = 0; i < actions->size(); i++) {
+    const ActionSuggestion& candidate = (*actions)[i];
+    const uint64 fingerprint = ActionFingerprint(candidate);
+    const auto range = kept_actions.equal_range(fingerprint);
+    keep[i] = std::none_of(
+        range.first, range.second,
+        [actions, &candidate](const std::pair<const uint64, int>& kept) {
+          return IsEquivalentActionSuggestion(candidate,
+                                              (*actions)[kept.second]);
+        });
+    if (keep[i]) {
+      kept_actions.emplace(fingerprint, i);
+    }
+  }
+  KeepActions(keep, actions);
+}
+
+// Index of annotations by message and span start, to find the annotations
+// overlapping a span without scanning all of them.
+class AnnotationSpanIndex {
+ public:
+  void Add(const ActionSuggestionAnnotation* annotation) {
+    MessageAnnotations& message = messages_[annotation->span.message_index];
+    message.by_start.emplace(annotation->span.span.first, annotation);
+    message.max_length =
+        std::max(message.max_length,
+                 annotation->span.span.second - annotation->span.span.first);
+  }
+
+  // Checks whether any indexed annotation conflicts with the given one.
+  bool IsAnyConflicting(const ActionSuggestionAnnotation& annotation) const {
+    const auto message_it = messages_.find(annotation.span.message_index);
+    if (message_it == messages_.end()) {
+      return false;
+    }
+    // Overlapping annotations start before the end of the span, and less
+    // than the longest annotation length before its start.
+    const MessageAnnotations& message = message_it->second;
+    const int min_start = annotation.span.span.first - message.max_length;
+    if (min_start >= annotation.span.span.second) {
+      return false;
+    }
+    const auto end =
+        message.by_start.lower_bound(annotation.span.span.second);
+    for (auto it = message.by_start.upper_bound(min_start); it != end; ++it) {
+      if (IsConflicting(annotation, *it->second)) {
         return true;
       }
     }
+    return false;
+  }
+
+ private:
+  struct MessageAnnotations {
+    std::multimap<int, const ActionSuggestionAnnotation*> by_start;
+    int max_length = 0;
+  };
+  std::unordered_map<int, MessageAnnotations> messages_;
+};
+
+// Removes the actions with an annotation that conflicts with an annotation of
+// an earlier, kept, action.
+void RemoveConflictingActions(std::vector<ActionSuggestion>* actions) {
+  AnnotationSpanIndex kept_annotations;
+  std::vector<bool> keep(actions->size(), false);
+  for (int i = 0; i < actions->size(); i++) {
+    const ActionSuggestion& candidate = (*actions)[i];
+    keep[i] = std::none_of(candidate.annotations.begin(),
+                           candidate.annotations.end(),
+                           [&kept_annotations](
+                               const ActionSuggestionAnnotation& annotation) {
+                             return kept_annotations.IsAnyConflicting(
+                                 annotation);
+                           });
+    if (keep[i]) {
+      for (const ActionSuggestionAnnotation& annotation :
+           candidate.annotations) {
+        kept_annotations.Add(&annotation);
+      }
+    }
   }
-  return false;
+  KeepActions(keep, actions);
 }
 
-// Checks whether any action is considered conflicting with the given one.
-bool IsAnyActionConflicting(const ActionSuggestion& action,
-                            const std::vector<ActionSuggestion>& actions) {
-  for (const ActionSuggestion& other : actions) {
-    if (IsConflictingActionSuggestion(action, other)) {
-      return true;
+// Groups the actions by the annotation set they are based on, and orders the
+// groups by their best action.
+void GroupByAnnotations(std::vector<ActionSuggestion>* actions) {
+  std::unordered_multimap<uint64, int> group_ids;
+  std::vector<std::vector<int>> groups;
+  for (int i = 0; i < actions->size(); i++) {
+    const ActionSuggestion& action = (*actions)[i];
+    // Treat actions with no annotations independently.
+    if (action.annotations.empty()) {
+      groups.push_back({i});
+      continue;
+    }
+
+    const uint64 fingerprint = AnnotationsFingerprint(action);
+    const auto range = group_ids.equal_range(fingerprint);
+    const auto group_it = std::find_if(
+        range.first, range.second,
+        [actions, &groups, &action](const std::pair<const uint64, int>& group) {
+          return HaveEquivalentAnnotations(
+              action, (*actions)[groups[group.second].front()]);
+        });
+    if (group_it != range.second) {
+      groups[group_it->second].push_back(i);
+    } else {
+      group_ids.emplace(fingerprint, groups.size());
+      groups.push_back({i});
     }
   }
-  return false;
+
+  const auto is_higher_score_or_type = [actions](int a, int b) {
+    return IsHigherScoreOrType((*actions)[a], (*actions)[b]);
+  };
+
+  // Sort within each group by score.
+  for (std::vector<int>& group : groups) {
+    std::sort(group.begin(), group.end(), is_higher_score_or_type);
+  }
+
+  // Sort groups by maximum score.
+  std::sort(groups.begin(), groups.end(),
+            [&is_higher_score_or_type](const std::vector<int>& a,
+                                       const std::vector<int>& b) {
+              return is_higher_score_or_type(a.front(), b.front());
+            });
+
+  // Flatten result.
+  std::vector<ActionSuggestion> grouped_actions;
+  grouped_actions.reserve(actions->size());
+  for (const std::vector<int>& group : groups) {
+    for (const int i : group) {
+      grouped_actions.push_back(std::move((*actions)[i]));
+    }
+  }
+  *actions = std::move(grouped_actions);
 }
 
 }  // namespace
@@ -245,92 +399,29 @@ bool ActionsSuggestionsRanker::RankActions(
 
     // Deduplicate, keeping the higher score actions.
     if (options_->deduplicate_suggestions()) {
-      std::vector<ActionSuggestion> deduplicated_actions;
-      for (const ActionSuggestion& candidate : response->actions) {
-        // Check whether we already have an equivalent action.
-        if (!IsAnyActionEquivalent(candidate, deduplicated_actions)) {
-          deduplicated_actions.push_back(std::move(candidate));
-        }
-      }
-      response->actions = std::move(deduplicated_actions);
+      RemoveEquivalentActions(&response->actions);
     }
 
     // Resolve conflicts between conflicting actions referring to the same
     // text span.
     if (options_->deduplicate_suggestions_by_span()) {
-      std::vector<ActionSuggestion> deduplicated_actions;
-      for (const ActionSuggestion& candidate : response->actions) {
-        // Check whether we already have a conflicting action.
-        if (!IsAnyActionConflicting(candidate, deduplicated_actions)) {
-          deduplicated_actions.push_back(std::move(candidate));
-        }
-      }
-      response->actions = std::move(deduplicated_actions);
+      RemoveConflictingActions(&response->actions);
     }
   }
 
   // Suppress smart replies if actions are present.
   if (options_->suppress_smart_replies_with_actions()) {
-    std::vector<ActionSuggestion> non_smart_reply_actions;
-    for (const ActionSuggestion& action : response->actions) {
-      if (action.type != smart_reply_action_type_) {
-        non_smart_reply_actions.push_back(std::move(action));
-      }
-    }
-    response->actions = std::move(non_smart_reply_actions);
+    response->actions.erase(
+        std::remove_if(response->actions.begin(), response->actions.end(),
+                       [this](const ActionSuggestion& action) {
+                         return action.type == smart_reply_action_type_;
+                       }),
+        response->actions.end());
   }
 
   // Group by annotation if specified.
   if (options_->group_by_annotations()) {
-    auto group_id = std::map<
-        ActionSuggestion, int,
-        std::function<bool(const ActionSuggestion&, const ActionSuggestion&)>>{
-        [](const ActionSuggestion& action, const ActionSuggestion& other) {
-          return (CompareAnnotationsOnly(action, other) < 0);
-        }};
-    typedef std::vector<ActionSuggestion> ActionSuggestionGroup;
-    std::vector<ActionSuggestionGroup> groups;
-
-    // Group actions by the annotation set they are based of.
-    for (const ActionSuggestion& action : response->actions) {
-      // Treat actions with no annotations idependently.
-      if (action.annotations.empty()) {
-        groups.emplace_back(1, action);
-        continue;
-      }
-
-      auto it = group_id.find(action);
-      if (it != group_id.end()) {
-        groups[it->second].push_back(action);
-      } else {
-        group_id[action] = groups.size();
-        groups.emplace_back(1, action);
-      }
-    }
-
-    // Sort within each group by score.
-    for (std::vector<ActionSuggestion>& group : groups) {
-      SortByScoreAndType(&group);
-    }
-
-    // Sort groups by maximum score.
-    std::sort(groups.begin(), groups.end(),
-              [](const std::vector<ActionSuggestion>& a,
-                 const std::vector<ActionSuggestion>& b) {
-                return a.begin()->score > b.begin()->score ||
-                       (a.begin()->score >= b.begin()->score &&
-                        a.begin()->type < b.begin()->type);
-              });
-
-    // Flatten result.
-    const size_t num_actions = response->actions.size();
-    response->actions.clear();
-    response->actions.reserve(num_actions);
-    for (const std::vector<ActionSuggestion>& actions : groups) {
-      response->actions.insert(response->actions.end(), actions.begin(),
-                               actions.end());
-    }
-
+    GroupByAnnotations(&response->actions);
   } else {
     // Order suggestions independently by score.
     SortByScoreAndType(&response->actions);
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks deduplication and grouping of responses with hundreds of
+// actions, as for long conversations with many annotations.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "actions/ranker.h"
+#include "actions/types.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+const int kNumMessages = 20;
+const char* const kActionTypes[] = {"call_phone", "add_contact", "send_sms",
+                                    "copy_code"};
+
+// Returns a response with `num_actions` actions, each based on one of the
+// annotations of the conversation. A quarter of the annotations overlap with
+// the previous one in the same message, and every action appears twice.
+ActionsSuggestionsResponse ResponseWithActions(int num_actions) {
+  ActionsSuggestionsResponse response;
+  for (int i = 0; response.actions.size() < num_actions; i++) {
+    ActionSuggestionAnnotation annotation;
+    const int start = (i / kNumMessages) * 10 - (i % 4 == 0 ? 5 : 0);
+    annotation.span = {/*message_index=*/i % kNumMessages,
+                       /*span=*/{start, start + 8},
+                       /*text=*/"1-800-TESTING"};
+    annotation.entity =
+        ClassificationResult(i % 4 == 0 ? "code" : "phone", 1.0);
+    for (const char* type : kActionTypes) {
+      for (int copy = 0; copy < 2 && response.actions.size() < num_actions;
+           copy++) {
+        response.actions.push_back({/*response_text=*/"",
+                                    /*type=*/type,
+                                    /*score=*/(i % 7) / 7.0f,
+                                    /*priority_score=*/(i % 3) / 3.0f,
+                                    /*annotations=*/{annotation}});
+      }
+    }
+  }
+  return response;
+}
+
+// Args: number of actions, group by annotations.
+void BM_RankActions(benchmark::State& state) {
+  RankingOptionsT options;
+  options.group_by_annotations = state.range(1);
+  flatbuffers::FlatBufferBuilder builder;
+  builder.Finish(RankingOptions::Pack(builder, &options));
+  const std::unique_ptr<ActionsSuggestionsRanker> ranker =
+      ActionsSuggestionsRanker::CreateActionsSuggestionsRanker(
+          flatbuffers::GetRoot<RankingOptions>(builder.GetBufferPointer()),
+          /*decompressor=*/nullptr, /*smart_reply_action_type=*/"text_reply");
+  if (ranker == nullptr) {
+    state.SkipWithError("Could not create the ranker.");
+    return;
+  }
+  const Conversation conversation = {
+      std::vector<ConversationMessage>(kNumMessages)};
+  const ActionsSuggestionsResponse response =
+      ResponseWithActions(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    ActionsSuggestionsResponse ranked_response = response;
+    state.ResumeTiming();
+    ranker->RankActions(conversation, &ranked_response);
+    benchmark::DoNotOptimize(ranked_response.actions.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RankActions)
+    ->Args({100, 0})
+    ->Args({100, 1})
+    ->Args({400, 0})
+    ->Args({400, 1})
+    ->Args({1600, 0})
+    ->Args({1600, 1});
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -378,5 +378,117 @@ TEST(RankingTest, SortsActionsByScore) {
                                  IsAction("add_contact", "", 0.0)}));
 }
 
+TEST(RankingTest, DeduplicatesActionsConflictingWithLongerSpans) {
+  const Conversation conversation = {
+      {{/*user_id=*/1, "call 1-800-TESTING or 911"}},
+      {{/*user_id=*/2, "call 1-800-TESTING"}}};
+  ActionSuggestionAnnotation phone_annotation;
+  phone_annotation.span = {/*message_index=*/0, /*span=*/{5, 18},
+                           /*text=*/"1-800-TESTING"};
+  phone_annotation.entity = ClassificationResult("phone", 1.0);
+  ActionSuggestionAnnotation emergency_annotation;
+  emergency_annotation.span = {/*message_index=*/0, /*span=*/{22, 25},
+                               /*text=*/"911"};
+  emergency_annotation.entity = ClassificationResult("phone", 1.0);
+  ActionSuggestionAnnotation code_annotation;
+  code_annotation.span = {/*message_index=*/0, /*span=*/{11, 18},
+                          /*text=*/"TESTING"};
+  code_annotation.entity = ClassificationResult("code", 1.0);
+  ActionSuggestionAnnotation other_message_code_annotation = code_annotation;
+  other_message_code_annotation.span.message_index = 1;
+
+  ActionsSuggestionsResponse response;
+  response.actions = {{/*response_text=*/"",
+                       /*type=*/"call_phone",
+                       /*score=*/1.0,
+                       /*priority_score=*/3.0,
+                       /*annotations=*/{phone_annotation}},
+                      {/*response_text=*/"",
+                       /*type=*/"call_phone",
+                       /*score=*/1.0,
+                       /*priority_score=*/2.0,
+                       /*annotations=*/{emergency_annotation}},
+                      {/*response_text=*/"",
+                       /*type=*/"copy_code",
+                       /*score=*/0.8,
+                       /*priority_score=*/1.0,
+                       /*annotations=*/{code_annotation}},
+                      {/*response_text=*/"",
+                       /*type=*/"copy_code",
+                       /*score=*/0.7,
+                       /*priority_score=*/1.0,
+                       /*annotations=*/{other_message_code_annotation}},
+                      {/*response_text=*/"",
+                       /*type=*/"add_contact",
+                       /*score=*/0.5,
+                       /*priority_score=*/0.0,
+                       /*annotations=*/{phone_annotation}}};
+  RankingOptionsT options;
+  options.group_by_annotations = false;
+  flatbuffers::FlatBufferBuilder builder;
+  builder.Finish(RankingOptions::Pack(builder, &options));
+  auto ranker = ActionsSuggestionsRanker::CreateActionsSuggestionsRanker(
+      flatbuffers::GetRoot<RankingOptions>(builder.GetBufferPointer()),
+      /*decompressor=*/nullptr, /*smart_reply_action_type=*/"text_reply");
+
+  ranker->RankActions(conversation, &response);
+
+  // The code conflicts with the phone number in the first message only, and
+  // adding the contact is based on the same annotation as the call.
+  EXPECT_THAT(response.actions,
+              testing::ElementsAreArray({IsAction("call_phone", "", 1.0),
+                                         IsAction("call_phone", "", 1.0),
+                                         IsAction("copy_code", "", 0.7),
+                                         IsAction("add_contact", "", 0.5)}));
+}
+
+TEST(RankingTest, GroupsNonAdjacentActionsByAnnotations) {
+  const Conversation conversation = {{{/*user_id=*/1, "call 911 or 112"}}};
+  ActionSuggestionAnnotation annotation;
+  annotation.span = {/*message_index=*/0, /*span=*/{5, 8}, /*text=*/"911"};
+  annotation.entity = ClassificationResult("phone", 1.0);
+  ActionSuggestionAnnotation other_annotation;
+  other_annotation.span = {/*message_index=*/0, /*span=*/{12, 15},
+                           /*text=*/"112"};
+  other_annotation.entity = ClassificationResult("phone", 1.0);
+
+  ActionsSuggestionsResponse response;
+  response.actions = {{/*response_text=*/"",
+                       /*type=*/"add_contact",
+                       /*score=*/0.2,
+                       /*priority_score=*/0.0,
+                       /*annotations=*/{annotation}},
+                      {/*response_text=*/"",
+                       /*type=*/"call_phone",
+                       /*score=*/0.9,
+                       /*priority_score=*/0.0,
+                       /*annotations=*/{other_annotation}},
+                      {/*response_text=*/"",
+                       /*type=*/"call_phone",
+                       /*score=*/0.8,
+                       /*priority_score=*/0.0,
+                       /*annotations=*/{annotation}},
+                      {/*response_text=*/"",
+                       /*type=*/"add_contact",
+                       /*score=*/0.1,
+                       /*priority_score=*/0.0,
+                       /*annotations=*/{other_annotation}}};
+  RankingOptionsT options;
+  options.group_by_annotations = true;
+  flatbuffers::FlatBufferBuilder builder;
+  builder.Finish(RankingOptions::Pack(builder, &options));
+  auto ranker = ActionsSuggestionsRanker::CreateActionsSuggestionsRanker(
+      flatbuffers::GetRoot<RankingOptions>(builder.GetBufferPointer()),
+      /*decompressor=*/nullptr, /*smart_reply_action_type=*/"text_reply");
+
+  ranker->RankActions(conversation, &response);
+
+  EXPECT_THAT(response.actions,
+              testing::ElementsAreArray({IsAction("call_phone", "", 0.9),
+                                         IsAction("add_contact", "", 0.1),
+                                         IsAction("call_phone", "", 0.8),
+                                         IsAction("add_contact", "", 0.2)}));
+}
+
 }  // namespace
 }  // namespace libtextclassifier3
@@ -82,6 +82,15 @@ struct ActionSuggestion {
   }
 };
 
+// Stages of the actions suggestion that can be skipped or cut short by the
+// deadline.
+enum ActionsSuggestionsStage {
+  ACTIONS_STAGE_ANNOTATIONS = 1 << 0,
+  ACTIONS_STAGE_MODEL = 1 << 1,
+  ACTIONS_STAGE_LUA = 1 << 2,
+  ACTIONS_STAGE_RULES = 1 << 3,
+};
+
 // Actions suggestions result containing meta - information and the suggested
 // actions.
 struct ActionsSuggestionsResponse {
@@ -91,7 +100,8 @@ struct ActionsSuggestionsResponse {
         output_filtered_sensitivity(false),
         output_filtered_min_triggering_score(false),
         output_filtered_low_confidence(false),
-        output_filtered_locale_mismatch(false) {}
+        output_filtered_locale_mismatch(false),
+        skipped_stages(0) {}
 
   // The sensitivity assessment.
   float sensitivity_score;
@@ -109,6 +119,10 @@ struct ActionsSuggestionsResponse {
   // Whether the output was suppressed due to locale mismatch.
   bool output_filtered_locale_mismatch;
 
+  // Bit mask of the ActionsSuggestionsStages that were skipped or cut short
+  // because the deadline expired.
+  int skipped_stages;
+
   // The suggested actions.
   std::vector<ActionSuggestion> actions;
 };
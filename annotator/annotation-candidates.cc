@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/annotation-candidates.h"
+
+#include <algorithm>
+
+#include "annotator/collections.h"
+
+namespace libtextclassifier3 {
+namespace {
+// The "other" collection is always interned first.
+constexpr int kOtherCollectionId = 0;
+}  // namespace
+
+AnnotationCandidates::AnnotationCandidates() {
+  collections_.push_back(Collections::Other());
+}
+
+int AnnotationCandidates::InternCollection(StringPiece collection) {
+  for (int i = 0; i < collections_.size(); ++i) {
+    if (collection.Equals(collections_[i])) {
+      return i;
+    }
+  }
+  collections_.push_back(collection.ToString());
+  return collections_.size() - 1;
+}
+
+void AnnotationCandidates::Add(const CodepointSpan& span,
+                               StringPiece collection, float score,
+                               float priority_score, int64 numeric_value,
+                               AnnotatedSpan::Source source) {
+  AnnotationCandidate candidate;
+  candidate.span = span;
+  candidate.source = source;
+  candidate.collection_id = InternCollection(collection);
+  candidate.score = score;
+  candidate.priority_score = priority_score;
+  candidate.numeric_value = numeric_value;
+  candidate.payload_index = kNoPayload;
+  candidates_.push_back(candidate);
+}
+
+void AnnotationCandidates::Add(
+    const CodepointSpan& span, std::vector<ClassificationResult> classification,
+    AnnotatedSpan::Source source) {
+  AnnotationCandidate candidate;
+  candidate.span = span;
+  candidate.source = source;
+  candidate.collection_id = kUnclassified;
+  candidate.score = -1.0f;
+  candidate.priority_score = -1.0f;
+  candidate.numeric_value = 0;
+  candidate.payload_index = kNoPayload;
+  candidates_.push_back(candidate);
+  SetClassification(candidates_.size() - 1, std::move(classification));
+}
+
+void AnnotationCandidates::AddAll(std::vector<AnnotatedSpan>* annotated_spans) {
+  candidates_.reserve(candidates_.size() + annotated_spans->size());
+  for (AnnotatedSpan& annotated_span : *annotated_spans) {
+    Add(annotated_span.span, std::move(annotated_span.classification),
+        annotated_span.source);
+  }
+  annotated_spans->clear();
+}
+
+void AnnotationCandidates::SetClassification(
+    int index, std::vector<ClassificationResult> classification) {
+  AnnotationCandidate& candidate = candidates_[index];
+  if (classification.empty()) {
+    candidate.collection_id = kUnclassified;
+    candidate.score = -1.0f;
+    candidate.priority_score = -1.0f;
+  } else {
+    candidate.collection_id = InternCollection(classification[0].collection);
+    candidate.score = classification[0].score;
+    candidate.priority_score = classification[0].priority_score;
+  }
+  if (candidate.payload_index == kNoPayload) {
+    candidate.payload_index = payloads_.size();
+    payloads_.push_back(std::move(classification));
+  } else {
+    payloads_[candidate.payload_index] = std::move(classification);
+  }
+}
+
+void AnnotationCandidates::SortBySpanStart() {
+  std::sort(candidates_.begin(), candidates_.end(),
+            [](const AnnotationCandidate& a, const AnnotationCandidate& b) {
+              return a.span.first < b.span.first;
+            });
+}
+
+bool AnnotationCandidates::IsClassifiedAsOther(int index) const {
+  return candidates_[index].collection_id == kOtherCollectionId;
+}
+
+float AnnotationCandidates::PriorityScore(int index) const {
+  if (!IsClassified(index) || IsClassifiedAsOther(index)) {
+    return -1.0f;
+  }
+  return candidates_[index].priority_score;
+}
+
+const std::string& AnnotationCandidates::collection(int index) const {
+  TC3_CHECK(IsClassified(index));
+  return collections_[candidates_[index].collection_id];
+}
+
+void AnnotationCandidates::MoveClassificationTo(
+    int index, std::vector<ClassificationResult>* classification) {
+  const AnnotationCandidate& candidate = candidates_[index];
+  if (candidate.payload_index != kNoPayload) {
+    std::vector<ClassificationResult>& payload =
+        payloads_[candidate.payload_index];
+    for (ClassificationResult& result : payload) {
+      classification->push_back(std::move(result));
+    }
+    payload.clear();
+    return;
+  }
+  if (!IsClassified(index)) {
+    return;
+  }
+  classification->emplace_back(collections_[candidate.collection_id],
+                               candidate.score, candidate.priority_score);
+  classification->back().numeric_value = candidate.numeric_value;
+}
+
+void AnnotationCandidates::MoveTo(
+    std::vector<AnnotatedSpan>* annotated_spans) {
+  annotated_spans->reserve(annotated_spans->size() + candidates_.size());
+  for (int i = 0; i < candidates_.size(); ++i) {
+    AnnotatedSpan annotated_span;
+    annotated_span.span = candidates_[i].span;
+    annotated_span.source = candidates_[i].source;
+    MoveClassificationTo(i, &annotated_span.classification);
+    annotated_spans->push_back(std::move(annotated_span));
+  }
+  Clear();
+}
+
+void AnnotationCandidates::Clear() {
+  candidates_.clear();
+  payloads_.clear();
+}
+
+}  // namespace libtextclassifier3
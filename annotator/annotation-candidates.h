@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compact representation of the annotation candidates that the annotator
+// collects before resolving the conflicts between them.
+
+#ifndef LIBTEXTCLASSIFIER_ANNOTATOR_ANNOTATION_CANDIDATES_H_
+#define LIBTEXTCLASSIFIER_ANNOTATOR_ANNOTATION_CANDIDATES_H_
+
+#include <string>
+#include <vector>
+
+#include "annotator/types.h"
+#include "utils/base/integral_types.h"
+#include "utils/strings/stringpiece.h"
+
+namespace libtextclassifier3 {
+
+// A candidate span with its top classification result. The collection name is
+// interned in the owning AnnotationCandidates, and the full classification
+// results are only stored for candidates that need more than the fields below
+// (e.g. datetime results or entity data).
+struct AnnotationCandidate {
+  // Unicode codepoint indices in the input string.
+  CodepointSpan span = {kInvalidIndex, kInvalidIndex};
+
+  // The source of the candidate, used in conflict resolution.
+  AnnotatedSpan::Source source = AnnotatedSpan::Source::OTHER;
+
+  // Id of the collection of the top classification result, or
+  // AnnotationCandidates::kUnclassified if the candidate has not been
+  // classified yet.
+  int collection_id;
+
+  // Score, priority score and numeric value of the top classification result.
+  float score;
+  float priority_score;
+  int64 numeric_value;
+
+  // Index of the full classification results in the payload arena of the
+  // owning AnnotationCandidates, or AnnotationCandidates::kNoPayload.
+  int payload_index;
+};
+
+// Collection of annotation candidates. Candidates with a single plain
+// classification result (the common case for the regex, number and model
+// candidates) are kept as AnnotationCandidate only, and are converted to
+// ClassificationResult when they make it to the output.
+class AnnotationCandidates {
+ public:
+  static constexpr int kUnclassified = -1;
+  static constexpr int kNoPayload = -1;
+
+  AnnotationCandidates();
+
+  // Adds a candidate with a single classification result.
+  void Add(const CodepointSpan& span, StringPiece collection, float score,
+           float priority_score, int64 numeric_value = 0,
+           AnnotatedSpan::Source source = AnnotatedSpan::Source::OTHER);
+
+  // Adds a candidate with the given classification results. The candidate is
+  // unclassified if 'classification' is empty.
+  void Add(const CodepointSpan& span,
+           std::vector<ClassificationResult> classification,
+           AnnotatedSpan::Source source = AnnotatedSpan::Source::OTHER);
+
+  // Moves the given annotated spans to the candidates and clears them.
+  void AddAll(std::vector<AnnotatedSpan>* annotated_spans);
+
+  // Replaces the classification results of the candidate at 'index'.
+  void SetClassification(int index,
+                         std::vector<ClassificationResult> classification);
+
+  // Sorts the candidates by the start of their span.
+  void SortBySpanStart();
+
+  int size() const { return candidates_.size(); }
+  bool empty() const { return candidates_.empty(); }
+  const AnnotationCandidate& operator[](int index) const {
+    return candidates_[index];
+  }
+  const std::vector<AnnotationCandidate>& candidates() const {
+    return candidates_;
+  }
+
+  // Returns whether the candidate at 'index' has a classification.
+  bool IsClassified(int index) const {
+    return candidates_[index].collection_id != kUnclassified;
+  }
+
+  // Returns whether the top classification of the candidate at 'index' is
+  // the "other" collection.
+  bool IsClassifiedAsOther(int index) const;
+
+  // Returns the priority score of the candidate at 'index', or -1 if it is
+  // unclassified or classified as "other".
+  float PriorityScore(int index) const;
+
+  // Returns the collection of the top classification of the candidate at
+  // 'index'. The candidate needs to be classified.
+  const std::string& collection(int index) const;
+
+  // Appends the classification results of the candidate at 'index' to
+  // 'classification'. The stored results are moved, so this can be called
+  // only once per candidate.
+  void MoveClassificationTo(int index,
+                            std::vector<ClassificationResult>* classification);
+
+  // Appends all the candidates to 'annotated_spans' and clears them.
+  void MoveTo(std::vector<AnnotatedSpan>* annotated_spans);
+
+  void Clear();
+
+ private:
+  // Returns the id of 'collection', adding it if it is not interned yet.
+  int InternCollection(StringPiece collection);
+
+  std::vector<AnnotationCandidate> candidates_;
+
+  // Interned collection names. There are only a handful of distinct
+  // collections per call, so they are looked up linearly.
+  std::vector<std::string> collections_;
+
+  // Full classification results of the candidates that need them.
+  std::vector<std::vector<ClassificationResult>> payloads_;
+};
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_ANNOTATOR_ANNOTATION_CANDIDATES_H_
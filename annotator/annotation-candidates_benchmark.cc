@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the candidate path of the annotator on number-dense input:
+// collecting one number candidate per token, sorting them and converting the
+// surviving ones to the output, with annotated spans versus the compact
+// candidates. The argument is the number of candidates.
+
+#include <algorithm>
+#include <vector>
+
+#include "annotator/annotation-candidates.h"
+#include "annotator/collections.h"
+#include "annotator/types.h"
+#include "utils/testing/benchmark-utils.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Span of the i-th number candidate. The candidates are produced out of
+// order, as when several annotators contribute to the candidates.
+CodepointSpan NumberSpan(int i, int num_candidates) {
+  const int position = (i * 7919) % num_candidates;
+  return {3 * position, 3 * position + 2};
+}
+
+std::vector<AnnotatedSpan> AnnotatedSpanCandidatePath(int num_candidates) {
+  std::vector<AnnotatedSpan> candidates;
+  for (int i = 0; i < num_candidates; ++i) {
+    ClassificationResult classification{Collections::Number(), 1.0};
+    classification.numeric_value = i;
+    classification.priority_score = 0.5;
+    AnnotatedSpan annotated_span;
+    annotated_span.span = NumberSpan(i, num_candidates);
+    annotated_span.classification.push_back(classification);
+    candidates.push_back(annotated_span);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const AnnotatedSpan& a, const AnnotatedSpan& b) {
+              return a.span.first < b.span.first;
+            });
+  std::vector<AnnotatedSpan> result;
+  result.reserve(candidates.size());
+  for (AnnotatedSpan& candidate : candidates) {
+    result.push_back(std::move(candidate));
+  }
+  return result;
+}
+
+std::vector<AnnotatedSpan> CompactCandidatePath(int num_candidates) {
+  AnnotationCandidates candidates;
+  for (int i = 0; i < num_candidates; ++i) {
+    candidates.Add(NumberSpan(i, num_candidates), Collections::Number(), 1.0,
+                   0.5, /*numeric_value=*/i);
+  }
+  candidates.SortBySpanStart();
+  std::vector<AnnotatedSpan> result;
+  candidates.MoveTo(&result);
+  return result;
+}
+
+void BM_AnnotatedSpanCandidates(benchmark::State& state) {
+  const int num_candidates = state.range(0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(AnnotatedSpanCandidatePath(num_candidates));
+  }
+  ReportAllocationsPerCall(state, [num_candidates]() {
+    AnnotatedSpanCandidatePath(num_candidates);
+  });
+}
+BENCHMARK(BM_AnnotatedSpanCandidates)->Range(64, 4096);
+
+void BM_CompactCandidates(benchmark::State& state) {
+  const int num_candidates = state.range(0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(CompactCandidatePath(num_candidates));
+  }
+  ReportAllocationsPerCall(
+      state, [num_candidates]() { CompactCandidatePath(num_candidates); });
+}
+BENCHMARK(BM_CompactCandidates)->Range(64, 4096);
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/annotation-candidates.h"
+
+#include "annotator/collections.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+TEST(AnnotationCandidatesTest, CompactCandidateRoundTrips) {
+  AnnotationCandidates candidates;
+  candidates.Add({3, 5}, "number", /*score=*/0.5, /*priority_score=*/0.25,
+                 /*numeric_value=*/42);
+
+  ASSERT_EQ(candidates.size(), 1);
+  EXPECT_TRUE(candidates.IsClassified(0));
+  EXPECT_FALSE(candidates.IsClassifiedAsOther(0));
+  EXPECT_EQ(candidates.collection(0), "number");
+  EXPECT_FLOAT_EQ(candidates.PriorityScore(0), 0.25);
+
+  std::vector<AnnotatedSpan> annotated_spans;
+  candidates.MoveTo(&annotated_spans);
+  EXPECT_TRUE(candidates.empty());
+  ASSERT_EQ(annotated_spans.size(), 1);
+  EXPECT_EQ(annotated_spans[0].span, CodepointSpan(3, 5));
+  EXPECT_EQ(annotated_spans[0].source, AnnotatedSpan::Source::OTHER);
+  ASSERT_EQ(annotated_spans[0].classification.size(), 1);
+  EXPECT_EQ(annotated_spans[0].classification[0].collection, "number");
+  EXPECT_FLOAT_EQ(annotated_spans[0].classification[0].score, 0.5);
+  EXPECT_FLOAT_EQ(annotated_spans[0].classification[0].priority_score, 0.25);
+  EXPECT_EQ(annotated_spans[0].classification[0].numeric_value, 42);
+}
+
+TEST(AnnotationCandidatesTest, KeepsFullClassificationResults) {
+  AnnotationCandidates candidates;
+  ClassificationResult datetime(Collections::DateTime(), 1.0, 0.1);
+  datetime.datetime_parse_result.time_ms_utc = 1000;
+  ClassificationResult date(Collections::Date(), 0.5, 0.1);
+  candidates.Add({0, 10}, {datetime, date}, AnnotatedSpan::Source::DATETIME);
+
+  EXPECT_EQ(candidates.collection(0), Collections::DateTime());
+  EXPECT_EQ(candidates[0].source, AnnotatedSpan::Source::DATETIME);
+
+  std::vector<ClassificationResult> classification;
+  candidates.MoveClassificationTo(0, &classification);
+  ASSERT_EQ(classification.size(), 2);
+  EXPECT_EQ(classification[0].collection, Collections::DateTime());
+  EXPECT_EQ(classification[0].datetime_parse_result.time_ms_utc, 1000);
+  EXPECT_EQ(classification[1].collection, Collections::Date());
+}
+
+TEST(AnnotationCandidatesTest, HandlesUnclassifiedAndOtherCandidates) {
+  AnnotationCandidates candidates;
+  std::vector<AnnotatedSpan> annotated_spans(1);
+  annotated_spans[0].span = {0, 4};
+  candidates.AddAll(&annotated_spans);
+  EXPECT_TRUE(annotated_spans.empty());
+  candidates.Add({5, 7}, Collections::Other(), 1.0, 1.0);
+
+  EXPECT_FALSE(candidates.IsClassified(0));
+  EXPECT_FLOAT_EQ(candidates.PriorityScore(0), -1.0);
+  EXPECT_TRUE(candidates.IsClassifiedAsOther(1));
+  EXPECT_FLOAT_EQ(candidates.PriorityScore(1), -1.0);
+
+  candidates.SetClassification(0, {{Collections::Phone(), 1.0, 0.5}});
+  EXPECT_TRUE(candidates.IsClassified(0));
+  EXPECT_EQ(candidates.collection(0), Collections::Phone());
+  EXPECT_FLOAT_EQ(candidates.PriorityScore(0), 0.5);
+}
+
+TEST(AnnotationCandidatesTest, SortsBySpanStart) {
+  AnnotationCandidates candidates;
+  candidates.Add({10, 12}, "number", 1.0, 1.0, /*numeric_value=*/2);
+  candidates.Add({0, 10}, {{Collections::Address(), 1.0}});
+  candidates.Add({4, 6}, "number", 1.0, 1.0, /*numeric_value=*/1);
+  candidates.SortBySpanStart();
+
+  std::vector<AnnotatedSpan> annotated_spans;
+  candidates.MoveTo(&annotated_spans);
+  ASSERT_EQ(annotated_spans.size(), 3);
+  EXPECT_EQ(annotated_spans[0].span, CodepointSpan(0, 10));
+  EXPECT_EQ(annotated_spans[0].classification[0].collection,
+            Collections::Address());
+  EXPECT_EQ(annotated_spans[1].span, CodepointSpan(4, 6));
+  EXPECT_EQ(annotated_spans[1].classification[0].numeric_value, 1);
+  EXPECT_EQ(annotated_spans[2].span, CodepointSpan(10, 12));
+  EXPECT_EQ(annotated_spans[2].classification[0].numeric_value, 2);
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
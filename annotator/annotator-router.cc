@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/annotator-router.h"
+
+#include <algorithm>
+
+#include "lang_id/lang-id.h"
+#include "utils/base/logging.h"
+
+namespace libtextclassifier3 {
+
+std::unique_ptr<AnnotatorRouter> AnnotatorRouter::Create(
+    const AnnotatorRouterOptions& options, const UniLib* unilib,
+    const CalendarLib* calendarlib) {
+  if (options.model_paths.empty() && options.fallback_model_path.empty()) {
+    TC3_LOG(ERROR) << "No models specified.";
+    return nullptr;
+  }
+
+  std::unique_ptr<AnnotatorRouter> router(
+      new AnnotatorRouter(options, unilib, calendarlib));
+  for (const std::string& path : options.model_paths) {
+    LocaleModel locale_model;
+    locale_model.path = path;
+    const bool locales_read = VisitAnnotatorModel<bool>(
+        path, [&locale_model](const Model* model) {
+          if (model == nullptr) {
+            return false;
+          }
+          if (model->locales() == nullptr) {
+            return true;
+          }
+          return ParseLocales(model->locales()->c_str(),
+                              &locale_model.locales);
+        });
+    if (!locales_read) {
+      TC3_LOG(ERROR) << "Could not read the locales of model: " << path;
+      return nullptr;
+    }
+    if (locale_model.locales.empty()) {
+      TC3_LOG(WARNING) << "Model without locales is never routed to: "
+                       << path;
+    }
+    router->models_.push_back(std::move(locale_model));
+  }
+  return router;
+}
+
+AnnotatorRouter::AnnotatorRouter(const AnnotatorRouterOptions& options,
+                                 const UniLib* unilib,
+                                 const CalendarLib* calendarlib)
+    : fallback_model_path_(options.fallback_model_path),
+      max_loaded_models_(std::max(options.max_loaded_models, 1)),
+      langid_(options.langid),
+      unilib_(unilib),
+      calendarlib_(calendarlib) {}
+
+CodepointSpan AnnotatorRouter::SuggestSelection(
+    const std::string& context, CodepointSpan click_indices,
+    const SelectionOptions& options) const {
+  SelectionOptions routed_options = options;
+  const std::shared_ptr<const Annotator> annotator =
+      AnnotatorForRequest(context, options.locales,
+                          &routed_options.detected_text_language_tags);
+  if (annotator == nullptr) {
+    return click_indices;
+  }
+  return annotator->SuggestSelection(context, click_indices, routed_options);
+}
+
+std::vector<ClassificationResult> AnnotatorRouter::ClassifyText(
+    const std::string& context, CodepointSpan selection_indices,
+    const ClassificationOptions& options) const {
+  ClassificationOptions routed_options = options;
+  const std::shared_ptr<const Annotator> annotator =
+      AnnotatorForRequest(context, options.locales,
+                          &routed_options.detected_text_language_tags);
+  if (annotator == nullptr) {
+    return {};
+  }
+  return annotator->ClassifyText(context, selection_indices, routed_options);
+}
+
+std::vector<AnnotatedSpan> AnnotatorRouter::Annotate(
+    const std::string& context, const AnnotationOptions& options) const {
+  AnnotationOptions routed_options = options;
+  const std::shared_ptr<const Annotator> annotator =
+      AnnotatorForRequest(context, options.locales,
+                          &routed_options.detected_text_language_tags);
+  if (annotator == nullptr) {
+    return {};
+  }
+  return annotator->Annotate(context, routed_options);
+}
+
+std::shared_ptr<const Annotator> AnnotatorRouter::AnnotatorForRequest(
+    const std::string& context, const std::string& locales,
+    std::string* detected_text_language_tags) const {
+  if (detected_text_language_tags->empty() && langid_ != nullptr) {
+    const std::string language = langid_->FindLanguage(context);
+    if (language != mobile::lang_id::LangId::kUnknownLanguageCode) {
+      *detected_text_language_tags = language;
+    }
+  }
+
+  std::vector<Locale> request_locales;
+  int model_index = -1;
+  if (ParseLocales(*detected_text_language_tags, &request_locales)) {
+    model_index = FindModel(request_locales);
+  }
+  if (model_index < 0) {
+    request_locales.clear();
+    if (ParseLocales(locales, &request_locales)) {
+      model_index = FindModel(request_locales);
+    }
+  }
+
+  if (model_index >= 0) {
+    std::shared_ptr<const Annotator> annotator = GetOrLoadModel(model_index);
+    if (annotator != nullptr) {
+      return annotator;
+    }
+  }
+  return GetOrLoadFallbackModel();
+}
+
+int AnnotatorRouter::NumLoadedModels() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return loaded_models_.size();
+}
+
+int AnnotatorRouter::FindModel(const std::vector<Locale>& locales) const {
+  // The models' locales are immutable after creation, so no lock is needed.
+  for (const Locale& locale : locales) {
+    for (int i = 0; i < models_.size(); ++i) {
+      if (Locale::IsAnyLocaleSupported({locale}, models_[i].locales,
+                                       /*default_value=*/false)) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+std::shared_ptr<const Annotator> AnnotatorRouter::GetOrLoadModel(
+    int model_index) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  LocaleModel& model = models_[model_index];
+  load_finished_.wait(lock, [&model] { return !model.loading; });
+  if (model.annotator != nullptr) {
+    loaded_models_.splice(
+        loaded_models_.begin(), loaded_models_,
+        std::find(loaded_models_.begin(), loaded_models_.end(), model_index));
+    return model.annotator;
+  }
+  if (model.failed_to_load) {
+    return nullptr;
+  }
+
+  model.loading = true;
+  lock.unlock();
+  std::shared_ptr<const Annotator> annotator = LoadAnnotator(model.path);
+  lock.lock();
+  model.loading = false;
+  load_finished_.notify_all();
+  if (annotator == nullptr) {
+    model.failed_to_load = true;
+    return nullptr;
+  }
+  model.annotator = annotator;
+  loaded_models_.push_front(model_index);
+  if (static_cast<int>(loaded_models_.size()) > max_loaded_models_) {
+    // In-flight requests keep their reference to the unloaded model.
+    models_[loaded_models_.back()].annotator.reset();
+    loaded_models_.pop_back();
+  }
+  return annotator;
+}
+
+std::shared_ptr<const Annotator> AnnotatorRouter::GetOrLoadFallbackModel()
+    const {
+  if (fallback_model_path_.empty()) {
+    return nullptr;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  load_finished_.wait(lock, [this] { return !fallback_loading_; });
+  if (fallback_annotator_ != nullptr || fallback_failed_to_load_) {
+    return fallback_annotator_;
+  }
+
+  fallback_loading_ = true;
+  lock.unlock();
+  std::shared_ptr<const Annotator> annotator =
+      LoadAnnotator(fallback_model_path_);
+  lock.lock();
+  fallback_loading_ = false;
+  load_finished_.notify_all();
+  fallback_annotator_ = annotator;
+  fallback_failed_to_load_ = annotator == nullptr;
+  return annotator;
+}
+
+std::unique_ptr<Annotator> AnnotatorRouter::LoadAnnotator(
+    const std::string& path) const {
+  std::unique_ptr<Annotator> annotator =
+      Annotator::FromPath(path, unilib_, calendarlib_);
+  if (annotator == nullptr) {
+    TC3_LOG(ERROR) << "Could not load model: " << path;
+    return nullptr;
+  }
+  return annotator;
+}
+
+}  // namespace libtextclassifier3
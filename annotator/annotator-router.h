@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Routes annotator requests to one of several locale-specific models.
+
+#ifndef LIBTEXTCLASSIFIER_ANNOTATOR_ANNOTATOR_ROUTER_H_
+#define LIBTEXTCLASSIFIER_ANNOTATOR_ANNOTATOR_ROUTER_H_
+
+#include <condition_variable>  // NOLINT
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "annotator/annotator.h"
+#include "annotator/types.h"
+#include "utils/calendar/calendar.h"
+#include "utils/i18n/locale.h"
+#include "utils/utf8/unilib.h"
+
+namespace libtextclassifier3 {
+
+namespace mobile {
+namespace lang_id {
+class LangId;
+}  // namespace lang_id
+}  // namespace mobile
+
+struct AnnotatorRouterOptions {
+  // Paths of the locale-specific annotator models. A request is routed to the
+  // first model whose `locales` support the language of the request.
+  std::vector<std::string> model_paths;
+
+  // Path of the model used for requests no locale-specific model supports,
+  // e.g. a universal model. Optional.
+  std::string fallback_model_path;
+
+  // Maximum number of locale-specific models loaded at the same time. The
+  // least recently used model is unloaded when another one needs to be loaded.
+  // The fallback model does not count towards the limit and stays loaded once
+  // used.
+  int max_loaded_models = 2;
+
+  // Language identification used for requests that don't specify the
+  // detected_text_language_tags. Optional, not owned.
+  const mobile::lang_id::LangId* langid = nullptr;
+};
+
+// Serves annotator requests with locale-specific models, loading each model
+// on first use. The language of a request is taken from its
+// detected_text_language_tags, detected with the LangId model if they are not
+// specified, and finally from its locales.
+// Only the `locales` of the models are read at creation, so memory scales with
+// the locales in use rather than with the installed models.
+// NOTE: This class is thread-safe. Models are loaded outside of the router's
+// lock: requests for a model being loaded wait for that load, requests for
+// other models are served meanwhile.
+class AnnotatorRouter {
+ public:
+  // Returns nullptr if no model is specified or the locales of a model can't
+  // be read.
+  static std::unique_ptr<AnnotatorRouter> Create(
+      const AnnotatorRouterOptions& options, const UniLib* unilib = nullptr,
+      const CalendarLib* calendarlib = nullptr);
+
+  // Same as the corresponding Annotator methods, run with the model the
+  // request is routed to. If no model supports the request or the model fails
+  // to load, the result is as if an error occurred in the Annotator.
+  CodepointSpan SuggestSelection(
+      const std::string& context, CodepointSpan click_indices,
+      const SelectionOptions& options = SelectionOptions()) const;
+  std::vector<ClassificationResult> ClassifyText(
+      const std::string& context, CodepointSpan selection_indices,
+      const ClassificationOptions& options = ClassificationOptions()) const;
+  std::vector<AnnotatedSpan> Annotate(
+      const std::string& context,
+      const AnnotationOptions& options = AnnotationOptions()) const;
+
+  // Returns the annotator for a request, loading it if needed, or nullptr if
+  // no model supports the request. Fills in detected_text_language_tags
+  // with the language detected by the LangId model if they are empty.
+  // The returned annotator stays valid even if the router unloads it.
+  std::shared_ptr<const Annotator> AnnotatorForRequest(
+      const std::string& context, const std::string& locales,
+      std::string* detected_text_language_tags) const;
+
+  // Returns the number of locale-specific models currently loaded.
+  int NumLoadedModels() const;
+
+ private:
+  struct LocaleModel {
+    std::string path;
+    std::vector<Locale> locales;
+
+    // The loaded model, nullptr if not loaded.
+    std::shared_ptr<const Annotator> annotator;
+
+    // Whether a request is loading the model.
+    bool loading = false;
+
+    // Whether loading the model failed, in which case it's not retried.
+    bool failed_to_load = false;
+  };
+
+  AnnotatorRouter(const AnnotatorRouterOptions& options, const UniLib* unilib,
+                  const CalendarLib* calendarlib);
+
+  // Returns the index of the first model supporting one of 'locales', or -1.
+  int FindModel(const std::vector<Locale>& locales) const;
+
+  // Returns the model at 'model_index', loading it if needed and unloading
+  // the least recently used one if too many are loaded.
+  std::shared_ptr<const Annotator> GetOrLoadModel(int model_index) const;
+
+  // Returns the fallback model, loading it if needed.
+  std::shared_ptr<const Annotator> GetOrLoadFallbackModel() const;
+
+  // Loads an annotator from 'path', logging an error on failure.
+  std::unique_ptr<Annotator> LoadAnnotator(const std::string& path) const;
+
+  const std::string fallback_model_path_;
+  const int max_loaded_models_;
+  const mobile::lang_id::LangId* langid_;
+  const UniLib* unilib_;
+  const CalendarLib* calendarlib_;
+
+  mutable std::mutex mutex_;
+
+  // Notified under mutex_ when a model load finishes.
+  mutable std::condition_variable load_finished_;
+  mutable std::vector<LocaleModel> models_;
+
+  // Indices into models_ of the loaded models, most recently used first.
+  mutable std::list<int> loaded_models_;
+
+  mutable std::shared_ptr<const Annotator> fallback_annotator_;
+  mutable bool fallback_loading_ = false;
+  mutable bool fallback_failed_to_load_ = false;
+};
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_ANNOTATOR_ANNOTATOR_ROUTER_H_
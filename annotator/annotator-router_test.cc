@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/annotator-router.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "annotator/model_generated.h"
+#include "utils/testing/annotator.h"
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+std::string GetModelPath() { return TC3_TEST_DATA_DIR; }
+
+std::string ReadFile(const std::string& file_name) {
+  std::ifstream file_stream(file_name);
+  return std::string(std::istreambuf_iterator<char>(file_stream), {});
+}
+
+// Writes the test model with the given name and locales to a temporary file
+// and returns its path.
+std::string WriteModel(const std::string& name, const std::string& locales) {
+  const std::string model_buffer = ModifyAnnotatorModel(
+      ReadFile(GetModelPath() + "test_model.fb"), [&](ModelT* model) {
+        model->name = name;
+        model->locales = locales;
+      });
+  const std::string path = testing::TempDir() + "router_" + name + ".fb";
+  std::ofstream(path, std::ios::binary) << model_buffer;
+  return path;
+}
+
+std::string ModelName(const std::shared_ptr<const Annotator>& annotator) {
+  if (annotator == nullptr || annotator->model()->name() == nullptr) {
+    return "";
+  }
+  return annotator->model()->name()->str();
+}
+
+class AnnotatorRouterTest : public testing::Test {
+ protected:
+  AnnotatorRouterTest() : INIT_UNILIB_FOR_TESTING(unilib_) {
+    options_.model_paths = {WriteModel("en", "en"),
+                            WriteModel("de", "de,de-CH")};
+    options_.fallback_model_path = WriteModel("universal", "");
+  }
+
+  std::string RoutedModel(const AnnotatorRouter& router,
+                          const std::string& locales,
+                          std::string detected_text_language_tags) {
+    return ModelName(router.AnnotatorForRequest("Hello", locales,
+                                                &detected_text_language_tags));
+  }
+
+  AnnotatorRouterOptions options_;
+  UniLib unilib_;
+};
+
+TEST_F(AnnotatorRouterTest, RoutesByLanguage) {
+  std::unique_ptr<AnnotatorRouter> router =
+      AnnotatorRouter::Create(options_, &unilib_);
+  ASSERT_TRUE(router);
+  EXPECT_EQ(router->NumLoadedModels(), 0);
+
+  // The detected language takes precedence over the locales.
+  EXPECT_EQ(RoutedModel(*router, "en-US", "de"), "de");
+  EXPECT_EQ(RoutedModel(*router, "en-US", ""), "en");
+  EXPECT_EQ(RoutedModel(*router, "en-US", "fr"), "en");
+  EXPECT_EQ(RoutedModel(*router, "fr", "it"), "universal");
+  EXPECT_EQ(router->NumLoadedModels(), 2);
+}
+
+TEST_F(AnnotatorRouterTest, UnloadsLeastRecentlyUsedModel) {
+  options_.max_loaded_models = 1;
+  std::unique_ptr<AnnotatorRouter> router =
+      AnnotatorRouter::Create(options_, &unilib_);
+  ASSERT_TRUE(router);
+
+  std::string detected_text_language_tags = "en";
+  const std::shared_ptr<const Annotator> english = router->AnnotatorForRequest(
+      "Hello", /*locales=*/"", &detected_text_language_tags);
+  EXPECT_EQ(RoutedModel(*router, "", "de"), "de");
+  EXPECT_EQ(router->NumLoadedModels(), 1);
+
+  // The unloaded model stays usable by the request holding it.
+  EXPECT_EQ(ModelName(english), "en");
+  EXPECT_EQ(RoutedModel(*router, "", "en"), "en");
+  EXPECT_EQ(router->NumLoadedModels(), 1);
+}
+
+TEST_F(AnnotatorRouterTest, LoadsEachModelOnceForConcurrentRequests) {
+  std::unique_ptr<AnnotatorRouter> router =
+      AnnotatorRouter::Create(options_, &unilib_);
+  ASSERT_TRUE(router);
+
+  const std::vector<std::string> languages = {"en", "de", "fr"};
+  const int kNumRequestsPerLanguage = 4;
+  std::vector<std::shared_ptr<const Annotator>> annotators(
+      languages.size() * kNumRequestsPerLanguage);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < annotators.size(); ++i) {
+    threads.emplace_back([&router, &languages, &annotators, i]() {
+      std::string detected_text_language_tags = languages[i % languages.size()];
+      annotators[i] = router->AnnotatorForRequest(
+          "Hello", /*locales=*/"", &detected_text_language_tags);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < annotators.size(); ++i) {
+    ASSERT_NE(annotators[i], nullptr);
+    // Requests for the same model share the instance loaded once.
+    EXPECT_EQ(annotators[i], annotators[i % languages.size()]);
+  }
+  EXPECT_EQ(ModelName(annotators[0]), "en");
+  EXPECT_EQ(ModelName(annotators[1]), "de");
+  EXPECT_EQ(ModelName(annotators[2]), "universal");
+  EXPECT_EQ(router->NumLoadedModels(), 2);
+}
+
+TEST_F(AnnotatorRouterTest, ReturnsNullWithoutFallbackModel) {
+  options_.fallback_model_path.clear();
+  std::unique_ptr<AnnotatorRouter> router =
+      AnnotatorRouter::Create(options_, &unilib_);
+  ASSERT_TRUE(router);
+
+  EXPECT_EQ(RoutedModel(*router, "fr", ""), "");
+  EXPECT_TRUE(router->Annotate("Call me at (800) 123-456 today.").empty());
+}
+
+TEST_F(AnnotatorRouterTest, FailsForUnreadableModel) {
+  options_.model_paths.push_back(GetModelPath() + "does_not_exist.fb");
+  EXPECT_FALSE(AnnotatorRouter::Create(options_, &unilib_));
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
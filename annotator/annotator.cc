@@ -25,6 +25,7 @@
 
 #include "annotator/collections.h"
 #include "annotator/model_generated.h"
+#include "annotator/native-verifiers.h"
 #include "annotator/types.h"
 #include "utils/base/logging.h"
 #include "utils/checksum.h"
@@ -82,6 +83,60 @@ const CalendarLib* MaybeCreateCalendarlib(
   }
 }
 
+// Returns the codepoint spans of the lines.
+std::vector<CodepointSpan> LineSpans(
+    const UnicodeText& context_unicode,
+    const std::vector<UnicodeTextRange>& lines) {
+  std::vector<CodepointSpan> line_spans;
+  line_spans.reserve(lines.size());
+  UnicodeText::const_iterator it = context_unicode.begin();
+  CodepointIndex index = 0;
+  for (const UnicodeTextRange& line : lines) {
+    index += std::distance(it, line.first);
+    const CodepointIndex line_begin = index;
+    index += std::distance(line.first, line.second);
+    it = line.second;
+    line_spans.push_back({line_begin, index});
+  }
+  return line_spans;
+}
+
+// Extends 'span' to the whole lines it touches and 'margin_lines' more lines
+// on each side.
+CodepointSpan ExtendToLines(const std::vector<CodepointSpan>& line_spans,
+                            CodepointSpan span, int margin_lines,
+                            int num_codepoints) {
+  const int num_lines = line_spans.size();
+  int first_line = 0;
+  while (first_line < num_lines &&
+         line_spans[first_line].second < span.first) {
+    ++first_line;
+  }
+  int last_line = num_lines - 1;
+  while (last_line >= 0 && line_spans[last_line].first > span.second) {
+    --last_line;
+  }
+  first_line -= margin_lines;
+  last_line += margin_lines;
+
+  CodepointSpan result = span;
+  if (first_line <= 0) {
+    result.first = 0;
+  } else if (first_line < num_lines) {
+    result.first = std::min(span.first, line_spans[first_line].first);
+  }
+  if (last_line >= num_lines - 1) {
+    result.second = num_codepoints;
+  } else if (last_line >= 0) {
+    result.second = std::max(span.second, line_spans[last_line].second);
+  }
+  return result;
+}
+
+bool SpansOverlap(CodepointSpan a, CodepointSpan b) {
+  return a.first < b.second && b.first < a.second;
+}
+
 }  // namespace
 
 tflite::Interpreter* InterpreterManager::SelectionInterpreter() {
@@ -283,7 +338,11 @@ void Annotator::ValidateAndInitialize() {
       TC3_LOG(ERROR) << "No selection model.";
       return;
     }
-    selection_executor_ = ModelExecutor::FromBuffer(model_->selection_model());
+    selection_executor_ =
+        model_->quantize_fully_connected_weights()
+            ? ModelExecutor::FromBufferWithQuantizedWeights(
+                  model_->selection_model())
+            : ModelExecutor::FromBuffer(model_->selection_model());
     if (!selection_executor_) {
       TC3_LOG(ERROR) << "Could not initialize selection executor.";
       return;
@@ -318,7 +377,10 @@ void Annotator::ValidateAndInitialize() {
     }
 
     classification_executor_ =
-        ModelExecutor::FromBuffer(model_->classification_model());
+        model_->quantize_fully_connected_weights()
+            ? ModelExecutor::FromBufferWithQuantizedWeights(
+                  model_->classification_model())
+            : ModelExecutor::FromBuffer(model_->classification_model());
     if (!classification_executor_) {
       TC3_LOG(ERROR) << "Could not initialize classification executor.";
       return;
@@ -461,6 +523,20 @@ void Annotator::ValidateAndInitialize() {
 }
 
 bool Annotator::InitializeRegexModel(ZlibDecompressor* decompressor) {
+  // Precompile the lua verifiers.
+  if (model_->regex_model()->lua_verifier() != nullptr) {
+    for (const flatbuffers::String* lua_verifier :
+         *model_->regex_model()->lua_verifier()) {
+      std::unique_ptr<const CompiledLuaVerifier> compiled_verifier =
+          CompiledLuaVerifier::Create(lua_verifier->str());
+      if (compiled_verifier == nullptr) {
+        TC3_LOG(ERROR) << "Failed to compile lua verifier.";
+        return false;
+      }
+      lua_verifiers_.push_back(std::move(compiled_verifier));
+    }
+  }
+
   if (!model_->regex_model()->patterns()) {
     return true;
   }
@@ -506,6 +582,9 @@ bool Annotator::InitializeKnowledgeEngine(
     return false;
   }
   knowledge_engine_ = std::move(knowledge_engine);
+  if (result_cache_ != nullptr) {
+    result_cache_->Clear();
+  }
   return true;
 }
 
@@ -517,6 +596,9 @@ bool Annotator::InitializeContactEngine(const std::string& serialized_config) {
     return false;
   }
   contact_engine_ = std::move(contact_engine);
+  if (result_cache_ != nullptr) {
+    result_cache_->Clear();
+  }
   return true;
 }
 
@@ -529,6 +611,19 @@ bool Annotator::InitializeInstalledAppEngine(
     return false;
   }
   installed_app_engine_ = std::move(installed_app_engine);
+  if (result_cache_ != nullptr) {
+    result_cache_->Clear();
+  }
+  return true;
+}
+
+bool Annotator::InitializeResultCache(const ResultCacheOptions& options) {
+  std::unique_ptr<ResultCache> result_cache = ResultCache::Create(options);
+  if (result_cache == nullptr) {
+    TC3_LOG(ERROR) << "Failed to initialize the result cache.";
+    return false;
+  }
+  result_cache_ = std::move(result_cache);
   return true;
 }
 
@@ -590,11 +685,9 @@ CodepointSpan SnapLeftIfWhitespaceSelection(CodepointSpan span,
 }
 }  // namespace internal
 
-bool Annotator::FilteredForAnnotation(const AnnotatedSpan& span) const {
-  return !span.classification.empty() &&
-         filtered_collections_annotation_.find(
-             span.classification[0].collection) !=
-             filtered_collections_annotation_.end();
+bool Annotator::FilteredForAnnotation(const std::string& collection) const {
+  return filtered_collections_annotation_.find(collection) !=
+         filtered_collections_annotation_.end();
 }
 
 bool Annotator::FilteredForClassification(
@@ -603,11 +696,9 @@ bool Annotator::FilteredForClassification(
          filtered_collections_classification_.end();
 }
 
-bool Annotator::FilteredForSelection(const AnnotatedSpan& span) const {
-  return !span.classification.empty() &&
-         filtered_collections_selection_.find(
-             span.classification[0].collection) !=
-             filtered_collections_selection_.end();
+bool Annotator::FilteredForSelection(const std::string& collection) const {
+  return filtered_collections_selection_.find(collection) !=
+         filtered_collections_selection_.end();
 }
 
 namespace {
@@ -628,8 +719,9 @@ float GetPriorityScore(
 }  // namespace
 
 bool Annotator::VerifyRegexMatchCandidate(
-    const std::string& context, const VerificationOptions* verification_options,
-    const std::string& match, const UniLib::RegexMatcher* matcher) const {
+    const VerificationOptions* verification_options, StringPiece match,
+    const UniLib::RegexMatcher* matcher,
+    ScopedLuaVerifiers* lua_verifiers) const {
   if (verification_options == nullptr) {
     return true;
   }
@@ -637,16 +729,16 @@ bool Annotator::VerifyRegexMatchCandidate(
       !VerifyLuhnChecksum(match)) {
     return false;
   }
+  if (!RunNativeVerifier(verification_options->native_verifier(), match)) {
+    return false;
+  }
   const int lua_verifier = verification_options->lua_verifier();
   if (lua_verifier >= 0) {
-    if (model_->regex_model()->lua_verifier() == nullptr ||
-        lua_verifier >= model_->regex_model()->lua_verifier()->size()) {
+    if (lua_verifier >= lua_verifiers_.size()) {
       TC3_LOG(ERROR) << "Invalid lua verifier specified: " << lua_verifier;
       return false;
     }
-    return VerifyMatch(
-        context, matcher,
-        model_->regex_model()->lua_verifier()->Get(lua_verifier)->str());
+    return lua_verifiers->Verify(*lua_verifiers_[lua_verifier], matcher);
   }
   return true;
 }
@@ -711,16 +803,21 @@ CodepointSpan Annotator::SuggestSelection(
         click_indices, context_unicode, *unilib_);
   }
 
-  std::vector<AnnotatedSpan> candidates;
+  // The regex and number candidates are added directly to 'candidates', the
+  // other annotators produce annotated spans that are added in order, so that
+  // the candidates keep the order of the annotators.
+  AnnotationCandidates candidates;
+  std::vector<AnnotatedSpan> annotated_spans;
   InterpreterManager interpreter_manager(selection_executor_.get(),
                                          classification_executor_.get());
   std::vector<Token> tokens;
   if (!ModelSuggestSelection(context_unicode, click_indices,
                              detected_text_language_tags, &interpreter_manager,
-                             &tokens, &candidates)) {
+                             &tokens, &annotated_spans)) {
     TC3_LOG(ERROR) << "Model suggest selection failed.";
     return original_click_indices;
   }
+  candidates.AddAll(&annotated_spans);
   if (!RegexChunk(context_unicode, selection_regex_patterns_, &candidates,
                   /*is_serialized_entity_data_enabled=*/false)) {
     TC3_LOG(ERROR) << "Regex suggest selection failed.";
@@ -730,25 +827,27 @@ CodepointSpan Annotator::SuggestSelection(
           UTF8ToUnicodeText(context, /*do_copy=*/false),
           /*reference_time_ms_utc=*/0, /*reference_timezone=*/"",
           options.locales, ModeFlag_SELECTION, options.annotation_usecase,
-          /*is_serialized_entity_data_enabled=*/false, &candidates)) {
+          /*is_serialized_entity_data_enabled=*/false, &annotated_spans)) {
     TC3_LOG(ERROR) << "Datetime suggest selection failed.";
     return original_click_indices;
   }
   if (knowledge_engine_ != nullptr &&
-      !knowledge_engine_->Chunk(context, &candidates)) {
+      !knowledge_engine_->Chunk(context, &annotated_spans)) {
     TC3_LOG(ERROR) << "Knowledge suggest selection failed.";
     return original_click_indices;
   }
   if (contact_engine_ != nullptr &&
-      !contact_engine_->Chunk(context_unicode, tokens, &candidates)) {
+      !contact_engine_->Chunk(context_unicode, tokens, &annotated_spans)) {
     TC3_LOG(ERROR) << "Contact suggest selection failed.";
     return original_click_indices;
   }
   if (installed_app_engine_ != nullptr &&
-      !installed_app_engine_->Chunk(context_unicode, tokens, &candidates)) {
+      !installed_app_engine_->Chunk(context_unicode, tokens,
+                                    &annotated_spans)) {
     TC3_LOG(ERROR) << "Installed app suggest selection failed.";
     return original_click_indices;
   }
+  candidates.AddAll(&annotated_spans);
   if (number_annotator_ != nullptr &&
       !number_annotator_->FindAll(context_unicode, options.annotation_usecase,
                                   &candidates)) {
@@ -757,18 +856,17 @@ CodepointSpan Annotator::SuggestSelection(
   }
   if (duration_annotator_ != nullptr &&
       !duration_annotator_->FindAll(context_unicode, tokens,
-                                    options.annotation_usecase, &candidates)) {
+                                    options.annotation_usecase,
+                                    &annotated_spans)) {
     TC3_LOG(ERROR) << "Duration annotator failed in suggest selection.";
     return original_click_indices;
   }
+  candidates.AddAll(&annotated_spans);
 
   // Sort candidates according to their position in the input, so that the next
   // code can assume that any connected component of overlapping spans forms a
   // contiguous block.
-  std::sort(candidates.begin(), candidates.end(),
-            [](const AnnotatedSpan& a, const AnnotatedSpan& b) {
-              return a.span.first < b.span.first;
-            });
+  candidates.SortBySpanStart();
 
   std::vector<int> candidate_indices;
   if (!ResolveConflicts(candidates, context, tokens,
@@ -780,8 +878,7 @@ CodepointSpan Annotator::SuggestSelection(
 
   std::sort(candidate_indices.begin(), candidate_indices.end(),
             [&candidates](int a, int b) {
-              return GetPriorityScore(candidates[a].classification) >
-                     GetPriorityScore(candidates[b].classification);
+              return candidates.PriorityScore(a) > candidates.PriorityScore(b);
             });
 
   for (const int i : candidate_indices) {
@@ -789,19 +886,21 @@ CodepointSpan Annotator::SuggestSelection(
         SpansOverlap(candidates[i].span, original_click_indices)) {
       // Run model classification if not present but requested and there's a
       // classification collection filter specified.
-      if (candidates[i].classification.empty() &&
+      if (!candidates.IsClassified(i) &&
           model_->selection_options()->always_classify_suggested_selection() &&
           !filtered_collections_selection_.empty()) {
+        std::vector<ClassificationResult> classification;
         if (!ModelClassifyText(context, detected_text_language_tags,
                                candidates[i].span, &interpreter_manager,
-                               /*embedding_cache=*/nullptr,
-                               &candidates[i].classification)) {
+                               /*embedding_cache=*/nullptr, &classification)) {
           return original_click_indices;
         }
+        candidates.SetClassification(i, std::move(classification));
       }
 
       // Ignore if span classification is filtered.
-      if (FilteredForSelection(candidates[i])) {
+      if (candidates.IsClassified(i) &&
+          FilteredForSelection(candidates.collection(i))) {
         return original_click_indices;
       }
 
@@ -817,7 +916,7 @@ namespace {
 // transitively does not overlap with the candidate on 'start_index'. If the end
 // of 'candidates' is reached, it returns the index that points right behind the
 // array.
-int FirstNonOverlappingSpanIndex(const std::vector<AnnotatedSpan>& candidates,
+int FirstNonOverlappingSpanIndex(const AnnotationCandidates& candidates,
                                  int start_index) {
   int first_non_overlapping = start_index + 1;
   CodepointSpan conflicting_span = candidates[start_index].span;
@@ -835,7 +934,7 @@ int FirstNonOverlappingSpanIndex(const std::vector<AnnotatedSpan>& candidates,
 }  // namespace
 
 bool Annotator::ResolveConflicts(
-    const std::vector<AnnotatedSpan>& candidates, const std::string& context,
+    const AnnotationCandidates& candidates, const std::string& context,
     const std::vector<Token>& cached_tokens,
     const std::vector<Locale>& detected_text_language_tags,
     AnnotationUsecase annotation_usecase,
@@ -910,7 +1009,7 @@ bool DoSourcesConflict(AnnotationUsecase annotation_usecase,
 
 bool Annotator::ResolveConflict(
     const std::string& context, const std::vector<Token>& cached_tokens,
-    const std::vector<AnnotatedSpan>& candidates,
+    const AnnotationCandidates& candidates,
     const std::vector<Locale>& detected_text_language_tags, int start_index,
     int end_index, AnnotationUsecase annotation_usecase,
     InterpreterManager* interpreter_manager,
@@ -919,8 +1018,8 @@ bool Annotator::ResolveConflict(
   std::unordered_map<int, float> scores;
   for (int i = start_index; i < end_index; ++i) {
     conflicting_indices.push_back(i);
-    if (!candidates[i].classification.empty()) {
-      scores[i] = GetPriorityScore(candidates[i].classification);
+    if (candidates.IsClassified(i)) {
+      scores[i] = candidates.PriorityScore(i);
       continue;
     }
 
@@ -965,7 +1064,7 @@ bool Annotator::ResolveConflict(
 
       if (DoSourcesConflict(annotation_usecase, source_set_pair.first,
                             candidates[considered_candidate].source) &&
-          DoesCandidateConflict(considered_candidate, candidates,
+          DoesCandidateConflict(considered_candidate, candidates.candidates(),
                                 source_set_pair.second)) {
         conflict = true;
         break;
@@ -1094,17 +1193,23 @@ bool Annotator::ModelSuggestSelection(
     return false;
   }
 
+  std::vector<CodepointSpan> candidate_spans;
+  candidate_spans.reserve(chunks.size());
   for (const TokenSpan& chunk : chunks) {
-    AnnotatedSpan candidate;
-    candidate.span = selection_feature_processor_->StripBoundaryCodepoints(
-        context_unicode, TokenSpanToCodepointSpan(*tokens, chunk));
-    if (model_->selection_options()->strip_unpaired_brackets()) {
-      candidate.span =
-          StripUnpairedBrackets(context_unicode, candidate.span, *unilib_);
-    }
+    candidate_spans.push_back(
+        selection_feature_processor_->StripBoundaryCodepoints(
+            context_unicode, TokenSpanToCodepointSpan(*tokens, chunk)));
+  }
+  if (model_->selection_options()->strip_unpaired_brackets()) {
+    candidate_spans =
+        StripUnpairedBrackets(context_unicode, candidate_spans, *unilib_);
+  }
 
+  for (const CodepointSpan& span : candidate_spans) {
     // Only output non-empty spans.
-    if (candidate.span.first != candidate.span.second) {
+    if (span.first != span.second) {
+      AnnotatedSpan candidate;
+      candidate.span = span;
       result->push_back(candidate);
     }
   }
@@ -1364,12 +1469,19 @@ bool Annotator::RegexClassifyText(
           .UTF8Substring(selection_indices.first, selection_indices.second);
   const UnicodeText selection_text_unicode(
       UTF8ToUnicodeText(selection_text, /*do_copy=*/false));
+  const std::unique_ptr<UniLib::PreparedText> prepared_selection_text =
+      unilib_->PrepareText(selection_text_unicode);
+  if (!prepared_selection_text) {
+    TC3_LOG(ERROR) << "Could not prepare the selection text for matching.";
+    return false;
+  }
 
   // Check whether any of the regular expressions match.
+  ScopedLuaVerifiers lua_verifiers(context);
   for (const int pattern_id : classification_regex_patterns_) {
     const CompiledRegexPattern& regex_pattern = regex_patterns_[pattern_id];
     const std::unique_ptr<UniLib::RegexMatcher> matcher =
-        regex_pattern.pattern->Matcher(selection_text_unicode);
+        regex_pattern.pattern->Matcher(*prepared_selection_text);
     int status = UniLib::RegexMatcher::kNoError;
     bool matches;
     if (regex_pattern.config->use_approximate_matching()) {
@@ -1381,8 +1493,8 @@ bool Annotator::RegexClassifyText(
       return false;
     }
     if (matches && VerifyRegexMatchCandidate(
-                       context, regex_pattern.config->verification_options(),
-                       selection_text, matcher.get())) {
+                       regex_pattern.config->verification_options(),
+                       selection_text, matcher.get(), &lua_verifiers)) {
       classification_result->push_back(
           {regex_pattern.config->collection_name()->str(),
            regex_pattern.config->target_classification_score(),
@@ -1474,6 +1586,23 @@ bool Annotator::DatetimeClassifyText(
 std::vector<ClassificationResult> Annotator::ClassifyText(
     const std::string& context, CodepointSpan selection_indices,
     const ClassificationOptions& options) const {
+  std::vector<ClassificationResult> result;
+  if (result_cache_ != nullptr &&
+      result_cache_->LookupClassification(context, selection_indices, options,
+                                          &result)) {
+    return result;
+  }
+  result = ClassifyTextUncached(context, selection_indices, options);
+  if (result_cache_ != nullptr) {
+    result_cache_->InsertClassification(context, selection_indices, options,
+                                        result);
+  }
+  return result;
+}
+
+std::vector<ClassificationResult> Annotator::ClassifyTextUncached(
+    const std::string& context, CodepointSpan selection_indices,
+    const ClassificationOptions& options) const {
   if (!initialized_) {
     TC3_LOG(ERROR) << "Not initialized";
     return {};
@@ -1509,15 +1638,15 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
 
   // We'll accumulate a list of candidates, and pick the best candidate in the
   // end.
-  std::vector<AnnotatedSpan> candidates;
+  AnnotationCandidates candidates;
 
   // Try the knowledge engine.
   // TODO(b/126579108): Propagate error status.
   ClassificationResult knowledge_result;
   if (knowledge_engine_ && knowledge_engine_->ClassifyText(
                                context, selection_indices, &knowledge_result)) {
-    candidates.push_back({selection_indices, {knowledge_result}});
-    candidates.back().source = AnnotatedSpan::Source::KNOWLEDGE;
+    candidates.Add(selection_indices, {knowledge_result},
+                   AnnotatedSpan::Source::KNOWLEDGE);
   }
 
   // Try the contact engine.
@@ -1525,7 +1654,7 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
   ClassificationResult contact_result;
   if (contact_engine_ && contact_engine_->ClassifyText(
                              context, selection_indices, &contact_result)) {
-    candidates.push_back({selection_indices, {contact_result}});
+    candidates.Add(selection_indices, {contact_result});
   }
 
   // Try the installed app engine.
@@ -1534,7 +1663,7 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
   if (installed_app_engine_ &&
       installed_app_engine_->ClassifyText(context, selection_indices,
                                           &installed_app_result)) {
-    candidates.push_back({selection_indices, {installed_app_result}});
+    candidates.Add(selection_indices, {installed_app_result});
   }
 
   // Try the regular expression models.
@@ -1543,7 +1672,7 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
     return {};
   }
   for (const ClassificationResult& result : regex_results) {
-    candidates.push_back({selection_indices, {result}});
+    candidates.Add(selection_indices, {result});
   }
 
   // Try the date model.
@@ -1558,8 +1687,8 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
     return {};
   }
   if (!datetime_results.empty()) {
-    candidates.push_back({selection_indices, std::move(datetime_results)});
-    candidates.back().source = AnnotatedSpan::Source::DATETIME;
+    candidates.Add(selection_indices, std::move(datetime_results),
+                   AnnotatedSpan::Source::DATETIME);
   }
 
   // Try the number annotator.
@@ -1569,7 +1698,7 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
       number_annotator_->ClassifyText(
           UTF8ToUnicodeText(context, /*do_copy=*/false), selection_indices,
           options.annotation_usecase, &number_annotator_result)) {
-    candidates.push_back({selection_indices, {number_annotator_result}});
+    candidates.Add(selection_indices, {number_annotator_result});
   }
 
   // Try the duration annotator.
@@ -1578,8 +1707,8 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
       duration_annotator_->ClassifyText(
           UTF8ToUnicodeText(context, /*do_copy=*/false), selection_indices,
           options.annotation_usecase, &duration_annotator_result)) {
-    candidates.push_back({selection_indices, {duration_annotator_result}});
-    candidates.back().source = AnnotatedSpan::Source::DURATION;
+    candidates.Add(selection_indices, {duration_annotator_result},
+                   AnnotatedSpan::Source::DURATION);
   }
 
   // Try the ML model.
@@ -1598,7 +1727,7 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
     return {};
   }
   if (!model_results.empty()) {
-    candidates.push_back({selection_indices, std::move(model_results)});
+    candidates.Add(selection_indices, std::move(model_results));
   }
 
   std::vector<int> candidate_indices;
@@ -1610,10 +1739,13 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
   }
 
   std::vector<ClassificationResult> results;
+  std::vector<ClassificationResult> classification;
   for (const int i : candidate_indices) {
-    for (const ClassificationResult& result : candidates[i].classification) {
+    classification.clear();
+    candidates.MoveClassificationTo(i, &classification);
+    for (ClassificationResult& result : classification) {
       if (!FilteredForClassification(result)) {
-        results.push_back(result);
+        results.push_back(std::move(result));
       }
     }
   }
@@ -1633,8 +1765,10 @@ std::vector<ClassificationResult> Annotator::ClassifyText(
 bool Annotator::ModelAnnotate(
     const std::string& context,
     const std::vector<Locale>& detected_text_language_tags,
-    InterpreterManager* interpreter_manager, std::vector<Token>* tokens,
-    std::vector<AnnotatedSpan>* result) const {
+    const Deadline& deadline, InterpreterManager* interpreter_manager,
+    std::vector<Token>* tokens, AnnotationCandidates* result,
+    bool* stopped_early) const {
+  *stopped_early = false;
   if (model_->triggering_options() == nullptr ||
       !(model_->triggering_options()->enabled_modes() & ModeFlag_ANNOTATION)) {
     return true;
@@ -1661,6 +1795,10 @@ bool Annotator::ModelAnnotate(
            : 0.f);
 
   for (const UnicodeTextRange& line : lines) {
+    if (deadline.Expired()) {
+      *stopped_early = true;
+      break;
+    }
     FeatureProcessor::EmbeddingCache embedding_cache;
     const std::string line_str =
         UnicodeText::UTF8Substring(line.first, line.second);
@@ -1718,14 +1856,15 @@ bool Annotator::ModelAnnotate(
           return false;
         }
 
-        // Do not include the span if it's classified as "other".
+        // Do not include the span if it's classified as "other". The model
+        // produces a single classification result, so the compact candidate
+        // representation is used.
         if (!classification.empty() && !ClassifiedAsOther(classification) &&
             classification[0].score >= min_annotate_confidence) {
-          AnnotatedSpan result_span;
-          result_span.span = {codepoint_span.first + offset,
-                              codepoint_span.second + offset};
-          result_span.classification = std::move(classification);
-          result->push_back(std::move(result_span));
+          result->Add({codepoint_span.first + offset,
+                       codepoint_span.second + offset},
+                      classification[0].collection, classification[0].score,
+                      classification[0].priority_score);
         }
       }
     }
@@ -1771,7 +1910,54 @@ void Annotator::RemoveNotEnabledEntityTypes(
 
 std::vector<AnnotatedSpan> Annotator::Annotate(
     const std::string& context, const AnnotationOptions& options) const {
-  std::vector<AnnotatedSpan> candidates;
+  int skipped_stages;
+  return Annotate(context, options, &skipped_stages);
+}
+
+std::vector<AnnotatedSpan> Annotator::Annotate(
+    const std::string& context, const AnnotationOptions& options,
+    int* skipped_stages) const {
+  std::vector<AnnotatedSpan> result;
+  if (result_cache_ != nullptr &&
+      result_cache_->LookupAnnotations(context, options, &result)) {
+    *skipped_stages = 0;
+    return result;
+  }
+  result = AnnotateUncached(context, options, skipped_stages);
+  if (result_cache_ != nullptr && *skipped_stages == 0) {
+    result_cache_->InsertAnnotations(context, options, result);
+  }
+  return result;
+}
+
+std::vector<AnnotatedSpan> Annotator::AnnotateUncached(
+    const std::string& context, const AnnotationOptions& options,
+    int* skipped_stages) const {
+  // The model, regex and number candidates are added directly to 'candidates',
+  // the other annotators produce annotated spans that are added in order, so
+  // that the candidates keep the order of the annotators.
+  AnnotationCandidates candidates;
+  std::vector<AnnotatedSpan> annotated_spans;
+  *skipped_stages = 0;
+
+  // Returns whether a stage can run, and records it as skipped if the deadline
+  // expired.
+  const Deadline& deadline = options.deadline;
+  const auto run_stage = [&deadline, skipped_stages](AnnotationStage stage) {
+    if (deadline.Expired()) {
+      *skipped_stages |= stage;
+      return false;
+    }
+    return true;
+  };
+  // Records a stage as cut short if it stopped early.
+  bool stopped_early = false;
+  const auto end_stage = [&stopped_early,
+                          skipped_stages](AnnotationStage stage) {
+    if (stopped_early) {
+      *skipped_stages |= stage;
+    }
+  };
 
   if (!(model_->enabled_modes() & ModeFlag_ANNOTATION)) {
     return {};
@@ -1801,55 +1987,70 @@ std::vector<AnnotatedSpan> Annotator::Annotate(
 
   // Annotate with the selection model.
   std::vector<Token> tokens;
-  if (!ModelAnnotate(context, detected_text_language_tags, &interpreter_manager,
-                     &tokens, &candidates)) {
-    TC3_LOG(ERROR) << "Couldn't run ModelAnnotate.";
-    return {};
+  if (run_stage(ANNOTATION_STAGE_MODEL)) {
+    if (!ModelAnnotate(context, detected_text_language_tags, deadline,
+                       &interpreter_manager, &tokens, &candidates,
+                       &stopped_early)) {
+      TC3_LOG(ERROR) << "Couldn't run ModelAnnotate.";
+      return {};
+    }
+    end_stage(ANNOTATION_STAGE_MODEL);
   }
 
   // Annotate with the regular expression models.
-  if (!RegexChunk(UTF8ToUnicodeText(context, /*do_copy=*/false),
-                  annotation_regex_patterns_, &candidates,
-                  options.is_serialized_entity_data_enabled)) {
-    TC3_LOG(ERROR) << "Couldn't run RegexChunk.";
-    return {};
+  if (run_stage(ANNOTATION_STAGE_REGEX)) {
+    if (!RegexChunk(UTF8ToUnicodeText(context, /*do_copy=*/false),
+                    annotation_regex_patterns_, &candidates,
+                    options.is_serialized_entity_data_enabled, deadline,
+                    &stopped_early)) {
+      TC3_LOG(ERROR) << "Couldn't run RegexChunk.";
+      return {};
+    }
+    end_stage(ANNOTATION_STAGE_REGEX);
   }
 
   // Annotate with the datetime model.
   const EnabledEntityTypes is_entity_type_enabled(options.entity_types);
   if ((is_entity_type_enabled(Collections::Date()) ||
        is_entity_type_enabled(Collections::DateTime())) &&
-      !DatetimeChunk(UTF8ToUnicodeText(context, /*do_copy=*/false),
-                     options.reference_time_ms_utc, options.reference_timezone,
-                     options.locales, ModeFlag_ANNOTATION,
-                     options.annotation_usecase,
-                     options.is_serialized_entity_data_enabled, &candidates)) {
-    TC3_LOG(ERROR) << "Couldn't run RegexChunk.";
-    return {};
+      run_stage(ANNOTATION_STAGE_DATETIME)) {
+    if (!DatetimeChunk(UTF8ToUnicodeText(context, /*do_copy=*/false),
+                       options.reference_time_ms_utc,
+                       options.reference_timezone, options.locales,
+                       ModeFlag_ANNOTATION, options.annotation_usecase,
+                       options.is_serialized_entity_data_enabled,
+                       &annotated_spans, deadline, &stopped_early)) {
+      TC3_LOG(ERROR) << "Couldn't run RegexChunk.";
+      return {};
+    }
+    end_stage(ANNOTATION_STAGE_DATETIME);
   }
 
   // Annotate with the knowledge engine.
-  if (knowledge_engine_ && !knowledge_engine_->Chunk(context, &candidates)) {
+  if (knowledge_engine_ && run_stage(ANNOTATION_STAGE_KNOWLEDGE) &&
+      !knowledge_engine_->Chunk(context, &annotated_spans)) {
     TC3_LOG(ERROR) << "Couldn't run knowledge engine Chunk.";
     return {};
   }
 
   // Annotate with the contact engine.
-  if (contact_engine_ &&
-      !contact_engine_->Chunk(context_unicode, tokens, &candidates)) {
+  if (contact_engine_ && run_stage(ANNOTATION_STAGE_CONTACT) &&
+      !contact_engine_->Chunk(context_unicode, tokens, &annotated_spans)) {
     TC3_LOG(ERROR) << "Couldn't run contact engine Chunk.";
     return {};
   }
 
   // Annotate with the installed app engine.
-  if (installed_app_engine_ &&
-      !installed_app_engine_->Chunk(context_unicode, tokens, &candidates)) {
+  if (installed_app_engine_ && run_stage(ANNOTATION_STAGE_INSTALLED_APP) &&
+      !installed_app_engine_->Chunk(context_unicode, tokens,
+                                    &annotated_spans)) {
     TC3_LOG(ERROR) << "Couldn't run installed app engine Chunk.";
     return {};
   }
+  candidates.AddAll(&annotated_spans);
 
   // Annotate with the number annotator.
-  if (number_annotator_ != nullptr &&
+  if (number_annotator_ != nullptr && run_stage(ANNOTATION_STAGE_NUMBER) &&
       !number_annotator_->FindAll(context_unicode, options.annotation_usecase,
                                   &candidates)) {
     TC3_LOG(ERROR) << "Couldn't run number annotator FindAll.";
@@ -1858,20 +2059,19 @@ std::vector<AnnotatedSpan> Annotator::Annotate(
 
   // Annotate with the duration annotator.
   if (is_entity_type_enabled(Collections::Duration()) &&
-      duration_annotator_ != nullptr &&
+      duration_annotator_ != nullptr && run_stage(ANNOTATION_STAGE_DURATION) &&
       !duration_annotator_->FindAll(context_unicode, tokens,
-                                    options.annotation_usecase, &candidates)) {
+                                    options.annotation_usecase,
+                                    &annotated_spans)) {
     TC3_LOG(ERROR) << "Couldn't run duration annotator FindAll.";
     return {};
   }
+  candidates.AddAll(&annotated_spans);
 
   // Sort candidates according to their position in the input, so that the next
   // code can assume that any connected component of overlapping spans forms a
   // contiguous block.
-  std::sort(candidates.begin(), candidates.end(),
-            [](const AnnotatedSpan& a, const AnnotatedSpan& b) {
-              return a.span.first < b.span.first;
-            });
+  candidates.SortBySpanStart();
 
   std::vector<int> candidate_indices;
   if (!ResolveConflicts(candidates, context, tokens,
@@ -1892,14 +2092,11 @@ std::vector<AnnotatedSpan> Annotator::Annotate(
       aggregated_span =
           AnnotatedSpan(candidates[i].span, /*arg_classification=*/{});
     }
-    if (candidates[i].classification.empty() ||
-        ClassifiedAsOther(candidates[i].classification) ||
-        FilteredForAnnotation(candidates[i])) {
+    if (!candidates.IsClassified(i) || candidates.IsClassifiedAsOther(i) ||
+        FilteredForAnnotation(candidates.collection(i))) {
       continue;
     }
-    for (ClassificationResult& classification : candidates[i].classification) {
-      aggregated_span.classification.push_back(std::move(classification));
-    }
+    candidates.MoveClassificationTo(i, &aggregated_span.classification);
   }
   if (!aggregated_span.classification.empty()) {
     result.push_back(std::move(aggregated_span));
@@ -1919,6 +2116,100 @@ std::vector<AnnotatedSpan> Annotator::Annotate(
   return result;
 }
 
+std::vector<AnnotatedSpan> Annotator::AnnotateEdited(
+    const std::string& context,
+    const std::vector<AnnotatedSpan>& previous_annotations,
+    const TextEdit& edit, const AnnotationOptions& options) const {
+  if (selection_feature_processor_ == nullptr ||
+      !selection_feature_processor_->GetOptions()->only_use_line_with_click()) {
+    return Annotate(context, options);
+  }
+
+  const UnicodeText context_unicode =
+      UTF8ToUnicodeText(context, /*do_copy=*/false);
+  if (!context_unicode.is_valid()) {
+    return {};
+  }
+  const int num_codepoints = context_unicode.size_codepoints();
+  const int inserted_length =
+      UTF8ToUnicodeText(edit.inserted_text, /*do_copy=*/false)
+          .size_codepoints();
+  const CodepointSpan edited_span = {edit.offset,
+                                     edit.offset + inserted_length};
+  if (edit.offset < 0 || edit.removed_length < 0 ||
+      edited_span.second > num_codepoints) {
+    TC3_LOG(ERROR) << "Invalid edit, annotating the whole context.";
+    return Annotate(context, options);
+  }
+
+  // Move the previous annotations to the edited text. The ones overlapping the
+  // removed text are always annotated again.
+  const int removed_end = edit.offset + edit.removed_length;
+  const int shift = inserted_length - edit.removed_length;
+  std::vector<AnnotatedSpan> shifted_annotations;
+  shifted_annotations.reserve(previous_annotations.size());
+  for (const AnnotatedSpan& annotation : previous_annotations) {
+    if (annotation.span.second <= edit.offset) {
+      shifted_annotations.push_back(annotation);
+    } else if (annotation.span.first >= removed_end) {
+      shifted_annotations.push_back(annotation);
+      shifted_annotations.back().span.first += shift;
+      shifted_annotations.back().span.second += shift;
+    }
+  }
+
+  // Find the lines to annotate again, extended so that no previous annotation
+  // crosses their boundaries.
+  const std::vector<CodepointSpan> line_spans = LineSpans(
+      context_unicode, selection_feature_processor_->SplitContext(
+                           context_unicode));
+  CodepointSpan region =
+      ExtendToLines(line_spans, edited_span, kIncrementalAnnotationMarginLines,
+                    num_codepoints);
+  bool region_extended = true;
+  while (region_extended) {
+    region_extended = false;
+    for (const AnnotatedSpan& annotation : shifted_annotations) {
+      if (SpansOverlap(annotation.span, region) &&
+          (annotation.span.first < region.first ||
+           annotation.span.second > region.second)) {
+        region = ExtendToLines(
+            line_spans,
+            {std::min(region.first, annotation.span.first),
+             std::max(region.second, annotation.span.second)},
+            /*margin_lines=*/0, num_codepoints);
+        region_extended = true;
+      }
+    }
+  }
+
+  auto region_begin = context_unicode.begin();
+  std::advance(region_begin, region.first);
+  auto region_end = region_begin;
+  std::advance(region_end, region.second - region.first);
+  std::vector<AnnotatedSpan> region_annotations = Annotate(
+      UnicodeText::UTF8Substring(region_begin, region_end), options);
+
+  std::vector<AnnotatedSpan> result;
+  result.reserve(shifted_annotations.size() + region_annotations.size());
+  for (AnnotatedSpan& annotation : shifted_annotations) {
+    if (annotation.span.second <= region.first) {
+      result.push_back(std::move(annotation));
+    }
+  }
+  for (AnnotatedSpan& annotation : region_annotations) {
+    annotation.span.first += region.first;
+    annotation.span.second += region.first;
+    result.push_back(std::move(annotation));
+  }
+  for (AnnotatedSpan& annotation : shifted_annotations) {
+    if (annotation.span.first >= region.second) {
+      result.push_back(std::move(annotation));
+    }
+  }
+  return result;
+}
+
 CodepointSpan Annotator::ComputeSelectionBoundaries(
     const UniLib::RegexMatcher* match,
     const RegexModel_::Pattern* config) const {
@@ -2020,26 +2311,105 @@ bool Annotator::SerializedEntityDataFromRegexMatch(
   return true;
 }
 
+namespace {
+// Maps codepoint offsets of a text to byte offsets. Lookups with increasing
+// offsets continue from the previous position instead of rescanning the text
+// from the beginning, which makes mapping all matches of a pattern linear in
+// the length of the text.
+class CodepointToByteOffsetMapper {
+ public:
+  explicit CodepointToByteOffsetMapper(const UnicodeText& text)
+      : text_(text), it_(text.begin()) {}
+
+  int ByteOffset(const int codepoint_offset) {
+    if (codepoint_offset < codepoint_offset_) {
+      it_ = text_.begin();
+      codepoint_offset_ = 0;
+    }
+    while (codepoint_offset_ < codepoint_offset && it_ != text_.end()) {
+      ++it_;
+      ++codepoint_offset_;
+    }
+    return it_.utf8_data() - text_.data();
+  }
+
+ private:
+  const UnicodeText& text_;
+  UnicodeText::const_iterator it_;
+  int codepoint_offset_ = 0;
+};
+
+// Returns a view of the text of a capturing group of the last match, backed by
+// the matched text.
+StringPiece CapturingGroupText(const UniLib::RegexMatcher* matcher,
+                               const int group_id, const UnicodeText& text,
+                               CodepointToByteOffsetMapper* mapper) {
+  int status = UniLib::RegexMatcher::kNoError;
+  const int start = matcher->Start(group_id, &status);
+  const int end = matcher->End(group_id, &status);
+  if (status != UniLib::RegexMatcher::kNoError || start == kInvalidIndex ||
+      end == kInvalidIndex) {
+    return StringPiece();
+  }
+  const int start_byte = mapper->ByteOffset(start);
+  const int end_byte = mapper->ByteOffset(end);
+  return StringPiece(text.data() + start_byte, end_byte - start_byte);
+}
+}  // namespace
+
 bool Annotator::RegexChunk(const UnicodeText& context_unicode,
                            const std::vector<int>& rules,
-                           std::vector<AnnotatedSpan>* result,
-                           bool is_serialized_entity_data_enabled) const {
+                           AnnotationCandidates* result,
+                           bool is_serialized_entity_data_enabled,
+                           const Deadline& deadline,
+                           bool* stopped_early) const {
+  if (stopped_early != nullptr) {
+    *stopped_early = false;
+  }
+  // The verifiers operate on a view of the context, so that the context is not
+  // copied for every match.
+  const StringPiece context(context_unicode.data(),
+                            context_unicode.size_bytes());
+  const std::unique_ptr<UniLib::PreparedText> prepared_context =
+      unilib_->PrepareText(context_unicode);
+  if (!prepared_context) {
+    TC3_LOG(ERROR) << "Could not prepare the context for matching.";
+    return false;
+  }
+  // Lua verifiers that read the context copy it only once for all the matches.
+  ScopedLuaVerifiers lua_verifiers(context);
   for (int pattern_id : rules) {
+    if (deadline.Expired()) {
+      if (stopped_early != nullptr) {
+        *stopped_early = true;
+      }
+      break;
+    }
     const CompiledRegexPattern& regex_pattern = regex_patterns_[pattern_id];
-    const auto matcher = regex_pattern.pattern->Matcher(context_unicode);
+    const auto matcher = regex_pattern.pattern->Matcher(*prepared_context);
     if (!matcher) {
       TC3_LOG(ERROR) << "Could not get regex matcher for pattern: "
                      << pattern_id;
       return false;
     }
 
+    const VerificationOptions* verification_options =
+        regex_pattern.config->verification_options();
+    CodepointToByteOffsetMapper byte_offset_mapper(context_unicode);
     int status = UniLib::RegexMatcher::kNoError;
     while (matcher->Find(&status) && status == UniLib::RegexMatcher::kNoError) {
-      if (regex_pattern.config->verification_options()) {
-        if (!VerifyRegexMatchCandidate(
-                context_unicode.ToUTF8String(),
-                regex_pattern.config->verification_options(),
-                matcher->Group(1, &status).ToUTF8String(), matcher.get())) {
+      if (verification_options) {
+        // The match text is only needed for the luhn checksum and the native
+        // verifiers.
+        StringPiece match;
+        if (verification_options->verify_luhn_checksum() ||
+            verification_options->native_verifier() !=
+                NativeVerifierType_NONE) {
+          match = CapturingGroupText(matcher.get(), /*group_id=*/1,
+                                     context_unicode, &byte_offset_mapper);
+        }
+        if (!VerifyRegexMatchCandidate(verification_options, match,
+                                       matcher.get(), &lua_verifiers)) {
           continue;
         }
       }
@@ -2053,20 +2423,29 @@ bool Annotator::RegexChunk(const UnicodeText& context_unicode,
         }
       }
 
-      result->emplace_back();
-
       // Selection/annotation regular expressions need to specify a capturing
       // group specifying the selection.
-      result->back().span =
+      const CodepointSpan span =
           ComputeSelectionBoundaries(matcher.get(), regex_pattern.config);
 
-      result->back().classification = {
-          {regex_pattern.config->collection_name()->str(),
-           regex_pattern.config->target_classification_score(),
-           regex_pattern.config->priority_score()}};
-
-      result->back().classification[0].serialized_entity_data =
-          serialized_entity_data;
+      // Only matches with entity data need the full classification result.
+      const flatbuffers::String* collection_name =
+          regex_pattern.config->collection_name();
+      if (serialized_entity_data.empty()) {
+        result->Add(span,
+                    StringPiece(collection_name->c_str(),
+                                collection_name->size()),
+                    regex_pattern.config->target_classification_score(),
+                    regex_pattern.config->priority_score());
+      } else {
+        ClassificationResult classification(
+            collection_name->str(),
+            regex_pattern.config->target_classification_score(),
+            regex_pattern.config->priority_score());
+        classification.serialized_entity_data =
+            std::move(serialized_entity_data);
+        result->Add(span, {std::move(classification)});
+      }
     }
   }
   return true;
@@ -2164,6 +2543,7 @@ bool Annotator::ModelClickContextScoreChunks(
   const int max_batch_size = model_->selection_options()->batch_size();
 
   std::vector<float> all_features;
+  std::vector<float> all_scores;
   std::map<TokenSpan, float> chunk_scores;
   for (int batch_start = span_of_interest.first;
        batch_start < span_of_interest.second; batch_start += max_batch_size) {
@@ -2196,10 +2576,13 @@ bool Annotator::ModelClickContextScoreChunks(
     }
 
     // Save results.
+    if (!ComputeSoftmaxRows(logits, &all_scores)) {
+      TC3_LOG(ERROR) << "Couldn't compute the scores.";
+      return false;
+    }
     for (int click_pos = batch_start; click_pos < batch_end; ++click_pos) {
-      const std::vector<float> scores = ComputeSoftmax(
-          logits.data() + logits.dim(1) * (click_pos - batch_start),
-          logits.dim(1));
+      const float* scores =
+          all_scores.data() + logits.dim(1) * (click_pos - batch_start);
       for (int j = 0;
            j < selection_feature_processor_->GetSelectionLabelCount(); ++j) {
         TokenSpan relative_token_span;
@@ -2321,7 +2704,12 @@ bool Annotator::DatetimeChunk(const UnicodeText& context_unicode,
                               const std::string& locales, ModeFlag mode,
                               AnnotationUsecase annotation_usecase,
                               bool is_serialized_entity_data_enabled,
-                              std::vector<AnnotatedSpan>* result) const {
+                              std::vector<AnnotatedSpan>* result,
+                              const Deadline& deadline,
+                              bool* stopped_early) const {
+  if (stopped_early != nullptr) {
+    *stopped_early = false;
+  }
   if (!datetime_parser_) {
     return true;
   }
@@ -2330,7 +2718,8 @@ bool Annotator::DatetimeChunk(const UnicodeText& context_unicode,
   if (!datetime_parser_->Parse(context_unicode, reference_time_ms_utc,
                                reference_timezone, locales, mode,
                                annotation_usecase,
-                               /*anchor_start_end=*/false, &datetime_spans)) {
+                               /*anchor_start_end=*/false, &datetime_spans,
+                               deadline, stopped_early)) {
     return false;
   }
   for (const DatetimeParseResultSpan& datetime_span : datetime_spans) {
@@ -25,6 +25,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "annotator/annotation-candidates.h"
 #include "annotator/contact/contact-engine.h"
 #include "annotator/datetime/parser.h"
 #include "annotator/duration/duration.h"
@@ -34,12 +35,15 @@
 #include "annotator/model-executor.h"
 #include "annotator/model_generated.h"
 #include "annotator/number/number.h"
+#include "annotator/result-cache.h"
 #include "annotator/strip-unpaired-brackets.h"
 #include "annotator/types.h"
 #include "annotator/zlib-utils.h"
+#include "utils/deadline.h"
 #include "utils/flatbuffers.h"
 #include "utils/i18n/locale.h"
 #include "utils/memory/mmap.h"
+#include "utils/regex-match.h"
 #include "utils/utf8/unilib.h"
 #include "utils/zlib/zlib.h"
 
@@ -124,6 +128,10 @@ struct AnnotationOptions {
   // Tailors the output annotations according to the specified use-case.
   AnnotationUsecase annotation_usecase = ANNOTATION_USECASE_SMART;
 
+  // Once the deadline expires, the remaining annotation stages are skipped and
+  // the annotations found so far are returned.
+  Deadline deadline;
+
   bool operator==(const AnnotationOptions& other) const {
     return this->reference_time_ms_utc == other.reference_time_ms_utc &&
            this->reference_timezone == other.reference_timezone &&
@@ -132,10 +140,31 @@ struct AnnotationOptions {
                other.detected_text_language_tags &&
            this->annotation_usecase == other.annotation_usecase &&
            this->is_serialized_entity_data_enabled ==
-               other.is_serialized_entity_data_enabled;
+               other.is_serialized_entity_data_enabled &&
+           this->deadline == other.deadline;
   }
 };
 
+// Stages of Annotate() that can be skipped or cut short by the deadline.
+enum AnnotationStage {
+  ANNOTATION_STAGE_MODEL = 1 << 0,
+  ANNOTATION_STAGE_REGEX = 1 << 1,
+  ANNOTATION_STAGE_DATETIME = 1 << 2,
+  ANNOTATION_STAGE_KNOWLEDGE = 1 << 3,
+  ANNOTATION_STAGE_CONTACT = 1 << 4,
+  ANNOTATION_STAGE_INSTALLED_APP = 1 << 5,
+  ANNOTATION_STAGE_NUMBER = 1 << 6,
+  ANNOTATION_STAGE_DURATION = 1 << 7,
+};
+
+// An edit of a text: 'removed_length' codepoints at codepoint 'offset' are
+// replaced with 'inserted_text' (UTF8).
+struct TextEdit {
+  int offset = 0;
+  int removed_length = 0;
+  std::string inserted_text;
+};
+
 // Holds TFLite interpreters for selection and classification models.
 // NOTE: his class is not thread-safe, thus should NOT be re-used across
 // threads.
@@ -226,6 +255,14 @@ class Annotator {
   // Initializes the installed app engine with the given config.
   bool InitializeInstalledAppEngine(const std::string& serialized_config);
 
+  // Enables caching the results of Annotate and ClassifyText, for repeated
+  // requests. Results cut short by the deadline are not cached. The cache is
+  // cleared when an engine is initialized.
+  bool InitializeResultCache(const ResultCacheOptions& options);
+
+  // Returns the result cache, or nullptr if it's not enabled.
+  ResultCache* result_cache() const { return result_cache_.get(); }
+
   // Runs inference for given a context and current selection (i.e. index
   // of the first and one past last selected characters (utf8 codepoint
   // offsets)). Returns the indices (utf8 codepoint offsets) of the selection
@@ -250,6 +287,31 @@ class Annotator {
       const std::string& context,
       const AnnotationOptions& options = AnnotationOptions()) const;
 
+  // Same as above, but also sets 'skipped_stages' to the bit mask of the
+  // AnnotationStages that were skipped or cut short because options.deadline
+  // expired. The conflicts between the annotations found are still resolved.
+  std::vector<AnnotatedSpan> Annotate(const std::string& context,
+                                      const AnnotationOptions& options,
+                                      int* skipped_stages) const;
+
+  // Annotates 'context' after 'edit' was applied to the text the
+  // 'previous_annotations' were produced for by Annotate() with the same
+  // options. Only the lines around the edit (as split by the selection
+  // feature processor) are annotated again, the other annotations are reused
+  // with their spans shifted. The result matches Annotate(context, options)
+  // as long as no annotation depends on the text further than
+  // kIncrementalAnnotationMarginLines lines away. Falls back to Annotate() if
+  // the model does not process the lines independently.
+  std::vector<AnnotatedSpan> AnnotateEdited(
+      const std::string& context,
+      const std::vector<AnnotatedSpan>& previous_annotations,
+      const TextEdit& edit,
+      const AnnotationOptions& options = AnnotationOptions()) const;
+
+  // Number of lines before and after the edited ones that AnnotateEdited()
+  // annotates again.
+  static const int kIncrementalAnnotationMarginLines = 1;
+
   // Looks up a knowledge entity by its id. If successful, populates the
   // serialized knowledge result and returns true.
   bool LookUpKnowledgeEntity(const std::string& id,
@@ -297,11 +359,19 @@ class Annotator {
   // Initializes regular expressions for the regex model.
   bool InitializeRegexModel(ZlibDecompressor* decompressor);
 
+  // ClassifyText and Annotate without the result cache.
+  std::vector<ClassificationResult> ClassifyTextUncached(
+      const std::string& context, CodepointSpan selection_indices,
+      const ClassificationOptions& options) const;
+  std::vector<AnnotatedSpan> AnnotateUncached(const std::string& context,
+                                              const AnnotationOptions& options,
+                                              int* skipped_stages) const;
+
   // Resolves conflicts in the list of candidates by removing some overlapping
   // ones. Returns indices of the surviving ones.
   // NOTE: Assumes that the candidates are sorted according to their position in
   // the span.
-  bool ResolveConflicts(const std::vector<AnnotatedSpan>& candidates,
+  bool ResolveConflicts(const AnnotationCandidates& candidates,
                         const std::string& context,
                         const std::vector<Token>& cached_tokens,
                         const std::vector<Locale>& detected_text_language_tags,
@@ -314,7 +384,7 @@ class Annotator {
   // indices to 'chosen_indices'. Returns false if a problem arises.
   bool ResolveConflict(const std::string& context,
                        const std::vector<Token>& cached_tokens,
-                       const std::vector<AnnotatedSpan>& candidates,
+                       const AnnotationCandidates& candidates,
                        const std::vector<Locale>& detected_text_language_tags,
                        int start_index, int end_index,
                        AnnotationUsecase annotation_usecase,
@@ -381,11 +451,14 @@ class Annotator {
   // exclude spans classified as 'other'.
   // Provides the tokens produced during tokenization of the context string for
   // reuse.
+  // Stops before the next line once 'deadline' expires, and sets
+  // 'stopped_early' to whether any line was left out.
   bool ModelAnnotate(const std::string& context,
                      const std::vector<Locale>& detected_text_language_tags,
+                     const Deadline& deadline,
                      InterpreterManager* interpreter_manager,
-                     std::vector<Token>* tokens,
-                     std::vector<AnnotatedSpan>* result) const;
+                     std::vector<Token>* tokens, AnnotationCandidates* result,
+                     bool* stopped_early) const;
 
   // Groups the tokens into chunks. A chunk is a token span that should be the
   // suggested selection when any of its contained tokens is clicked. The chunks
@@ -419,26 +492,34 @@ class Annotator {
       tflite::Interpreter* selection_interpreter,
       std::vector<ScoredChunk>* scored_chunks) const;
 
-  // Produces chunks isolated by a set of regular expressions.
+  // Produces chunks isolated by a set of regular expressions. Stops before the
+  // next pattern once 'deadline' expires and, if not null, sets
+  // 'stopped_early' to whether any pattern was left out.
   bool RegexChunk(const UnicodeText& context_unicode,
                   const std::vector<int>& rules,
-                  std::vector<AnnotatedSpan>* result,
-                  bool is_serialized_entity_data_enabled) const;
-
-  // Produces chunks from the datetime parser.
+                  AnnotationCandidates* result,
+                  bool is_serialized_entity_data_enabled,
+                  const Deadline& deadline = Deadline(),
+                  bool* stopped_early = nullptr) const;
+
+  // Produces chunks from the datetime parser. Stops before the next datetime
+  // rule once 'deadline' expires and, if not null, sets 'stopped_early' to
+  // whether any rule was left out.
   bool DatetimeChunk(const UnicodeText& context_unicode,
                      int64 reference_time_ms_utc,
                      const std::string& reference_timezone,
                      const std::string& locales, ModeFlag mode,
                      AnnotationUsecase annotation_usecase,
                      bool is_serialized_entity_data_enabled,
-                     std::vector<AnnotatedSpan>* result) const;
+                     std::vector<AnnotatedSpan>* result,
+                     const Deadline& deadline = Deadline(),
+                     bool* stopped_early = nullptr) const;
 
   // Returns whether a classification should be filtered.
-  bool FilteredForAnnotation(const AnnotatedSpan& span) const;
+  bool FilteredForAnnotation(const std::string& collection) const;
   bool FilteredForClassification(
       const ClassificationResult& classification) const;
-  bool FilteredForSelection(const AnnotatedSpan& span) const;
+  bool FilteredForSelection(const std::string& collection) const;
 
   // Computes the selection boundaries from a regular expression match.
   CodepointSpan ComputeSelectionBoundaries(
@@ -454,10 +535,13 @@ class Annotator {
       std::string* serialized_entity_data) const;
 
   // Verifies a regex match and returns true if verification was successful.
+  // `match` is the text of the first capturing group, it only needs to be set
+  // if the luhn checksum or a native verifier is used. Lua verifiers run on
+  // the context of `lua_verifiers`.
   bool VerifyRegexMatchCandidate(
-      const std::string& context,
-      const VerificationOptions* verification_options, const std::string& match,
-      const UniLib::RegexMatcher* matcher) const;
+      const VerificationOptions* verification_options, StringPiece match,
+      const UniLib::RegexMatcher* matcher,
+      ScopedLuaVerifiers* lua_verifiers) const;
 
   const Model* model_;
 
@@ -493,6 +577,10 @@ class Annotator {
 
   std::vector<CompiledRegexPattern> regex_patterns_;
 
+  // Precompiled lua verifiers of the regex model, indexed by the
+  // `lua_verifier` id in the verification options.
+  std::vector<std::unique_ptr<const CompiledLuaVerifier>> lua_verifiers_;
+
   // Indices into regex_patterns_ for the different modes.
   std::vector<int> annotation_regex_patterns_, classification_regex_patterns_,
       selection_regex_patterns_;
@@ -507,6 +595,7 @@ class Annotator {
   std::unique_ptr<const InstalledAppEngine> installed_app_engine_;
   std::unique_ptr<const NumberAnnotator> number_annotator_;
   std::unique_ptr<const DurationAnnotator> duration_annotator_;
+  std::unique_ptr<ResultCache> result_cache_;
 
   // Builder for creating extra data.
   const reflection::Schema* entity_data_schema_;
@@ -552,7 +641,7 @@ template <typename ReturnType, typename Func>
 ReturnType VisitAnnotatorModel(const std::string& path, Func function) {
   ScopedMmap mmap(path);
   if (!mmap.handle().ok()) {
-    function(/*model=*/nullptr);
+    return function(/*model=*/nullptr);
   }
   const Model* model =
       ViewModel(mmap.handle().start(), mmap.handle().num_bytes());
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the Annotator APIs with the bundled English model over the
+// benchmark corpora.
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "annotator/annotation-candidates.h"
+#include "annotator/annotator.h"
+#include "annotator/model_generated.h"
+#include "utils/testing/annotator.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "utils/testing/benchmark-utils.h"
+#include "utils/utf8/unicodetext.h"
+#include "utils/utf8/unilib.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Returns the annotator shared by all the benchmarks, nullptr if the model
+// could not be loaded.
+const Annotator* GetAnnotator() {
+  static const Annotator* annotator =
+      Annotator::FromPath(GetBenchmarkModelPath("textclassifier.en.model"))
+          .release();
+  return annotator;
+}
+
+// Returns the span of the middle token of `text`, for selection and
+// classification requests.
+CodepointSpan MiddleTokenSpan(const std::string& text) {
+  const UnicodeText unicode = UTF8ToUnicodeText(text, /*do_copy=*/false);
+  const int num_codepoints = unicode.size_codepoints();
+  int start = num_codepoints / 2;
+  auto it = unicode.begin();
+  std::advance(it, start);
+  while (start > 0 && *it != ' ') {
+    --it;
+    --start;
+  }
+  if (*it == ' ') {
+    ++it;
+    ++start;
+  }
+  int end = start;
+  while (it != unicode.end() && *it != ' ') {
+    ++it;
+    ++end;
+  }
+  return {start, end};
+}
+
+void BM_Annotate(benchmark::State& state) {
+  const Annotator* annotator = GetAnnotator();
+  if (annotator == nullptr) {
+    state.SkipWithError("Could not load annotator model.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  ReportAllocationsPerCall(state, [&] { annotator->Annotate(text); });
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    benchmark::DoNotOptimize(annotator->Annotate(text));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Annotate)
+    ->Apply(CorpusTextArguments)
+    ->ThreadRange(1, 4);
+
+// Reports the numbers of texts converted for regex matching and of regex
+// matchers created by one Annotate call as the counters "text_conversions"
+// and "regex_matchers". Before the matchers shared a prepared text, every
+// matcher converted its input, so the two counters were equal. Runs on a
+// single thread, as the UniLib counters are process-wide.
+void BM_AnnotateRegexInputs(benchmark::State& state) {
+  const Annotator* annotator = GetAnnotator();
+  if (annotator == nullptr) {
+    state.SkipWithError("Could not load annotator model.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  const int64 num_prepared_texts = UniLib::NumPreparedTexts();
+  const int64 num_regex_matchers = UniLib::NumRegexMatchers();
+  annotator->Annotate(text);
+  state.counters["text_conversions"] =
+      UniLib::NumPreparedTexts() - num_prepared_texts;
+  state.counters["regex_matchers"] =
+      UniLib::NumRegexMatchers() - num_regex_matchers;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(annotator->Annotate(text));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_AnnotateRegexInputs)->Apply(CorpusTextArguments);
+
+void BM_ClassifyText(benchmark::State& state) {
+  const Annotator* annotator = GetAnnotator();
+  if (annotator == nullptr) {
+    state.SkipWithError("Could not load annotator model.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  const CodepointSpan span = MiddleTokenSpan(text);
+  ReportAllocationsPerCall(state, [&] { annotator->ClassifyText(text, span); });
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    benchmark::DoNotOptimize(annotator->ClassifyText(text, span));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ClassifyText)
+    ->Apply(CorpusTextArguments)
+    ->ThreadRange(1, 4);
+
+void BM_SuggestSelection(benchmark::State& state) {
+  const Annotator* annotator = GetAnnotator();
+  if (annotator == nullptr) {
+    state.SkipWithError("Could not load annotator model.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  const CodepointSpan span = MiddleTokenSpan(text);
+  ReportAllocationsPerCall(state,
+                           [&] { annotator->SuggestSelection(text, span); });
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    benchmark::DoNotOptimize(annotator->SuggestSelection(text, span));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SuggestSelection)
+    ->Apply(CorpusTextArguments)
+    ->ThreadRange(1, 4);
+
+// Annotator that exposes the regex chunking with the annotation patterns, so
+// that it can be run without the other annotators.
+class RegexChunkingAnnotator : public Annotator {
+ public:
+  static std::unique_ptr<RegexChunkingAnnotator> FromPath(
+      const std::string& path) {
+    std::unique_ptr<ScopedMmap> mmap(new ScopedMmap(path));
+    if (!mmap->handle().ok()) {
+      return nullptr;
+    }
+    const Model* model =
+        ViewModel(mmap->handle().start(), mmap->handle().num_bytes());
+    if (model == nullptr) {
+      return nullptr;
+    }
+    std::unique_ptr<RegexChunkingAnnotator> annotator(
+        new RegexChunkingAnnotator(&mmap, model));
+    if (!annotator->IsInitialized()) {
+      return nullptr;
+    }
+    return annotator;
+  }
+
+  // Same as above, for a model in a buffer that outlives the annotator.
+  static std::unique_ptr<RegexChunkingAnnotator> FromUnownedBuffer(
+      const std::string& buffer) {
+    const Model* model = ViewModel(buffer.data(), buffer.size());
+    if (model == nullptr) {
+      return nullptr;
+    }
+    std::unique_ptr<RegexChunkingAnnotator> annotator(
+        new RegexChunkingAnnotator(model));
+    if (!annotator->IsInitialized()) {
+      return nullptr;
+    }
+    return annotator;
+  }
+
+  bool RegexChunk(const std::string& text,
+                  AnnotationCandidates* candidates) const {
+    return Annotator::RegexChunk(UTF8ToUnicodeText(text, /*do_copy=*/false),
+                                 annotation_patterns_, candidates,
+                                 /*is_serialized_entity_data_enabled=*/false);
+  }
+
+ private:
+  RegexChunkingAnnotator(std::unique_ptr<ScopedMmap>* mmap, const Model* model)
+      : Annotator(mmap, model, static_cast<const UniLib*>(nullptr),
+                  static_cast<const CalendarLib*>(nullptr)) {
+    CollectAnnotationPatterns(model);
+  }
+
+  explicit RegexChunkingAnnotator(const Model* model)
+      : Annotator(model, static_cast<const UniLib*>(nullptr),
+                  static_cast<const CalendarLib*>(nullptr)) {
+    CollectAnnotationPatterns(model);
+  }
+
+  void CollectAnnotationPatterns(const Model* model) {
+    if (model->regex_model() == nullptr ||
+        model->regex_model()->patterns() == nullptr) {
+      return;
+    }
+    const auto* patterns = model->regex_model()->patterns();
+    for (int i = 0; i < patterns->size(); ++i) {
+      if (patterns->Get(i)->enabled_modes() & ModeFlag_ANNOTATION) {
+        annotation_patterns_.push_back(i);
+      }
+    }
+  }
+
+  std::vector<int> annotation_patterns_;
+};
+
+// Runs the regex chunking from several threads on one shared annotator, to
+// measure the contention on the shared, lazily compiled regex patterns.
+void BM_RegexChunkSharedAnnotator(benchmark::State& state) {
+  static const RegexChunkingAnnotator* annotator =
+      RegexChunkingAnnotator::FromPath(
+          GetBenchmarkModelPath("textclassifier.en.model"))
+          .release();
+  if (annotator == nullptr) {
+    state.SkipWithError("Could not load annotator model.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  AnnotationCandidates candidates;
+  for (auto _ : state) {
+    candidates.Clear();
+    if (!annotator->RegexChunk(text, &candidates)) {
+      state.SkipWithError("Regex chunking failed.");
+      break;
+    }
+    benchmark::DoNotOptimize(candidates.size());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_RegexChunkSharedAnnotator)
+    ->Apply(CorpusTextArguments)
+    ->ThreadRange(1, 8);
+
+// Returns the bundled model with a single annotation pattern, whose matches
+// are verified by a lua verifier that reads the context. Empty if the model
+// could not be read.
+const std::string& GetContextReadingLuaVerifierModel() {
+  static const std::string* buffer = [] {
+    std::ifstream file_stream(GetBenchmarkModelPath("textclassifier.en.model"));
+    const std::string model_buffer(std::istreambuf_iterator<char>(file_stream),
+                                   {});
+    if (model_buffer.empty()) {
+      return new std::string();
+    }
+    return new std::string(
+        ModifyAnnotatorModel(model_buffer, [](ModelT* model) {
+          if (model->regex_model == nullptr) {
+            model->regex_model.reset(new RegexModelT);
+          }
+          model->regex_model->patterns.clear();
+          model->regex_model->lua_verifier.clear();
+          model->regex_model->lua_verifier.push_back(
+              "return string.len(context) >= match[1]['end'];");
+          std::unique_ptr<RegexModel_::PatternT> pattern(
+              new RegexModel_::PatternT);
+          pattern->collection_name = "number";
+          pattern->pattern = "(\\d{4,})";
+          pattern->enabled_modes = ModeFlag_ANNOTATION;
+          pattern->verification_options.reset(new VerificationOptionsT);
+          pattern->verification_options->lua_verifier = 0;
+          model->regex_model->patterns.push_back(std::move(pattern));
+        }));
+  }();
+  return *buffer;
+}
+
+// Runs the regex chunking over a text of the given size with many matches,
+// each verified by a lua verifier that reads the context. The context should
+// be copied to lua once per request, so the per-match cost should not depend
+// on the text size.
+void BM_RegexChunkLuaVerifierReadingContext(benchmark::State& state) {
+  static const RegexChunkingAnnotator* annotator =
+      RegexChunkingAnnotator::FromUnownedBuffer(
+          GetContextReadingLuaVerifierModel())
+          .release();
+  if (annotator == nullptr) {
+    state.SkipWithError("Could not load annotator model.");
+    return;
+  }
+  std::string text;
+  while (text.size() < static_cast<size_t>(state.range(0))) {
+    text += "call 12345678 ";
+  }
+  AnnotationCandidates candidates;
+  for (auto _ : state) {
+    candidates.Clear();
+    if (!annotator->RegexChunk(text, &candidates)) {
+      state.SkipWithError("Regex chunking failed.");
+      break;
+    }
+    benchmark::DoNotOptimize(candidates.size());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+  state.counters["matches"] = candidates.size();
+}
+BENCHMARK(BM_RegexChunkLuaVerifierReadingContext)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20);
+
+}  // namespace
+}  // namespace libtextclassifier3
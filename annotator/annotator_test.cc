@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/annotator.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "annotator/model_generated.h"
+#include "annotator/types-test-util.h"
+#include "utils/testing/annotator.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+std::string GetModelPath() { return TC3_TEST_DATA_DIR; }
+
+std::string ReadFile(const std::string& file_name) {
+  std::ifstream file_stream(file_name);
+  return std::string(std::istreambuf_iterator<char>(file_stream), {});
+}
+
+// Applies the edit to the text, with codepoint offsets.
+std::string ApplyEdit(const std::string& text, const TextEdit& edit) {
+  const UnicodeText text_unicode = UTF8ToUnicodeText(text, /*do_copy=*/false);
+  return text_unicode.UTF8Substring(0, edit.offset) + edit.inserted_text +
+         text_unicode.UTF8Substring(edit.offset + edit.removed_length,
+                                    text_unicode.size_codepoints());
+}
+
+// Spans and top collections of the annotations, for comparison.
+std::vector<std::pair<CodepointSpan, std::string>> SpansAndCollections(
+    const std::vector<AnnotatedSpan>& annotations) {
+  std::vector<std::pair<CodepointSpan, std::string>> result;
+  for (const AnnotatedSpan& annotation : annotations) {
+    result.push_back({annotation.span, annotation.classification.empty()
+                                           ? ""
+                                           : annotation.classification[0]
+                                                 .collection});
+  }
+  return result;
+}
+
+class AnnotateEditedTest : public testing::Test {
+ protected:
+  AnnotateEditedTest() : INIT_UNILIB_FOR_TESTING(unilib_) {
+    model_buffer_ = ModifyAnnotatorModel(
+        ReadFile(GetModelPath() + "test_model.fb"), [](ModelT* model) {
+          model->selection_feature_options->only_use_line_with_click = true;
+        });
+    classifier_ = Annotator::FromUnownedBuffer(
+        model_buffer_.data(), model_buffer_.size(), &unilib_);
+  }
+
+  // Checks that annotating the edited text incrementally gives the same
+  // result as annotating it from scratch.
+  void ExpectSameAsFullAnnotation(const std::string& text,
+                                  const TextEdit& edit) {
+    const std::string edited_text = ApplyEdit(text, edit);
+    const std::vector<AnnotatedSpan> expected =
+        classifier_->Annotate(edited_text);
+    const std::vector<AnnotatedSpan> incremental = classifier_->AnnotateEdited(
+        edited_text, classifier_->Annotate(text), edit);
+    EXPECT_EQ(SpansAndCollections(incremental), SpansAndCollections(expected))
+        << edited_text;
+  }
+
+  std::string model_buffer_;
+  UniLib unilib_;
+  std::unique_ptr<Annotator> classifier_;
+};
+
+TEST_F(AnnotateEditedTest, MatchesFullAnnotation) {
+  ASSERT_TRUE(classifier_);
+  const std::string text =
+      "Call me at (800) 123-456 today\n"
+      "or write to me@example.com\n"
+      "\n"
+      "I live at 350 Third Street, Cambridge | see you there\n"
+      "Second number is +41 79 123 45 67";
+
+  // Insertions.
+  ExpectSameAsFullAnnotation(text, {0, 0, "Hi! "});
+  ExpectSameAsFullAnnotation(text, {24, 0, "7"});
+  ExpectSameAsFullAnnotation(text, {31, 0, "Please "});
+  ExpectSameAsFullAnnotation(text, {58, 0, "\n"});
+  ExpectSameAsFullAnnotation(text, {112, 0, ", or (650) 555-0123"});
+
+  // Deletions.
+  ExpectSameAsFullAnnotation(text, {11, 5, ""});
+  ExpectSameAsFullAnnotation(text, {30, 1, ""});
+  ExpectSameAsFullAnnotation(text, {43, 14, ""});
+
+  // Replacements.
+  ExpectSameAsFullAnnotation(text, {43, 2, "you"});
+  ExpectSameAsFullAnnotation(text, {69, 3, "1600"});
+}
+
+TEST_F(AnnotateEditedTest, SequenceOfEditsMatchesFullAnnotation) {
+  ASSERT_TRUE(classifier_);
+  std::string text = "Number (800) 123-456\nMail me@example.com";
+  std::vector<AnnotatedSpan> annotations = classifier_->Annotate(text);
+  const std::vector<TextEdit> edits = {
+      {20, 0, "7"}, {0, 0, "My "}, {25, 0, "or "}, {11, 3, "650"}};
+  for (const TextEdit& edit : edits) {
+    text = ApplyEdit(text, edit);
+    annotations = classifier_->AnnotateEdited(text, annotations, edit);
+    EXPECT_EQ(SpansAndCollections(annotations),
+              SpansAndCollections(classifier_->Annotate(text)))
+        << text;
+  }
+}
+
+TEST_F(AnnotateEditedTest, FallsBackToFullAnnotationForInvalidEdit) {
+  ASSERT_TRUE(classifier_);
+  const std::string text = "Call me at (800) 123-456 today";
+  EXPECT_EQ(SpansAndCollections(
+                classifier_->AnnotateEdited(text, {}, {100, 0, "x"})),
+            SpansAndCollections(classifier_->Annotate(text)));
+}
+
+class AnnotateDeadlineTest : public testing::Test {
+ protected:
+  AnnotateDeadlineTest() : INIT_UNILIB_FOR_TESTING(unilib_) {
+    classifier_ = Annotator::FromPath(GetModelPath() + "test_model.fb",
+                                      &unilib_);
+  }
+
+  // Stages that run on kText without a deadline.
+  static constexpr int kRunStages = ANNOTATION_STAGE_MODEL |
+                                    ANNOTATION_STAGE_REGEX |
+                                    ANNOTATION_STAGE_DATETIME;
+  static constexpr char kText[] =
+      "Call me at (800) 123-456 today or on January 1, 2020 at 10:00";
+
+  UniLib unilib_;
+  std::unique_ptr<Annotator> classifier_;
+};
+
+constexpr char AnnotateDeadlineTest::kText[];
+
+TEST_F(AnnotateDeadlineTest, SkipsAllStagesOnceDeadlineExpired) {
+  ASSERT_TRUE(classifier_);
+  ASSERT_TRUE(classifier_->InitializeResultCache(ResultCacheOptions()));
+  AnnotationOptions options;
+  options.deadline = Deadline::InMilliseconds(0);
+  int skipped_stages = 0;
+  EXPECT_THAT(classifier_->Annotate(kText, options, &skipped_stages),
+              testing::IsEmpty());
+  EXPECT_EQ(skipped_stages & kRunStages, kRunStages);
+
+  // The partial result isn't cached.
+  EXPECT_EQ(classifier_->result_cache()->GetStats().num_entries, 0);
+  options.deadline = Deadline();
+  EXPECT_THAT(
+      SpansAndCollections(classifier_->Annotate(kText, options,
+                                                &skipped_stages)),
+      testing::Contains(testing::Pair(testing::_, "phone")));
+  EXPECT_EQ(skipped_stages, 0);
+  EXPECT_EQ(classifier_->result_cache()->GetStats().num_entries, 1);
+}
+
+TEST_F(AnnotateDeadlineTest, SkipsAllStagesOnceDeadlineCancelled) {
+  ASSERT_TRUE(classifier_);
+  AnnotationOptions options;
+  options.deadline = Deadline::Cancellable();
+  options.deadline.Cancel();
+  int skipped_stages = 0;
+  EXPECT_THAT(classifier_->Annotate(kText, options, &skipped_stages),
+              testing::IsEmpty());
+  EXPECT_EQ(skipped_stages & kRunStages, kRunStages);
+}
+
+TEST_F(AnnotateDeadlineTest, SkipsNoStagesBeforeDeadline) {
+  ASSERT_TRUE(classifier_);
+  const std::vector<std::pair<CodepointSpan, std::string>> expected =
+      SpansAndCollections(classifier_->Annotate(kText));
+  EXPECT_THAT(expected, testing::Contains(testing::Pair(testing::_, "phone")));
+
+  AnnotationOptions options;
+  options.deadline = Deadline::Cancellable();
+  int skipped_stages = -1;
+  const std::vector<AnnotatedSpan> annotations =
+      classifier_->Annotate(kText, options, &skipped_stages);
+  EXPECT_EQ(skipped_stages, 0);
+  EXPECT_EQ(SpansAndCollections(annotations), expected);
+
+  options.deadline = Deadline::InMilliseconds(/*timeout_ms=*/3600 * 1000);
+  skipped_stages = -1;
+  EXPECT_EQ(SpansAndCollections(
+                classifier_->Annotate(kText, options, &skipped_stages)),
+            expected);
+  EXPECT_EQ(skipped_stages, 0);
+}
+
+// Whenever the deadline expires, the annotations are complete if no stage is
+// reported as skipped or cut short.
+TEST_F(AnnotateDeadlineTest, ReportsStagesCutShort) {
+  ASSERT_TRUE(classifier_);
+  const std::vector<std::pair<CodepointSpan, std::string>> expected =
+      SpansAndCollections(classifier_->Annotate(kText));
+  for (int timeout_ms = 0; timeout_ms <= 8; ++timeout_ms) {
+    AnnotationOptions options;
+    options.deadline = Deadline::InMilliseconds(timeout_ms);
+    int skipped_stages = -1;
+    const std::vector<AnnotatedSpan> annotations =
+        classifier_->Annotate(kText, options, &skipped_stages);
+    EXPECT_GE(skipped_stages, 0);
+    if (skipped_stages == 0) {
+      EXPECT_EQ(SpansAndCollections(annotations), expected) << timeout_ms;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/datetime/extractor-lexicon.h"
+
+#include <algorithm>
+
+#include "utils/base/logging.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Codepoints outside of ASCII whose case folding is ASCII, e.g. U+00DF to "ss".
+const char32 kFoldsToAscii[] = {
+    0x00DF, 0x017F, 0x1E9E, 0x212A, 0xFB00, 0xFB01,
+    0xFB02, 0xFB03, 0xFB04, 0xFB05, 0xFB06,
+};
+
+bool FoldsToAscii(char32 codepoint) {
+  return std::find(std::begin(kFoldsToAscii), std::end(kFoldsToAscii),
+                   codepoint) != std::end(kFoldsToAscii);
+}
+
+// Returns whether the codepoint is in a script without case: Arabic, Thai,
+// CJK and Hangul.
+bool IsCaseless(char32 codepoint) {
+  return (codepoint >= 0x0600 && codepoint <= 0x06FF) ||
+         (codepoint >= 0x0E00 && codepoint <= 0x0E7F) ||
+         (codepoint >= 0x3000 && codepoint <= 0x9FFF) ||
+         (codepoint >= 0xAC00 && codepoint <= 0xD7AF);
+}
+
+// Returns whether a text with the codepoint can be looked up in the lexicon.
+bool IsLexiconCodepoint(char32 codepoint) {
+  if (codepoint >= 0 && codepoint < 0x80) {
+    return codepoint < '\n' || codepoint > '\r';
+  }
+  return IsCaseless(codepoint);
+}
+
+char32 ToLowerAscii(char32 codepoint) {
+  return (codepoint >= 'A' && codepoint <= 'Z') ? codepoint - 'A' + 'a'
+                                                : codepoint;
+}
+
+bool IsAsciiAlnum(char32 codepoint) {
+  return (codepoint >= '0' && codepoint <= '9') ||
+         (codepoint >= 'a' && codepoint <= 'z') ||
+         (codepoint >= 'A' && codepoint <= 'Z');
+}
+
+bool IsMetachar(char32 codepoint) {
+  switch (codepoint) {
+    case '\\':
+    case '^':
+    case '$':
+    case '.':
+    case '|':
+    case '?':
+    case '*':
+    case '+':
+    case '(':
+    case ')':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Expands the pattern of a rule to the words it matches. Fails on the syntax
+// that is not supported by the lexicon.
+class RuleParser {
+ public:
+  explicit RuleParser(const std::string& pattern) {
+    const UnicodeText unicode_pattern =
+        UTF8ToUnicodeText(pattern, /*do_copy=*/false);
+    pattern_.assign(unicode_pattern.begin(), unicode_pattern.end());
+  }
+
+  bool Parse(std::vector<std::string>* words) {
+    return ConsumeString("^(?i:") && ParseAlternation(words) &&
+           ConsumeString(")$") && pos_ == pattern_.size();
+  }
+
+ private:
+  bool AtEnd() const { return pos_ >= pattern_.size(); }
+
+  char32 Peek(int offset = 0) const {
+    return pos_ + offset < pattern_.size() ? pattern_[pos_ + offset] : 0;
+  }
+
+  bool Consume(char32 codepoint) {
+    if (AtEnd() || pattern_[pos_] != codepoint) {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  bool ConsumeString(const char* ascii) {
+    for (; *ascii != '\0'; ++ascii) {
+      if (!Consume(*ascii)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool ParseAlternation(std::vector<std::string>* words) {
+    if (!ParseSequence(words)) {
+      return false;
+    }
+    while (Consume('|')) {
+      std::vector<std::string> alternative;
+      if (!ParseSequence(&alternative)) {
+        return false;
+      }
+      if (words->size() + alternative.size() >
+          DatetimeExtractorLexicon::kMaxWordsPerRule) {
+        return false;
+      }
+      words->insert(words->end(), alternative.begin(), alternative.end());
+    }
+    return true;
+  }
+
+  bool ParseSequence(std::vector<std::string>* words) {
+    words->assign(1, std::string());
+    while (!AtEnd() && Peek() != '|' && Peek() != ')') {
+      std::vector<std::string> atom;
+      if (!ParseAtom(&atom)) {
+        return false;
+      }
+      if (Consume('?')) {
+        atom.push_back(std::string());
+      }
+      // Lazy and possessive quantifiers and repetitions.
+      if (Peek() == '?' || Peek() == '*' || Peek() == '+' || Peek() == '{') {
+        return false;
+      }
+      if (static_cast<int64>(words->size()) * atom.size() >
+          DatetimeExtractorLexicon::kMaxWordsPerRule) {
+        return false;
+      }
+      std::vector<std::string> sequence;
+      sequence.reserve(words->size() * atom.size());
+      for (const std::string& prefix : *words) {
+        for (const std::string& suffix : atom) {
+          sequence.push_back(prefix + suffix);
+        }
+      }
+      words->swap(sequence);
+    }
+    return true;
+  }
+
+  bool ParseAtom(std::vector<std::string>* words) {
+    if (Consume('(')) {
+      if (Consume('?') && !Consume(':')) {
+        return false;
+      }
+      return ParseAlternation(words) && Consume(')');
+    }
+    if (Consume('[')) {
+      return ParseClass(words);
+    }
+    char32 codepoint;
+    if (!ParseLiteral(&codepoint)) {
+      return false;
+    }
+    return AddCodepoint(codepoint, words);
+  }
+
+  // Parses a class of literals and ranges, e.g. [a-c\.].
+  bool ParseClass(std::vector<std::string>* words) {
+    if (Peek() == '^') {
+      return false;
+    }
+    std::vector<char32> codepoints;
+    while (!Consume(']')) {
+      char32 first;
+      if (Peek() == '-' && (codepoints.empty() || Peek(1) == ']')) {
+        first = '-';
+        ++pos_;
+      } else if (!ParseClassLiteral(&first)) {
+        return false;
+      }
+      char32 last = first;
+      if (Peek() == '-' && Peek(1) != ']') {
+        ++pos_;
+        if (!ParseClassLiteral(&last) || last < first) {
+          return false;
+        }
+      }
+      if (static_cast<int64>(codepoints.size()) + last - first >=
+          DatetimeExtractorLexicon::kMaxWordsPerRule) {
+        return false;
+      }
+      for (char32 codepoint = first; codepoint <= last; ++codepoint) {
+        codepoints.push_back(codepoint);
+      }
+    }
+    if (codepoints.empty()) {
+      return false;
+    }
+    for (const char32 codepoint : codepoints) {
+      if (!AddCodepoint(codepoint, words)) {
+        return false;
+      }
+    }
+    std::sort(words->begin(), words->end());
+    words->erase(std::unique(words->begin(), words->end()), words->end());
+    return true;
+  }
+
+  // Parses a literal or escaped punctuation.
+  bool ParseLiteral(char32* codepoint) {
+    if (AtEnd()) {
+      return false;
+    }
+    if (Consume('\\')) {
+      *codepoint = Peek();
+      ++pos_;
+      return *codepoint > 0 && *codepoint < 0x80 && !IsAsciiAlnum(*codepoint);
+    }
+    *codepoint = Peek();
+    ++pos_;
+    return !IsMetachar(*codepoint);
+  }
+
+  // Like ParseLiteral, but only allows letters, digits and non-ASCII
+  // codepoints unescaped.
+  bool ParseClassLiteral(char32* codepoint) {
+    if (Peek() != '\\' && Peek() < 0x80 && !IsAsciiAlnum(Peek())) {
+      return false;
+    }
+    return ParseLiteral(codepoint);
+  }
+
+  // Adds the word of the codepoint. Codepoints that never are in a looked up
+  // text don't add a word.
+  bool AddCodepoint(char32 codepoint, std::vector<std::string>* words) {
+    if (FoldsToAscii(codepoint)) {
+      return false;
+    }
+    if (IsLexiconCodepoint(codepoint)) {
+      words->emplace_back();
+      AppendUTF8(ToLowerAscii(codepoint), &words->back());
+    }
+    return true;
+  }
+
+  std::vector<char32> pattern_;
+  int pos_ = 0;
+};
+
+}  // namespace
+
+DatetimeExtractorLexicon::DatetimeExtractorLexicon(
+    const std::vector<std::string>& patterns)
+    : supported_rules_(patterns.size(), false) {
+  for (int rule_id = 0; rule_id < patterns.size(); ++rule_id) {
+    std::vector<std::string> words;
+    if (!RuleParser(patterns[rule_id]).Parse(&words)) {
+      TC3_VLOG(1) << "Datetime extractor rule " << rule_id
+                  << " is not supported by the lexicon.";
+      continue;
+    }
+    supported_rules_[rule_id] = true;
+    ++num_supported_rules_;
+    for (const std::string& word : words) {
+      std::vector<int>& rule_ids = rules_for_word_[word];
+      if (rule_ids.empty() || rule_ids.back() != rule_id) {
+        rule_ids.push_back(rule_id);
+      }
+    }
+  }
+}
+
+const std::vector<int>* DatetimeExtractorLexicon::Match(
+    const UnicodeText& text) const {
+  if (!text.is_valid()) {
+    return nullptr;
+  }
+  std::string word;
+  for (const char32 codepoint : text) {
+    if (!IsLexiconCodepoint(codepoint)) {
+      return nullptr;
+    }
+    AppendUTF8(ToLowerAscii(codepoint), &word);
+  }
+  const auto it = rules_for_word_.find(word);
+  return it != rules_for_word_.end() ? &it->second : &no_rules_;
+}
+
+}  // namespace libtextclassifier3
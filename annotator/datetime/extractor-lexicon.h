@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBTEXTCLASSIFIER_ANNOTATOR_DATETIME_EXTRACTOR_LEXICON_H_
+#define LIBTEXTCLASSIFIER_ANNOTATOR_DATETIME_EXTRACTOR_LEXICON_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/base/integral_types.h"
+#include "utils/utf8/unicodetext.h"
+
+namespace libtextclassifier3 {
+
+// A lexicon of the words matched by the datetime extractor rules, that looks up
+// all the rules matching a group text with one hash lookup instead of running
+// the regex of each rule on it.
+//
+// Only rules of the form ^(?i:...)$ whose body is a finite alternation of
+// literals are supported: the body may only use literals, escaped punctuation,
+// groups, alternation, '?' and character classes with ranges. The words of a
+// rule are all the strings it matches, with ASCII lowercased.
+//
+// A text is only looked up if all its codepoints are ASCII (but the line
+// terminators that '$' matches before) or in scripts without case, since the
+// lexicon can't reproduce the case insensitive matching of the regexes for the
+// other codepoints. Rules using a codepoint that case folds to ASCII (e.g.
+// U+00DF to "ss") are not supported for the same reason.
+class DatetimeExtractorLexicon {
+ public:
+  // Maximum number of words of a rule.
+  static constexpr int kMaxWordsPerRule = 1 << 12;
+
+  // 'patterns' are the patterns of the extractor rules, indexed by rule id.
+  explicit DatetimeExtractorLexicon(const std::vector<std::string>& patterns);
+
+  // Returns whether the matches of the rule are looked up in the lexicon.
+  bool IsSupported(int rule_id) const {
+    return rule_id >= 0 && rule_id < supported_rules_.size() &&
+           supported_rules_[rule_id];
+  }
+
+  // Returns the sorted ids of the supported rules that match 'text', or
+  // nullptr if 'text' can't be looked up and the rules need to be matched with
+  // their regexes.
+  const std::vector<int>* Match(const UnicodeText& text) const;
+
+  int num_supported_rules() const { return num_supported_rules_; }
+  int num_words() const { return rules_for_word_.size(); }
+
+ private:
+  std::vector<bool> supported_rules_;
+  int num_supported_rules_ = 0;
+  std::unordered_map<std::string, std::vector<int>> rules_for_word_;
+  const std::vector<int> no_rules_;
+};
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_ANNOTATOR_DATETIME_EXTRACTOR_LEXICON_H_
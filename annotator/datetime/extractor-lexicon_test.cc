@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/datetime/extractor-lexicon.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::Pointee;
+
+const std::vector<int>* Match(const DatetimeExtractorLexicon& lexicon,
+                              const std::string& text) {
+  return lexicon.Match(UTF8ToUnicodeText(text, /*do_copy=*/false));
+}
+
+TEST(DatetimeExtractorLexiconTest, MatchesWordsOfRules) {
+  const DatetimeExtractorLexicon lexicon(
+      {"^(?i:mo(?:n(?:day)?|\\.)?|lun(?:es|\\.)?)$",
+       "^(?i:tue(?:s|sday)?|d[ie]\\.?)$", "^(?i:ma[iy]|mayo)$",
+       "^(?i:may|m[aä]rz|mar(?:\\.|ch)?)$"});
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(lexicon.IsSupported(i));
+  }
+
+  EXPECT_THAT(Match(lexicon, "mon"), Pointee(ElementsAre(0)));
+  EXPECT_THAT(Match(lexicon, "Monday"), Pointee(ElementsAre(0)));
+  EXPECT_THAT(Match(lexicon, "MO."), Pointee(ElementsAre(0)));
+  EXPECT_THAT(Match(lexicon, "mo"), Pointee(ElementsAre(0)));
+  EXPECT_THAT(Match(lexicon, "Lunes"), Pointee(ElementsAre(0)));
+  EXPECT_THAT(Match(lexicon, "tues"), Pointee(ElementsAre(1)));
+  EXPECT_THAT(Match(lexicon, "Di."), Pointee(ElementsAre(1)));
+  EXPECT_THAT(Match(lexicon, "de"), Pointee(ElementsAre(1)));
+  EXPECT_THAT(Match(lexicon, "MAY"), Pointee(ElementsAre(2, 3)));
+  EXPECT_THAT(Match(lexicon, "Mai"), Pointee(ElementsAre(2)));
+  EXPECT_THAT(Match(lexicon, "marz"), Pointee(ElementsAre(3)));
+  EXPECT_THAT(Match(lexicon, "March"), Pointee(ElementsAre(3)));
+
+  // The rules are anchored at both ends.
+  EXPECT_THAT(Match(lexicon, "mond"), Pointee(IsEmpty()));
+  EXPECT_THAT(Match(lexicon, "monday."), Pointee(IsEmpty()));
+  EXPECT_THAT(Match(lexicon, " mon"), Pointee(IsEmpty()));
+  EXPECT_THAT(Match(lexicon, "d"), Pointee(IsEmpty()));
+  EXPECT_THAT(Match(lexicon, ""), Pointee(IsEmpty()));
+}
+
+TEST(DatetimeExtractorLexiconTest, MatchesCaselessScripts) {
+  const DatetimeExtractorLexicon lexicon(
+      {"^(?i:星期二|周二|火曜日|화요일|الثلاثاء|ث|วันอังคาร|อ\\.?)$",
+       "^(?i:[ث-خ]|[月월])$"});
+  EXPECT_TRUE(lexicon.IsSupported(0));
+  EXPECT_TRUE(lexicon.IsSupported(1));
+
+  EXPECT_THAT(Match(lexicon, "星期二"), Pointee(ElementsAre(0)));
+  EXPECT_THAT(Match(lexicon, "화요일"), Pointee(ElementsAre(0)));
+  EXPECT_THAT(Match(lexicon, "อ."), Pointee(ElementsAre(0)));
+  EXPECT_THAT(Match(lexicon, "ث"), Pointee(ElementsAre(0, 1)));
+  EXPECT_THAT(Match(lexicon, "خ"), Pointee(ElementsAre(1)));
+  EXPECT_THAT(Match(lexicon, "월"), Pointee(ElementsAre(1)));
+  EXPECT_THAT(Match(lexicon, "星期"), Pointee(IsEmpty()));
+}
+
+TEST(DatetimeExtractorLexiconTest, DoesNotLookUpTextsWithCasedLetters) {
+  const DatetimeExtractorLexicon lexicon({"^(?i:m[aä]rz|вт|tue)$"});
+  EXPECT_TRUE(lexicon.IsSupported(0));
+
+  EXPECT_THAT(Match(lexicon, "MARZ"), Pointee(ElementsAre(0)));
+  EXPECT_EQ(Match(lexicon, "märz"), nullptr);
+  EXPECT_EQ(Match(lexicon, "MÄRZ"), nullptr);
+  EXPECT_EQ(Match(lexicon, "Вт"), nullptr);
+
+  // '$' also matches before a final line terminator.
+  EXPECT_EQ(Match(lexicon, "tue\n"), nullptr);
+  EXPECT_EQ(Match(lexicon, "tue\r"), nullptr);
+
+  EXPECT_EQ(Match(lexicon, "\xff"), nullptr);
+}
+
+TEST(DatetimeExtractorLexiconTest, ReportsUnsupportedRules) {
+  const DatetimeExtractorLexicon lexicon(
+      {"^(?i:\\d{1,2}|\\d{4})$", "^(?i:a+)$", "(?i:tue)", "^tue$",
+       "^(?i:stra[ßs]e)$", "^(?i:[^a])$", "^(?i:d.)$", "^(?i:(?=a)a)$",
+       "^(?i:a?\?)$", "^(?i:[a-z&&[^x]])$", "^(?i:\\p{Lu})$", "^(?i:(a)$",
+       "^(?i:a)b)$", "^(?i:[a-zA-Z]{4})$", "^(?i:tue)$"});
+  for (int i = 0; i < 14; ++i) {
+    EXPECT_FALSE(lexicon.IsSupported(i)) << i;
+  }
+  EXPECT_TRUE(lexicon.IsSupported(14));
+  EXPECT_FALSE(lexicon.IsSupported(15));
+  EXPECT_FALSE(lexicon.IsSupported(-1));
+  EXPECT_EQ(lexicon.num_supported_rules(), 1);
+
+  EXPECT_THAT(Match(lexicon, "12"), Pointee(IsEmpty()));
+  EXPECT_THAT(Match(lexicon, "TUE"), Pointee(ElementsAre(14)));
+}
+
+TEST(DatetimeExtractorLexiconTest, LimitsTheNumberOfWords) {
+  // 10^4 words.
+  const DatetimeExtractorLexicon lexicon(
+      {"^(?i:[0-9][0-9][0-9][0-9])$", "^(?i:[0-9][0-9][0-9])$"});
+  EXPECT_FALSE(lexicon.IsSupported(0));
+  EXPECT_TRUE(lexicon.IsSupported(1));
+  EXPECT_EQ(lexicon.num_words(), 1000);
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -16,6 +16,8 @@
 
 #include "annotator/datetime/extractor.h"
 
+#include <algorithm>
+
 #include "utils/base/logging.h"
 
 namespace libtextclassifier3 {
@@ -44,9 +46,12 @@ bool DatetimeExtractor::Extract(DateParseData* result,
     if (group_text.empty()) {
       continue;
     }
+    // The group text is looked up and converted once for all the extractor
+    // rules.
+    const GroupText input(group_text, unilib_, lexicon_);
     switch (group_type) {
       case DatetimeGroupType_GROUP_YEAR: {
-        if (!ParseYear(group_text, &(result->year))) {
+        if (!ParseYear(input, &(result->year))) {
           TC3_LOG(ERROR) << "Couldn't extract YEAR.";
           return false;
         }
@@ -54,7 +59,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_MONTH: {
-        if (!ParseMonth(group_text, &(result->month))) {
+        if (!ParseMonth(input, &(result->month))) {
           TC3_LOG(ERROR) << "Couldn't extract MONTH.";
           return false;
         }
@@ -62,7 +67,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_DAY: {
-        if (!ParseDigits(group_text, &(result->day_of_month))) {
+        if (!ParseDigits(input, &(result->day_of_month))) {
           TC3_LOG(ERROR) << "Couldn't extract DAY.";
           return false;
         }
@@ -70,7 +75,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_HOUR: {
-        if (!ParseDigits(group_text, &(result->hour))) {
+        if (!ParseDigits(input, &(result->hour))) {
           TC3_LOG(ERROR) << "Couldn't extract HOUR.";
           return false;
         }
@@ -78,7 +83,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_MINUTE: {
-        if (!ParseDigits(group_text, &(result->minute))) {
+        if (!ParseDigits(input, &(result->minute))) {
           TC3_LOG(ERROR) << "Couldn't extract MINUTE.";
           return false;
         }
@@ -86,7 +91,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_SECOND: {
-        if (!ParseDigits(group_text, &(result->second))) {
+        if (!ParseDigits(input, &(result->second))) {
           TC3_LOG(ERROR) << "Couldn't extract SECOND.";
           return false;
         }
@@ -94,7 +99,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_AMPM: {
-        if (!ParseAMPM(group_text, &(result->ampm))) {
+        if (!ParseAMPM(input, &(result->ampm))) {
           TC3_LOG(ERROR) << "Couldn't extract AMPM.";
           return false;
         }
@@ -102,7 +107,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_RELATIONDISTANCE: {
-        if (!ParseRelationDistance(group_text, &(result->relation_distance))) {
+        if (!ParseRelationDistance(input, &(result->relation_distance))) {
           TC3_LOG(ERROR) << "Couldn't extract RELATION_DISTANCE_FIELD.";
           return false;
         }
@@ -110,7 +115,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_RELATION: {
-        if (!ParseRelation(group_text, &(result->relation))) {
+        if (!ParseRelation(input, &(result->relation))) {
           TC3_LOG(ERROR) << "Couldn't extract RELATION_FIELD.";
           return false;
         }
@@ -118,7 +123,7 @@ bool DatetimeExtractor::Extract(DateParseData* result,
         break;
       }
       case DatetimeGroupType_GROUP_RELATIONTYPE: {
-        if (!ParseRelationType(group_text, &(result->relation_type))) {
+        if (!ParseRelationType(input, &(result->relation_type))) {
           TC3_LOG(ERROR) << "Couldn't extract RELATION_TYPE_FIELD.";
           return false;
         }
@@ -161,7 +166,40 @@ bool DatetimeExtractor::RuleIdForType(DatetimeExtractorType type,
   return true;
 }
 
-bool DatetimeExtractor::ExtractType(const UnicodeText& input,
+const std::vector<int>* DatetimeExtractor::GroupText::LexiconMatches() const {
+  if (!looked_up_) {
+    lexicon_matches_ = lexicon_.Match(text_);
+    looked_up_ = true;
+  }
+  return lexicon_matches_;
+}
+
+const UniLib::PreparedText* DatetimeExtractor::GroupText::Prepared() const {
+  if (!prepare_attempted_) {
+    prepared_text_ = unilib_.PrepareText(text_);
+    if (!prepared_text_) {
+      TC3_LOG(ERROR) << "Couldn't prepare group.";
+    }
+    prepare_attempted_ = true;
+  }
+  return prepared_text_.get();
+}
+
+bool DatetimeExtractor::LookUpRule(const GroupText& input, int rule_id,
+                                   bool* matched) const {
+  if (!lexicon_.IsSupported(rule_id)) {
+    return false;
+  }
+  const std::vector<int>* matching_rule_ids = input.LexiconMatches();
+  if (matching_rule_ids == nullptr) {
+    return false;
+  }
+  *matched = std::binary_search(matching_rule_ids->begin(),
+                                matching_rule_ids->end(), rule_id);
+  return true;
+}
+
+bool DatetimeExtractor::ExtractType(const GroupText& input,
                                     DatetimeExtractorType extractor_type,
                                     UnicodeText* match_result) const {
   int rule_id;
@@ -169,8 +207,21 @@ bool DatetimeExtractor::ExtractType(const UnicodeText& input,
     return false;
   }
 
+  bool matched;
+  if (LookUpRule(input, rule_id, &matched)) {
+    // The lexicon rules can only match the whole input.
+    if (matched && match_result != nullptr) {
+      *match_result = UnicodeText(input.text());
+    }
+    return matched;
+  }
+
+  const UniLib::PreparedText* prepared_input = input.Prepared();
+  if (prepared_input == nullptr) {
+    return false;
+  }
   std::unique_ptr<UniLib::RegexMatcher> matcher =
-      rules_[rule_id]->Matcher(input);
+      rules_[rule_id]->Matcher(*prepared_input);
   if (!matcher) {
     return false;
   }
@@ -222,7 +273,7 @@ bool DatetimeExtractor::UpdateMatchSpan(int group_id,
 
 template <typename T>
 bool DatetimeExtractor::MapInput(
-    const UnicodeText& input,
+    const GroupText& input,
     const std::vector<std::pair<DatetimeExtractorType, T>>& mapping,
     T* result) const {
   for (const auto& type_value_pair : mapping) {
@@ -234,7 +285,7 @@ bool DatetimeExtractor::MapInput(
   return false;
 }
 
-bool DatetimeExtractor::ParseWrittenNumber(const UnicodeText& input,
+bool DatetimeExtractor::ParseWrittenNumber(const GroupText& input,
                                            int* parsed_number) const {
   std::vector<std::pair<int, int>> found_numbers;
   for (const auto& type_value_pair :
@@ -275,8 +326,20 @@ bool DatetimeExtractor::ParseWrittenNumber(const UnicodeText& input,
       return false;
     }
 
+    bool matched;
+    if (LookUpRule(input, rule_id, &matched)) {
+      if (matched) {
+        found_numbers.push_back({0, type_value_pair.second});
+      }
+      continue;
+    }
+
+    const UniLib::PreparedText* prepared_input = input.Prepared();
+    if (prepared_input == nullptr) {
+      return false;
+    }
     std::unique_ptr<UniLib::RegexMatcher> matcher =
-        rules_[rule_id]->Matcher(input);
+        rules_[rule_id]->Matcher(*prepared_input);
     if (!matcher) {
       return false;
     }
@@ -317,7 +380,7 @@ bool DatetimeExtractor::ParseWrittenNumber(const UnicodeText& input,
   return true;
 }
 
-bool DatetimeExtractor::ParseDigits(const UnicodeText& input,
+bool DatetimeExtractor::ParseDigits(const GroupText& input,
                                     int* parsed_digits) const {
   UnicodeText digit;
   if (!ExtractType(input, DatetimeExtractorType_DIGITS, &digit)) {
@@ -330,7 +393,7 @@ bool DatetimeExtractor::ParseDigits(const UnicodeText& input,
   return true;
 }
 
-bool DatetimeExtractor::ParseYear(const UnicodeText& input,
+bool DatetimeExtractor::ParseYear(const GroupText& input,
                                   int* parsed_year) const {
   if (!ParseDigits(input, parsed_year)) {
     return false;
@@ -347,7 +410,7 @@ bool DatetimeExtractor::ParseYear(const UnicodeText& input,
   return true;
 }
 
-bool DatetimeExtractor::ParseMonth(const UnicodeText& input,
+bool DatetimeExtractor::ParseMonth(const GroupText& input,
                                    int* parsed_month) const {
   if (ParseDigits(input, parsed_month)) {
     return true;
@@ -375,7 +438,7 @@ bool DatetimeExtractor::ParseMonth(const UnicodeText& input,
   return false;
 }
 
-bool DatetimeExtractor::ParseAMPM(const UnicodeText& input,
+bool DatetimeExtractor::ParseAMPM(const GroupText& input,
                                   DateParseData::AMPM* parsed_ampm) const {
   return MapInput(input,
                   {
@@ -385,7 +448,7 @@ bool DatetimeExtractor::ParseAMPM(const UnicodeText& input,
                   parsed_ampm);
 }
 
-bool DatetimeExtractor::ParseRelationDistance(const UnicodeText& input,
+bool DatetimeExtractor::ParseRelationDistance(const GroupText& input,
                                               int* parsed_distance) const {
   if (ParseDigits(input, parsed_distance)) {
     return true;
@@ -397,7 +460,8 @@ bool DatetimeExtractor::ParseRelationDistance(const UnicodeText& input,
 }
 
 bool DatetimeExtractor::ParseRelation(
-    const UnicodeText& input, DateParseData::Relation* parsed_relation) const {
+    const GroupText& input,
+    DateParseData::Relation* parsed_relation) const {
   return MapInput(
       input,
       {
@@ -415,7 +479,7 @@ bool DatetimeExtractor::ParseRelation(
 }
 
 bool DatetimeExtractor::ParseRelationType(
-    const UnicodeText& input,
+    const GroupText& input,
     DateParseData::RelationType* parsed_relation_type) const {
   return MapInput(
       input,
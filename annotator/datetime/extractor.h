@@ -17,10 +17,12 @@
 #ifndef LIBTEXTCLASSIFIER_ANNOTATOR_DATETIME_EXTRACTOR_H_
 #define LIBTEXTCLASSIFIER_ANNOTATOR_DATETIME_EXTRACTOR_H_
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "annotator/datetime/extractor-lexicon.h"
 #include "annotator/model_generated.h"
 #include "annotator/types.h"
 #include "utils/strings/stringpiece.h"
@@ -51,22 +53,55 @@ class DatetimeExtractor {
           extractor_rules,
       const std::unordered_map<DatetimeExtractorType,
                                std::unordered_map<int, int>>&
-          type_and_locale_to_extractor_rule)
+          type_and_locale_to_extractor_rule,
+      const DatetimeExtractorLexicon& extractor_lexicon)
       : rule_(rule),
         matcher_(matcher),
         locale_id_(locale_id),
         unilib_(unilib),
         rules_(extractor_rules),
-        type_and_locale_to_rule_(type_and_locale_to_extractor_rule) {}
+        type_and_locale_to_rule_(type_and_locale_to_extractor_rule),
+        lexicon_(extractor_lexicon) {}
   bool Extract(DateParseData* result, CodepointSpan* result_span) const;
 
  private:
+  // The text of a group. It is looked up in the lexicon and converted for the
+  // regexes of the extractor rules at most once, when first needed.
+  class GroupText {
+   public:
+    GroupText(const UnicodeText& text, const UniLib& unilib,
+              const DatetimeExtractorLexicon& lexicon)
+        : text_(text), unilib_(unilib), lexicon_(lexicon) {}
+
+    const UnicodeText& text() const { return text_; }
+
+    // Returns the ids of the lexicon rules that match the text, nullptr if the
+    // text can't be looked up in the lexicon.
+    const std::vector<int>* LexiconMatches() const;
+
+    // Returns nullptr if the text couldn't be converted.
+    const UniLib::PreparedText* Prepared() const;
+
+   private:
+    const UnicodeText& text_;
+    const UniLib& unilib_;
+    const DatetimeExtractorLexicon& lexicon_;
+    mutable bool looked_up_ = false;
+    mutable const std::vector<int>* lexicon_matches_ = nullptr;
+    mutable bool prepare_attempted_ = false;
+    mutable std::unique_ptr<UniLib::PreparedText> prepared_text_;
+  };
+
   bool RuleIdForType(DatetimeExtractorType type, int* rule_id) const;
 
+  // Returns true if the rule is in the lexicon and the input can be looked up
+  // in it. If so, 'matched' is set to whether the rule matches the input.
+  bool LookUpRule(const GroupText& input, int rule_id, bool* matched) const;
+
   // Returns true if the rule for given extractor matched. If it matched,
   // match_result will contain the first group of the rule (if match_result not
   // nullptr).
-  bool ExtractType(const UnicodeText& input,
+  bool ExtractType(const GroupText& input,
                    DatetimeExtractorType extractor_type,
                    UnicodeText* match_result = nullptr) const;
 
@@ -78,26 +113,26 @@ class DatetimeExtractor {
   // Returns true if any of the extractors from 'mapping' matched. If it did,
   // will fill 'result' with the associated value from 'mapping'.
   template <typename T>
-  bool MapInput(const UnicodeText& input,
+  bool MapInput(const GroupText& input,
                 const std::vector<std::pair<DatetimeExtractorType, T>>& mapping,
                 T* result) const;
 
-  bool ParseDigits(const UnicodeText& input, int* parsed_digits) const;
-  bool ParseWrittenNumber(const UnicodeText& input, int* parsed_number) const;
-  bool ParseYear(const UnicodeText& input, int* parsed_year) const;
-  bool ParseMonth(const UnicodeText& input, int* parsed_month) const;
-  bool ParseAMPM(const UnicodeText& input,
+  bool ParseDigits(const GroupText& input, int* parsed_digits) const;
+  bool ParseWrittenNumber(const GroupText& input, int* parsed_number) const;
+  bool ParseYear(const GroupText& input, int* parsed_year) const;
+  bool ParseMonth(const GroupText& input, int* parsed_month) const;
+  bool ParseAMPM(const GroupText& input,
                  DateParseData::AMPM* parsed_ampm) const;
-  bool ParseRelation(const UnicodeText& input,
+  bool ParseRelation(const GroupText& input,
                      DateParseData::Relation* parsed_relation) const;
-  bool ParseRelationDistance(const UnicodeText& input,
+  bool ParseRelationDistance(const GroupText& input,
                              int* parsed_distance) const;
-  bool ParseTimeUnit(const UnicodeText& input,
+  bool ParseTimeUnit(const GroupText& input,
                      DateParseData::TimeUnit* parsed_time_unit) const;
   bool ParseRelationType(
-      const UnicodeText& input,
+      const GroupText& input,
       DateParseData::RelationType* parsed_relation_type) const;
-  bool ParseWeekday(const UnicodeText& input,
+  bool ParseWeekday(const GroupText& input,
                     DateParseData::RelationType* parsed_weekday) const;
 
   const CompiledRule& rule_;
@@ -107,6 +142,7 @@ class DatetimeExtractor {
   const std::vector<std::unique_ptr<const UniLib::RegexPattern>>& rules_;
   const std::unordered_map<DatetimeExtractorType, std::unordered_map<int, int>>&
       type_and_locale_to_rule_;
+  const DatetimeExtractorLexicon& lexicon_;
 };
 
 }  // namespace libtextclassifier3
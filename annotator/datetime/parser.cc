@@ -70,17 +70,20 @@ DatetimeParser::DatetimeParser(const DatetimeModel* model, const UniLib& unilib,
     }
   }
 
+  std::vector<std::string> extractor_patterns;
   if (model->extractors() != nullptr) {
     for (const DatetimeModelExtractor* extractor : *model->extractors()) {
+      std::string pattern;
       std::unique_ptr<UniLib::RegexPattern> regex_pattern =
           UncompressMakeRegexPattern(
               unilib, extractor->pattern(), extractor->compressed_pattern(),
-              model->lazy_regex_compilation(), decompressor);
+              model->lazy_regex_compilation(), decompressor, &pattern);
       if (!regex_pattern) {
         TC3_LOG(ERROR) << "Couldn't create extractor pattern";
         return;
       }
       extractor_rules_.push_back(std::move(regex_pattern));
+      extractor_patterns.push_back(std::move(pattern));
 
       if (extractor->locales()) {
         for (int locale : *extractor->locales()) {
@@ -91,6 +94,8 @@ DatetimeParser::DatetimeParser(const DatetimeModel* model, const UniLib& unilib,
     }
   }
 
+  extractor_lexicon_.reset(new DatetimeExtractorLexicon(extractor_patterns));
+
   if (model->locales() != nullptr) {
     for (int i = 0; i < model->locales()->Length(); ++i) {
       locale_string_to_id_[model->locales()->Get(i)->str()] = i;
@@ -114,19 +119,22 @@ bool DatetimeParser::Parse(
     const std::string& input, const int64 reference_time_ms_utc,
     const std::string& reference_timezone, const std::string& locales,
     ModeFlag mode, AnnotationUsecase annotation_usecase, bool anchor_start_end,
-    std::vector<DatetimeParseResultSpan>* results) const {
+    std::vector<DatetimeParseResultSpan>* results, const Deadline& deadline,
+    bool* stopped_early) const {
   return Parse(UTF8ToUnicodeText(input, /*do_copy=*/false),
                reference_time_ms_utc, reference_timezone, locales, mode,
-               annotation_usecase, anchor_start_end, results);
+               annotation_usecase, anchor_start_end, results, deadline,
+               stopped_early);
 }
 
 bool DatetimeParser::FindSpansUsingLocales(
-    const std::vector<int>& locale_ids, const UnicodeText& input,
+    const std::vector<int>& locale_ids, const UniLib::PreparedText& input,
     const int64 reference_time_ms_utc, const std::string& reference_timezone,
     ModeFlag mode, AnnotationUsecase annotation_usecase, bool anchor_start_end,
-    const std::string& reference_locale,
+    const std::string& reference_locale, const Deadline& deadline,
     std::unordered_set<int>* executed_rules,
-    std::vector<DatetimeParseResultSpan>* found_spans) const {
+    std::vector<DatetimeParseResultSpan>* found_spans,
+    bool* stopped_early) const {
   for (const int locale_id : locale_ids) {
     auto rules_it = locale_to_rules_.find(locale_id);
     if (rules_it == locale_to_rules_.end()) {
@@ -148,6 +156,11 @@ bool DatetimeParser::FindSpansUsingLocales(
         continue;
       }
 
+      if (deadline.Expired()) {
+        *stopped_early = true;
+        return true;
+      }
+
       executed_rules->insert(rule_id);
 
       if (!ParseWithRule(rules_[rule_id], input, reference_time_ms_utc,
@@ -164,18 +177,30 @@ bool DatetimeParser::Parse(
     const UnicodeText& input, const int64 reference_time_ms_utc,
     const std::string& reference_timezone, const std::string& locales,
     ModeFlag mode, AnnotationUsecase annotation_usecase, bool anchor_start_end,
-    std::vector<DatetimeParseResultSpan>* results) const {
+    std::vector<DatetimeParseResultSpan>* results, const Deadline& deadline,
+    bool* stopped_early) const {
+  bool skipped_rules = false;
   std::vector<DatetimeParseResultSpan> found_spans;
   std::unordered_set<int> executed_rules;
   std::string reference_locale;
   const std::vector<int> requested_locales =
       ParseAndExpandLocales(locales, &reference_locale);
-  if (!FindSpansUsingLocales(requested_locales, input, reference_time_ms_utc,
-                             reference_timezone, mode, annotation_usecase,
-                             anchor_start_end, reference_locale,
-                             &executed_rules, &found_spans)) {
+  const std::unique_ptr<UniLib::PreparedText> prepared_input =
+      unilib_.PrepareText(input);
+  if (!prepared_input) {
+    TC3_LOG(ERROR) << "Could not prepare the input for matching.";
     return false;
   }
+  if (!FindSpansUsingLocales(requested_locales, *prepared_input,
+                             reference_time_ms_utc, reference_timezone, mode,
+                             annotation_usecase, anchor_start_end,
+                             reference_locale, deadline, &executed_rules,
+                             &found_spans, &skipped_rules)) {
+    return false;
+  }
+  if (stopped_early != nullptr) {
+    *stopped_early = skipped_rules;
+  }
 
   std::vector<std::pair<DatetimeParseResultSpan, int>> indexed_found_spans;
   indexed_found_spans.reserve(found_spans.size());
@@ -259,7 +284,7 @@ bool DatetimeParser::HandleParseMatch(
 }
 
 bool DatetimeParser::ParseWithRule(
-    const CompiledRule& rule, const UnicodeText& input,
+    const CompiledRule& rule, const UniLib::PreparedText& input,
     const int64 reference_time_ms_utc, const std::string& reference_timezone,
     const std::string& reference_locale, const int locale_id,
     bool anchor_start_end, std::vector<DatetimeParseResultSpan>* result) const {
@@ -397,7 +422,8 @@ bool DatetimeParser::ExtractDatetime(const CompiledRule& rule,
   DateParseData parse;
   DatetimeExtractor extractor(rule, matcher, locale_id, unilib_,
                               extractor_rules_,
-                              type_and_locale_to_extractor_rule_);
+                              type_and_locale_to_extractor_rule_,
+                              *extractor_lexicon_);
   if (!extractor.Extract(&parse, result_span)) {
     return false;
   }
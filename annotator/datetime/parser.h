@@ -28,6 +28,7 @@
 #include "annotator/types.h"
 #include "utils/base/integral_types.h"
 #include "utils/calendar/calendar.h"
+#include "utils/deadline.h"
 #include "utils/utf8/unilib.h"
 #include "utils/zlib/zlib.h"
 
@@ -45,23 +46,34 @@ class DatetimeParser {
   // do not overlap.
   // If 'anchor_start_end' is true the extracted results need to start at the
   // beginning of 'input' and end at the end of it.
+  // Once 'deadline' expires, the remaining rules are skipped and, if not null,
+  // 'stopped_early' is set to whether any rule was skipped.
   bool Parse(const std::string& input, int64 reference_time_ms_utc,
              const std::string& reference_timezone, const std::string& locales,
              ModeFlag mode, AnnotationUsecase annotation_usecase,
              bool anchor_start_end,
-             std::vector<DatetimeParseResultSpan>* results) const;
+             std::vector<DatetimeParseResultSpan>* results,
+             const Deadline& deadline = Deadline(),
+             bool* stopped_early = nullptr) const;
 
   // Same as above but takes UnicodeText.
   bool Parse(const UnicodeText& input, int64 reference_time_ms_utc,
              const std::string& reference_timezone, const std::string& locales,
              ModeFlag mode, AnnotationUsecase annotation_usecase,
              bool anchor_start_end,
-             std::vector<DatetimeParseResultSpan>* results) const;
+             std::vector<DatetimeParseResultSpan>* results,
+             const Deadline& deadline = Deadline(),
+             bool* stopped_early = nullptr) const;
 
 #ifdef TC3_TEST_ONLY
   void TestOnlySetGenerateAlternativeInterpretationsWhenAmbiguous(bool value) {
     generate_alternative_interpretations_when_ambiguous_ = value;
   }
+
+  // Makes the extractors match all their rules with the regexes.
+  void TestOnlyDisableExtractorLexicon() {
+    extractor_lexicon_.reset(new DatetimeExtractorLexicon({}));
+  }
 #endif  // TC3_TEST_ONLY
 
  protected:
@@ -77,14 +89,16 @@ class DatetimeParser {
   // Helper function that finds datetime spans, only using the rules associated
   // with the given locales.
   bool FindSpansUsingLocales(
-      const std::vector<int>& locale_ids, const UnicodeText& input,
+      const std::vector<int>& locale_ids, const UniLib::PreparedText& input,
       const int64 reference_time_ms_utc, const std::string& reference_timezone,
       ModeFlag mode, AnnotationUsecase annotation_usecase,
       bool anchor_start_end, const std::string& reference_locale,
-      std::unordered_set<int>* executed_rules,
-      std::vector<DatetimeParseResultSpan>* found_spans) const;
+      const Deadline& deadline, std::unordered_set<int>* executed_rules,
+      std::vector<DatetimeParseResultSpan>* found_spans,
+      bool* stopped_early) const;
 
-  bool ParseWithRule(const CompiledRule& rule, const UnicodeText& input,
+  bool ParseWithRule(const CompiledRule& rule,
+                     const UniLib::PreparedText& input,
                      int64 reference_time_ms_utc,
                      const std::string& reference_timezone,
                      const std::string& reference_locale, const int locale_id,
@@ -120,6 +134,9 @@ class DatetimeParser {
   std::vector<std::unique_ptr<const UniLib::RegexPattern>> extractor_rules_;
   std::unordered_map<DatetimeExtractorType, std::unordered_map<int, int>>
       type_and_locale_to_extractor_rule_;
+  // Looks up the matches of the extractor rules that are plain alternations of
+  // literals, instead of running their regexes.
+  std::unique_ptr<const DatetimeExtractorLexicon> extractor_lexicon_;
   std::unordered_map<std::string, int> locale_string_to_id_;
   std::vector<int> default_locale_ids_;
   bool use_extractors_for_locating_;
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the DatetimeParser of the bundled English model over the
+// benchmark corpora and over datetime expressions.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "annotator/annotator.h"
+#include "annotator/datetime/parser.h"
+#include "utils/base/integral_types.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "utils/testing/benchmark-utils.h"
+#include "utils/utf8/unilib.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Returns the annotator owning the datetime parser, nullptr if the model could
+// not be loaded.
+const Annotator* GetAnnotator() {
+  static const Annotator* annotator =
+      Annotator::FromPath(GetBenchmarkModelPath("textclassifier.en.model"))
+          .release();
+  return annotator;
+}
+
+void BM_DatetimeParse(benchmark::State& state) {
+  const Annotator* annotator = GetAnnotator();
+  const DatetimeParser* parser =
+      annotator != nullptr ? annotator->DatetimeParserForTests() : nullptr;
+  if (parser == nullptr) {
+    state.SkipWithError("Could not load datetime parser.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    std::vector<DatetimeParseResultSpan> results;
+    parser->Parse(text, /*reference_time_ms_utc=*/0,
+                  /*reference_timezone=*/"Europe/Zurich", /*locales=*/"en",
+                  ModeFlag_ANNOTATION, ANNOTATION_USECASE_SMART,
+                  /*anchor_start_end=*/false, &results);
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_DatetimeParse)
+    ->Apply(CorpusTextArguments)
+    ->ThreadRange(1, 4);
+
+// Datetime expressions using the extractors of all the datetime group types.
+const char* const kDatetimeExpressions[] = {
+    "next tuesday at 5 pm",
+    "Meet me on March 3rd, 2019 at 10:30am",
+    "in twenty one days",
+    "three hours ago",
+    "last Friday",
+    "tomorrow at 9",
+    "The deadline is 12 Dec 2018 18:00",
+    "see you next week on Saturday morning",
+    "a fortnight from now",
+    "January 31 at noon",
+    "in fifty one thousand and one seconds",
+    "yesterday 7:15 PM",
+};
+
+// Args: none. Reports the number of text conversions and regex matchers of one
+// pass over the expressions, which the extractor lexicon avoids.
+void BM_DatetimeParseExpressions(benchmark::State& state) {
+  const Annotator* annotator = GetAnnotator();
+  const DatetimeParser* parser =
+      annotator != nullptr ? annotator->DatetimeParserForTests() : nullptr;
+  if (parser == nullptr) {
+    state.SkipWithError("Could not load datetime parser.");
+    return;
+  }
+  const auto parse_all = [parser]() {
+    for (const char* expression : kDatetimeExpressions) {
+      std::vector<DatetimeParseResultSpan> results;
+      parser->Parse(expression, /*reference_time_ms_utc=*/0,
+                    /*reference_timezone=*/"Europe/Zurich", /*locales=*/"en",
+                    ModeFlag_ANNOTATION, ANNOTATION_USECASE_SMART,
+                    /*anchor_start_end=*/false, &results);
+      benchmark::DoNotOptimize(results);
+    }
+  };
+  const int64 num_prepared_texts = UniLib::NumPreparedTexts();
+  const int64 num_regex_matchers = UniLib::NumRegexMatchers();
+  parse_all();
+  state.counters["text_conversions"] =
+      UniLib::NumPreparedTexts() - num_prepared_texts;
+  state.counters["regex_matchers"] =
+      UniLib::NumRegexMatchers() - num_regex_matchers;
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    parse_all();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          (sizeof(kDatetimeExpressions) /
+                           sizeof(kDatetimeExpressions[0])));
+}
+BENCHMARK(BM_DatetimeParseExpressions);
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -15,19 +15,26 @@
  */
 
 #include <time.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 #include "annotator/annotator.h"
+#include "annotator/datetime/extractor-lexicon.h"
 #include "annotator/datetime/parser.h"
 #include "annotator/model_generated.h"
 #include "annotator/types-test-util.h"
+#include "utils/testing/allocation-tracker.h"
+#include "utils/strings/split.h"
 #include "utils/testing/annotator.h"
+#include "utils/zlib/zlib.h"
+#include "utils/zlib/zlib_regex.h"
 
 using testing::ElementsAreArray;
 
@@ -325,6 +332,32 @@ TEST_F(ParserTest, ParsesNoonAndMidnightCorrectly) {
                               GRANULARITY_MINUTE));
 }
 
+// Guards against allocation regressions, the bounds leave ample headroom.
+TEST_F(ParserTest, AllocationsAreBounded) {
+  ScopedAllocationTracker tracker;
+  {
+    ScopedAllocationStage stage("parse");
+    std::vector<DatetimeParseResultSpan> results;
+    ASSERT_TRUE(parser_->Parse(
+        "Let's meet on Thursday, March 14 at 10:00 AM at the office.",
+        /*reference_time_ms_utc=*/0, /*reference_timezone=*/"Europe/Zurich",
+        /*locales=*/"en-US", ModeFlag_ANNOTATION, ANNOTATION_USECASE_SMART,
+        /*anchor_start_end=*/false, &results));
+  }
+  {
+    ScopedAllocationStage stage("annotate");
+    classifier_->Annotate(
+        "Let's meet on Thursday, March 14 at 10:00 AM at the office.");
+  }
+
+  const AllocationStats& parse = tracker.stage_stats().at("parse");
+  EXPECT_LT(parse.num_allocations, 5000);
+  EXPECT_LT(parse.peak_bytes, 1 << 20);
+  const AllocationStats& annotate = tracker.stage_stats().at("annotate");
+  EXPECT_LT(annotate.num_allocations, 50000);
+  EXPECT_LT(annotate.peak_bytes, 16 << 20);
+}
+
 TEST_F(ParserTest, ParseGerman) {
   EXPECT_TRUE(
       ParsesCorrectlyGerman("{Januar 1 2018}", 1514761200000, GRANULARITY_DAY));
@@ -444,6 +477,130 @@ TEST_F(ParserTest, WhenAlternativesDisabledDoesNotGenerateAlternatives) {
                               GRANULARITY_MINUTE));
 }
 
+// Texts with the words of the extractor rules, in several cases and scripts.
+const char* const kExtractorTexts[] = {
+    "next tuesday at 5 pm",
+    "Meet me on March 3rd, 2019 at 10:30am",
+    "in twenty one days",
+    "THREE HOURS AGO",
+    "last Friday",
+    "tomorrow at 9",
+    "The deadline is 12 Dec 2018 18:00",
+    "see you next week on Saturday morning",
+    "January 31 at noon",
+    "in fifty one thousand and one seconds",
+    "yesterday 7:15 PM",
+    "Mo. 3. März 2014, 17 Uhr",
+    "DI 4. MÄRZ um 9",
+    "am Freitag um halb acht",
+    "el martes 3 de marzo",
+    "mercredi 5 mars à 10h",
+    "2018年3月4日 星期二",
+    "3월 4일 화요일",
+    "Monday the 1st of Sept. at 1:15",
+    "ſunday",
+    "STRASSE 1",
+};
+
+// The results of the extractors don't depend on whether the matches of their
+// rules are looked up in the lexicon.
+TEST_F(ParserTest, ExtractorLexiconGivesSameResultsAsRegexes) {
+  const Model* model = GetModel(model_buffer_.data());
+  ASSERT_TRUE(model->datetime_model());
+  std::unique_ptr<ZlibDecompressor> decompressor = ZlibDecompressor::Instance();
+  CalendarLib calendarlib;
+  std::unique_ptr<DatetimeParser> regex_parser = DatetimeParser::Instance(
+      model->datetime_model(), unilib_, calendarlib, decompressor.get());
+  ASSERT_TRUE(regex_parser);
+  regex_parser->TestOnlyDisableExtractorLexicon();
+
+  for (const char* locales : {"", "en", "de", "es", "fr", "zh", "ko"}) {
+    for (const char* text : kExtractorTexts) {
+      std::vector<DatetimeParseResultSpan> results;
+      std::vector<DatetimeParseResultSpan> expected;
+      ASSERT_TRUE(parser_->Parse(
+          text, /*reference_time_ms_utc=*/0, "Europe/Zurich", locales,
+          ModeFlag_ANNOTATION, AnnotationUsecase_ANNOTATION_USECASE_SMART,
+          /*anchor_start_end=*/false, &results));
+      ASSERT_TRUE(regex_parser->Parse(
+          text, /*reference_time_ms_utc=*/0, "Europe/Zurich", locales,
+          ModeFlag_ANNOTATION, AnnotationUsecase_ANNOTATION_USECASE_SMART,
+          /*anchor_start_end=*/false, &expected));
+      EXPECT_EQ(results, expected) << text << " " << locales;
+    }
+  }
+}
+
+// Every text that is looked up in the lexicon matches the same supported rules
+// as with their regexes.
+TEST_F(ParserTest, ExtractorLexiconMatchesLikeTheRegexes) {
+  const DatetimeModel* datetime_model =
+      GetModel(model_buffer_.data())->datetime_model();
+  ASSERT_TRUE(datetime_model && datetime_model->extractors());
+  std::unique_ptr<ZlibDecompressor> decompressor = ZlibDecompressor::Instance();
+  std::vector<std::string> patterns;
+  std::vector<std::unique_ptr<UniLib::RegexPattern>> regexes;
+  for (const DatetimeModelExtractor* extractor :
+       *datetime_model->extractors()) {
+    std::string pattern;
+    regexes.push_back(UncompressMakeRegexPattern(
+        unilib_, extractor->pattern(), extractor->compressed_pattern(),
+        /*lazy_compile_regex=*/false, decompressor.get(), &pattern));
+    ASSERT_TRUE(regexes.back());
+    patterns.push_back(pattern);
+  }
+  const DatetimeExtractorLexicon lexicon(patterns);
+  EXPECT_GT(lexicon.num_supported_rules(), 0);
+
+  // The words of the texts, their prefixes, in upper and lower case, and with
+  // a trailing period.
+  std::vector<std::string> probes;
+  for (const char* text : kExtractorTexts) {
+    for (const StringPiece token : strings::Split(text, ' ')) {
+      const UnicodeText word = UTF8ToUnicodeText(token.ToString());
+      for (int length = 1; length <= word.size_codepoints(); ++length) {
+        const std::string prefix = word.UTF8Substring(0, length);
+        probes.push_back(prefix);
+        probes.push_back(prefix + ".");
+        std::string upper = prefix;
+        std::string lower = prefix;
+        for (char& c : upper) {
+          c = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+        }
+        for (char& c : lower) {
+          c = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+        }
+        probes.push_back(upper);
+        probes.push_back(lower);
+      }
+    }
+  }
+
+  int num_looked_up = 0;
+  for (const std::string& probe : probes) {
+    const UnicodeText probe_unicode = UTF8ToUnicodeText(probe);
+    const std::vector<int>* matches = lexicon.Match(probe_unicode);
+    if (matches == nullptr) {
+      continue;
+    }
+    ++num_looked_up;
+    for (int rule_id = 0; rule_id < regexes.size(); ++rule_id) {
+      if (!lexicon.IsSupported(rule_id)) {
+        continue;
+      }
+      int status = UniLib::RegexMatcher::kNoError;
+      const bool regex_matches =
+          regexes[rule_id]->Matcher(probe_unicode)->Matches(&status);
+      ASSERT_EQ(status, UniLib::RegexMatcher::kNoError);
+      EXPECT_EQ(std::find(matches->begin(), matches->end(), rule_id) !=
+                    matches->end(),
+                regex_matches)
+          << probe << " " << patterns[rule_id];
+    }
+  }
+  EXPECT_GT(num_looked_up, 0);
+}
+
 class ParserLocaleTest : public testing::Test {
  public:
   void SetUp() override;
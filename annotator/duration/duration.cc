@@ -16,8 +16,12 @@
 
 #include "annotator/duration/duration.h"
 
+#include <algorithm>
+#include <cctype>
 #include <climits>
 #include <cstdlib>
+#include <functional>
+#include <map>
 
 #include "annotator/collections.h"
 #include "annotator/types.h"
@@ -31,49 +35,112 @@ using DurationUnit = internal::DurationUnit;
 namespace internal {
 
 namespace {
-void FillDurationUnitMap(
+
+// Returns the child of a node in the trie under construction, adding it if
+// needed.
+int AddEdge(int node, char label, std::vector<std::map<char, int>>* children,
+            std::vector<DurationExpressionInfo>* infos) {
+  const auto it = (*children)[node].find(label);
+  if (it != (*children)[node].end()) {
+    return it->second;
+  }
+  const int child = children->size();
+  (*children)[node][label] = child;
+  children->emplace_back();
+  infos->emplace_back();
+  return child;
+}
+
+// Adds the expressions to the trie under construction, normalizing the
+// whitespace between tokens to a single space.
+void AddExpressions(
     const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>*
         expressions,
-    DurationUnit duration_unit,
-    std::unordered_map<std::string, DurationUnit>* target_map) {
+    const std::function<void(DurationExpressionInfo*)>& set_info,
+    std::vector<std::map<char, int>>* children,
+    std::vector<DurationExpressionInfo>* infos) {
   if (expressions == nullptr) {
     return;
   }
 
-  for (const flatbuffers::String* expression_string : *expressions) {
-    (*target_map)[expression_string->c_str()] = duration_unit;
+  for (const flatbuffers::String* expression : *expressions) {
+    int node = 0;
+    bool pending_space = false;
+    for (const char c : *expression) {
+      if (c == ' ') {
+        // Leading, trailing and repeated spaces are dropped.
+        pending_space = (node != 0);
+        continue;
+      }
+      if (pending_space) {
+        node = AddEdge(node, ' ', children, infos);
+        pending_space = false;
+      }
+      node = AddEdge(node, c, children, infos);
+    }
+    if (node != 0) {
+      set_info(&(*infos)[node]);
+    }
   }
 }
+
 }  // namespace
 
-std::unordered_map<std::string, DurationUnit> BuildTokenToDurationUnitMapping(
+DurationExpressionTrie::DurationExpressionTrie(
     const DurationAnnotatorOptions* options) {
-  std::unordered_map<std::string, DurationUnit> mapping;
-  FillDurationUnitMap(options->week_expressions(), DurationUnit::WEEK,
-                      &mapping);
-  FillDurationUnitMap(options->day_expressions(), DurationUnit::DAY, &mapping);
-  FillDurationUnitMap(options->hour_expressions(), DurationUnit::HOUR,
-                      &mapping);
-  FillDurationUnitMap(options->minute_expressions(), DurationUnit::MINUTE,
-                      &mapping);
-  FillDurationUnitMap(options->second_expressions(), DurationUnit::SECOND,
-                      &mapping);
-  return mapping;
-}
-
-std::unordered_set<std::string> BuildStringSet(
-    const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>*
-        strings) {
-  std::unordered_set<std::string> result;
-  if (strings == nullptr) {
-    return result;
+  std::vector<std::map<char, int>> children(1);
+  std::vector<DurationExpressionInfo> infos(1);
+  const std::pair<decltype(options->week_expressions()), DurationUnit>
+      unit_expressions[] = {
+          {options->week_expressions(), DurationUnit::WEEK},
+          {options->day_expressions(), DurationUnit::DAY},
+          {options->hour_expressions(), DurationUnit::HOUR},
+          {options->minute_expressions(), DurationUnit::MINUTE},
+          {options->second_expressions(), DurationUnit::SECOND}};
+  for (const auto& expressions_and_unit : unit_expressions) {
+    const DurationUnit unit = expressions_and_unit.second;
+    AddExpressions(
+        expressions_and_unit.first,
+        [unit](DurationExpressionInfo* info) { info->unit = unit; }, &children,
+        &infos);
   }
-
-  for (const flatbuffers::String* string_value : *strings) {
-    result.insert(string_value->c_str());
+  AddExpressions(
+      options->filler_expressions(),
+      [](DurationExpressionInfo* info) { info->is_filler = true; }, &children,
+      &infos);
+  AddExpressions(
+      options->half_expressions(),
+      [](DurationExpressionInfo* info) { info->is_half = true; }, &children,
+      &infos);
+
+  // Flatten the edges into a single array.
+  nodes_.resize(children.size());
+  for (int i = 0; i < children.size(); i++) {
+    nodes_[i].info = infos[i];
+    nodes_[i].first_edge = edges_.size();
+    nodes_[i].num_edges = children[i].size();
+    for (const auto& label_and_target : children[i]) {
+      edges_.push_back({label_and_target.first, label_and_target.second});
+    }
   }
+}
 
-  return result;
+int DurationExpressionTrie::Follow(int node, StringPiece text) const {
+  for (int i = 0; i < text.size(); i++) {
+    const Node& current = nodes_[node];
+    const Edge* edges_begin = edges_.data() + current.first_edge;
+    const Edge* edges_end = edges_begin + current.num_edges;
+    const Edge* edge = std::lower_bound(
+        edges_begin, edges_end, text[i],
+        [](const Edge& candidate, const char label) {
+          return candidate.label < label;
+        });
+    if (edge == edges_end || edge->label != text[i]) {
+      return kNoNode;
+    }
+    node = edge->target;
+  }
+  return node;
 }
 
 }  // namespace internal
@@ -141,29 +208,43 @@ int DurationAnnotator::FindDurationStartingAt(const UnicodeText& context,
   // This is the core algorithm for finding the duration expressions. It
   // basically iterates over tokens and changes the state variables above as it
   // goes.
-  int token_index;
-  for (token_index = start_token_index; token_index < tokens.size();
-       token_index++) {
-    const Token& token = tokens[token_index];
-
-    if (ParseQuantityToken(token, &parsed_duration)) {
+  int token_index = start_token_index;
+  while (token_index < tokens.size()) {
+    const internal::DurationExpressionInfo* expression = nullptr;
+    const int num_expression_tokens =
+        MatchExpression(tokens, token_index, &expression);
+
+    int num_consumed_tokens = 1;
+    bool extends_span = true;
+    if (expression != nullptr && expression->is_half) {
+      parsed_duration.plus_half = true;
       has_quantity = true;
-      if (start_index == kInvalidIndex) {
-        start_index = token.start;
-      }
-      end_index = token.end;
-    } else if (ParseDurationUnitToken(token, &parsed_duration.unit)) {
-      if (start_index == kInvalidIndex) {
-        start_index = token.start;
-      }
-      end_index = token.end;
+      num_consumed_tokens = num_expression_tokens;
+    } else if (ParseQuantity(feature_processor_->StripBoundaryCodepoints(
+                                 tokens[token_index].value),
+                             &parsed_duration)) {
+      has_quantity = true;
+    } else if (expression != nullptr &&
+               expression->unit != DurationUnit::UNKNOWN) {
+      parsed_duration.unit = expression->unit;
       parsed_duration_atoms.push_back(parsed_duration);
       has_quantity = false;
       parsed_duration = ParsedDurationAtom();
-    } else if (ParseFillerToken(token)) {
+      num_consumed_tokens = num_expression_tokens;
+    } else if (expression != nullptr && expression->is_filler) {
+      extends_span = false;
+      num_consumed_tokens = num_expression_tokens;
     } else {
       break;
     }
+
+    if (extends_span) {
+      if (start_index == kInvalidIndex) {
+        start_index = tokens[token_index].start;
+      }
+      end_index = tokens[token_index + num_consumed_tokens - 1].end;
+    }
+    token_index += num_consumed_tokens;
   }
 
   if (parsed_duration_atoms.empty()) {
@@ -236,23 +317,43 @@ int64 DurationAnnotator::ParsedDurationAtomsToMillis(
   return result;
 }
 
-bool DurationAnnotator::ParseQuantityToken(const Token& token,
-                                           ParsedDurationAtom* value) const {
-  if (token.value.empty()) {
-    return false;
+int DurationAnnotator::MatchExpression(
+    const std::vector<Token>& tokens, int start_token_index,
+    const internal::DurationExpressionInfo** expression) const {
+  int num_matched_tokens = 0;
+  int node = expression_trie_.Root();
+  for (int i = start_token_index; i < tokens.size(); i++) {
+    if (i > start_token_index) {
+      node = expression_trie_.Follow(node, " ");
+    }
+    if (node != internal::DurationExpressionTrie::kNoNode) {
+      node = expression_trie_.Follow(
+          node,
+          feature_processor_->StripBoundaryCodepoints(tokens[i].value));
+    }
+    if (node == internal::DurationExpressionTrie::kNoNode) {
+      break;
+    }
+    const internal::DurationExpressionInfo& info = expression_trie_.Info(node);
+    if (info.IsExpression()) {
+      *expression = &info;
+      num_matched_tokens = i - start_token_index + 1;
+    }
   }
+  return num_matched_tokens;
+}
 
-  std::string token_value_buffer;
-  const std::string& token_value = feature_processor_->StripBoundaryCodepoints(
-      token.value, &token_value_buffer);
-
-  if (half_expressions_.find(token_value) != half_expressions_.end()) {
-    value->plus_half = true;
-    return true;
+bool DurationAnnotator::ParseQuantity(StringPiece token_value,
+                                      ParsedDurationAtom* value) const {
+  // Only numbers are parsed, so don't bother copying other tokens.
+  if (token_value.empty() ||
+      !(isdigit(token_value[0]) || token_value[0] == '-' ||
+        token_value[0] == '+')) {
+    return false;
   }
 
   int32 parsed_value;
-  if (ParseInt32(token_value.c_str(), &parsed_value)) {
+  if (ParseInt32(token_value.ToString().c_str(), &parsed_value)) {
     value->value = parsed_value;
     return true;
   }
@@ -260,31 +361,4 @@ bool DurationAnnotator::ParseQuantityToken(const Token& token,
   return false;
 }
 
-bool DurationAnnotator::ParseDurationUnitToken(
-    const Token& token, DurationUnit* duration_unit) const {
-  std::string token_value_buffer;
-  const std::string& token_value = feature_processor_->StripBoundaryCodepoints(
-      token.value, &token_value_buffer);
-
-  const auto it = token_value_to_duration_unit_.find(token_value);
-  if (it == token_value_to_duration_unit_.end()) {
-    return false;
-  }
-
-  *duration_unit = it->second;
-  return true;
-}
-
-bool DurationAnnotator::ParseFillerToken(const Token& token) const {
-  std::string token_value_buffer;
-  const std::string& token_value = feature_processor_->StripBoundaryCodepoints(
-      token.value, &token_value_buffer);
-
-  if (filler_expressions_.find(token_value) == filler_expressions_.end()) {
-    return false;
-  }
-
-  return true;
-}
-
 }  // namespace libtextclassifier3
@@ -17,14 +17,12 @@
 #ifndef LIBTEXTCLASSIFIER_ANNOTATOR_DURATION_DURATION_H_
 #define LIBTEXTCLASSIFIER_ANNOTATOR_DURATION_DURATION_H_
 
-#include <string>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "annotator/feature-processor.h"
 #include "annotator/model_generated.h"
 #include "annotator/types.h"
+#include "utils/strings/stringpiece.h"
 #include "utils/utf8/unicodetext.h"
 
 namespace libtextclassifier3 {
@@ -44,13 +42,58 @@ enum class DurationUnit {
   // savings time and assume the day is always 24 hours.
 };
 
-// Prepares the mapping between token values and duration unit types.
-std::unordered_map<std::string, internal::DurationUnit>
-BuildTokenToDurationUnitMapping(const DurationAnnotatorOptions* options);
+// Properties of a duration expression from the model.
+struct DurationExpressionInfo {
+  // Unit, if the expression names a duration unit (e.g. "hours").
+  DurationUnit unit = DurationUnit::UNKNOWN;
 
-// Creates a set of strings from a flatbuffer string vector.
-std::unordered_set<std::string> BuildStringSet(
-    const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>*);
+  // Whether the expression is a filler (e.g. "and").
+  bool is_filler = false;
+
+  // Whether the expression specifies half a unit (e.g. "half").
+  bool is_half = false;
+
+  bool IsExpression() const {
+    return unit != DurationUnit::UNKNOWN || is_filler || is_half;
+  }
+};
+
+// Compact byte-wise trie over the duration expressions of the model.
+// Expressions spanning several tokens are stored with their tokens separated by
+// a single space, so that they can be matched token by token without going
+// back to the start of the expression.
+class DurationExpressionTrie {
+ public:
+  static constexpr int kNoNode = -1;
+
+  explicit DurationExpressionTrie(const DurationAnnotatorOptions* options);
+
+  int Root() const { return 0; }
+
+  // Follows the path of `text` starting at `node`. Returns kNoNode if there is
+  // no expression continuing with `text`.
+  int Follow(int node, StringPiece text) const;
+
+  const DurationExpressionInfo& Info(int node) const {
+    return nodes_[node].info;
+  }
+
+ private:
+  struct Node {
+    // Range of the outgoing edges in `edges_`, sorted by label.
+    int first_edge = 0;
+    int num_edges = 0;
+    DurationExpressionInfo info;
+  };
+
+  struct Edge {
+    char label;
+    int target;
+  };
+
+  std::vector<Node> nodes_;
+  std::vector<Edge> edges_;
+};
 
 }  // namespace internal
 
@@ -61,12 +104,7 @@ class DurationAnnotator {
                              const FeatureProcessor* feature_processor)
       : options_(options),
         feature_processor_(feature_processor),
-        token_value_to_duration_unit_(
-            internal::BuildTokenToDurationUnitMapping(options)),
-        filler_expressions_(
-            internal::BuildStringSet(options->filler_expressions())),
-        half_expressions_(
-            internal::BuildStringSet(options->half_expressions())) {}
+        expression_trie_(options) {}
 
   // Classifies given text, and if it is a duration, it passes the result in
   // 'classification_result' and returns true, otherwise returns false.
@@ -107,20 +145,20 @@ class DurationAnnotator {
                              int start_token_index,
                              AnnotatedSpan* result) const;
 
-  bool ParseQuantityToken(const Token& token, ParsedDurationAtom* value) const;
-  bool ParseDurationUnitToken(const Token& token,
-                              internal::DurationUnit* duration_unit) const;
-  bool ParseFillerToken(const Token& token) const;
+  // Finds the longest duration expression starting at the given token.
+  // Returns the number of tokens of the expression, or 0 if there is none.
+  int MatchExpression(
+      const std::vector<Token>& tokens, int start_token_index,
+      const internal::DurationExpressionInfo** expression) const;
+
+  bool ParseQuantity(StringPiece token_value, ParsedDurationAtom* value) const;
 
   int64 ParsedDurationAtomsToMillis(
       const std::vector<ParsedDurationAtom>& atoms) const;
 
   const DurationAnnotatorOptions* options_;
   const FeatureProcessor* feature_processor_;
-  const std::unordered_map<std::string, internal::DurationUnit>
-      token_value_to_duration_unit_;
-  const std::unordered_set<std::string> filler_expressions_;
-  const std::unordered_set<std::string> half_expressions_;
+  const internal::DurationExpressionTrie expression_trie_;
 };
 
 }  // namespace libtextclassifier3
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks finding durations in long, number-dense inputs.
+
+#include <string>
+#include <vector>
+
+#include "annotator/duration/duration.h"
+#include "annotator/feature-processor.h"
+#include "annotator/model_generated.h"
+#include "annotator/types.h"
+#include "utils/utf8/unicodetext.h"
+#include "utils/utf8/unilib.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+const DurationAnnotatorOptions* BenchmarkDurationAnnotatorOptions() {
+  static const flatbuffers::DetachedBuffer* options_data = []() {
+    DurationAnnotatorOptionsT options;
+    options.enabled = true;
+    options.week_expressions = {"week", "weeks"};
+    options.day_expressions = {"day", "days", "calendar days"};
+    options.hour_expressions = {"hour", "hours", "hr", "hrs"};
+    options.minute_expressions = {"minute", "minutes", "min", "mins"};
+    options.second_expressions = {"second", "seconds", "sec", "secs"};
+    options.filler_expressions = {"and", "a", "an", "one"};
+    options.half_expressions = {"half", "and a half"};
+
+    flatbuffers::FlatBufferBuilder builder;
+    builder.Finish(DurationAnnotatorOptions::Pack(builder, &options));
+    return new flatbuffers::DetachedBuffer(builder.Release());
+  }();
+
+  return flatbuffers::GetRoot<DurationAnnotatorOptions>(options_data->data());
+}
+
+const FeatureProcessorOptions* BenchmarkFeatureProcessorOptions() {
+  static const flatbuffers::DetachedBuffer* options_data = []() {
+    FeatureProcessorOptionsT options;
+    options.context_size = 1;
+    options.max_selection_span = 1;
+    options.snap_label_span_boundaries_to_containing_tokens = false;
+    options.ignored_span_boundary_codepoints.push_back(',');
+
+    options.tokenization_codepoint_config.emplace_back(
+        new TokenizationCodepointRangeT());
+    auto& config = options.tokenization_codepoint_config.back();
+    config->start = 32;
+    config->end = 33;
+    config->role = TokenizationCodepointRange_::Role_WHITESPACE_SEPARATOR;
+
+    flatbuffers::FlatBufferBuilder builder;
+    builder.Finish(FeatureProcessorOptions::Pack(builder, &options));
+    return new flatbuffers::DetachedBuffer(builder.Release());
+  }();
+
+  return flatbuffers::GetRoot<FeatureProcessorOptions>(options_data->data());
+}
+
+// Builds a text of roughly `num_bytes` that mixes durations with plain
+// numbers, e.g. order numbers and prices.
+std::string NumberDenseText(const int num_bytes) {
+  static const char* const kSnippets[] = {
+      "order 12345 ships in 2 days and 3 hours, ",
+      "call 555 0199 in 10 mins 30 secs ",
+      "room 42 for 1 hour and a half, ",
+      "total 19 99 plus 7 50 ",
+      "back in 3 calendar days ",
+  };
+  std::string text;
+  for (int i = 0; text.size() < num_bytes; i++) {
+    text += kSnippets[i % (sizeof(kSnippets) / sizeof(kSnippets[0]))];
+  }
+  return text;
+}
+
+void BM_DurationFindAll(benchmark::State& state) {
+  UniLib unilib;
+  const FeatureProcessor feature_processor(BenchmarkFeatureProcessorOptions(),
+                                           &unilib);
+  const DurationAnnotator annotator(BenchmarkDurationAnnotatorOptions(),
+                                    &feature_processor);
+  const UnicodeText text = UTF8ToUnicodeText(NumberDenseText(state.range(0)),
+                                             /*do_copy=*/true);
+  const std::vector<Token> tokens = feature_processor.Tokenize(text);
+
+  for (auto _ : state) {
+    std::vector<AnnotatedSpan> results;
+    annotator.FindAll(text, tokens, AnnotationUsecase_ANNOTATION_USECASE_RAW,
+                      &results);
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size_bytes());
+}
+BENCHMARK(BM_DurationFindAll)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18);
+
+}  // namespace
+}  // namespace libtextclassifier3
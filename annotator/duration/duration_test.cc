@@ -46,6 +46,7 @@ const DurationAnnotatorOptions* TestingDurationAnnotatorOptions() {
 
     options.day_expressions.push_back("day");
     options.day_expressions.push_back("days");
+    options.day_expressions.push_back("calendar  days");
 
     options.hour_expressions.push_back("hour");
     options.hour_expressions.push_back("hours");
@@ -316,5 +317,35 @@ TEST_F(DurationAnnotatorTest, StripsPunctuationFromTokens) {
                                 10 * 60 * 1000 + 2 * 1000)))))));
 }
 
+TEST_F(DurationAnnotatorTest, FindsMultiTokenExpressions) {
+  const UnicodeText text =
+      UTF8ToUnicodeText("Set a timer for 3 calendar days and 2 hours ok?");
+  std::vector<Token> tokens = Tokenize(text);
+  std::vector<AnnotatedSpan> result;
+  EXPECT_TRUE(duration_annotator_.FindAll(
+      text, tokens, AnnotationUsecase_ANNOTATION_USECASE_RAW, &result));
+
+  EXPECT_THAT(
+      result,
+      ElementsAre(
+          AllOf(Field(&AnnotatedSpan::span, CodepointSpan(16, 43)),
+                Field(&AnnotatedSpan::classification,
+                      ElementsAre(AllOf(
+                          Field(&ClassificationResult::collection, "duration"),
+                          Field(&ClassificationResult::duration_ms,
+                                3 * 24 * 60 * 60 * 1000 +
+                                    2 * 60 * 60 * 1000)))))));
+}
+
+TEST_F(DurationAnnotatorTest, DoesNotMatchPrefixOfMultiTokenExpression) {
+  const UnicodeText text = UTF8ToUnicodeText("Set a timer for 3 calendar ok?");
+  std::vector<Token> tokens = Tokenize(text);
+  std::vector<AnnotatedSpan> result;
+  EXPECT_TRUE(duration_annotator_.FindAll(
+      text, tokens, AnnotationUsecase_ANNOTATION_USECASE_RAW, &result));
+
+  EXPECT_THAT(result, testing::IsEmpty());
+}
+
 }  // namespace
 }  // namespace libtextclassifier3
@@ -630,6 +630,28 @@ const std::string& FeatureProcessor::StripBoundaryCodepoints(
   return value;
 }
 
+StringPiece FeatureProcessor::StripBoundaryCodepoints(
+    StringPiece value) const {
+  const UnicodeText value_unicode =
+      UTF8ToUnicodeText(value.data(), value.size(), /*do_copy=*/false);
+  UnicodeText::const_iterator begin = value_unicode.begin();
+  UnicodeText::const_iterator end = value_unicode.end();
+  while (begin != end && ignored_span_boundary_codepoints_.find(*begin) !=
+                             ignored_span_boundary_codepoints_.end()) {
+    ++begin;
+  }
+  while (begin != end) {
+    UnicodeText::const_iterator last = end;
+    --last;
+    if (ignored_span_boundary_codepoints_.find(*last) ==
+        ignored_span_boundary_codepoints_.end()) {
+      break;
+    }
+    end = last;
+  }
+  return StringPiece(begin.utf8_data(), end.utf8_data() - begin.utf8_data());
+}
+
 int FeatureProcessor::CollectionToLabel(const std::string& collection) const {
   const auto it = collection_to_label_.find(collection);
   if (it == collection_to_label_.end()) {
@@ -30,6 +30,7 @@
 #include "annotator/types.h"
 #include "utils/base/integral_types.h"
 #include "utils/base/logging.h"
+#include "utils/strings/stringpiece.h"
 #include "utils/token-feature-extractor.h"
 #include "utils/tokenizer.h"
 #include "utils/utf8/unicodetext.h"
@@ -192,6 +193,10 @@ class FeatureProcessor {
   const std::string& StripBoundaryCodepoints(const std::string& value,
                                              std::string* buffer) const;
 
+  // Same as above, but returns a view of the stripped part of 'value', without
+  // copying.
+  StringPiece StripBoundaryCodepoints(StringPiece value) const;
+
  protected:
   // Returns the class id corresponding to the given string collection
   // identifier. There is a catch-all class id that the function returns for
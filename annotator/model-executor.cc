@@ -18,9 +18,27 @@
 
 #include "annotator/quantization.h"
 #include "utils/base/logging.h"
+#include "utils/tflite-quantization.h"
 
 namespace libtextclassifier3 {
 
+std::unique_ptr<ModelExecutor> ModelExecutor::FromBufferWithQuantizedWeights(
+    const flatbuffers::Vector<uint8_t>* model_spec_buffer) {
+  const tflite::Model* model_spec = VerifiedTfLiteModel(model_spec_buffer);
+  if (model_spec == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<const std::string> quantized_buffer(
+      new std::string(QuantizeFullyConnectedWeights(model_spec)));
+  auto model =
+      TfLiteModelFromModelSpec(tflite::GetModel(quantized_buffer->data()));
+  if (!model) {
+    return nullptr;
+  }
+  return std::unique_ptr<ModelExecutor>(
+      new ModelExecutor(std::move(quantized_buffer), std::move(model)));
+}
+
 TensorView<float> ModelExecutor::ComputeLogits(
     const TensorView<float>& features, tflite::Interpreter* interpreter) const {
   if (!interpreter) {
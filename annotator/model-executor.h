@@ -20,6 +20,7 @@
 #define LIBTEXTCLASSIFIER_ANNOTATOR_MODEL_EXECUTOR_H_
 
 #include <memory>
+#include <string>
 
 #include "annotator/types.h"
 #include "utils/base/logging.h"
@@ -49,12 +50,20 @@ class ModelExecutor : public TfLiteModelExecutor {
     return std::unique_ptr<ModelExecutor>(new ModelExecutor(std::move(model)));
   }
 
+  // Same as above, but with the float weights of the fully connected layers
+  // quantized to int8 at load time, see QuantizeFullyConnectedWeights().
+  static std::unique_ptr<ModelExecutor> FromBufferWithQuantizedWeights(
+      const flatbuffers::Vector<uint8_t>* model_spec_buffer);
+
   TensorView<float> ComputeLogits(const TensorView<float>& features,
                                   tflite::Interpreter* interpreter) const;
 
  protected:
   explicit ModelExecutor(std::unique_ptr<const tflite::FlatBufferModel> model)
       : TfLiteModelExecutor(std::move(model)) {}
+  ModelExecutor(std::unique_ptr<const std::string> model_buffer,
+                std::unique_ptr<const tflite::FlatBufferModel> model)
+      : TfLiteModelExecutor(std::move(model_buffer), std::move(model)) {}
 
   static const int kInputIndexFeatures = 0;
   static const int kOutputIndexLogits = 0;
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the selection and classification models of the bundled English
+// model with float weights and with the weights quantized to int8 at load
+// time, and evaluates the accuracy delta of the quantized models against the
+// float ones. The delta is reported as counters:
+// - "max_logit_delta": the largest absolute difference of the logits, relative
+//   to the largest absolute float logit.
+// - "argmax_agreement": the fraction of the rows with the same best class.
+// - "annotation_agreement": the F1 score of the annotations (span and top
+//   collection) of the quantized model against the float model on the corpus.
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "annotator/annotator.h"
+#include "annotator/model-executor.h"
+#include "annotator/model_generated.h"
+#include "utils/testing/annotator.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "utils/testing/benchmark-utils.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+const int kBatchSize = 16;
+
+// Returns the buffer of the bundled model, with the weights quantized at load
+// time if 'quantized' is true. Empty if the model could not be read.
+const std::string& GetModelBuffer(bool quantized) {
+  static const std::string* float_buffer = [] {
+    std::ifstream file_stream(GetBenchmarkModelPath("textclassifier.en.model"));
+    return new std::string(std::istreambuf_iterator<char>(file_stream), {});
+  }();
+  static const std::string* quantized_buffer =
+      float_buffer->empty()
+          ? new std::string()
+          : new std::string(
+                ModifyAnnotatorModel(*float_buffer, [](ModelT* model) {
+                  model->quantize_fully_connected_weights = true;
+                }));
+  return quantized ? *quantized_buffer : *float_buffer;
+}
+
+const Annotator* GetAnnotator(bool quantized) {
+  static const Annotator* float_annotator =
+      Annotator::FromUnownedBuffer(GetModelBuffer(false).data(),
+                                   GetModelBuffer(false).size())
+          .release();
+  static const Annotator* quantized_annotator =
+      Annotator::FromUnownedBuffer(GetModelBuffer(true).data(),
+                                   GetModelBuffer(true).size())
+          .release();
+  return quantized ? quantized_annotator : float_annotator;
+}
+
+const flatbuffers::Vector<uint8_t>* GetTfLiteModel(bool classification) {
+  const std::string& buffer = GetModelBuffer(false);
+  if (buffer.empty()) {
+    return nullptr;
+  }
+  const Model* model = GetModel(buffer.data());
+  return classification ? model->classification_model()
+                        : model->selection_model();
+}
+
+// Returns deterministic features for a batch of the model's input.
+std::vector<float> BatchFeatures(int num_features) {
+  std::vector<float> features;
+  for (int i = 0; i < kBatchSize * num_features; ++i) {
+    features.push_back((i * 7919 % 2003 - 1001) / 1001.0f);
+  }
+  return features;
+}
+
+// Reports the accuracy delta of the quantized logits as counters.
+void ReportLogitsDelta(benchmark::State& state,
+                       const TensorView<float>& float_logits,
+                       const TensorView<float>& quantized_logits) {
+  const int num_classes = float_logits.dim(float_logits.dims() - 1);
+  const int num_rows = float_logits.size() / num_classes;
+  float max_abs_logit = 0.0f;
+  float max_delta = 0.0f;
+  for (int i = 0; i < float_logits.size(); ++i) {
+    max_abs_logit = std::max(max_abs_logit, std::abs(float_logits.data()[i]));
+    max_delta = std::max(max_delta, std::abs(float_logits.data()[i] -
+                                             quantized_logits.data()[i]));
+  }
+  int num_agreeing_rows = 0;
+  for (int row = 0; row < num_rows; ++row) {
+    const float* float_row = float_logits.data() + row * num_classes;
+    const float* quantized_row = quantized_logits.data() + row * num_classes;
+    if (std::max_element(float_row, float_row + num_classes) - float_row ==
+        std::max_element(quantized_row, quantized_row + num_classes) -
+            quantized_row) {
+      ++num_agreeing_rows;
+    }
+  }
+  state.counters["max_logit_delta"] =
+      max_abs_logit > 0.0f ? max_delta / max_abs_logit : max_delta;
+  state.counters["argmax_agreement"] =
+      static_cast<double>(num_agreeing_rows) / num_rows;
+}
+
+// Args: (classification model, quantized weights).
+void BM_ComputeLogits(benchmark::State& state) {
+  const flatbuffers::Vector<uint8_t>* tflite_model =
+      GetTfLiteModel(/*classification=*/state.range(0));
+  if (tflite_model == nullptr) {
+    state.SkipWithError("Could not load annotator model.");
+    return;
+  }
+  const bool quantized = state.range(1);
+  state.SetLabel(std::string(state.range(0) ? "classification" : "selection") +
+                 (quantized ? "/int8" : "/float"));
+  const std::unique_ptr<ModelExecutor> float_executor =
+      ModelExecutor::FromBuffer(tflite_model);
+  const std::unique_ptr<ModelExecutor> executor =
+      quantized ? ModelExecutor::FromBufferWithQuantizedWeights(tflite_model)
+                : ModelExecutor::FromBuffer(tflite_model);
+  if (!float_executor || !executor) {
+    state.SkipWithError("Could not create the model executor.");
+    return;
+  }
+  std::unique_ptr<tflite::Interpreter> float_interpreter =
+      float_executor->CreateInterpreter();
+  std::unique_ptr<tflite::Interpreter> interpreter =
+      executor->CreateInterpreter();
+  const TfLiteTensor* input = interpreter->tensor(interpreter->inputs()[0]);
+  const int num_features = input->dims->data[input->dims->size - 1];
+  const std::vector<float> features = BatchFeatures(num_features);
+  const TensorView<float> features_view(features.data(),
+                                        {kBatchSize, num_features});
+
+  const TensorView<float> float_logits =
+      float_executor->ComputeLogits(features_view, float_interpreter.get());
+  const TensorView<float> logits =
+      executor->ComputeLogits(features_view, interpreter.get());
+  if (!float_logits.is_valid() || !logits.is_valid()) {
+    state.SkipWithError("Could not compute the logits.");
+    return;
+  }
+  ReportLogitsDelta(state, float_logits, logits);
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    benchmark::DoNotOptimize(
+        executor->ComputeLogits(features_view, interpreter.get()).data());
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_ComputeLogits)
+    ->Args({0, 0})
+    ->Args({0, 1})
+    ->Args({1, 0})
+    ->Args({1, 1});
+
+// Returns the F1 score of the 'actual' annotations against the 'expected'
+// ones, comparing spans and top collections.
+double AnnotationAgreement(const std::vector<AnnotatedSpan>& expected,
+                           const std::vector<AnnotatedSpan>& actual) {
+  if (expected.empty() && actual.empty()) {
+    return 1.0;
+  }
+  std::map<CodepointSpan, std::string> expected_collections;
+  for (const AnnotatedSpan& annotation : expected) {
+    expected_collections[annotation.span] =
+        annotation.classification[0].collection;
+  }
+  int num_matches = 0;
+  for (const AnnotatedSpan& annotation : actual) {
+    const auto it = expected_collections.find(annotation.span);
+    if (it != expected_collections.end() &&
+        it->second == annotation.classification[0].collection) {
+      ++num_matches;
+    }
+  }
+  return 2.0 * num_matches / (expected.size() + actual.size());
+}
+
+// Args: corpus arguments, quantized weights.
+void BM_AnnotateQuantized(benchmark::State& state) {
+  const Annotator* float_annotator = GetAnnotator(/*quantized=*/false);
+  const Annotator* annotator = GetAnnotator(/*quantized=*/state.range(2));
+  if (float_annotator == nullptr || annotator == nullptr) {
+    state.SkipWithError("Could not load annotator model.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  state.counters["annotation_agreement"] = AnnotationAgreement(
+      float_annotator->Annotate(text), annotator->Annotate(text));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(annotator->Annotate(text));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_AnnotateQuantized)->Apply([](benchmark::internal::Benchmark* b) {
+  for (int corpus = 0; corpus < kNumBenchmarkCorpora; corpus++) {
+    for (int quantized = 0; quantized <= 1; quantized++) {
+      b->Args({corpus, 4 << 10, quantized});
+    }
+  }
+});
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/model-executor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "annotator/model_generated.h"
+#include "utils/tflite-quantization.h"
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+std::string GetModelPath() { return TC3_TEST_DATA_DIR; }
+
+std::string ReadFile(const std::string& file_name) {
+  std::ifstream file_stream(file_name);
+  return std::string(std::istreambuf_iterator<char>(file_stream), {});
+}
+
+// Checks that the logits of the model with quantized weights are close to the
+// ones with float weights.
+void ExpectQuantizedLogitsClose(const flatbuffers::Vector<uint8_t>* buffer) {
+  int num_quantized_tensors = 0;
+  const std::string quantized_model = QuantizeFullyConnectedWeights(
+      tflite::GetModel(buffer->data()), &num_quantized_tensors);
+  EXPECT_GT(num_quantized_tensors, 0);
+
+  // The weights are quantized with one scale per tensor.
+  for (const tflite::SubGraph* subgraph :
+       *tflite::GetModel(quantized_model.data())->subgraphs()) {
+    for (const tflite::Tensor* tensor : *subgraph->tensors()) {
+      if (tensor->type() == tflite::TensorType_INT8) {
+        EXPECT_EQ(tensor->quantization()->scale()->size(), 1);
+        EXPECT_EQ(tensor->quantization()->zero_point()->size(), 1);
+      }
+    }
+  }
+
+  const std::unique_ptr<ModelExecutor> float_executor =
+      ModelExecutor::FromBuffer(buffer);
+  const std::unique_ptr<ModelExecutor> quantized_executor =
+      ModelExecutor::FromBufferWithQuantizedWeights(buffer);
+  ASSERT_TRUE(float_executor);
+  ASSERT_TRUE(quantized_executor);
+  std::unique_ptr<tflite::Interpreter> float_interpreter =
+      float_executor->CreateInterpreter();
+  std::unique_ptr<tflite::Interpreter> quantized_interpreter =
+      quantized_executor->CreateInterpreter();
+  ASSERT_TRUE(float_interpreter);
+  ASSERT_TRUE(quantized_interpreter);
+
+  const TfLiteTensor* input =
+      float_interpreter->tensor(float_interpreter->inputs()[0]);
+  const int num_features = input->dims->data[input->dims->size - 1];
+  const int batch_size = 4;
+  std::vector<float> features;
+  for (int i = 0; i < batch_size * num_features; ++i) {
+    features.push_back((i * 37 % 101 - 50) / 50.0f);
+  }
+  const TensorView<float> features_view(features.data(),
+                                        {batch_size, num_features});
+
+  const TensorView<float> float_logits =
+      float_executor->ComputeLogits(features_view, float_interpreter.get());
+  const TensorView<float> quantized_logits = quantized_executor->ComputeLogits(
+      features_view, quantized_interpreter.get());
+  ASSERT_TRUE(float_logits.is_valid());
+  ASSERT_TRUE(quantized_logits.is_valid());
+  ASSERT_EQ(float_logits.size(), quantized_logits.size());
+
+  float max_abs_logit = 0.0f;
+  for (int i = 0; i < float_logits.size(); ++i) {
+    max_abs_logit = std::max(max_abs_logit, std::abs(float_logits.data()[i]));
+  }
+  for (int i = 0; i < float_logits.size(); ++i) {
+    EXPECT_NEAR(quantized_logits.data()[i], float_logits.data()[i],
+                0.05f * max_abs_logit + 1e-3f)
+        << i;
+  }
+}
+
+TEST(ModelExecutorTest, QuantizedWeightsGiveCloseLogits) {
+  const std::string model_buffer = ReadFile(GetModelPath() + "test_model.fb");
+  const Model* model = GetModel(model_buffer.data());
+  ASSERT_TRUE(model);
+  ExpectQuantizedLogitsClose(model->selection_model());
+  ExpectQuantizedLogitsClose(model->classification_model());
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/native-verifiers.h"
+
+#include <ctype.h>
+
+#include "utils/base/logging.h"
+#include "utils/checksum.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Parses a fixed number of digits starting at `pos`.
+bool ParseDigits(StringPiece input, const int pos, const int num_digits,
+                 int* value) {
+  if (pos + num_digits > input.size()) {
+    return false;
+  }
+  *value = 0;
+  for (int i = pos; i < pos + num_digits; i++) {
+    if (!isdigit(input[i])) {
+      return false;
+    }
+    *value = *value * 10 + (input[i] - '0');
+  }
+  return true;
+}
+
+bool IsLeapYear(const int year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+}  // namespace
+
+bool VerifyIpv4Address(StringPiece input) {
+  int num_octets = 0;
+  int pos = 0;
+  while (num_octets < 4) {
+    if (num_octets > 0) {
+      if (pos >= input.size() || input[pos] != '.') {
+        return false;
+      }
+      ++pos;
+    }
+    const int octet_begin = pos;
+    int octet = 0;
+    while (pos < input.size() && isdigit(input[pos])) {
+      octet = octet * 10 + (input[pos] - '0');
+      ++pos;
+      if (pos - octet_begin > 3) {
+        return false;
+      }
+    }
+    const int octet_length = pos - octet_begin;
+    if (octet_length == 0 || octet > 255 ||
+        (octet_length > 1 && input[octet_begin] == '0')) {
+      return false;
+    }
+    ++num_octets;
+  }
+  return pos == input.size();
+}
+
+bool VerifyIsoDate(StringPiece input) {
+  static const int kDaysInMonth[] = {31, 28, 31, 30, 31, 30,
+                                     31, 31, 30, 31, 30, 31};
+  int year, month, day;
+  if (input.size() != 10 || input[4] != '-' || input[7] != '-' ||
+      !ParseDigits(input, 0, 4, &year) || !ParseDigits(input, 5, 2, &month) ||
+      !ParseDigits(input, 8, 2, &day)) {
+    return false;
+  }
+  if (month < 1 || month > 12 || day < 1) {
+    return false;
+  }
+  int days_in_month = kDaysInMonth[month - 1];
+  if (month == 2 && IsLeapYear(year)) {
+    days_in_month = 29;
+  }
+  return day <= days_in_month;
+}
+
+bool RunNativeVerifier(NativeVerifierType type, StringPiece match) {
+  switch (type) {
+    case NativeVerifierType_NONE:
+      return true;
+    case NativeVerifierType_LUHN:
+      return VerifyLuhnChecksum(match);
+    case NativeVerifierType_IBAN:
+      return VerifyIbanChecksum(match);
+    case NativeVerifierType_ISBN10:
+      return VerifyIsbn10Checksum(match);
+    case NativeVerifierType_ISBN13:
+      return VerifyIsbn13Checksum(match);
+    case NativeVerifierType_IPV4:
+      return VerifyIpv4Address(match);
+    case NativeVerifierType_ISO_DATE:
+      return VerifyIsoDate(match);
+  }
+  TC3_LOG(ERROR) << "Unknown native verifier: " << static_cast<int>(type);
+  return false;
+}
+
+}  // namespace libtextclassifier3
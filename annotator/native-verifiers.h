@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Natively implemented verifiers for the text of regex matches. They cover the
+// common checks that would otherwise need a lua verifier and don't allocate.
+
+#ifndef LIBTEXTCLASSIFIER_ANNOTATOR_NATIVE_VERIFIERS_H_
+#define LIBTEXTCLASSIFIER_ANNOTATOR_NATIVE_VERIFIERS_H_
+
+#include "annotator/model_generated.h"
+#include "utils/strings/stringpiece.h"
+
+namespace libtextclassifier3 {
+
+// Verifies a dotted-quad IPv4 address, e.g. "192.168.0.1". Octets need to be
+// in the range 0-255 and must not have leading zeros.
+bool VerifyIpv4Address(StringPiece input);
+
+// Verifies that an ISO 8601 calendar date (YYYY-MM-DD) exists, taking leap
+// years into account.
+bool VerifyIsoDate(StringPiece input);
+
+// Runs the native verifier of the given type on the text of a match.
+// Returns true for NativeVerifierType_NONE.
+bool RunNativeVerifier(NativeVerifierType type, StringPiece match);
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_ANNOTATOR_NATIVE_VERIFIERS_H_
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the native verifiers against the equivalent lua verifier, on the
+// same candidate matches.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "annotator/native-verifiers.h"
+#include "utils/regex-match.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+constexpr char kLuhnVerifier[] = R"(
+function luhn(candidate)
+    local sum = 0
+    local num_digits = string.len(candidate)
+    local parity = num_digits % 2
+    for pos = 1,num_digits do
+      d = tonumber(string.sub(candidate, pos, pos))
+      if pos % 2 ~= parity then
+        d = d * 2
+      end
+      if d > 9 then
+        d = d - 9
+      end
+      sum = sum + d
+    end
+    return (sum % 10) == 0
+end
+return luhn(context);
+)";
+
+std::vector<std::string> CardNumberCandidates(const int num_candidates) {
+  std::vector<std::string> candidates;
+  candidates.reserve(num_candidates);
+  for (int i = 0; i < num_candidates; i++) {
+    candidates.push_back(std::to_string(4012888888881881LL + i));
+  }
+  return candidates;
+}
+
+void BM_LuaLuhnVerifier(benchmark::State& state) {
+  const std::vector<std::string> candidates =
+      CardNumberCandidates(state.range(0));
+  std::unique_ptr<CompiledLuaVerifier> verifier =
+      CompiledLuaVerifier::Create(kLuhnVerifier);
+  for (auto _ : state) {
+    for (const std::string& candidate : candidates) {
+      benchmark::DoNotOptimize(
+          verifier->Verify(candidate, /*matcher=*/nullptr));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * candidates.size());
+}
+BENCHMARK(BM_LuaLuhnVerifier)->Arg(100)->Arg(1000);
+
+void BM_NativeVerifier(benchmark::State& state) {
+  const NativeVerifierType type =
+      static_cast<NativeVerifierType>(state.range(0));
+  const std::vector<std::string> candidates =
+      CardNumberCandidates(state.range(1));
+  for (auto _ : state) {
+    for (const std::string& candidate : candidates) {
+      benchmark::DoNotOptimize(RunNativeVerifier(type, candidate));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * candidates.size());
+}
+BENCHMARK(BM_NativeVerifier)
+    ->Args({NativeVerifierType_LUHN, 100})
+    ->Args({NativeVerifierType_LUHN, 1000})
+    ->Args({NativeVerifierType_ISBN13, 1000})
+    ->Args({NativeVerifierType_IPV4, 1000});
+
+}  // namespace
+}  // namespace libtextclassifier3
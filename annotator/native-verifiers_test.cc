@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/native-verifiers.h"
+
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+TEST(NativeVerifiersTest, VerifiesIpv4Addresses) {
+  EXPECT_TRUE(VerifyIpv4Address("192.168.0.1"));
+  EXPECT_TRUE(VerifyIpv4Address("0.0.0.0"));
+  EXPECT_TRUE(VerifyIpv4Address("255.255.255.255"));
+  EXPECT_FALSE(VerifyIpv4Address("256.1.1.1"));
+  EXPECT_FALSE(VerifyIpv4Address("1.1.1"));
+  EXPECT_FALSE(VerifyIpv4Address("1.1.1.1.1"));
+  EXPECT_FALSE(VerifyIpv4Address("01.1.1.1"));
+  EXPECT_FALSE(VerifyIpv4Address("1.1..1"));
+  EXPECT_FALSE(VerifyIpv4Address("1.1.1.1000"));
+  EXPECT_FALSE(VerifyIpv4Address(""));
+}
+
+TEST(NativeVerifiersTest, VerifiesIsoDates) {
+  EXPECT_TRUE(VerifyIsoDate("2018-12-31"));
+  EXPECT_TRUE(VerifyIsoDate("2016-02-29"));
+  EXPECT_TRUE(VerifyIsoDate("2000-02-29"));
+  EXPECT_FALSE(VerifyIsoDate("1900-02-29"));
+  EXPECT_FALSE(VerifyIsoDate("2018-02-29"));
+  EXPECT_FALSE(VerifyIsoDate("2018-13-01"));
+  EXPECT_FALSE(VerifyIsoDate("2018-04-31"));
+  EXPECT_FALSE(VerifyIsoDate("2018-00-10"));
+  EXPECT_FALSE(VerifyIsoDate("2018/01/10"));
+  EXPECT_FALSE(VerifyIsoDate("2018-1-10"));
+}
+
+TEST(NativeVerifiersTest, DispatchesByType) {
+  EXPECT_TRUE(RunNativeVerifier(NativeVerifierType_NONE, "anything"));
+  EXPECT_TRUE(RunNativeVerifier(NativeVerifierType_LUHN, "4012888888881881"));
+  EXPECT_FALSE(RunNativeVerifier(NativeVerifierType_LUHN, "4012888888881882"));
+  EXPECT_TRUE(RunNativeVerifier(NativeVerifierType_IBAN,
+                                "GB82 WEST 1234 5698 7654 32"));
+  EXPECT_TRUE(RunNativeVerifier(NativeVerifierType_ISBN10, "0-306-40615-2"));
+  EXPECT_TRUE(
+      RunNativeVerifier(NativeVerifierType_ISBN13, "978-0-306-40615-7"));
+  EXPECT_TRUE(RunNativeVerifier(NativeVerifierType_IPV4, "10.0.0.1"));
+  EXPECT_FALSE(RunNativeVerifier(NativeVerifierType_ISO_DATE, "2018-02-30"));
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -21,6 +21,7 @@
 
 #include "annotator/collections.h"
 #include "utils/base/logging.h"
+#include "utils/strings/utf8.h"
 
 namespace libtextclassifier3 {
 
@@ -28,14 +29,15 @@ bool NumberAnnotator::ClassifyText(
     const UnicodeText& context, CodepointSpan selection_indices,
     AnnotationUsecase annotation_usecase,
     ClassificationResult* classification_result) const {
+  const UnicodeText selection =
+      UnicodeText::Substring(context, selection_indices.first,
+                             selection_indices.second, /*do_copy=*/false);
   int64 parsed_value;
   int num_prefix_codepoints;
   int num_suffix_codepoints;
-  if (ParseNumber(UnicodeText::Substring(context, selection_indices.first,
-                                         selection_indices.second),
+  if (ParseNumber(StringPiece(selection.data(), selection.size_bytes()),
                   &parsed_value, &num_prefix_codepoints,
                   &num_suffix_codepoints)) {
-    ClassificationResult classification{Collections::Number(), 1.0};
     TC3_CHECK(classification_result != nullptr);
     classification_result->collection = Collections::Number();
     classification_result->score = options_->score();
@@ -54,134 +56,159 @@ bool NumberAnnotator::FindAll(const UnicodeText& context,
     return true;
   }
 
-  const std::vector<Token> tokens = feature_processor_->Tokenize(context);
+  return FindAll(context, feature_processor_->Tokenize(context),
+                 annotation_usecase, result);
+}
+
+bool NumberAnnotator::FindAll(const UnicodeText& context,
+                              const std::vector<Token>& tokens,
+                              AnnotationUsecase annotation_usecase,
+                              std::vector<AnnotatedSpan>* result) const {
+  AnnotationCandidates candidates;
+  if (!FindAll(context, tokens, annotation_usecase, &candidates)) {
+    return false;
+  }
+  candidates.MoveTo(result);
+  return true;
+}
+
+bool NumberAnnotator::FindAll(const UnicodeText& context,
+                              AnnotationUsecase annotation_usecase,
+                              AnnotationCandidates* result) const {
+  if (!options_->enabled() || ((1 << annotation_usecase) &
+                               options_->enabled_annotation_usecases()) == 0) {
+    return true;
+  }
+
+  return FindAll(context, feature_processor_->Tokenize(context),
+                 annotation_usecase, result);
+}
+
+bool NumberAnnotator::FindAll(const UnicodeText& context,
+                              const std::vector<Token>& tokens,
+                              AnnotationUsecase annotation_usecase,
+                              AnnotationCandidates* result) const {
+  if (!options_->enabled() || ((1 << annotation_usecase) &
+                               options_->enabled_annotation_usecases()) == 0) {
+    return true;
+  }
+
   for (const Token& token : tokens) {
-    const UnicodeText token_text =
-        UTF8ToUnicodeText(token.value, /*do_copy=*/false);
     int64 parsed_value;
     int num_prefix_codepoints;
     int num_suffix_codepoints;
-    if (ParseNumber(token_text, &parsed_value, &num_prefix_codepoints,
+    if (ParseNumber(token.value, &parsed_value, &num_prefix_codepoints,
                     &num_suffix_codepoints)) {
-      ClassificationResult classification{Collections::Number(),
-                                          options_->score()};
-      classification.numeric_value = parsed_value;
-      classification.priority_score = options_->priority_score();
-
-      AnnotatedSpan annotated_span;
-      annotated_span.span = {token.start + num_prefix_codepoints,
-                             token.end - num_suffix_codepoints};
-      annotated_span.classification.push_back(classification);
-
-      result->push_back(annotated_span);
+      result->Add({token.start + num_prefix_codepoints,
+                   token.end - num_suffix_codepoints},
+                  Collections::Number(), options_->score(),
+                  options_->priority_score(), parsed_value);
     }
   }
 
   return true;
 }
 
-std::unordered_set<int> NumberAnnotator::FlatbuffersVectorToSet(
+NumberAnnotator::CodepointSet::CodepointSet(
     const flatbuffers::Vector<int32_t>* codepoints) {
   if (codepoints == nullptr) {
-    return std::unordered_set<int>{};
+    return;
   }
-
-  std::unordered_set<int> result;
   for (const int codepoint : *codepoints) {
-    result.insert(codepoint);
+    if (codepoint >= 0 && codepoint < kNumAsciiCodepoints) {
+      ascii_codepoints_.set(codepoint);
+    } else {
+      other_codepoints_.push_back(codepoint);
+    }
   }
-  return result;
+  std::sort(other_codepoints_.begin(), other_codepoints_.end());
 }
 
 namespace {
-UnicodeText::const_iterator ConsumeAndParseNumber(
-    const UnicodeText::const_iterator& it_begin,
-    const UnicodeText::const_iterator& it_end, int64* result) {
+
+// Counts the codepoints in a UTF-8 byte range.
+int CountCodepoints(const char* begin, const char* end) {
+  int num_codepoints = 0;
+  for (const char* it = begin; it < end; ++it) {
+    if (!IsTrailByte(*it)) {
+      ++num_codepoints;
+    }
+  }
+  return num_codepoints;
+}
+
+// Parses an optionally signed sequence of ASCII digits from the UTF-8 bytes.
+// Returns the position after the parsed number, or `begin` if the number would
+// overflow.
+const char* ConsumeAndParseNumber(const char* begin, const char* end,
+                                  int64* result) {
   *result = 0;
 
   // See if there's a sign in the beginning of the number.
   int sign = 1;
-  auto it = it_begin;
-  if (it != it_end) {
-    if (*it == '-') {
-      ++it;
-      sign = -1;
-    } else if (*it == '+') {
-      ++it;
-      sign = 1;
-    }
+  const char* it = begin;
+  if (it != end && (*it == '-' || *it == '+')) {
+    sign = (*it == '-') ? -1 : 1;
+    ++it;
   }
 
-  while (it != it_end) {
-    if (*it >= '0' && *it <= '9') {
-      // When overflow is imminent we'll fail to parse the number.
-      if (*result > INT64_MAX / 10) {
-        return it_begin;
-      }
-      *result *= 10;
-      *result += *it - '0';
-    } else {
-      *result *= sign;
-      return it;
+  for (; it != end && *it >= '0' && *it <= '9'; ++it) {
+    const int digit = *it - '0';
+    // When overflow is imminent we'll fail to parse the number.
+    if (*result > (INT64_MAX - digit) / 10) {
+      return begin;
     }
-
-    ++it;
+    *result = *result * 10 + digit;
   }
 
   *result *= sign;
-  return it_end;
+  return it;
 }
+
 }  // namespace
 
-bool NumberAnnotator::ParseNumber(const UnicodeText& text, int64* result,
+bool NumberAnnotator::ParseNumber(StringPiece text, int64* result,
                                   int* num_prefix_codepoints,
                                   int* num_suffix_codepoints) const {
   TC3_CHECK(result != nullptr && num_prefix_codepoints != nullptr &&
             num_suffix_codepoints != nullptr);
-  auto it = text.begin();
-  auto it_end = text.end();
+  const char* text_end = text.data() + text.size();
 
   // Strip boundary codepoints from both ends.
-  const CodepointSpan original_span{0, text.size_codepoints()};
-  const CodepointSpan stripped_span =
-      feature_processor_->StripBoundaryCodepoints(text, original_span);
-  const int num_stripped_end = (original_span.second - stripped_span.second);
-  std::advance(it, stripped_span.first);
-  std::advance(it_end, -num_stripped_end);
+  const StringPiece stripped =
+      feature_processor_->StripBoundaryCodepoints(text);
+  const char* stripped_end = stripped.data() + stripped.size();
+  const int num_stripped_end = CountCodepoints(stripped_end, text_end);
 
   // Consume prefix codepoints.
-  *num_prefix_codepoints = stripped_span.first;
-  while (it != text.end()) {
-    if (allowed_prefix_codepoints_.find(*it) ==
-        allowed_prefix_codepoints_.end()) {
-      break;
-    }
-
+  *num_prefix_codepoints = CountCodepoints(text.data(), stripped.data());
+  const UnicodeText stripped_unicode =
+      UTF8ToUnicodeText(stripped.data(), stripped.size(), /*do_copy=*/false);
+  auto it = stripped_unicode.begin();
+  while (it != stripped_unicode.end() &&
+         allowed_prefix_codepoints_.Contains(*it)) {
     ++it;
     ++(*num_prefix_codepoints);
   }
 
-  auto it_start = it;
-  it = ConsumeAndParseNumber(it, text.end(), result);
-  if (it == it_start) {
+  const char* number_begin = it.utf8_data();
+  const char* number_end =
+      ConsumeAndParseNumber(number_begin, stripped_end, result);
+  if (number_end == number_begin) {
     return false;
   }
 
   // Consume suffix codepoints.
-  bool valid_suffix = true;
-  *num_suffix_codepoints = 0;
-  while (it != it_end) {
-    if (allowed_suffix_codepoints_.find(*it) ==
-        allowed_suffix_codepoints_.end()) {
-      valid_suffix = false;
-      break;
+  *num_suffix_codepoints = num_stripped_end;
+  const UnicodeText suffix = UTF8ToUnicodeText(
+      number_end, stripped_end - number_end, /*do_copy=*/false);
+  for (const char32 codepoint : suffix) {
+    if (!allowed_suffix_codepoints_.Contains(codepoint)) {
+      return false;
     }
-
-    ++it;
     ++(*num_suffix_codepoints);
   }
-  *num_suffix_codepoints += num_stripped_end;
-  return valid_suffix;
+  return true;
 }
 
 }  // namespace libtextclassifier3
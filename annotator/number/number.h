@@ -17,13 +17,16 @@
 #ifndef LIBTEXTCLASSIFIER_ANNOTATOR_NUMBER_NUMBER_H_
 #define LIBTEXTCLASSIFIER_ANNOTATOR_NUMBER_NUMBER_H_
 
+#include <algorithm>
+#include <bitset>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
+#include "annotator/annotation-candidates.h"
 #include "annotator/feature-processor.h"
 #include "annotator/model_generated.h"
 #include "annotator/types.h"
+#include "utils/strings/stringpiece.h"
 #include "utils/utf8/unicodetext.h"
 
 namespace libtextclassifier3 {
@@ -40,10 +43,8 @@ class NumberAnnotator {
                            const FeatureProcessor* feature_processor)
       : options_(options),
         feature_processor_(feature_processor),
-        allowed_prefix_codepoints_(
-            FlatbuffersVectorToSet(options->allowed_prefix_codepoints())),
-        allowed_suffix_codepoints_(
-            FlatbuffersVectorToSet(options->allowed_suffix_codepoints())) {}
+        allowed_prefix_codepoints_(options->allowed_prefix_codepoints()),
+        allowed_suffix_codepoints_(options->allowed_suffix_codepoints()) {}
 
   // Classifies given text, and if it is a number, it passes the result in
   // 'classification_result' and returns true, otherwise returns false.
@@ -56,21 +57,57 @@ class NumberAnnotator {
                AnnotationUsecase annotation_usecase,
                std::vector<AnnotatedSpan>* result) const;
 
+  // Same as above, but uses the given tokens of the context, so that the
+  // tokenization can be shared with other annotators.
+  bool FindAll(const UnicodeText& context_unicode,
+               const std::vector<Token>& tokens,
+               AnnotationUsecase annotation_usecase,
+               std::vector<AnnotatedSpan>* result) const;
+
+  // Same as above, but adds the numbers to the compact candidates used by the
+  // annotator.
+  bool FindAll(const UnicodeText& context_unicode,
+               AnnotationUsecase annotation_usecase,
+               AnnotationCandidates* result) const;
+  bool FindAll(const UnicodeText& context_unicode,
+               const std::vector<Token>& tokens,
+               AnnotationUsecase annotation_usecase,
+               AnnotationCandidates* result) const;
+
  private:
-  static std::unordered_set<int> FlatbuffersVectorToSet(
-      const flatbuffers::Vector<int32_t>* codepoints);
+  // Set of codepoints, with a bitmap for the ASCII range, where the commonly
+  // used prefix and suffix codepoints are.
+  class CodepointSet {
+   public:
+    explicit CodepointSet(const flatbuffers::Vector<int32_t>* codepoints);
+
+    bool Contains(const int codepoint) const {
+      if (codepoint >= 0 && codepoint < kNumAsciiCodepoints) {
+        return ascii_codepoints_[codepoint];
+      }
+      return std::binary_search(other_codepoints_.begin(),
+                                other_codepoints_.end(), codepoint);
+    }
+
+   private:
+    static constexpr int kNumAsciiCodepoints = 128;
+    std::bitset<kNumAsciiCodepoints> ascii_codepoints_;
+
+    // Sorted non-ASCII codepoints.
+    std::vector<int> other_codepoints_;
+  };
 
   // Parses the text to an int64 value and returns true if succeeded, otherwise
   // false. Also returns the number of prefix/suffix codepoints that were
   // stripped from the number.
-  bool ParseNumber(const UnicodeText& text, int64* result,
-                   int* num_prefix_codepoints,
+  // Works directly on the UTF-8 bytes of the text and doesn't allocate.
+  bool ParseNumber(StringPiece text, int64* result, int* num_prefix_codepoints,
                    int* num_suffix_codepoints) const;
 
   const NumberAnnotatorOptions* options_;
   const FeatureProcessor* feature_processor_;
-  const std::unordered_set<int> allowed_prefix_codepoints_;
-  const std::unordered_set<int> allowed_suffix_codepoints_;
+  const CodepointSet allowed_prefix_codepoints_;
+  const CodepointSet allowed_suffix_codepoints_;
 };
 
 }  // namespace libtextclassifier3
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks finding numbers in numeric-heavy text, like tables and logs.
+
+#include <string>
+#include <vector>
+
+#include "annotator/feature-processor.h"
+#include "annotator/model_generated.h"
+#include "annotator/number/number.h"
+#include "annotator/types.h"
+#include "utils/utf8/unicodetext.h"
+#include "utils/utf8/unilib.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+const NumberAnnotatorOptions* BenchmarkNumberAnnotatorOptions() {
+  static const flatbuffers::DetachedBuffer* options_data = []() {
+    NumberAnnotatorOptionsT options;
+    options.enabled = true;
+    options.allowed_prefix_codepoints = {'$', 0x20AC};
+    options.allowed_suffix_codepoints = {'%'};
+
+    flatbuffers::FlatBufferBuilder builder;
+    builder.Finish(NumberAnnotatorOptions::Pack(builder, &options));
+    return new flatbuffers::DetachedBuffer(builder.Release());
+  }();
+
+  return flatbuffers::GetRoot<NumberAnnotatorOptions>(options_data->data());
+}
+
+const FeatureProcessorOptions* BenchmarkFeatureProcessorOptions() {
+  static const flatbuffers::DetachedBuffer* options_data = []() {
+    FeatureProcessorOptionsT options;
+    options.context_size = 1;
+    options.max_selection_span = 1;
+    options.snap_label_span_boundaries_to_containing_tokens = false;
+    options.ignored_span_boundary_codepoints = {',', '.', ':', '|'};
+
+    options.tokenization_codepoint_config.emplace_back(
+        new TokenizationCodepointRangeT());
+    auto& config = options.tokenization_codepoint_config.back();
+    config->start = 32;
+    config->end = 33;
+    config->role = TokenizationCodepointRange_::Role_WHITESPACE_SEPARATOR;
+
+    flatbuffers::FlatBufferBuilder builder;
+    builder.Finish(FeatureProcessorOptions::Pack(builder, &options));
+    return new flatbuffers::DetachedBuffer(builder.Release());
+  }();
+
+  return flatbuffers::GetRoot<FeatureProcessorOptions>(options_data->data());
+}
+
+// Builds a text of roughly `num_bytes` consisting of table rows and log lines.
+std::string NumericText(const int num_bytes) {
+  std::string text;
+  for (int i = 0; text.size() < num_bytes; i++) {
+    if (i % 2 == 0) {
+      text += "| " + std::to_string(i) + " | $" +
+              std::to_string(i * 37 % 1000) + " | " + std::to_string(i % 100) +
+              "% | -" + std::to_string(i * 7919) + " |\n";
+    } else {
+      text += "2019 04 " + std::to_string(i % 28 + 1) + " 12:" +
+              std::to_string(i % 60) + " pid " + std::to_string(i * 131) +
+              " took " + std::to_string(i % 997) + " ms, rc=0\n";
+    }
+  }
+  return text;
+}
+
+class NumberAnnotatorFixture {
+ public:
+  NumberAnnotatorFixture()
+      : feature_processor_(BenchmarkFeatureProcessorOptions(), &unilib_),
+        annotator_(BenchmarkNumberAnnotatorOptions(), &feature_processor_) {}
+
+  const FeatureProcessor& feature_processor() const {
+    return feature_processor_;
+  }
+  const NumberAnnotator& annotator() const { return annotator_; }
+
+ private:
+  UniLib unilib_;
+  FeatureProcessor feature_processor_;
+  NumberAnnotator annotator_;
+};
+
+void BM_NumberFindAll(benchmark::State& state) {
+  const NumberAnnotatorFixture fixture;
+  const UnicodeText text =
+      UTF8ToUnicodeText(NumericText(state.range(0)), /*do_copy=*/true);
+
+  for (auto _ : state) {
+    std::vector<AnnotatedSpan> results;
+    fixture.annotator().FindAll(
+        text, AnnotationUsecase_ANNOTATION_USECASE_RAW, &results);
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size_bytes());
+}
+BENCHMARK(BM_NumberFindAll)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18);
+
+// Same as above, but with the tokens shared with other annotators, so only the
+// number parsing is measured.
+void BM_NumberFindAllWithTokens(benchmark::State& state) {
+  const NumberAnnotatorFixture fixture;
+  const UnicodeText text =
+      UTF8ToUnicodeText(NumericText(state.range(0)), /*do_copy=*/true);
+  const std::vector<Token> tokens = fixture.feature_processor().Tokenize(text);
+
+  for (auto _ : state) {
+    std::vector<AnnotatedSpan> results;
+    fixture.annotator().FindAll(
+        text, tokens, AnnotationUsecase_ANNOTATION_USECASE_RAW, &results);
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size_bytes());
+}
+BENCHMARK(BM_NumberFindAllWithTokens)
+    ->Arg(1 << 10)
+    ->Arg(1 << 14)
+    ->Arg(1 << 18);
+
+}  // namespace
+}  // namespace libtextclassifier3
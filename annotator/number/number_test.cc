@@ -41,6 +41,7 @@ const NumberAnnotatorOptions* TestingNumberAnnotatorOptions() {
     NumberAnnotatorOptionsT options;
     options.enabled = true;
     options.allowed_prefix_codepoints.push_back('$');
+    options.allowed_prefix_codepoints.push_back(0x20AC);  // Euro sign.
     options.allowed_suffix_codepoints.push_back('%');
 
     flatbuffers::FlatBufferBuilder builder;
@@ -254,5 +255,50 @@ TEST_F(NumberAnnotatorTest, WhenPrefixAndSuffixWithoutNumberDoesNotParseIt) {
   ASSERT_EQ(result.size(), 0);
 }
 
+TEST_F(NumberAnnotatorTest, FindsNumberWithNonAsciiPrefix) {
+  std::vector<AnnotatedSpan> result;
+  EXPECT_TRUE(number_annotator_.FindAll(
+      UTF8ToUnicodeText("I paid \u20AC42, ok?"),
+      AnnotationUsecase_ANNOTATION_USECASE_RAW, &result));
+
+  EXPECT_THAT(
+      result,
+      ElementsAre(
+          AllOf(Field(&AnnotatedSpan::span, CodepointSpan(8, 10)),
+                Field(&AnnotatedSpan::classification,
+                      ElementsAre(AllOf(
+                          Field(&ClassificationResult::collection, "number"),
+                          Field(&ClassificationResult::numeric_value, 42)))))));
+}
+
+TEST_F(NumberAnnotatorTest, FindsAllNumbersInGivenTokens) {
+  const UnicodeText text = UTF8ToUnicodeText("... 12345 ... 9 ...");
+  std::vector<AnnotatedSpan> result;
+  EXPECT_TRUE(number_annotator_.FindAll(
+      text, feature_processor_.Tokenize(text),
+      AnnotationUsecase_ANNOTATION_USECASE_RAW, &result));
+
+  EXPECT_THAT(
+      result,
+      ElementsAre(Field(&AnnotatedSpan::span, CodepointSpan(4, 9)),
+                  Field(&AnnotatedSpan::span, CodepointSpan(14, 15))));
+}
+
+TEST_F(NumberAnnotatorTest, WhenLargestInt64ParsesIt) {
+  ClassificationResult classification_result;
+  EXPECT_TRUE(number_annotator_.ClassifyText(
+      UTF8ToUnicodeText("9223372036854775807"), {0, 19},
+      AnnotationUsecase_ANNOTATION_USECASE_RAW, &classification_result));
+
+  EXPECT_EQ(classification_result.numeric_value, INT64_MAX);
+}
+
+TEST_F(NumberAnnotatorTest, WhenInt64OverflowsDoesNotParseIt) {
+  ClassificationResult classification_result;
+  EXPECT_FALSE(number_annotator_.ClassifyText(
+      UTF8ToUnicodeText("9223372036854775808"), {0, 19},
+      AnnotationUsecase_ANNOTATION_USECASE_RAW, &classification_result));
+}
+
 }  // namespace
 }  // namespace libtextclassifier3
@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/result-cache.h"
+
+#include <algorithm>
+
+#include "annotator/annotator.h"
+#include "utils/base/logging.h"
+#include "utils/hash/farmhash.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+const int64 kMillisInMinute = 60 * 1000;
+
+// Appends a field to the key, terminated so that consecutive fields can't be
+// confused.
+void AppendKeyField(const std::string& field, std::string* key) {
+  key->append(field);
+  key->push_back('\0');
+}
+
+std::string AnnotationKey(const std::string& context,
+                          const AnnotationOptions& options) {
+  std::vector<std::string> entity_types(options.entity_types.begin(),
+                                        options.entity_types.end());
+  std::sort(entity_types.begin(), entity_types.end());
+
+  std::string key = "A";
+  AppendKeyField(options.locales, &key);
+  AppendKeyField(options.detected_text_language_tags, &key);
+  AppendKeyField(options.reference_timezone, &key);
+  AppendKeyField(std::to_string(options.annotation_usecase), &key);
+  AppendKeyField(options.is_serialized_entity_data_enabled ? "1" : "0", &key);
+  AppendKeyField(std::to_string(entity_types.size()), &key);
+  for (const std::string& entity_type : entity_types) {
+    AppendKeyField(entity_type, &key);
+  }
+  key.append(context);
+  return key;
+}
+
+std::string ClassificationKey(const std::string& context,
+                              CodepointSpan selection_indices,
+                              const ClassificationOptions& options) {
+  std::string key = "C";
+  AppendKeyField(std::to_string(selection_indices.first), &key);
+  AppendKeyField(std::to_string(selection_indices.second), &key);
+  AppendKeyField(options.locales, &key);
+  AppendKeyField(options.detected_text_language_tags, &key);
+  AppendKeyField(options.reference_timezone, &key);
+  AppendKeyField(std::to_string(options.annotation_usecase), &key);
+  key.append(context);
+  return key;
+}
+
+uint64 Fingerprint(const std::string& key) {
+  return tc3farmhash::Fingerprint64(key.data(), key.size());
+}
+
+int64 MemoryBytes(const ClassificationResult& result) {
+  return sizeof(result) + result.collection.size() +
+         result.serialized_knowledge_result.size() +
+         result.contact_name.size() + result.contact_given_name.size() +
+         result.contact_nickname.size() + result.contact_email_address.size() +
+         result.contact_phone_number.size() + result.contact_id.size() +
+         result.app_name.size() + result.app_package_name.size() +
+         result.serialized_entity_data.size();
+}
+
+void CollectDatetimes(const std::vector<ClassificationResult>& classification,
+                      std::vector<const DatetimeParseResult*>* datetimes) {
+  for (const ClassificationResult& result : classification) {
+    if (result.datetime_parse_result.IsSet()) {
+      datetimes->push_back(&result.datetime_parse_result);
+    }
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<ResultCache> ResultCache::Create(
+    const ResultCacheOptions& options) {
+  if (options.num_shards <= 0 || options.max_memory_bytes <= 0) {
+    TC3_LOG(ERROR) << "Invalid result cache options.";
+    return nullptr;
+  }
+  return std::unique_ptr<ResultCache>(new ResultCache(options));
+}
+
+ResultCache::ResultCache(const ResultCacheOptions& options)
+    : options_(options),
+      max_shard_memory_bytes_(options.max_memory_bytes / options.num_shards) {
+  for (int i = 0; i < options.num_shards; ++i) {
+    shards_.emplace_back(new Shard());
+  }
+}
+
+bool ResultCache::LookupAnnotations(const std::string& context,
+                                    const AnnotationOptions& options,
+                                    std::vector<AnnotatedSpan>* annotations) {
+  const std::string key = AnnotationKey(context, options);
+  const uint64 fingerprint = Fingerprint(key);
+  Shard* shard = ShardFor(fingerprint);
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  const Entry* entry =
+      Lookup(shard, fingerprint, key, options.reference_time_ms_utc);
+  if (entry == nullptr) {
+    return false;
+  }
+  *annotations = entry->annotations;
+  return true;
+}
+
+bool ResultCache::LookupClassification(
+    const std::string& context, CodepointSpan selection_indices,
+    const ClassificationOptions& options,
+    std::vector<ClassificationResult>* classification) {
+  const std::string key =
+      ClassificationKey(context, selection_indices, options);
+  const uint64 fingerprint = Fingerprint(key);
+  Shard* shard = ShardFor(fingerprint);
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  const Entry* entry =
+      Lookup(shard, fingerprint, key, options.reference_time_ms_utc);
+  if (entry == nullptr) {
+    return false;
+  }
+  *classification = entry->classification;
+  return true;
+}
+
+void ResultCache::InsertAnnotations(
+    const std::string& context, const AnnotationOptions& options,
+    const std::vector<AnnotatedSpan>& annotations) {
+  Entry entry;
+  std::vector<const DatetimeParseResult*> datetimes;
+  for (const AnnotatedSpan& annotation : annotations) {
+    CollectDatetimes(annotation.classification, &datetimes);
+  }
+  if (!SetReferenceTimeValidity(datetimes, options.reference_time_ms_utc,
+                                &entry)) {
+    return;
+  }
+
+  entry.key = AnnotationKey(context, options);
+  entry.annotations = annotations;
+  entry.memory_bytes = sizeof(Entry) + entry.key.size();
+  for (const AnnotatedSpan& annotation : annotations) {
+    entry.memory_bytes += sizeof(annotation);
+    for (const ClassificationResult& result : annotation.classification) {
+      entry.memory_bytes += MemoryBytes(result);
+    }
+  }
+
+  entry.fingerprint = Fingerprint(entry.key);
+  Shard* shard = ShardFor(entry.fingerprint);
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  Insert(shard, std::move(entry));
+}
+
+void ResultCache::InsertClassification(
+    const std::string& context, CodepointSpan selection_indices,
+    const ClassificationOptions& options,
+    const std::vector<ClassificationResult>& classification) {
+  Entry entry;
+  std::vector<const DatetimeParseResult*> datetimes;
+  CollectDatetimes(classification, &datetimes);
+  if (!SetReferenceTimeValidity(datetimes, options.reference_time_ms_utc,
+                                &entry)) {
+    return;
+  }
+
+  entry.key = ClassificationKey(context, selection_indices, options);
+  entry.classification = classification;
+  entry.memory_bytes = sizeof(Entry) + entry.key.size();
+  for (const ClassificationResult& result : classification) {
+    entry.memory_bytes += MemoryBytes(result);
+  }
+
+  entry.fingerprint = Fingerprint(entry.key);
+  Shard* shard = ShardFor(entry.fingerprint);
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  Insert(shard, std::move(entry));
+}
+
+void ResultCache::Clear() {
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->entries.clear();
+    shard->index.clear();
+    shard->memory_bytes = 0;
+  }
+}
+
+ResultCacheStats ResultCache::GetStats() const {
+  ResultCacheStats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.evictions = evictions_.load(std::memory_order_relaxed);
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    stats.num_entries += shard->entries.size();
+    stats.memory_bytes += shard->memory_bytes;
+  }
+  return stats;
+}
+
+const ResultCache::Entry* ResultCache::Lookup(Shard* shard, uint64 fingerprint,
+                                              const std::string& key,
+                                              int64 reference_time_ms_utc) {
+  const auto index_it = shard->index.find(fingerprint);
+  if (index_it == shard->index.end() || index_it->second->key != key) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  const std::list<Entry>::iterator it = index_it->second;
+  if (it->expiration <= Clock::now()) {
+    Erase(shard, it);
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  if (it->reference_time_unit_ms > 0 &&
+      reference_time_ms_utc / it->reference_time_unit_ms !=
+          it->reference_time_bucket) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  shard->entries.splice(shard->entries.begin(), shard->entries, it);
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  return &*it;
+}
+
+void ResultCache::Insert(Shard* shard, Entry entry) {
+  if (entry.memory_bytes > max_shard_memory_bytes_) {
+    return;
+  }
+
+  const auto index_it = shard->index.find(entry.fingerprint);
+  if (index_it != shard->index.end()) {
+    Erase(shard, index_it->second);
+  }
+  while (shard->memory_bytes + entry.memory_bytes > max_shard_memory_bytes_) {
+    Erase(shard, std::prev(shard->entries.end()));
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  entry.expiration =
+      options_.ttl_ms > 0
+          ? Clock::now() + std::chrono::milliseconds(options_.ttl_ms)
+          : Clock::time_point::max();
+  shard->memory_bytes += entry.memory_bytes;
+  shard->entries.push_front(std::move(entry));
+  shard->index[shard->entries.front().fingerprint] = shard->entries.begin();
+}
+
+void ResultCache::Erase(Shard* shard, std::list<Entry>::iterator it) {
+  shard->memory_bytes -= it->memory_bytes;
+  shard->index.erase(it->fingerprint);
+  shard->entries.erase(it);
+}
+
+bool ResultCache::SetReferenceTimeValidity(
+    const std::vector<const DatetimeParseResult*>& datetimes,
+    int64 reference_time_ms_utc, Entry* entry) const {
+  if (datetimes.empty()) {
+    entry->reference_time_unit_ms = 0;
+    return true;
+  }
+  if (!options_.cache_datetime_results) {
+    return false;
+  }
+
+  // A datetime rounded to its granularity has no seconds, while a relative
+  // datetime with a distance keeps the seconds of the reference time, so the
+  // two can be told apart unless the reference time has no seconds either.
+  bool minute_precision = reference_time_ms_utc % kMillisInMinute != 0;
+  for (const DatetimeParseResult* datetime : datetimes) {
+    if (datetime->granularity > GRANULARITY_MINUTE ||
+        datetime->time_ms_utc % kMillisInMinute != 0) {
+      minute_precision = false;
+    }
+  }
+  entry->reference_time_unit_ms = minute_precision ? kMillisInMinute : 1;
+  entry->reference_time_bucket =
+      reference_time_ms_utc / entry->reference_time_unit_ms;
+  return true;
+}
+
+ResultCache::Shard* ResultCache::ShardFor(uint64 fingerprint) {
+  return shards_[fingerprint % shards_.size()].get();
+}
+
+}  // namespace libtextclassifier3
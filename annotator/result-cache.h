@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cache of whole Annotate and ClassifyText results, for repeated requests.
+
+#ifndef LIBTEXTCLASSIFIER_ANNOTATOR_RESULT_CACHE_H_
+#define LIBTEXTCLASSIFIER_ANNOTATOR_RESULT_CACHE_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "annotator/types.h"
+#include "utils/base/integral_types.h"
+
+namespace libtextclassifier3 {
+
+struct AnnotationOptions;
+struct ClassificationOptions;
+
+struct ResultCacheOptions {
+  // Number of independently locked shards, to reduce lock contention.
+  int num_shards = 8;
+
+  // Approximate upper bound of the memory used by the cached results and
+  // their keys. Split evenly between the shards, each evicting its least
+  // recently used results when full.
+  int64 max_memory_bytes = 1 << 20;
+
+  // Time after which a cached result is dropped. Non-positive for no limit.
+  int64 ttl_ms = 10 * 60 * 1000;
+
+  // Whether results with datetimes are cached. Such results are only reused
+  // for requests whose reference time gives the same datetimes, see below.
+  bool cache_datetime_results = true;
+};
+
+struct ResultCacheStats {
+  int64 hits = 0;
+  int64 misses = 0;
+
+  // Results dropped because the cache was full or their TTL passed.
+  int64 evictions = 0;
+
+  int num_entries = 0;
+  int64 memory_bytes = 0;
+};
+
+// A bounded, sharded LRU cache of Annotate and ClassifyText results, keyed by
+// a fingerprint of the text and the options the results depend on.
+//
+// The reference time is not part of the key: results without datetimes don't
+// depend on it, and results with datetimes are only returned for reference
+// times that give the same datetimes. Datetimes rounded to their granularity
+// only depend on the local time truncated to the granularity, so they're
+// reused within the same minute of the reference time (the finest precision
+// of time zone offsets). Relative datetimes with a distance, e.g. "in 2 hours",
+// and datetimes with second granularity are only reused for the exact same
+// reference time.
+//
+// NOTE: This class is thread-safe.
+class ResultCache {
+ public:
+  // Returns nullptr if the options are invalid.
+  static std::unique_ptr<ResultCache> Create(const ResultCacheOptions& options);
+
+  // Returns whether the results for the request were cached, and if so fills
+  // them in.
+  bool LookupAnnotations(const std::string& context,
+                         const AnnotationOptions& options,
+                         std::vector<AnnotatedSpan>* annotations);
+  bool LookupClassification(const std::string& context,
+                            CodepointSpan selection_indices,
+                            const ClassificationOptions& options,
+                            std::vector<ClassificationResult>* classification);
+
+  // Caches the results of a request, replacing previous results for it.
+  void InsertAnnotations(const std::string& context,
+                         const AnnotationOptions& options,
+                         const std::vector<AnnotatedSpan>& annotations);
+  void InsertClassification(
+      const std::string& context, CodepointSpan selection_indices,
+      const ClassificationOptions& options,
+      const std::vector<ClassificationResult>& classification);
+
+  // Drops all cached results, e.g. when the annotator's data changes.
+  void Clear();
+
+  ResultCacheStats GetStats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    // The full key, to tell fingerprint collisions apart.
+    std::string key;
+    uint64 fingerprint = 0;
+
+    // Only one of them is set, depending on the kind of request.
+    std::vector<AnnotatedSpan> annotations;
+    std::vector<ClassificationResult> classification;
+
+    // The results are valid for reference times with the same quotient by
+    // reference_time_unit_ms, or for any reference time if it's 0.
+    int64 reference_time_unit_ms = 0;
+    int64 reference_time_bucket = 0;
+
+    Clock::time_point expiration;
+    int64 memory_bytes = 0;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+
+    // Most recently used first.
+    std::list<Entry> entries;
+    std::unordered_map<uint64, std::list<Entry>::iterator> index;
+    int64 memory_bytes = 0;
+  };
+
+  explicit ResultCache(const ResultCacheOptions& options);
+
+  // Returns the entry for the key that is valid at the reference time, moved
+  // to the front of the shard, or nullptr. Requires the shard's lock.
+  const Entry* Lookup(Shard* shard, uint64 fingerprint, const std::string& key,
+                      int64 reference_time_ms_utc);
+
+  // Inserts the entry, evicting others as needed. Requires the shard's lock.
+  void Insert(Shard* shard, Entry entry);
+
+  // Removes the entry. Requires the shard's lock.
+  void Erase(Shard* shard, std::list<Entry>::iterator it);
+
+  // Sets the reference time validity of the entry with the given datetimes,
+  // or returns false if they must not be cached.
+  bool SetReferenceTimeValidity(
+      const std::vector<const DatetimeParseResult*>& datetimes,
+      int64 reference_time_ms_utc, Entry* entry) const;
+
+  Shard* ShardFor(uint64 fingerprint);
+
+  const ResultCacheOptions options_;
+  const int64 max_shard_memory_bytes_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::atomic<int64> hits_{0};
+  std::atomic<int64> misses_{0};
+  std::atomic<int64> evictions_{0};
+};
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_ANNOTATOR_RESULT_CACHE_H_
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "annotator/result-cache.h"
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "annotator/annotator.h"
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+const int64 kMinute = 60 * 1000;
+
+// A reference time in the middle of a minute.
+const int64 kReferenceTime = 1000 * kMinute + 30 * 1000;
+
+std::vector<AnnotatedSpan> Annotations(const std::string& collection) {
+  return {AnnotatedSpan({0, 4}, {ClassificationResult(collection, 1.0)})};
+}
+
+std::vector<AnnotatedSpan> DatetimeAnnotations(
+    int64 time_ms_utc, DatetimeGranularity granularity) {
+  ClassificationResult result("datetime", 1.0);
+  result.datetime_parse_result = {time_ms_utc, granularity};
+  return {AnnotatedSpan({0, 8}, {result})};
+}
+
+std::string LookupCollection(ResultCache* cache, const std::string& context,
+                             const AnnotationOptions& options) {
+  std::vector<AnnotatedSpan> annotations;
+  if (!cache->LookupAnnotations(context, options, &annotations)) {
+    return "<miss>";
+  }
+  return annotations.empty() ? "" : annotations[0].classification[0].collection;
+}
+
+TEST(ResultCacheTest, CachesAnnotationsPerOptions) {
+  std::unique_ptr<ResultCache> cache = ResultCache::Create({});
+  ASSERT_TRUE(cache);
+  AnnotationOptions options;
+  options.locales = "en";
+  options.entity_types = {"phone", "email"};
+  cache->InsertAnnotations("text", options, Annotations("phone"));
+
+  EXPECT_EQ(LookupCollection(cache.get(), "text", options), "phone");
+  AnnotationOptions same_options = options;
+  same_options.entity_types = {"email", "phone"};
+  same_options.deadline = Deadline::InMilliseconds(1000);
+  EXPECT_EQ(LookupCollection(cache.get(), "text", same_options), "phone");
+
+  EXPECT_EQ(LookupCollection(cache.get(), "other text", options), "<miss>");
+  AnnotationOptions other_options = options;
+  other_options.locales = "de";
+  EXPECT_EQ(LookupCollection(cache.get(), "text", other_options), "<miss>");
+  other_options = options;
+  other_options.entity_types = {"phone"};
+  EXPECT_EQ(LookupCollection(cache.get(), "text", other_options), "<miss>");
+
+  const ResultCacheStats stats = cache->GetStats();
+  EXPECT_EQ(stats.hits, 2);
+  EXPECT_EQ(stats.misses, 3);
+  EXPECT_EQ(stats.num_entries, 1);
+  EXPECT_GT(stats.memory_bytes, 0);
+}
+
+TEST(ResultCacheTest, CachesClassificationPerSelection) {
+  std::unique_ptr<ResultCache> cache = ResultCache::Create({});
+  ASSERT_TRUE(cache);
+  const ClassificationOptions options;
+  cache->InsertClassification("call 123", {5, 8}, options,
+                              {ClassificationResult("phone", 1.0)});
+
+  std::vector<ClassificationResult> classification;
+  EXPECT_TRUE(cache->LookupClassification("call 123", {5, 8}, options,
+                                          &classification));
+  ASSERT_EQ(classification.size(), 1);
+  EXPECT_EQ(classification[0].collection, "phone");
+  EXPECT_FALSE(cache->LookupClassification("call 123", {0, 4}, options,
+                                           &classification));
+}
+
+TEST(ResultCacheTest, ReusesRoundedDatetimesWithinTheMinute) {
+  std::unique_ptr<ResultCache> cache = ResultCache::Create({});
+  ASSERT_TRUE(cache);
+  AnnotationOptions options;
+  options.reference_time_ms_utc = kReferenceTime;
+  cache->InsertAnnotations(
+      "tomorrow", options,
+      DatetimeAnnotations(2000 * kMinute, GRANULARITY_DAY));
+
+  options.reference_time_ms_utc = kReferenceTime + 20 * 1000;
+  EXPECT_EQ(LookupCollection(cache.get(), "tomorrow", options), "datetime");
+  options.reference_time_ms_utc = kReferenceTime + 40 * 1000;
+  EXPECT_EQ(LookupCollection(cache.get(), "tomorrow", options), "<miss>");
+}
+
+TEST(ResultCacheTest, ReusesRelativeDatetimesOnlyForSameReferenceTime) {
+  std::unique_ptr<ResultCache> cache = ResultCache::Create({});
+  ASSERT_TRUE(cache);
+  AnnotationOptions options;
+  options.reference_time_ms_utc = kReferenceTime;
+  cache->InsertAnnotations(
+      "in 2 hours", options,
+      DatetimeAnnotations(kReferenceTime + 120 * kMinute, GRANULARITY_HOUR));
+
+  EXPECT_EQ(LookupCollection(cache.get(), "in 2 hours", options), "datetime");
+  options.reference_time_ms_utc = kReferenceTime + 1;
+  EXPECT_EQ(LookupCollection(cache.get(), "in 2 hours", options), "<miss>");
+}
+
+TEST(ResultCacheTest, BypassesDatetimeResultsIfDisabled) {
+  ResultCacheOptions cache_options;
+  cache_options.cache_datetime_results = false;
+  std::unique_ptr<ResultCache> cache = ResultCache::Create(cache_options);
+  ASSERT_TRUE(cache);
+  AnnotationOptions options;
+  options.reference_time_ms_utc = kReferenceTime;
+  cache->InsertAnnotations(
+      "tomorrow", options,
+      DatetimeAnnotations(2000 * kMinute, GRANULARITY_DAY));
+  cache->InsertAnnotations("text", options, Annotations("phone"));
+
+  EXPECT_EQ(LookupCollection(cache.get(), "tomorrow", options), "<miss>");
+  EXPECT_EQ(LookupCollection(cache.get(), "text", options), "phone");
+}
+
+TEST(ResultCacheTest, EvictsLeastRecentlyUsedWhenFull) {
+  // Measures the memory of one entry to fit exactly two in the cache.
+  std::unique_ptr<ResultCache> cache = ResultCache::Create({});
+  ASSERT_TRUE(cache);
+  const AnnotationOptions options;
+  cache->InsertAnnotations("text 1", options, Annotations("phone"));
+  ResultCacheOptions cache_options;
+  cache_options.num_shards = 1;
+  cache_options.max_memory_bytes = 2 * cache->GetStats().memory_bytes;
+  cache = ResultCache::Create(cache_options);
+  ASSERT_TRUE(cache);
+
+  cache->InsertAnnotations("text 1", options, Annotations("phone"));
+  cache->InsertAnnotations("text 2", options, Annotations("email"));
+  EXPECT_EQ(LookupCollection(cache.get(), "text 1", options), "phone");
+  cache->InsertAnnotations("text 3", options, Annotations("url"));
+
+  EXPECT_EQ(LookupCollection(cache.get(), "text 1", options), "phone");
+  EXPECT_EQ(LookupCollection(cache.get(), "text 2", options), "<miss>");
+  EXPECT_EQ(LookupCollection(cache.get(), "text 3", options), "url");
+  EXPECT_EQ(cache->GetStats().evictions, 1);
+  EXPECT_EQ(cache->GetStats().num_entries, 2);
+}
+
+TEST(ResultCacheTest, DropsResultsAfterTtl) {
+  ResultCacheOptions cache_options;
+  cache_options.ttl_ms = 1;
+  std::unique_ptr<ResultCache> cache = ResultCache::Create(cache_options);
+  ASSERT_TRUE(cache);
+  const AnnotationOptions options;
+  cache->InsertAnnotations("text", options, Annotations("phone"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  EXPECT_EQ(LookupCollection(cache.get(), "text", options), "<miss>");
+  EXPECT_EQ(cache->GetStats().num_entries, 0);
+}
+
+TEST(ResultCacheTest, ClearsResults) {
+  std::unique_ptr<ResultCache> cache = ResultCache::Create({});
+  ASSERT_TRUE(cache);
+  const AnnotationOptions options;
+  cache->InsertAnnotations("text", options, Annotations("phone"));
+  cache->Clear();
+
+  EXPECT_EQ(LookupCollection(cache.get(), "text", options), "<miss>");
+  EXPECT_EQ(cache->GetStats().memory_bytes, 0);
+}
+
+TEST(ResultCacheTest, FailsForInvalidOptions) {
+  ResultCacheOptions cache_options;
+  cache_options.num_shards = 0;
+  EXPECT_FALSE(ResultCache::Create(cache_options));
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
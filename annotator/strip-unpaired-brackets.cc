@@ -16,7 +16,9 @@
 
 #include "annotator/strip-unpaired-brackets.h"
 
+#include <algorithm>
 #include <iterator>
+#include <unordered_map>
 
 #include "utils/base/logging.h"
 #include "utils/utf8/unicodetext.h"
@@ -52,6 +54,90 @@ char32 LastSpanCodepoint(const UnicodeText& context_unicode,
   return *it;
 }
 
+// Bracket properties of a codepoint.
+struct Bracket {
+  char32 paired;
+  bool is_opening;
+  bool is_closing;
+};
+
+// Returns the bracket properties of the codepoint, looking them up only if
+// they are not in the cache yet.
+const Bracket& LookupBracket(const char32 codepoint, const UniLib& unilib,
+                             std::unordered_map<char32, Bracket>* cache) {
+  auto it = cache->find(codepoint);
+  if (it == cache->end()) {
+    Bracket bracket = {unilib.GetPairedBracket(codepoint),
+                       /*is_opening=*/false, /*is_closing=*/false};
+    if (bracket.paired != codepoint) {
+      bracket.is_opening = unilib.IsOpeningBracket(codepoint);
+      bracket.is_closing = unilib.IsClosingBracket(codepoint);
+    }
+    it = cache->emplace(codepoint, bracket).first;
+  }
+  return it->second;
+}
+
+// Strips the unpaired brackets of the span, whose codepoints are
+// [span_begin, span_end), with a single scan over the span.
+CodepointSpan StripUnpairedBracketsInSpan(
+    const UnicodeText::const_iterator& span_begin,
+    const UnicodeText::const_iterator& span_end, CodepointSpan span,
+    const UniLib& unilib, std::unordered_map<char32, Bracket>* brackets) {
+  const char32 begin_char = *span_begin;
+  const char32 end_char = *std::prev(span_end);
+  const Bracket begin_bracket = LookupBracket(begin_char, unilib, brackets);
+  const Bracket end_bracket = LookupBracket(end_char, unilib, brackets);
+
+  // Whether the paired brackets are in the span. The paired end bracket is
+  // tracked separately for the first codepoint, which is not part of the span
+  // anymore if it gets stripped.
+  bool has_paired_begin = false;
+  bool has_paired_end_at_first = false;
+  bool has_paired_end_after_first = false;
+  if (begin_bracket.is_opening || end_bracket.is_closing) {
+    for (auto it = span_begin; it != span_end; ++it) {
+      if (*it == begin_bracket.paired) {
+        has_paired_begin = true;
+      }
+      if (*it == end_bracket.paired) {
+        if (it == span_begin) {
+          has_paired_end_at_first = true;
+        } else {
+          has_paired_end_after_first = true;
+        }
+      }
+    }
+  }
+
+  if (begin_bracket.paired != begin_char) {
+    if (!begin_bracket.is_opening || !has_paired_begin) {
+      ++span.first;
+      has_paired_end_at_first = false;
+    }
+  }
+
+  if (span.first == span.second) {
+    return span;
+  }
+
+  if (end_bracket.paired != end_char) {
+    if (!end_bracket.is_closing ||
+        !(has_paired_end_at_first || has_paired_end_after_first)) {
+      --span.second;
+    }
+  }
+
+  // Should not happen, but let's make sure.
+  if (span.first > span.second) {
+    TC3_LOG(WARNING) << "Inverse indices result: " << span.first << ", "
+                     << span.second;
+    span.second = span.first;
+  }
+
+  return span;
+}
+
 }  // namespace
 
 CodepointSpan StripUnpairedBrackets(const std::string& context,
@@ -102,4 +188,38 @@ CodepointSpan StripUnpairedBrackets(const UnicodeText& context_unicode,
   return span;
 }
 
+std::vector<CodepointSpan> StripUnpairedBrackets(
+    const UnicodeText& context_unicode, const std::vector<CodepointSpan>& spans,
+    const UniLib& unilib) {
+  std::vector<CodepointSpan> result = spans;
+  if (context_unicode.empty()) {
+    return result;
+  }
+
+  // Visit the spans in order of their start, so that the context only needs
+  // to be traversed once to find them.
+  std::vector<int> order;
+  for (int i = 0; i < spans.size(); ++i) {
+    if (ValidNonEmptySpan(spans[i])) {
+      order.push_back(i);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&spans](int a, int b) {
+    return spans[a].first < spans[b].first;
+  });
+
+  std::unordered_map<char32, Bracket> brackets;
+  UnicodeText::const_iterator position = context_unicode.begin();
+  int position_index = 0;
+  for (const int i : order) {
+    const CodepointSpan& span = spans[i];
+    std::advance(position, span.first - position_index);
+    position_index = span.first;
+    result[i] = StripUnpairedBracketsInSpan(
+        position, std::next(position, span.second - span.first), span, unilib,
+        &brackets);
+  }
+  return result;
+}
+
 }  // namespace libtextclassifier3
@@ -18,6 +18,7 @@
 #define LIBTEXTCLASSIFIER_ANNOTATOR_STRIP_UNPAIRED_BRACKETS_H_
 
 #include <string>
+#include <vector>
 
 #include "annotator/types.h"
 #include "utils/utf8/unilib.h"
@@ -33,6 +34,14 @@ CodepointSpan StripUnpairedBrackets(const std::string& context,
 CodepointSpan StripUnpairedBrackets(const UnicodeText& context_unicode,
                                     CodepointSpan span, const UniLib& unilib);
 
+// Same as above for many spans of the same context. The context is traversed
+// once in order of the span starts, instead of from its beginning for every
+// span, and the brackets are looked up once per distinct codepoint at the span
+// boundaries.
+std::vector<CodepointSpan> StripUnpairedBrackets(
+    const UnicodeText& context_unicode, const std::vector<CodepointSpan>& spans,
+    const UniLib& unilib);
+
 }  // namespace libtextclassifier3
 
 #endif  // LIBTEXTCLASSIFIER_ANNOTATOR_STRIP_UNPAIRED_BRACKETS_H_
@@ -16,6 +16,9 @@
 
 #include "annotator/strip-unpaired-brackets.h"
 
+#include <vector>
+
+#include "utils/utf8/unicodetext.h"
 #include "gtest/gtest.h"
 
 namespace libtextclassifier3 {
@@ -62,5 +65,39 @@ TEST_F(StripUnpairedBracketsTest, StripUnpairedBrackets) {
             std::make_pair(-1, -1));
 }
 
+TEST_F(StripUnpairedBracketsTest, StripsManySpansLikeSingleSpans) {
+  const UnicodeText context = UTF8ToUnicodeText(
+      "(call) me at [123) 456] or \u00AB(789\u00BB) ((", /*do_copy=*/false);
+  const int num_codepoints = context.size_codepoints();
+  std::vector<CodepointSpan> spans;
+  for (int end = num_codepoints; end >= 0; --end) {
+    for (int start = 0; start <= end; ++start) {
+      spans.push_back({start, end});
+    }
+  }
+  spans.push_back({-1, -1});
+  spans.push_back({5, 2});
+
+  const std::vector<CodepointSpan> stripped_spans =
+      StripUnpairedBrackets(context, spans, unilib_);
+
+  ASSERT_EQ(stripped_spans.size(), spans.size());
+  for (int i = 0; i < spans.size(); ++i) {
+    EXPECT_EQ(stripped_spans[i],
+              StripUnpairedBrackets(context, spans[i], unilib_))
+        << spans[i].first << ", " << spans[i].second;
+  }
+}
+
+TEST_F(StripUnpairedBracketsTest, StripsNoSpans) {
+  EXPECT_TRUE(StripUnpairedBrackets(UTF8ToUnicodeText("(a", /*do_copy=*/false),
+                                    std::vector<CodepointSpan>{}, unilib_)
+                  .empty());
+  const std::vector<CodepointSpan> spans = {{0, 0}};
+  EXPECT_EQ(StripUnpairedBrackets(UTF8ToUnicodeText("", /*do_copy=*/false),
+                                  spans, unilib_),
+            spans);
+}
+
 }  // namespace
 }  // namespace libtextclassifier3
@@ -17,10 +17,12 @@
 #ifndef NLP_SAFT_COMPONENTS_COMMON_MOBILE_EMBEDDING_FEATURE_EXTRACTOR_H_
 #define NLP_SAFT_COMPONENTS_COMMON_MOBILE_EMBEDDING_FEATURE_EXTRACTOR_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "lang_id/common/fel/feature-descriptors.h"
 #include "lang_id/common/fel/feature-extractor.h"
 #include "lang_id/common/fel/task-context.h"
 #include "lang_id/common/fel/workspace.h"
@@ -51,6 +53,19 @@ class GenericEmbeddingFeatureExtractor {
 
   virtual ~GenericEmbeddingFeatureExtractor() {}
 
+  // Provider of precompiled feature extractor descriptors.  Called with the
+  // index of an embedding space: if a precompiled descriptor is available for
+  // it, fills the (empty) descriptor and returns true.  Otherwise, returns
+  // false, the descriptor is discarded and obtained by parsing the FEL
+  // specification instead.
+  typedef std::function<bool(int, FeatureExtractorDescriptor *)>
+      DescriptorProvider;
+
+  // Sets the provider of precompiled descriptors used by Setup().
+  void set_descriptor_provider(const DescriptorProvider &provider) {
+    descriptor_provider_ = provider;
+  }
+
   // Sets/inits up predicate maps and embedding space names that are common for
   // all embedding based feature extractors.
   //
@@ -67,6 +82,10 @@ class GenericEmbeddingFeatureExtractor {
 
   const std::vector<string> &embedding_fml() const { return embedding_fml_; }
 
+  const DescriptorProvider &descriptor_provider() const {
+    return descriptor_provider_;
+  }
+
   // Get parameter name by concatenating the prefix and the original name.
   string GetParamName(const string &param_name) const {
     string full_name = arg_prefix_;
@@ -90,6 +109,9 @@ class GenericEmbeddingFeatureExtractor {
 
   // Embedding dimensions of the embedding spaces (i.e. 32, 64 etc.)
   std::vector<int> embedding_dims_;
+
+  // See set_descriptor_provider().
+  DescriptorProvider descriptor_provider_;
 };
 
 // Templated, object-specific implementation of the
@@ -117,7 +139,16 @@ class EmbeddingFeatureExtractor : public GenericEmbeddingFeatureExtractor {
     feature_extractors_.resize(embedding_fml().size());
     for (int i = 0; i < embedding_fml().size(); ++i) {
       feature_extractors_[i].reset(new EXTRACTOR());
-      if (!feature_extractors_[i]->Parse(embedding_fml()[i])) return false;
+      if (descriptor_provider() &&
+          descriptor_provider()(
+              i, feature_extractors_[i]->mutable_descriptor())) {
+        if (!feature_extractors_[i]->InitializeFromDescriptor()) return false;
+      } else {
+        // Start from a fresh extractor: the provider may have partially
+        // filled the descriptor before failing.
+        feature_extractors_[i].reset(new EXTRACTOR());
+        if (!feature_extractors_[i]->Parse(embedding_fml()[i])) return false;
+      }
       if (!feature_extractors_[i]->Setup(context)) return false;
     }
     return true;
@@ -39,6 +39,14 @@ class EmbeddingFeatureInterface {
   explicit EmbeddingFeatureInterface(const string &arg_prefix)
       : feature_extractor_(arg_prefix) {}
 
+  // Sets the provider of precompiled feature extractor descriptors, see
+  // GenericEmbeddingFeatureExtractor::DescriptorProvider.  Must be called
+  // before SetupForProcessing().
+  void set_descriptor_provider(
+      const GenericEmbeddingFeatureExtractor::DescriptorProvider &provider) {
+    feature_extractor_.set_descriptor_provider(provider);
+  }
+
   // Sets up feature extractors and flags for processing (inference).
   SAFTM_MUST_USE_RESULT bool SetupForProcessing(TaskContext *context) {
     return feature_extractor_.Setup(context);
@@ -128,6 +128,15 @@ class GenericFeatureExtractor {
   // Returns true on success, false otherwise (e.g., FEL syntax error).
   SAFTM_MUST_USE_RESULT bool Parse(const string &source);
 
+  // Initializes the feature extractor from its descriptor, which has already
+  // been filled via mutable_descriptor(), e.g., from a descriptor precompiled
+  // into the model.  This skips the parsing of the FEL specification.
+  //
+  // Returns true on success, false otherwise.
+  SAFTM_MUST_USE_RESULT bool InitializeFromDescriptor() {
+    return InitializeFeatureFunctions();
+  }
+
   // Returns the feature extractor descriptor.
   const FeatureExtractorDescriptor &descriptor() const { return descriptor_; }
   FeatureExtractorDescriptor *mutable_descriptor() { return &descriptor_; }
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lang_id/common/flatbuffers/feature-descriptors-utils.h"
+
+#include <memory>
+
+#include "lang_id/common/lite_base/logging.h"
+
+namespace libtextclassifier3 {
+namespace saft_fbs {
+
+namespace {
+bool FillFeatureFunctionDescriptor(const FeatureFunctionDescriptor &function,
+                                   mobile::FeatureFunctionDescriptor *result) {
+  if (function.type() == nullptr) {
+    SAFTM_LOG(ERROR) << "Feature function without type";
+    return false;
+  }
+  result->set_type(function.type()->str());
+  if (function.name() != nullptr) {
+    result->set_name(function.name()->str());
+  }
+  result->set_argument(function.argument());
+  if (function.parameters() != nullptr) {
+    for (const FeatureParameter *parameter : *function.parameters()) {
+      if (parameter->name() == nullptr || parameter->value() == nullptr) {
+        SAFTM_LOG(ERROR) << "Incomplete parameter for feature "
+                         << result->type();
+        return false;
+      }
+      mobile::Parameter *result_parameter = result->add_parameter();
+      result_parameter->set_name(parameter->name()->str());
+      result_parameter->set_value(parameter->value()->str());
+    }
+  }
+  if (function.features() != nullptr) {
+    for (const FeatureFunctionDescriptor *nested : *function.features()) {
+      if (!FillFeatureFunctionDescriptor(*nested, result->add_feature())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void PackFeatureFunctionDescriptor(
+    const mobile::FeatureFunctionDescriptor &function,
+    FeatureFunctionDescriptorT *result) {
+  result->type = function.type();
+  result->name = function.name();
+  result->argument = function.argument();
+  for (int i = 0; i < function.parameter_size(); ++i) {
+    result->parameters.emplace_back(new FeatureParameterT);
+    result->parameters.back()->name = function.parameter(i).name();
+    result->parameters.back()->value = function.parameter(i).value();
+  }
+  for (int i = 0; i < function.feature_size(); ++i) {
+    result->features.emplace_back(new FeatureFunctionDescriptorT);
+    PackFeatureFunctionDescriptor(function.feature(i),
+                                  result->features.back().get());
+  }
+}
+}  // namespace
+
+const FeatureExtractorDescriptors *GetVerifiedFeatureExtractorDescriptors(
+    mobile::StringPiece bytes) {
+  if ((bytes.data() == nullptr) || bytes.empty()) {
+    SAFTM_LOG(ERROR) << "Empty feature extractor descriptors";
+    return nullptr;
+  }
+  flatbuffers::Verifier verifier(
+      reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+  if (!VerifyFeatureExtractorDescriptorsBuffer(verifier)) {
+    SAFTM_LOG(ERROR) << "Not a valid FeatureExtractorDescriptors flatbuffer";
+    return nullptr;
+  }
+  return GetFeatureExtractorDescriptors(bytes.data());
+}
+
+bool FillFeatureExtractorDescriptor(
+    const FeatureExtractorDescriptor &descriptor,
+    mobile::FeatureExtractorDescriptor *result) {
+  if (descriptor.features() == nullptr) {
+    return true;
+  }
+  for (const FeatureFunctionDescriptor *function : *descriptor.features()) {
+    if (!FillFeatureFunctionDescriptor(*function, result->add_feature())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PackFeatureExtractorDescriptor(
+    const mobile::FeatureExtractorDescriptor &descriptor,
+    FeatureExtractorDescriptorT *result) {
+  for (int i = 0; i < descriptor.feature_size(); ++i) {
+    result->features.emplace_back(new FeatureFunctionDescriptorT);
+    PackFeatureFunctionDescriptor(descriptor.feature(i),
+                                  result->features.back().get());
+  }
+}
+
+}  // namespace saft_fbs
+}  // namespace nlp_saft
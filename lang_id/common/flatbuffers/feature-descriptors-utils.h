@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Conversions between FeatureExtractorDescriptors and their flatbuffer
+// representation from feature-descriptors.fbs.
+
+#ifndef NLP_SAFT_COMPONENTS_COMMON_MOBILE_FLATBUFFERS_FEATURE_DESCRIPTORS_UTILS_H_
+#define NLP_SAFT_COMPONENTS_COMMON_MOBILE_FLATBUFFERS_FEATURE_DESCRIPTORS_UTILS_H_
+
+#include "lang_id/common/fel/feature-descriptors.h"
+#include "lang_id/common/flatbuffers/feature-descriptors_generated.h"
+#include "lang_id/common/lite_strings/stringpiece.h"
+
+namespace libtextclassifier3 {
+namespace saft_fbs {
+
+// Returns the FeatureExtractorDescriptors flatbuffer from |bytes|, or nullptr
+// if |bytes| are not a valid such flatbuffer.
+const FeatureExtractorDescriptors *GetVerifiedFeatureExtractorDescriptors(
+    mobile::StringPiece bytes);
+
+// Fills |*result| with the content of the flatbuffer |descriptor|.  |*result|
+// should be empty.  Returns true on success, false otherwise (e.g., feature
+// function without a type).
+bool FillFeatureExtractorDescriptor(
+    const FeatureExtractorDescriptor &descriptor,
+    mobile::FeatureExtractorDescriptor *result);
+
+// Fills |*result| with the flatbuffer representation of |descriptor|.  Used
+// to precompile the FEL specifications of a model.
+void PackFeatureExtractorDescriptor(
+    const mobile::FeatureExtractorDescriptor &descriptor,
+    FeatureExtractorDescriptorT *result);
+
+}  // namespace saft_fbs
+}  // namespace nlp_saft
+
+#endif  // NLP_SAFT_COMPONENTS_COMMON_MOBILE_FLATBUFFERS_FEATURE_DESCRIPTORS_UTILS_H_
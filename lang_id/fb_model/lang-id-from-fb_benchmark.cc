@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks LangId construction from the flatbuffer model, comparing the
+// shipped model (feature extractors parsed from FEL) with the same model
+// extended with precompiled feature extractor descriptors.
+
+#include <memory>
+#include <string>
+
+#include "lang_id/common/fel/feature-descriptors.h"
+#include "lang_id/common/fel/fel-parser.h"
+#include "lang_id/common/file/file-utils.h"
+#include "lang_id/common/flatbuffers/feature-descriptors-utils.h"
+#include "lang_id/common/flatbuffers/model-utils.h"
+#include "lang_id/common/lite_strings/str-split.h"
+#include "lang_id/fb_model/lang-id-from-fb.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace mobile {
+namespace lang_id {
+namespace {
+
+// Returns the value of the model parameter |name|, or "" if absent.
+string GetParameter(const saft_fbs::ModelT &model, const string &name) {
+  for (const auto &parameter : model.parameters) {
+    if (parameter->name == name) {
+      return parameter->value;
+    }
+  }
+  return "";
+}
+
+// Returns |model_bytes| with an additional model input that stores the
+// precompiled descriptors of the FEL feature specifications of the model.
+// Returns "" on error.
+string AddPrecompiledFeatureDescriptors(const string &model_bytes) {
+  const saft_fbs::Model *model =
+      saft_fbs::GetVerifiedModelFromBytes(model_bytes);
+  if (model == nullptr) {
+    return "";
+  }
+  std::unique_ptr<saft_fbs::ModelT> unpacked_model(model->UnPack());
+
+  saft_fbs::FeatureExtractorDescriptorsT descriptors;
+  const string features =
+      GetParameter(*unpacked_model, "language_identifier_features");
+  for (StringPiece fel : LiteStrSplit(features, ';')) {
+    FeatureExtractorDescriptor descriptor;
+    FELParser parser;
+    if (!parser.Parse(string(fel), &descriptor)) {
+      return "";
+    }
+    descriptors.extractors.emplace_back(
+        new saft_fbs::FeatureExtractorDescriptorT);
+    saft_fbs::PackFeatureExtractorDescriptor(
+        descriptor, descriptors.extractors.back().get());
+  }
+  flatbuffers::FlatBufferBuilder descriptors_builder;
+  saft_fbs::FinishFeatureExtractorDescriptorsBuffer(
+      descriptors_builder, saft_fbs::FeatureExtractorDescriptors::Pack(
+                               descriptors_builder, &descriptors));
+
+  std::unique_ptr<saft_fbs::ModelInputT> input(new saft_fbs::ModelInputT);
+  input->name = "language-identifier-features";
+  input->type = "flatbuffer";
+  input->sub_type = "FeatureExtractorDescriptors";
+  input->data.assign(
+      descriptors_builder.GetBufferPointer(),
+      descriptors_builder.GetBufferPointer() + descriptors_builder.GetSize());
+  unpacked_model->inputs.push_back(std::move(input));
+
+  // The checksum covers the inputs, so it needs to be recomputed.
+  unpacked_model->crc32 = 0;
+  flatbuffers::FlatBufferBuilder builder;
+  saft_fbs::FinishModelBuffer(
+      builder, saft_fbs::Model::Pack(builder, unpacked_model.get()));
+  unpacked_model->crc32 = saft_fbs::ComputeCrc2Checksum(
+      saft_fbs::GetModel(builder.GetBufferPointer()));
+  builder.Clear();
+  saft_fbs::FinishModelBuffer(
+      builder, saft_fbs::Model::Pack(builder, unpacked_model.get()));
+  return string(reinterpret_cast<const char *>(builder.GetBufferPointer()),
+                builder.GetSize());
+}
+
+void RunLangIdConstruction(const string &model_bytes,
+                           benchmark::State &state) {
+  for (auto _ : state) {
+    std::unique_ptr<LangId> lang_id = GetLangIdFromFlatbufferBytes(model_bytes);
+    if (!lang_id->is_valid()) {
+      state.SkipWithError("Invalid LangId model.");
+      break;
+    }
+    benchmark::DoNotOptimize(lang_id);
+  }
+}
+
+void BM_LangIdFromFelModel(benchmark::State &state) {
+  string model_bytes;
+  if (!file_utils::GetFileContent(
+          GetBenchmarkModelPath("lang_id.model"), &model_bytes)) {
+    state.SkipWithError("Could not read LangId model.");
+    return;
+  }
+  RunLangIdConstruction(model_bytes, state);
+}
+BENCHMARK(BM_LangIdFromFelModel);
+
+void BM_LangIdFromPrecompiledModel(benchmark::State &state) {
+  string model_bytes;
+  if (!file_utils::GetFileContent(
+          GetBenchmarkModelPath("lang_id.model"), &model_bytes)) {
+    state.SkipWithError("Could not read LangId model.");
+    return;
+  }
+  const string precompiled_model_bytes =
+      AddPrecompiledFeatureDescriptors(model_bytes);
+  if (precompiled_model_bytes.empty()) {
+    state.SkipWithError("Could not precompile feature descriptors.");
+    return;
+  }
+  RunLangIdConstruction(precompiled_model_bytes, state);
+}
+BENCHMARK(BM_LangIdFromPrecompiledModel);
+
+}  // namespace
+}  // namespace lang_id
+}  // namespace mobile
+}  // namespace nlp_saft
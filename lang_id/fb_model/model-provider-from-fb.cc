@@ -18,6 +18,7 @@
 
 #include "lang_id/common/file/file-utils.h"
 #include "lang_id/common/flatbuffers/embedding-network-params-from-flatbuffer.h"
+#include "lang_id/common/flatbuffers/feature-descriptors-utils.h"
 #include "lang_id/common/flatbuffers/model-utils.h"
 #include "lang_id/common/lite_strings/str-split.h"
 
@@ -75,6 +76,8 @@ void ModelProviderFromFlatbuffer::Initialize(StringPiece model_bytes) {
     return;
   }
 
+  InitFeatureDescriptors();
+
   // Everything looks fine.
   valid_ = true;
 }
@@ -97,6 +100,33 @@ bool ModelProviderFromFlatbuffer::InitNetworkParams() {
   return true;
 }
 
+void ModelProviderFromFlatbuffer::InitFeatureDescriptors() {
+  const string kInputName = "language-identifier-features";
+  const saft_fbs::ModelInput *input =
+      saft_fbs::GetInputByName(model_, kInputName);
+  if (input == nullptr) {
+    // Older models don't have precompiled descriptors: the features are parsed
+    // from their FEL specification instead.
+    return;
+  }
+  feature_descriptors_ = saft_fbs::GetVerifiedFeatureExtractorDescriptors(
+      saft_fbs::GetInputBytes(input));
+  if (feature_descriptors_ == nullptr) {
+    SAFTM_LOG(ERROR) << "Ignoring invalid model input " << kInputName;
+  }
+}
+
+bool ModelProviderFromFlatbuffer::FillFeatureExtractorDescriptor(
+    int index, FeatureExtractorDescriptor *descriptor) const {
+  if ((feature_descriptors_ == nullptr) ||
+      (feature_descriptors_->extractors() == nullptr) || (index < 0) ||
+      (index >= static_cast<int>(feature_descriptors_->extractors()->size()))) {
+    return false;
+  }
+  return saft_fbs::FillFeatureExtractorDescriptor(
+      *feature_descriptors_->extractors()->Get(index), descriptor);
+}
+
 }  // namespace lang_id
 }  // namespace mobile
 }  // namespace nlp_saft
@@ -22,8 +22,10 @@
 #include <string>
 #include <vector>
 
+#include "lang_id/common/fel/feature-descriptors.h"
 #include "lang_id/common/fel/task-context.h"
 #include "lang_id/common/file/mmap.h"
+#include "lang_id/common/flatbuffers/feature-descriptors_generated.h"
 #include "lang_id/common/flatbuffers/model_generated.h"
 #include "lang_id/common/lite_strings/stringpiece.h"
 #include "lang_id/model-provider.h"
@@ -75,6 +77,9 @@ class ModelProviderFromFlatbuffer : public ModelProvider {
     return languages_;
   }
 
+  bool FillFeatureExtractorDescriptor(
+      int index, FeatureExtractorDescriptor *descriptor) const override;
+
  private:
   // Initializes the fields of this class based on the flatbuffer from
   // |model_bytes|.  These bytes are supposed to be the representation of a
@@ -84,6 +89,10 @@ class ModelProviderFromFlatbuffer : public ModelProvider {
   // Initializes nn_params_ based on model_.
   bool InitNetworkParams();
 
+  // Initializes feature_descriptors_ based on model_.  The precompiled
+  // descriptors are optional: models without them are still valid.
+  void InitFeatureDescriptors();
+
   // If filename-based constructor is used, scoped_mmap_ keeps the file mmapped
   // during the lifetime of this object, such that references inside the Model
   // flatbuffer from those bytes remain valid.
@@ -109,6 +118,11 @@ class ModelProviderFromFlatbuffer : public ModelProvider {
   // EmbeddingNetworkParams, see GetNnParams().  Set based on the ModelInput
   // named "language-identifier-network" from model_.
   std::unique_ptr<EmbeddingNetworkParams> nn_params_;
+
+  // Precompiled feature extractor descriptors, see
+  // FillFeatureExtractorDescriptor().  Set based on the optional ModelInput
+  // named "language-identifier-features" from model_; nullptr if absent.
+  const saft_fbs::FeatureExtractorDescriptors *feature_descriptors_ = nullptr;
 };
 
 }  // namespace lang_id
@@ -27,6 +27,7 @@
 #include "lang_id/common/embedding-feature-interface.h"
 #include "lang_id/common/embedding-network-params.h"
 #include "lang_id/common/embedding-network.h"
+#include "lang_id/common/fel/feature-descriptors.h"
 #include "lang_id/common/fel/feature-extractor.h"
 #include "lang_id/common/lite_base/logging.h"
 #include "lang_id/common/lite_strings/numbers.h"
@@ -191,6 +192,15 @@ class LangIdImpl {
  private:
   bool Setup(TaskContext *context) {
     tokenizer_.Setup(context);
+
+    // Use the precompiled feature extractor descriptors from the model, if
+    // any: this avoids parsing the FEL feature specifications.
+    const ModelProvider *model_provider = model_provider_.get();
+    lang_id_brain_interface_.set_descriptor_provider(
+        [model_provider](int index, FeatureExtractorDescriptor *descriptor) {
+          return model_provider->FillFeatureExtractorDescriptor(index,
+                                                                descriptor);
+        });
     if (!lang_id_brain_interface_.SetupForProcessing(context)) return false;
 
     min_text_size_in_bytes_ = context->Get("min_text_size_in_bytes", 0);
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks LangId::FindLanguages with the bundled model over the benchmark
+// corpora.
+
+#include <memory>
+#include <string>
+
+#include "lang_id/fb_model/lang-id-from-fb.h"
+#include "lang_id/lang-id.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "utils/testing/benchmark-utils.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+using mobile::lang_id::LangId;
+using mobile::lang_id::LangIdResult;
+
+// Returns the LangId shared by all the benchmarks, nullptr if the model could
+// not be loaded.
+const LangId* GetLangId() {
+  static const LangId* lang_id = [] {
+    std::unique_ptr<LangId> result =
+        mobile::lang_id::GetLangIdFromFlatbufferFile(
+            GetBenchmarkModelPath("lang_id.model"));
+    return (result != nullptr && result->is_valid()) ? result.release()
+                                                     : nullptr;
+  }();
+  return lang_id;
+}
+
+void BM_FindLanguages(benchmark::State& state) {
+  const LangId* lang_id = GetLangId();
+  if (lang_id == nullptr) {
+    state.SkipWithError("Could not load LangId model.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  ReportAllocationsPerCall(state, [&] {
+    LangIdResult result;
+    lang_id->FindLanguages(text, &result);
+  });
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    LangIdResult result;
+    lang_id->FindLanguages(text, &result);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_FindLanguages)
+    ->Apply(CorpusTextArguments)
+    ->ThreadRange(1, 4);
+
+}  // namespace
+}  // namespace libtextclassifier3
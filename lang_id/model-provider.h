@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "lang_id/common/embedding-network-params.h"
+#include "lang_id/common/fel/feature-descriptors.h"
 
 namespace libtextclassifier3 {
 namespace mobile {
@@ -53,6 +54,16 @@ class ModelProvider {
   // i.
   virtual std::vector<string> GetLanguages() const = 0;
 
+  // Fills |*descriptor| with the precompiled descriptor of the feature
+  // extractor for embedding space |index| and returns true, if the model
+  // provides one.  Otherwise, returns false, in which case |*descriptor| is
+  // discarded and the features are parsed from their FEL specification in the
+  // TaskContext.
+  virtual bool FillFeatureExtractorDescriptor(
+      int index, FeatureExtractorDescriptor *descriptor) const {
+    return false;
+  }
+
  protected:
   bool valid_ = false;
 };
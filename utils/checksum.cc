@@ -19,7 +19,7 @@
 
 namespace libtextclassifier3 {
 
-bool VerifyLuhnChecksum(const std::string& input, bool ignore_whitespace) {
+bool VerifyLuhnChecksum(StringPiece input, bool ignore_whitespace) {
   int sum = 0;
   int num_digits = 0;
   bool is_odd = true;
@@ -47,4 +47,122 @@ bool VerifyLuhnChecksum(const std::string& input, bool ignore_whitespace) {
   return (num_digits > 1 && sum % 10 == 0);
 }
 
+namespace {
+
+// Returns whether the character is a separator that is ignored in ISBNs.
+inline bool IsIsbnSeparator(const char c) { return c == ' ' || c == '-'; }
+
+// Adds the value of an alphanumeric IBAN character to the running remainder.
+// Returns false for characters that are not allowed.
+bool UpdateIbanRemainder(const char c, int* remainder) {
+  if (isdigit(c)) {
+    *remainder = (*remainder * 10 + (c - '0')) % 97;
+    return true;
+  }
+  // Letters count as two digit numbers: A = 10, ..., Z = 35.
+  const char upper = toupper(c);
+  if (upper < 'A' || upper > 'Z') {
+    return false;
+  }
+  *remainder = (*remainder * 100 + (upper - 'A' + 10)) % 97;
+  return true;
+}
+
+}  // namespace
+
+bool VerifyIbanChecksum(StringPiece input) {
+  // The longest IBANs have 34 characters, the shortest 15.
+  static const int kMinIbanLength = 15;
+  static const int kMaxIbanLength = 34;
+
+  // The check is done on the number with the country code and check digits
+  // moved to the end, so the first four characters are processed last.
+  int num_chars = 0;
+  int head_end = 0;
+  for (; head_end < input.size() && num_chars < 4; head_end++) {
+    if (input[head_end] == ' ') {
+      continue;
+    }
+    const char c = input[head_end];
+    // Country code letters followed by check digits.
+    if (num_chars < 2 ? !isalpha(c) : !isdigit(c)) {
+      return false;
+    }
+    ++num_chars;
+  }
+  if (num_chars < 4) {
+    return false;
+  }
+
+  int remainder = 0;
+  for (int i = head_end; i < input.size(); i++) {
+    if (input[i] == ' ') {
+      continue;
+    }
+    if (!UpdateIbanRemainder(input[i], &remainder)) {
+      return false;
+    }
+    ++num_chars;
+  }
+  if (num_chars < kMinIbanLength || num_chars > kMaxIbanLength) {
+    return false;
+  }
+  for (int i = 0; i < head_end; i++) {
+    if (input[i] != ' ') {
+      UpdateIbanRemainder(input[i], &remainder);
+    }
+  }
+  return remainder == 1;
+}
+
+bool VerifyIsbn10Checksum(StringPiece input) {
+  int sum = 0;
+  int num_digits = 0;
+  for (int i = 0; i < input.size(); i++) {
+    const char c = input[i];
+    if (IsIsbnSeparator(c)) {
+      continue;
+    }
+    int digit;
+    if (isdigit(c)) {
+      digit = c - '0';
+    } else if ((c == 'X' || c == 'x') && num_digits == 9) {
+      // Only the check digit can be 10.
+      digit = 10;
+    } else {
+      return false;
+    }
+    if (num_digits == 10) {
+      return false;
+    }
+    sum += (10 - num_digits) * digit;
+    ++num_digits;
+  }
+  return num_digits == 10 && sum % 11 == 0;
+}
+
+bool VerifyIsbn13Checksum(StringPiece input) {
+  int sum = 0;
+  int num_digits = 0;
+  int prefix = 0;
+  for (int i = 0; i < input.size(); i++) {
+    const char c = input[i];
+    if (IsIsbnSeparator(c)) {
+      continue;
+    }
+    if (!isdigit(c) || num_digits == 13) {
+      return false;
+    }
+    const int digit = c - '0';
+    if (num_digits < 3) {
+      prefix = prefix * 10 + digit;
+    }
+    sum += (num_digits % 2 == 0 ? 1 : 3) * digit;
+    ++num_digits;
+  }
+  // ISBNs are EANs in the "Bookland" prefixes.
+  return num_digits == 13 && (prefix == 978 || prefix == 979) &&
+         sum % 10 == 0;
+}
+
 }  // namespace libtextclassifier3
@@ -19,15 +19,26 @@
 #ifndef LIBTEXTCLASSIFIER_UTILS_CHECKSUM_H_
 #define LIBTEXTCLASSIFIER_UTILS_CHECKSUM_H_
 
-#include <string>
+#include "utils/strings/stringpiece.h"
 
 namespace libtextclassifier3 {
 
 // Computes and verifies that the last digit of `input` matches the Luhn
 // checksum. Returns false if presented with non-digits, or on whitespace
 // characters if `ignore_whitespace` is false.
-bool VerifyLuhnChecksum(const std::string& input,
-                        bool ignore_whitespace = true);
+bool VerifyLuhnChecksum(StringPiece input, bool ignore_whitespace = true);
+
+// Verifies the mod-97 check digits of an international bank account number
+// (ISO 13616). Spaces are ignored, letters are accepted in either case.
+bool VerifyIbanChecksum(StringPiece input);
+
+// Verifies the check digit of an ISBN-10. Spaces and hyphens are ignored, the
+// check digit can be 'X'.
+bool VerifyIsbn10Checksum(StringPiece input);
+
+// Verifies the check digit and the prefix of an ISBN-13. Spaces and hyphens are
+// ignored.
+bool VerifyIsbn13Checksum(StringPiece input);
 
 }  // namespace libtextclassifier3
 
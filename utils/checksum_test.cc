@@ -53,5 +53,40 @@ TEST(LuhnTest, HandlesEdgeCases) {
   EXPECT_FALSE(VerifyLuhnChecksum("", /*ignore_whitespace=*/false));
 }
 
+TEST(IbanTest, CorrectlyVerifiesAccountNumbers) {
+  EXPECT_TRUE(VerifyIbanChecksum("GB82 WEST 1234 5698 7654 32"));
+  EXPECT_TRUE(VerifyIbanChecksum("GB82WEST12345698765432"));
+  EXPECT_TRUE(VerifyIbanChecksum("gb82 west 1234 5698 7654 32"));
+  EXPECT_TRUE(VerifyIbanChecksum("DE89 3704 0044 0532 0130 00"));
+  EXPECT_FALSE(VerifyIbanChecksum("GB82 WEST 1234 5698 7654 31"));
+  EXPECT_FALSE(VerifyIbanChecksum("GB82 WEST 1234 5698 7654 3!"));
+  EXPECT_FALSE(VerifyIbanChecksum("82GB WEST 1234 5698 7654 32"));
+}
+
+TEST(IbanTest, HandlesEdgeCases) {
+  EXPECT_FALSE(VerifyIbanChecksum(""));
+  EXPECT_FALSE(VerifyIbanChecksum("GB82"));
+  EXPECT_FALSE(VerifyIbanChecksum("GB82 WEST 1234"));
+}
+
+TEST(IsbnTest, CorrectlyVerifiesIsbn10) {
+  EXPECT_TRUE(VerifyIsbn10Checksum("0-306-40615-2"));
+  EXPECT_TRUE(VerifyIsbn10Checksum("0306406152"));
+  EXPECT_TRUE(VerifyIsbn10Checksum("0-8044-2957-X"));
+  EXPECT_FALSE(VerifyIsbn10Checksum("0-306-40615-3"));
+  EXPECT_FALSE(VerifyIsbn10Checksum("0-306-4061X-2"));
+  EXPECT_FALSE(VerifyIsbn10Checksum("0-306-40615-22"));
+  EXPECT_FALSE(VerifyIsbn10Checksum(""));
+}
+
+TEST(IsbnTest, CorrectlyVerifiesIsbn13) {
+  EXPECT_TRUE(VerifyIsbn13Checksum("978-0-306-40615-7"));
+  EXPECT_TRUE(VerifyIsbn13Checksum("9780306406157"));
+  EXPECT_FALSE(VerifyIsbn13Checksum("978-0-306-40615-8"));
+  EXPECT_FALSE(VerifyIsbn13Checksum("977-0-306-40615-8"));
+  EXPECT_FALSE(VerifyIsbn13Checksum("978-0-306-40615"));
+  EXPECT_FALSE(VerifyIsbn13Checksum(""));
+}
+
 }  // namespace
 }  // namespace libtextclassifier3
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/deadline.h"
+
+namespace libtextclassifier3 {
+
+Deadline::Deadline(Clock::time_point expiration)
+    : expiration_(expiration),
+      cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+Deadline Deadline::InMilliseconds(int64 timeout_ms) {
+  return Deadline(Clock::now() + std::chrono::milliseconds(timeout_ms));
+}
+
+Deadline Deadline::Cancellable() {
+  return Deadline(Clock::time_point::max());
+}
+
+void Deadline::Cancel() const {
+  if (cancelled_ != nullptr) {
+    cancelled_->store(true, std::memory_order_relaxed);
+  }
+}
+
+bool Deadline::Expired() const {
+  if (cancelled_ == nullptr) {
+    return false;
+  }
+  if (cancelled_->load(std::memory_order_relaxed)) {
+    return true;
+  }
+  return expiration_ != Clock::time_point::max() &&
+         Clock::now() >= expiration_;
+}
+
+}  // namespace libtextclassifier3
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBTEXTCLASSIFIER_UTILS_DEADLINE_H_
+#define LIBTEXTCLASSIFIER_UTILS_DEADLINE_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+
+#include "utils/base/integral_types.h"
+
+namespace libtextclassifier3 {
+
+// A time budget for a computation, that can also be cancelled. The copies of a
+// deadline share its cancellation, so a deadline passed by value in options can
+// be cancelled from another thread. The default deadline never expires.
+class Deadline {
+ public:
+  Deadline() = default;
+
+  // Returns a deadline that expires 'timeout_ms' milliseconds from now.
+  static Deadline InMilliseconds(int64 timeout_ms);
+
+  // Returns a deadline that only expires when cancelled.
+  static Deadline Cancellable();
+
+  // Makes the deadline and all its copies expire. Has no effect on the default
+  // deadline.
+  void Cancel() const;
+
+  // Returns whether the deadline passed or was cancelled.
+  bool Expired() const;
+
+  bool operator==(const Deadline& other) const {
+    return expiration_ == other.expiration_ && cancelled_ == other.cancelled_;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  explicit Deadline(Clock::time_point expiration);
+
+  Clock::time_point expiration_ = Clock::time_point::max();
+
+  // Shared by the copies, nullptr for the default deadline.
+  std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_UTILS_DEADLINE_H_
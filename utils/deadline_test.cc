@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/deadline.h"
+
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+TEST(DeadlineTest, DefaultNeverExpires) {
+  const Deadline deadline;
+  deadline.Cancel();
+  EXPECT_FALSE(deadline.Expired());
+  EXPECT_TRUE(deadline == Deadline());
+}
+
+TEST(DeadlineTest, ExpiresAfterTimeout) {
+  EXPECT_TRUE(Deadline::InMilliseconds(0).Expired());
+  EXPECT_TRUE(Deadline::InMilliseconds(-1).Expired());
+  EXPECT_FALSE(Deadline::InMilliseconds(60 * 1000).Expired());
+
+  const Deadline deadline = Deadline::InMilliseconds(1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_TRUE(deadline.Expired());
+}
+
+TEST(DeadlineTest, CancellationIsSharedByCopies) {
+  const Deadline deadline = Deadline::Cancellable();
+  const Deadline copy = deadline;
+  EXPECT_FALSE(copy.Expired());
+
+  std::thread([&deadline]() { deadline.Cancel(); }).join();
+  EXPECT_TRUE(deadline.Expired());
+  EXPECT_TRUE(copy.Expired());
+  EXPECT_FALSE(Deadline::Cancellable().Expired());
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
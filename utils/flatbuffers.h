@@ -197,6 +197,9 @@ class ReflectiveFlatbuffer {
                           ReflectiveFlatbuffer** parent,
                           reflection::Field const** field);
 
+  // Gets the type of the flatbuffer table.
+  const reflection::Object* type() const { return type_; }
+
   // Checks whether a variant value type agrees with a field type.
   bool IsMatchingType(const reflection::Field* field,
                       const Variant& value) const;
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests of the intent generator that need a Java VM and an Android context.
+// They are run by IntentGeneratorTest.java.
+
+#include <jni.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "annotator/types.h"
+#include "utils/intents/intent-config_generated.h"
+#include "utils/intents/intent-generator.h"
+#include "utils/java/jni-base.h"
+#include "utils/java/jni-cache.h"
+#include "utils/java/scoped_local_ref.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "flatbuffers/flatbuffers.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+JNIEnv* g_jenv = nullptr;
+jobject g_context = nullptr;
+
+// Counts the calls of the lua environment that runs it, and reports whether
+// the package name of the context of the call could be read.
+constexpr char kGeneratorSnippet[] = R"(
+calls = (calls or 0) + 1
+local has_package_name, package_name = pcall(function()
+  return external.android.package_name
+end)
+local has_user_restrictions = pcall(function()
+  return external.android.user_restrictions["no_sms"]
+end)
+return {
+  {
+    title_without_entity = tostring(calls),
+    package_name = has_package_name and package_name or nil,
+    description = tostring(has_user_restrictions),
+  },
+}
+)";
+
+class IntentGeneratorTest : public testing::Test {
+ protected:
+  IntentGeneratorTest() : jni_cache_(JniCache::Create(g_jenv)) {
+    IntentFactoryModelT model;
+    model.generator.emplace_back(new IntentFactoryModel_::IntentGeneratorT);
+    model.generator.back()->type = "phone";
+    const std::string snippet = kGeneratorSnippet;
+    model.generator.back()->lua_template_generator.assign(snippet.begin(),
+                                                          snippet.end());
+    flatbuffers::FlatBufferBuilder builder;
+    builder.Finish(IntentFactoryModel::Pack(builder, &model));
+    model_buffer_.assign(
+        reinterpret_cast<const char*>(builder.GetBufferPointer()),
+        builder.GetSize());
+    generator_ = IntentGenerator::Create(
+        flatbuffers::GetRoot<IntentFactoryModel>(model_buffer_.data()),
+        /*resources=*/nullptr, jni_cache_);
+  }
+
+  // Generates the intents for a phone number with the given context.
+  RemoteActionTemplate GenerateIntent(const jobject context) {
+    ScopedLocalRef<jstring> device_locales(g_jenv->NewStringUTF("en-US"),
+                                          g_jenv);
+    std::vector<RemoteActionTemplate> remote_actions;
+    EXPECT_TRUE(generator_->GenerateIntents(
+        device_locales.get(), ClassificationResult("phone", /*arg_score=*/1.0),
+        /*reference_time_ms_utc=*/0, "(555) 123-4567",
+        /*selection_indices=*/{0, 14}, context,
+        /*annotations_entity_data_schema=*/nullptr, &remote_actions));
+    EXPECT_EQ(remote_actions.size(), 1);
+    return remote_actions.empty() ? RemoteActionTemplate() : remote_actions[0];
+  }
+
+  std::string PackageName(const jobject context) {
+    ScopedLocalRef<jclass> context_class(g_jenv->GetObjectClass(context),
+                                         g_jenv);
+    const jmethodID get_package_name = g_jenv->GetMethodID(
+        context_class.get(), "getPackageName", "()Ljava/lang/String;");
+    ScopedLocalRef<jstring> package_name(
+        static_cast<jstring>(
+            g_jenv->CallObjectMethod(context, get_package_name)),
+        g_jenv);
+    return ToStlString(g_jenv, package_name.get());
+  }
+
+  std::shared_ptr<JniCache> jni_cache_;
+  std::string model_buffer_;
+  std::unique_ptr<IntentGenerator> generator_;
+};
+
+TEST_F(IntentGeneratorTest, ReusesPooledEnvironments) {
+  ASSERT_TRUE(generator_ != nullptr);
+  EXPECT_EQ(GenerateIntent(g_context).title_without_entity.value(), "1");
+  EXPECT_EQ(GenerateIntent(g_context).title_without_entity.value(), "2");
+  EXPECT_EQ(GenerateIntent(g_context).title_without_entity.value(), "3");
+}
+
+TEST_F(IntentGeneratorTest, RebindsContextOfPooledEnvironments) {
+  ASSERT_TRUE(generator_ != nullptr);
+  const std::string package_name = PackageName(g_context);
+
+  RemoteActionTemplate intent = GenerateIntent(g_context);
+  EXPECT_EQ(intent.title_without_entity.value(), "1");
+  EXPECT_EQ(intent.package_name.value(), package_name);
+  EXPECT_EQ(intent.description.value(), "true");
+
+  // Neither the context nor the UserManager retrieved from it are kept for
+  // the next call of the pooled environment.
+  intent = GenerateIntent(/*context=*/nullptr);
+  EXPECT_EQ(intent.title_without_entity.value(), "2");
+  EXPECT_FALSE(intent.package_name.has_value());
+  EXPECT_EQ(intent.description.value(), "false");
+
+  intent = GenerateIntent(g_context);
+  EXPECT_EQ(intent.title_without_entity.value(), "3");
+  EXPECT_EQ(intent.package_name.value(), package_name);
+  EXPECT_EQ(intent.description.value(), "true");
+}
+
+TEST_F(IntentGeneratorTest, BindsContextOfEachCall) {
+  ASSERT_TRUE(generator_ != nullptr);
+  ScopedLocalRef<jclass> context_class(g_jenv->GetObjectClass(g_context),
+                                       g_jenv);
+  const jmethodID get_application_context =
+      g_jenv->GetMethodID(context_class.get(), "getApplicationContext",
+                          "()Landroid/content/Context;");
+  ScopedLocalRef<jobject> application_context(
+      g_jenv->CallObjectMethod(g_context, get_application_context), g_jenv);
+  ASSERT_TRUE(application_context != nullptr);
+
+  RemoteActionTemplate intent = GenerateIntent(g_context);
+  EXPECT_EQ(intent.package_name.value(), PackageName(g_context));
+  intent = GenerateIntent(application_context.get());
+  EXPECT_EQ(intent.title_without_entity.value(), "2");
+  EXPECT_EQ(intent.package_name.value(),
+            PackageName(application_context.get()));
+  EXPECT_EQ(intent.description.value(), "true");
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
+
+extern "C" TC3_JNI_METHOD2(jboolean,
+                           com_google_android_textclassifier_utils_intents,
+                           IntentGeneratorTest, testsMain)(JNIEnv* env,
+                                                           jobject thiz,
+                                                           jobject context) {
+  libtextclassifier3::g_jenv = env;
+  libtextclassifier3::g_context = context;
+  int argc = 1;
+  char arg0[] = "intent-generator-test-lib";
+  char* argv[] = {arg0};
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS() == 0;
+}
@@ -54,21 +54,34 @@ static constexpr const char* kPackageNameKey = "package_name";
 static constexpr const char* kDeviceLocaleKey = "device_locales";
 static constexpr const char* kFormatKey = "format";
 
+// Maximum number of idle lua environments kept per generator.
+static constexpr int kMaxIdleEnvironments = 4;
+
 // An Android specific Lua environment with JNI backed callbacks.
+// The environment can be reused for several calls, the generator snippet is
+// loaded once and the per call state is set with `SetCallContext` and the
+// `BindEntity` methods of the subclasses, and dropped with `ResetCallContext`.
+// Without a JNI cache, the `android` callbacks are not available.
 class JniLuaEnvironment : public LuaEnvironment {
  public:
-  JniLuaEnvironment(const Resources& resources, const JniCache* jni_cache,
-                    const jobject context,
-                    const std::vector<Locale>& device_locales);
-  // Environment setup.
-  bool Initialize();
+  JniLuaEnvironment(const Resources& resources, const JniCache* jni_cache);
+
+  // Environment setup, loads the generator snippet.
+  bool Initialize(const std::string& generator_snippet);
+
+  // Sets the Android context and device locales for the next call.
+  void SetCallContext(const jobject context,
+                      const std::vector<Locale>& device_locales);
+
+  // Drops the Android context of the last call and everything retrieved from
+  // it, so that an idle environment doesn't keep the context alive.
+  void ResetCallContext();
 
-  // Runs an intent generator snippet.
-  bool RunIntentGenerator(const std::string& generator_snippet,
-                          std::vector<RemoteActionTemplate>* remote_actions);
+  // Runs the intent generator snippet.
+  bool RunIntentGenerator(std::vector<RemoteActionTemplate>* remote_actions);
 
  protected:
-  virtual void SetupExternalHook();
+  void SetupExternalHook();
 
   int HandleExternalCallback();
   int HandleAndroidCallback();
@@ -92,7 +105,7 @@ class JniLuaEnvironment : public LuaEnvironment {
   // Reads the intent categories array from a Lua result.
   void ReadCategories(std::vector<std::string>* category);
 
-  // Retrieves user manager if not previously done.
+  // Retrieves user manager if not previously done in this call.
   bool RetrieveUserManager();
 
   // Retrieves system resources if not previously done.
@@ -107,11 +120,16 @@ class JniLuaEnvironment : public LuaEnvironment {
   const Resources& resources_;
   JNIEnv* jenv_;
   const JniCache* jni_cache_;
-  const jobject context_;
+  jobject context_;
   std::vector<Locale> device_locales_;
 
+  // Reference to the loaded generator snippet in the lua registry.
+  int generator_;
+
+  // The UserManager holds on to the context it was retrieved from, so it is
+  // only kept for the current call.
   ScopedGlobalRef<jobject> usermanager_;
-  // Whether we previously attempted to retrieve the UserManager before.
+  // Whether we previously attempted to retrieve the UserManager in this call.
   bool usermanager_retrieved_;
 
   ScopedGlobalRef<jobject> system_resources_;
@@ -124,14 +142,12 @@ class JniLuaEnvironment : public LuaEnvironment {
 };
 
 JniLuaEnvironment::JniLuaEnvironment(const Resources& resources,
-                                     const JniCache* jni_cache,
-                                     const jobject context,
-                                     const std::vector<Locale>& device_locales)
+                                     const JniCache* jni_cache)
     : resources_(resources),
       jenv_(jni_cache ? jni_cache->GetEnv() : nullptr),
       jni_cache_(jni_cache),
-      context_(context),
-      device_locales_(device_locales),
+      context_(nullptr),
+      generator_(LUA_NOREF),
       usermanager_(/*object=*/nullptr,
                    /*jvm=*/(jni_cache ? jni_cache->jvm : nullptr)),
       usermanager_retrieved_(false),
@@ -143,21 +159,52 @@ JniLuaEnvironment::JniLuaEnvironment(const Resources& resources,
       android_(/*object=*/nullptr,
                /*jvm=*/(jni_cache ? jni_cache->jvm : nullptr)) {}
 
-bool JniLuaEnvironment::Initialize() {
-  string_ =
-      MakeGlobalRef(jenv_->NewStringUTF("string"), jenv_, jni_cache_->jvm);
-  android_ =
-      MakeGlobalRef(jenv_->NewStringUTF("android"), jenv_, jni_cache_->jvm);
-  if (string_ == nullptr || android_ == nullptr) {
-    TC3_LOG(ERROR) << "Could not allocate constant strings references.";
+bool JniLuaEnvironment::Initialize(const std::string& generator_snippet) {
+  if (jni_cache_ != nullptr) {
+    string_ =
+        MakeGlobalRef(jenv_->NewStringUTF("string"), jenv_, jni_cache_->jvm);
+    android_ =
+        MakeGlobalRef(jenv_->NewStringUTF("android"), jenv_, jni_cache_->jvm);
+    if (string_ == nullptr || android_ == nullptr) {
+      TC3_LOG(ERROR) << "Could not allocate constant strings references.";
+      return false;
+    }
+  }
+  if (RunProtected([this] {
+        LoadDefaultLibraries();
+        SetupExternalHook();
+        lua_setglobal(state_, "external");
+        return LUA_OK;
+      }) != LUA_OK) {
     return false;
   }
-  return (RunProtected([this] {
-            LoadDefaultLibraries();
-            SetupExternalHook();
-            lua_setglobal(state_, "external");
-            return LUA_OK;
-          }) == LUA_OK);
+  const int status =
+      luaL_loadbuffer(state_, generator_snippet.data(),
+                      generator_snippet.size(), /*name=*/nullptr);
+  if (status != LUA_OK) {
+    TC3_LOG(ERROR) << "Couldn't load generator snippet: " << status;
+    return false;
+  }
+  generator_ = luaL_ref(state_, LUA_REGISTRYINDEX);
+  return true;
+}
+
+void JniLuaEnvironment::SetCallContext(
+    const jobject context, const std::vector<Locale>& device_locales) {
+  // The environment might be used from a different thread than before.
+  if (jni_cache_ != nullptr) {
+    jenv_ = jni_cache_->GetEnv();
+  }
+  context_ = context;
+  device_locales_ = device_locales;
+}
+
+void JniLuaEnvironment::ResetCallContext() {
+  // The system resources don't depend on the context, so they are kept.
+  context_ = nullptr;
+  device_locales_.clear();
+  usermanager_.reset();
+  usermanager_retrieved_ = false;
 }
 
 void JniLuaEnvironment::SetupExternalHook() {
@@ -168,6 +215,9 @@ void JniLuaEnvironment::SetupExternalHook() {
   //   * android.R: callbacks to retrieve string resources.
   BindTable<JniLuaEnvironment, &JniLuaEnvironment::HandleExternalCallback>(
       "external");
+  if (jni_cache_ == nullptr) {
+    return;
+  }
 
   // android
   BindTable<JniLuaEnvironment, &JniLuaEnvironment::HandleAndroidCallback>(
@@ -665,17 +715,10 @@ int JniLuaEnvironment::ReadRemoteActionTemplates(
 }
 
 bool JniLuaEnvironment::RunIntentGenerator(
-    const std::string& generator_snippet,
     std::vector<RemoteActionTemplate>* remote_actions) {
-  int status;
-  status = luaL_loadbuffer(state_, generator_snippet.data(),
-                           generator_snippet.size(),
-                           /*name=*/nullptr);
-  if (status != LUA_OK) {
-    TC3_LOG(ERROR) << "Couldn't load generator snippet: " << status;
-    return false;
-  }
-  status = lua_pcall(state_, /*nargs=*/0, /*nresults=*/1, /*errfunc=*/0);
+  lua_rawgeti(state_, LUA_REGISTRYINDEX, generator_);
+  const int status =
+      lua_pcall(state_, /*nargs=*/0, /*nresults=*/1, /*errfunc=*/0);
   if (status != LUA_OK) {
     TC3_LOG(ERROR) << "Couldn't run generator snippet: " << status;
     return false;
@@ -695,76 +738,111 @@ bool JniLuaEnvironment::RunIntentGenerator(
     lua_settop(state_, 0);
     return false;
   }
+
+  // Unbind the per call data, so that it is not accessed after the call.
+  lua_getglobal(state_, "external");
+  lua_pushnil(state_);
+  lua_setfield(state_, /*idx=*/-2, "entity");
+  lua_pushnil(state_);
+  lua_setfield(state_, /*idx=*/-2, "conversation");
+  lua_pop(state_, 1);
   return true;
 }
 
 // Lua environment for classfication result intent generation.
 class AnnotatorJniEnvironment : public JniLuaEnvironment {
  public:
-  AnnotatorJniEnvironment(const Resources& resources, const JniCache* jni_cache,
-                          const jobject context,
-                          const std::vector<Locale>& device_locales,
-                          const std::string& entity_text,
-                          const ClassificationResult& classification,
-                          const int64 reference_time_ms_utc,
-                          const reflection::Schema* entity_data_schema)
-      : JniLuaEnvironment(resources, jni_cache, context, device_locales),
-        entity_text_(entity_text),
-        classification_(classification),
-        reference_time_ms_utc_(reference_time_ms_utc),
-        entity_data_schema_(entity_data_schema) {}
-
- protected:
-  void SetupExternalHook() override {
-    JniLuaEnvironment::SetupExternalHook();
-    lua_pushinteger(state_, reference_time_ms_utc_);
-    lua_setfield(state_, /*idx=*/-2, kReferenceTimeUsecKey);
-
-    PushAnnotation(classification_, entity_text_, entity_data_schema_, this);
-    lua_setfield(state_, /*idx=*/-2, "entity");
+  AnnotatorJniEnvironment(const Resources& resources, const JniCache* jni_cache)
+      : JniLuaEnvironment(resources, jni_cache) {}
+
+  // Binds the classification result to generate intents for.
+  bool BindEntity(const std::string& entity_text,
+                  const ClassificationResult& classification,
+                  const int64 reference_time_ms_utc,
+                  const reflection::Schema* entity_data_schema) {
+    return RunProtected([&] {
+             lua_getglobal(state_, "external");
+             lua_pushinteger(state_, reference_time_ms_utc);
+             lua_setfield(state_, /*idx=*/-2, kReferenceTimeUsecKey);
+
+             PushAnnotation(classification, entity_text, entity_data_schema,
+                            this);
+             lua_setfield(state_, /*idx=*/-2, "entity");
+             lua_pop(state_, 1);
+             return LUA_OK;
+           }) == LUA_OK;
   }
-
-  const std::string& entity_text_;
-  const ClassificationResult& classification_;
-  const int64 reference_time_ms_utc_;
-
-  // Reflection schema data.
-  const reflection::Schema* const entity_data_schema_;
 };
 
 // Lua environment for actions intent generation.
 class ActionsJniLuaEnvironment : public JniLuaEnvironment {
  public:
-  ActionsJniLuaEnvironment(
-      const Resources& resources, const JniCache* jni_cache,
-      const jobject context, const std::vector<Locale>& device_locales,
-      const Conversation& conversation, const ActionSuggestion& action,
-      const reflection::Schema* actions_entity_data_schema,
-      const reflection::Schema* annotations_entity_data_schema)
-      : JniLuaEnvironment(resources, jni_cache, context, device_locales),
-        conversation_(conversation),
-        action_(action),
-        annotation_iterator_(annotations_entity_data_schema, this),
-        conversation_iterator_(annotations_entity_data_schema, this),
-        entity_data_schema_(actions_entity_data_schema) {}
-
- protected:
-  void SetupExternalHook() override {
-    JniLuaEnvironment::SetupExternalHook();
-    conversation_iterator_.NewIterator("conversation", &conversation_.messages,
-                                       state_);
-    lua_setfield(state_, /*idx=*/-2, "conversation");
+  ActionsJniLuaEnvironment(const Resources& resources,
+                           const JniCache* jni_cache)
+      : JniLuaEnvironment(resources, jni_cache) {}
+
+  // Binds the action and conversation to generate intents for.
+  bool BindEntity(const Conversation& conversation,
+                  const ActionSuggestion& action,
+                  const reflection::Schema* actions_entity_data_schema,
+                  const reflection::Schema* annotations_entity_data_schema) {
+    // The iterators only depend on the schema, so they are kept as long as
+    // the schema doesn't change.
+    if (annotation_iterator_ == nullptr ||
+        annotations_entity_data_schema_ != annotations_entity_data_schema) {
+      annotation_iterator_.reset(
+          new AnnotationIterator<ActionSuggestionAnnotation>(
+              annotations_entity_data_schema, this));
+      conversation_iterator_.reset(
+          new ConversationIterator(annotations_entity_data_schema, this));
+      annotations_entity_data_schema_ = annotations_entity_data_schema;
+    }
+    return RunProtected([&] {
+             lua_getglobal(state_, "external");
+             conversation_iterator_->NewIterator(
+                 "conversation", &conversation.messages, state_);
+             lua_setfield(state_, /*idx=*/-2, "conversation");
+
+             PushAction(action, actions_entity_data_schema,
+                        *annotation_iterator_, this);
+             lua_setfield(state_, /*idx=*/-2, "entity");
+             lua_pop(state_, 1);
+             return LUA_OK;
+           }) == LUA_OK;
+  }
+
+ private:
+  std::unique_ptr<AnnotationIterator<ActionSuggestionAnnotation>>
+      annotation_iterator_;
+  std::unique_ptr<ConversationIterator> conversation_iterator_;
+  const reflection::Schema* annotations_entity_data_schema_ = nullptr;
+};
 
-    PushAction(action_, entity_data_schema_, annotation_iterator_, this);
-    lua_setfield(state_, /*idx=*/-2, "entity");
+// Takes an idle environment from a pool, returns nullptr if there is none.
+template <typename T>
+std::unique_ptr<T> AcquireEnvironment(
+    std::mutex* mutex,
+    std::vector<std::unique_ptr<LuaEnvironment>>* environments) {
+  std::lock_guard<std::mutex> lock(*mutex);
+  if (environments->empty()) {
+    return nullptr;
   }
+  std::unique_ptr<T> environment(
+      static_cast<T*>(environments->back().release()));
+  environments->pop_back();
+  return environment;
+}
 
-  const Conversation& conversation_;
-  const ActionSuggestion& action_;
-  const AnnotationIterator<ActionSuggestionAnnotation> annotation_iterator_;
-  const ConversationIterator conversation_iterator_;
-  const reflection::Schema* entity_data_schema_;
-};
+// Returns an environment to a pool, or drops it if the pool is full.
+void ReleaseEnvironment(
+    std::unique_ptr<JniLuaEnvironment> environment, std::mutex* mutex,
+    std::vector<std::unique_ptr<LuaEnvironment>>* environments) {
+  environment->ResetCallContext();
+  std::lock_guard<std::mutex> lock(*mutex);
+  if (environments->size() < kMaxIdleEnvironments) {
+    environments->push_back(std::move(environment));
+  }
+}
 
 }  // namespace
 
@@ -805,7 +883,10 @@ std::unique_ptr<IntentGenerator> IntentGenerator::Create(
       }
     }
 
-    intent_generator->generators_[generator->type()->str()] = lua_code;
+    std::unique_ptr<Generator> intent_generator_snippet(new Generator);
+    intent_generator_snippet->lua_code = lua_code;
+    intent_generator->generators_[generator->type()->str()] =
+        std::move(intent_generator_snippet);
   }
 
   return intent_generator;
@@ -813,6 +894,10 @@ std::unique_ptr<IntentGenerator> IntentGenerator::Create(
 
 std::vector<Locale> IntentGenerator::ParseDeviceLocales(
     const jstring device_locales) const {
+  if (jni_cache_ == nullptr) {
+    // There are no device locales without JNI.
+    return {};
+  }
   if (device_locales == nullptr) {
     TC3_LOG(ERROR) << "No locales provided.";
     return {};
@@ -852,18 +937,32 @@ bool IntentGenerator::GenerateIntents(
       UTF8ToUnicodeText(text, /*do_copy=*/false)
           .UTF8Substring(selection_indices.first, selection_indices.second);
 
-  std::unique_ptr<AnnotatorJniEnvironment> interpreter(
-      new AnnotatorJniEnvironment(
-          resources_, jni_cache_.get(), context,
-          ParseDeviceLocales(device_locales), entity_text, classification,
-          reference_time_ms_utc, annotations_entity_data_schema));
+  Generator* generator = it->second.get();
+  std::unique_ptr<AnnotatorJniEnvironment> interpreter =
+      AcquireEnvironment<AnnotatorJniEnvironment>(
+          &generator->mutex, &generator->annotator_environments);
+  if (interpreter == nullptr) {
+    interpreter.reset(
+        new AnnotatorJniEnvironment(resources_, jni_cache_.get()));
+    if (!interpreter->Initialize(generator->lua_code)) {
+      TC3_LOG(ERROR) << "Could not create Lua interpreter.";
+      return false;
+    }
+  }
 
-  if (!interpreter->Initialize()) {
-    TC3_LOG(ERROR) << "Could not create Lua interpreter.";
+  interpreter->SetCallContext(context, ParseDeviceLocales(device_locales));
+  if (!interpreter->BindEntity(entity_text, classification,
+                               reference_time_ms_utc,
+                               annotations_entity_data_schema)) {
+    TC3_LOG(ERROR) << "Could not bind entity.";
     return false;
   }
-
-  return interpreter->RunIntentGenerator(it->second, remote_actions);
+  if (!interpreter->RunIntentGenerator(remote_actions)) {
+    return false;
+  }
+  ReleaseEnvironment(std::move(interpreter), &generator->mutex,
+                     &generator->annotator_environments);
+  return true;
 }
 
 bool IntentGenerator::GenerateIntents(
@@ -882,18 +981,32 @@ bool IntentGenerator::GenerateIntents(
     return true;
   }
 
-  std::unique_ptr<ActionsJniLuaEnvironment> interpreter(
-      new ActionsJniLuaEnvironment(
-          resources_, jni_cache_.get(), context,
-          ParseDeviceLocales(device_locales), conversation, action,
-          actions_entity_data_schema, annotations_entity_data_schema));
+  Generator* generator = it->second.get();
+  std::unique_ptr<ActionsJniLuaEnvironment> interpreter =
+      AcquireEnvironment<ActionsJniLuaEnvironment>(
+          &generator->mutex, &generator->actions_environments);
+  if (interpreter == nullptr) {
+    interpreter.reset(
+        new ActionsJniLuaEnvironment(resources_, jni_cache_.get()));
+    if (!interpreter->Initialize(generator->lua_code)) {
+      TC3_LOG(ERROR) << "Could not create Lua interpreter.";
+      return false;
+    }
+  }
 
-  if (!interpreter->Initialize()) {
-    TC3_LOG(ERROR) << "Could not create Lua interpreter.";
+  interpreter->SetCallContext(context, ParseDeviceLocales(device_locales));
+  if (!interpreter->BindEntity(conversation, action,
+                               actions_entity_data_schema,
+                               annotations_entity_data_schema)) {
+    TC3_LOG(ERROR) << "Could not bind entity.";
     return false;
   }
-
-  return interpreter->RunIntentGenerator(it->second, remote_actions);
+  if (!interpreter->RunIntentGenerator(remote_actions)) {
+    return false;
+  }
+  ReleaseEnvironment(std::move(interpreter), &generator->mutex,
+                     &generator->actions_environments);
+  return true;
 }
 
 }  // namespace libtextclassifier3
@@ -5,6 +5,7 @@
 #include <jni.h>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -14,6 +15,7 @@
 #include "utils/intents/intent-config_generated.h"
 #include "utils/java/jni-cache.h"
 #include "utils/java/scoped_local_ref.h"
+#include "utils/lua-utils.h"
 #include "utils/optional.h"
 #include "utils/resources.h"
 #include "utils/resources_generated.h"
@@ -66,6 +68,7 @@ struct RemoteActionTemplate {
 // Helper class to generate Android intents for text classifier results.
 class IntentGenerator {
  public:
+  // Without a JNI cache, the generators run without the Android callbacks.
   static std::unique_ptr<IntentGenerator> Create(
       const IntentFactoryModel* options, const ResourcePool* resources,
       const std::shared_ptr<JniCache>& jni_cache);
@@ -100,12 +103,22 @@ class IntentGenerator {
         resources_(Resources(resources)),
         jni_cache_(jni_cache) {}
 
+  // A generator snippet with pools of idle lua environments that have the
+  // snippet preloaded and the JNI callbacks bound, so that they can be reused
+  // across calls.
+  struct Generator {
+    std::string lua_code;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<LuaEnvironment>> annotator_environments;
+    std::vector<std::unique_ptr<LuaEnvironment>> actions_environments;
+  };
+
   std::vector<Locale> ParseDeviceLocales(const jstring device_locales) const;
 
   const IntentFactoryModel* options_;
   const Resources resources_;
   std::shared_ptr<JniCache> jni_cache_;
-  std::map<std::string, std::string> generators_;
+  std::map<std::string, std::unique_ptr<Generator>> generators_;
 };
 
 }  // namespace libtextclassifier3
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the latency of running an intent generator snippet, comparing
+// the creation of a fresh lua environment per call with the reuse of an
+// environment that has the snippet preloaded, and with the pooled
+// environments of the IntentGenerator.
+// The JNI callbacks of the intent generator need a Java VM, so the benchmarks
+// run the lua part of the generation only.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "annotator/types.h"
+#include "utils/intents/intent-config_generated.h"
+#include "utils/intents/intent-generator.h"
+#include "utils/lua-utils.h"
+#include "flatbuffers/flatbuffers.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// A generator that builds intents similar to the ones of the default model.
+constexpr char kGeneratorSnippet[] = R"(
+local text = "(555) 123-4567"
+local number = string.gsub(text, "[^%d+]", "")
+return {
+  {
+    title_without_entity = "Call",
+    description = "Call " .. text,
+    action = "android.intent.action.DIAL",
+    data = "tel:" .. number,
+    request_code = 1,
+  },
+  {
+    title_without_entity = "Send a message",
+    description = "Send a message to " .. text,
+    action = "android.intent.action.SENDTO",
+    data = "smsto:" .. number,
+    request_code = 2,
+  },
+}
+)";
+
+// Runs the generator at the top of the stack and pops its results.
+void RunGenerator(LuaEnvironment* environment) {
+  lua_State* state = environment->state();
+  if (lua_pcall(state, /*nargs=*/0, /*nresults=*/1, /*errfunc=*/0) != LUA_OK) {
+    lua_settop(state, 0);
+    return;
+  }
+  benchmark::DoNotOptimize(lua_rawlen(state, /*idx=*/-1));
+  lua_pop(state, 1);
+}
+
+void BM_GenerateWithNewEnvironment(benchmark::State& state) {
+  const std::string snippet = kGeneratorSnippet;
+  for (auto _ : state) {
+    LuaEnvironment environment;
+    environment.LoadDefaultLibraries();
+    if (luaL_loadbuffer(environment.state(), snippet.data(), snippet.size(),
+                        /*name=*/nullptr) != LUA_OK) {
+      state.SkipWithError("Could not load generator snippet.");
+      break;
+    }
+    RunGenerator(&environment);
+  }
+}
+BENCHMARK(BM_GenerateWithNewEnvironment);
+
+void BM_GenerateWithReusedEnvironment(benchmark::State& state) {
+  const std::string snippet = kGeneratorSnippet;
+  LuaEnvironment environment;
+  environment.LoadDefaultLibraries();
+  if (luaL_loadbuffer(environment.state(), snippet.data(), snippet.size(),
+                      /*name=*/nullptr) != LUA_OK) {
+    state.SkipWithError("Could not load generator snippet.");
+    return;
+  }
+  const int generator = luaL_ref(environment.state(), LUA_REGISTRYINDEX);
+  for (auto _ : state) {
+    lua_rawgeti(environment.state(), LUA_REGISTRYINDEX, generator);
+    RunGenerator(&environment);
+  }
+}
+BENCHMARK(BM_GenerateWithReusedEnvironment);
+
+// The generator above, for the phone number bound as the entity.
+constexpr char kEntityGeneratorSnippet[] = R"(
+local text = external.entity.text
+local number = string.gsub(text, "[^%d+]", "")
+return {
+  {
+    title_without_entity = "Call",
+    description = "Call " .. text,
+    action = "android.intent.action.DIAL",
+    data = "tel:" .. number,
+    request_code = 1,
+  },
+  {
+    title_without_entity = "Send a message",
+    description = "Send a message to " .. text,
+    action = "android.intent.action.SENDTO",
+    data = "smsto:" .. number,
+    request_code = 2,
+  },
+}
+)";
+
+// Builds an intent factory model with the entity generator for phone numbers.
+std::string PhoneIntentFactoryModel() {
+  IntentFactoryModelT model;
+  model.precompile_generators = true;
+  model.generator.emplace_back(new IntentFactoryModel_::IntentGeneratorT);
+  model.generator.back()->type = "phone";
+  const std::string snippet = kEntityGeneratorSnippet;
+  model.generator.back()->lua_template_generator.assign(snippet.begin(),
+                                                        snippet.end());
+  flatbuffers::FlatBufferBuilder builder;
+  builder.Finish(IntentFactoryModel::Pack(builder, &model));
+  return std::string(reinterpret_cast<const char*>(builder.GetBufferPointer()),
+                     builder.GetSize());
+}
+
+// Generates the intents for a phone number through the IntentGenerator, that
+// binds the call to an environment borrowed from its pool. Several threads
+// share the generator and its pool.
+void BM_GenerateIntentsWithPooledEnvironments(benchmark::State& state) {
+  static const std::string* model_buffer =
+      new std::string(PhoneIntentFactoryModel());
+  static const IntentGenerator* generator =
+      IntentGenerator::Create(
+          flatbuffers::GetRoot<IntentFactoryModel>(model_buffer->data()),
+          /*resources=*/nullptr, /*jni_cache=*/nullptr)
+          .release();
+  if (generator == nullptr) {
+    state.SkipWithError("Could not create intent generator.");
+    return;
+  }
+  const std::string text = "Call me at (555) 123-4567";
+  const ClassificationResult classification("phone", /*arg_score=*/1.0);
+  std::vector<RemoteActionTemplate> remote_actions;
+  for (auto _ : state) {
+    remote_actions.clear();
+    if (!generator->GenerateIntents(
+            /*device_locales=*/nullptr, classification,
+            /*reference_time_ms_utc=*/0, text, /*selection_indices=*/{11, 25},
+            /*context=*/nullptr, /*annotations_entity_data_schema=*/nullptr,
+            &remote_actions)) {
+      state.SkipWithError("Could not generate intents.");
+      break;
+    }
+    benchmark::DoNotOptimize(remote_actions.size());
+  }
+}
+BENCHMARK(BM_GenerateIntentsWithPooledEnvironments)->ThreadRange(1, 8);
+
+}  // namespace
+}  // namespace libtextclassifier3
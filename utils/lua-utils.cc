@@ -27,6 +27,7 @@ namespace {
 static constexpr int kSchemaArgId = 1;
 static constexpr int kTypeArgId = 2;
 static constexpr int kTableArgId = 3;
+static constexpr int kFieldAccessorsArgId = 4;
 
 static constexpr luaL_Reg defaultlibs[] = {{"_G", luaopen_base},
                                            {LUA_TABLIBNAME, luaopen_table},
@@ -44,6 +45,108 @@ int LuaStringWriter(lua_State *state, const void *data, size_t size,
   return LUA_OK;
 }
 
+// Pushes the value of a scalar or string field of a flatbuffer table.
+typedef void (*FieldReader)(const reflection::Field *field,
+                            const flatbuffers::Table *table, lua_State *state);
+
+// Precomputed access to a flatbuffer field, kept as user data in the field
+// accessors table of a type.
+struct FieldAccessor {
+  const reflection::Field *field;
+
+  // Typed reader of the field value, nullptr for table fields.
+  FieldReader reader;
+};
+
+void ReadBoolField(const reflection::Field *field,
+                   const flatbuffers::Table *table, lua_State *state) {
+  lua_pushboolean(state, table->GetField<uint8_t>(field->offset(),
+                                                  field->default_integer()));
+}
+
+template <typename T>
+void ReadIntegerField(const reflection::Field *field,
+                      const flatbuffers::Table *table, lua_State *state) {
+  lua_pushinteger(
+      state, table->GetField<T>(field->offset(), field->default_integer()));
+}
+
+template <typename T>
+void ReadRealField(const reflection::Field *field,
+                   const flatbuffers::Table *table, lua_State *state) {
+  lua_pushnumber(state,
+                 table->GetField<T>(field->offset(), field->default_real()));
+}
+
+void ReadStringField(const reflection::Field *field,
+                     const flatbuffers::Table *table, lua_State *state) {
+  const flatbuffers::String *string_value =
+      table->GetPointer<const flatbuffers::String *>(field->offset());
+  if (string_value != nullptr) {
+    lua_pushlstring(state, string_value->data(), string_value->Length());
+  } else {
+    lua_pushlstring(state, "", 0);
+  }
+}
+
+// Gets the reader for a field type. Returns false for unsupported types.
+bool GetFieldReader(const reflection::BaseType field_type,
+                    FieldReader *reader) {
+  switch (field_type) {
+    case reflection::Bool:
+      *reader = &ReadBoolField;
+      return true;
+    case reflection::Int:
+      *reader = &ReadIntegerField<int32>;
+      return true;
+    case reflection::Long:
+      *reader = &ReadIntegerField<int64>;
+      return true;
+    case reflection::Float:
+      *reader = &ReadRealField<float>;
+      return true;
+    case reflection::Double:
+      *reader = &ReadRealField<double>;
+      return true;
+    case reflection::String:
+      *reader = &ReadStringField;
+      return true;
+    case reflection::Obj:
+      *reader = nullptr;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Pushes the table of field accessors of a flatbuffer type, keyed by field
+// name. The table is built on first use and cached in the registry of the lua
+// state, keyed by the type, so that field accesses become a single lookup of
+// an interned string.
+void PushFieldAccessors(const reflection::Object *type, lua_State *state) {
+  lua_rawgetp(state, LUA_REGISTRYINDEX, type);
+  if (!lua_isnil(state, -1)) {
+    return;
+  }
+  lua_pop(state, 1);
+  const int num_fields = type->fields() != nullptr ? type->fields()->size() : 0;
+  lua_createtable(state, /*narr=*/0, /*nrec=*/num_fields);
+  for (int i = 0; i < num_fields; i++) {
+    const reflection::Field *field = type->fields()->Get(i);
+    FieldReader reader;
+    if (!GetFieldReader(field->type()->base_type(), &reader)) {
+      continue;
+    }
+    FieldAccessor *accessor = static_cast<FieldAccessor *>(
+        lua_newuserdata(state, sizeof(FieldAccessor)));
+    accessor->field = field;
+    accessor->reader = reader;
+    lua_setfield(state, -2, field->name()->c_str());
+  }
+  lua_pushvalue(state, -1);
+  lua_rawsetp(state, LUA_REGISTRYINDEX, type);
+}
+
 }  // namespace
 
 LuaEnvironment::LuaEnvironment() { state_ = luaL_newstate(); }
@@ -70,94 +173,60 @@ int LuaEnvironment::Iterator::IteritemsCallback(lua_State *state) {
   return FromUpValue<Iterator *>(kIteratorArgId, state)->Iteritems(state);
 }
 
-void LuaEnvironment::PushFlatbuffer(const char *name,
-                                    const reflection::Schema *schema,
+void LuaEnvironment::PushFlatbuffer(const reflection::Schema *schema,
                                     const reflection::Object *type,
                                     const flatbuffers::Table *table,
                                     lua_State *state) {
   lua_newtable(state);
-  luaL_newmetatable(state, name);
+  lua_newtable(state);
   lua_pushlightuserdata(state, AsUserData(schema));
   lua_pushlightuserdata(state, AsUserData(type));
   lua_pushlightuserdata(state, AsUserData(table));
-  lua_pushcclosure(state, &GetFieldCallback, 3);
+  PushFieldAccessors(type, state);
+  lua_pushcclosure(state, &GetFieldCallback, 4);
   lua_setfield(state, -2, kIndexKey);
   lua_setmetatable(state, -2);
 }
 
 int LuaEnvironment::GetFieldCallback(lua_State *state) {
-  // Fetch the arguments.
-  const reflection::Schema *schema =
-      FromUpValue<reflection::Schema *>(kSchemaArgId, state);
-  const reflection::Object *type =
-      FromUpValue<reflection::Object *>(kTypeArgId, state);
+  // Look up the accessor of the field.
+  lua_pushvalue(state, -1);
+  lua_rawget(state, lua_upvalueindex(kFieldAccessorsArgId));
+  const FieldAccessor *accessor =
+      static_cast<const FieldAccessor *>(lua_touserdata(state, -1));
+  lua_pop(state, 1);
+  if (accessor == nullptr) {
+    const char *field_name = lua_tostring(state, -1);
+    TC3_LOG(ERROR) << "Unknown or unsupported field: "
+                   << (field_name != nullptr ? field_name : "");
+    lua_error(state);
+    return 0;
+  }
+
   const flatbuffers::Table *table =
       FromUpValue<flatbuffers::Table *>(kTableArgId, state);
-  return GetField(schema, type, table, state);
+  if (accessor->reader != nullptr) {
+    accessor->reader(accessor->field, table, state);
+    return 1;
+  }
+  return GetTableField(FromUpValue<reflection::Schema *>(kSchemaArgId, state),
+                       accessor->field, table, state);
 }
 
-int LuaEnvironment::GetField(const reflection::Schema *schema,
-                             const reflection::Object *type,
-                             const flatbuffers::Table *table,
-                             lua_State *state) {
-  const char *field_name = lua_tostring(state, -1);
-  const reflection::Field *field = type->fields()->LookupByKey(field_name);
-  if (field == nullptr) {
+int LuaEnvironment::GetTableField(const reflection::Schema *schema,
+                                  const reflection::Field *field,
+                                  const flatbuffers::Table *table,
+                                  lua_State *state) {
+  const flatbuffers::Table *field_table =
+      table->GetPointer<const flatbuffers::Table *>(field->offset());
+  if (field_table == nullptr) {
+    TC3_LOG(ERROR) << "Field was not set in entity data.";
     lua_error(state);
     return 0;
   }
-  // Provide primitive fields directly.
-  const reflection::BaseType field_type = field->type()->base_type();
-  switch (field_type) {
-    case reflection::Bool:
-      lua_pushboolean(state, table->GetField<uint8_t>(
-                                 field->offset(), field->default_integer()));
-      break;
-    case reflection::Int:
-      lua_pushinteger(state, table->GetField<int32>(field->offset(),
-                                                    field->default_integer()));
-      break;
-    case reflection::Long:
-      lua_pushinteger(state, table->GetField<int64>(field->offset(),
-                                                    field->default_integer()));
-      break;
-    case reflection::Float:
-      lua_pushnumber(state, table->GetField<float>(field->offset(),
-                                                   field->default_real()));
-      break;
-    case reflection::Double:
-      lua_pushnumber(state, table->GetField<double>(field->offset(),
-                                                    field->default_real()));
-      break;
-    case reflection::String: {
-      const flatbuffers::String *string_value =
-          table->GetPointer<const flatbuffers::String *>(field->offset());
-      if (string_value != nullptr) {
-        lua_pushlstring(state, string_value->data(), string_value->Length());
-      } else {
-        lua_pushlstring(state, "", 0);
-      }
-      break;
-    }
-    case reflection::Obj: {
-      const flatbuffers::Table *field_table =
-          table->GetPointer<const flatbuffers::Table *>(field->offset());
-      if (field_table == nullptr) {
-        TC3_LOG(ERROR) << "Field was not set in entity data.";
-        lua_error(state);
-        return 0;
-      }
-      const reflection::Object *field_type =
-          schema->objects()->Get(field->type()->index());
-      PushFlatbuffer(field->name()->c_str(), schema, field_type, field_table,
-                     state);
-      break;
-    }
-    default:
-      TC3_LOG(ERROR) << "Unsupported type: " << field_type;
-      lua_error(state);
-      return 0;
-  }
+  const reflection::Object *field_type =
+      schema->objects()->Get(field->type()->index());
+  PushFlatbuffer(schema, field_type, field_table, state);
   return 1;
 }
 
@@ -169,18 +238,28 @@ int LuaEnvironment::ReadFlatbuffer(ReflectiveFlatbuffer *buffer) {
     return LUA_ERRRUN;
   }
 
+  // Stack: table, field accessors, key, value.
+  PushFieldAccessors(buffer->type(), state_);
   lua_pushnil(state_);
-  while (lua_next(state_, /*idx=*/-2)) {
-    const StringPiece key = ReadString(/*index=*/-2);
-    const reflection::Field *field = buffer->GetFieldOrNull(key);
-    if (field == nullptr) {
-      TC3_LOG(ERROR) << "Unknown field: " << key.ToString();
+  while (lua_next(state_, /*idx=*/-3)) {
+    lua_pushvalue(state_, /*idx=*/-2);
+    lua_rawget(state_, /*idx=*/-4);
+    const FieldAccessor *accessor =
+        static_cast<const FieldAccessor *>(lua_touserdata(state_, -1));
+    lua_pop(state_, 1);
+    if (accessor == nullptr) {
+      TC3_LOG(ERROR) << "Unknown field: "
+                     << ReadString(/*index=*/-2).ToString();
       lua_error(state_);
       return LUA_ERRRUN;
     }
+    const reflection::Field *field = accessor->field;
     switch (field->type()->base_type()) {
       case reflection::Obj:
-        return ReadFlatbuffer(buffer->Mutable(field));
+        if (ReadFlatbuffer(buffer->Mutable(field)) != LUA_OK) {
+          return LUA_ERRRUN;
+        }
+        break;
       case reflection::Bool:
         buffer->Set(field,
                     static_cast<bool>(lua_toboolean(state_, /*idx=*/-1)));
@@ -211,7 +290,8 @@ int LuaEnvironment::ReadFlatbuffer(ReflectiveFlatbuffer *buffer) {
     }
     lua_pop(state_, 1);
   }
-  // lua_pop(state_, /*n=*/1);
+  // Remove the field accessors.
+  lua_pop(state_, 1);
   return LUA_OK;
 }
 
@@ -253,8 +333,7 @@ void LuaEnvironment::PushString(const StringPiece str) {
 
 void LuaEnvironment::PushFlatbuffer(const reflection::Schema *schema,
                                     const flatbuffers::Table *table) {
-  PushFlatbuffer(schema->root_table()->name()->c_str(), schema,
-                 schema->root_table(), table, state_);
+  PushFlatbuffer(schema, schema->root_table(), table, state_);
 }
 
 int LuaEnvironment::RunProtected(const std::function<int()> &func,
@@ -242,13 +242,17 @@ class LuaEnvironment {
 
  private:
   // Auxiliary methods to expose (reflective) flatbuffer based data to Lua.
-  static void PushFlatbuffer(const char *name, const reflection::Schema *schema,
+  // Field accesses are resolved via a table of accessors that is created once
+  // per lua state and flatbuffer type.
+  static void PushFlatbuffer(const reflection::Schema *schema,
                              const reflection::Object *type,
                              const flatbuffers::Table *table, lua_State *state);
   static int GetFieldCallback(lua_State *state);
-  static int GetField(const reflection::Schema *schema,
-                      const reflection::Object *type,
-                      const flatbuffers::Table *table, lua_State *state);
+
+  // Pushes a table valued field.
+  static int GetTableField(const reflection::Schema *schema,
+                           const reflection::Field *field,
+                           const flatbuffers::Table *table, lua_State *state);
 
   template <typename T, int (T::*handler)()>
   static int Dispatch(lua_State *state) {
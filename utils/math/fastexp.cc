@@ -16,6 +16,14 @@
 
 #include "utils/math/fastexp.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 namespace libtextclassifier3 {
 
 const int FastMathClass::kBits;
@@ -45,4 +53,64 @@ const FastMathClass::Table FastMathClass::cache_ = {
      7940441, 8029106, 8118253, 8207884, 8298001}
 };
 
+// The vectorized versions do the same float operations as VeryFastExp2(), in
+// the same order, and only differ in how the table is looked up.
+void FastMathClass::VeryFastExp(const float* input, int size,
+                                float* output) const {
+  int i = 0;
+#if defined(__AVX2__)
+  const __m256 log_base2_of_e = _mm256_set1_ps(kLogBase2OfE);
+  const __m256 offset = _mm256_set1_ps(127 + (1 << (23 - kBits)));
+  const __m256i mask1 = _mm256_set1_epi32(kMask1);
+  const __m256i mask2 = _mm256_set1_epi32(kMask2);
+  for (; i + 8 <= size; i += 8) {
+    const __m256 f = _mm256_mul_ps(_mm256_loadu_ps(input + i), log_base2_of_e);
+    const __m256i x = _mm256_castps_si256(_mm256_add_ps(f, offset));
+    const __m256i exp1 = _mm256_i32gather_epi32(
+        cache_.exp1, _mm256_and_si256(x, mask1), sizeof(int32));
+    const __m256i result = _mm256_or_si256(
+        _mm256_slli_epi32(_mm256_and_si256(x, mask2), 23 - kBits), exp1);
+    _mm256_storeu_ps(output + i, _mm256_castsi256_ps(result));
+  }
+#elif defined(__SSE2__)
+  const __m128 log_base2_of_e = _mm_set1_ps(kLogBase2OfE);
+  const __m128 offset = _mm_set1_ps(127 + (1 << (23 - kBits)));
+  const __m128i mask1 = _mm_set1_epi32(kMask1);
+  const __m128i mask2 = _mm_set1_epi32(kMask2);
+  alignas(16) int32 indices[4];
+  for (; i + 4 <= size; i += 4) {
+    const __m128 f = _mm_mul_ps(_mm_loadu_ps(input + i), log_base2_of_e);
+    const __m128i x = _mm_castps_si128(_mm_add_ps(f, offset));
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices),
+                    _mm_and_si128(x, mask1));
+    const __m128i exp1 =
+        _mm_setr_epi32(cache_.exp1[indices[0]], cache_.exp1[indices[1]],
+                       cache_.exp1[indices[2]], cache_.exp1[indices[3]]);
+    const __m128i result = _mm_or_si128(
+        _mm_slli_epi32(_mm_and_si128(x, mask2), 23 - kBits), exp1);
+    _mm_storeu_ps(output + i, _mm_castsi128_ps(result));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const float32x4_t log_base2_of_e = vdupq_n_f32(kLogBase2OfE);
+  const float32x4_t offset = vdupq_n_f32(127 + (1 << (23 - kBits)));
+  const int32x4_t mask1 = vdupq_n_s32(kMask1);
+  const int32x4_t mask2 = vdupq_n_s32(kMask2);
+  for (; i + 4 <= size; i += 4) {
+    const float32x4_t f = vmulq_f32(vld1q_f32(input + i), log_base2_of_e);
+    const int32x4_t x = vreinterpretq_s32_f32(vaddq_f32(f, offset));
+    const int32x4_t indices = vandq_s32(x, mask1);
+    int32x4_t exp1 = vdupq_n_s32(cache_.exp1[vgetq_lane_s32(indices, 0)]);
+    exp1 = vsetq_lane_s32(cache_.exp1[vgetq_lane_s32(indices, 1)], exp1, 1);
+    exp1 = vsetq_lane_s32(cache_.exp1[vgetq_lane_s32(indices, 2)], exp1, 2);
+    exp1 = vsetq_lane_s32(cache_.exp1[vgetq_lane_s32(indices, 3)], exp1, 3);
+    const int32x4_t result =
+        vorrq_s32(vshlq_n_s32(vandq_s32(x, mask2), 23 - kBits), exp1);
+    vst1q_f32(output + i, vreinterpretq_f32_s32(result));
+  }
+#endif
+  for (; i < size; ++i) {
+    output[i] = VeryFastExp(input[i]);
+  }
+}
+
 }  // namespace libtextclassifier3
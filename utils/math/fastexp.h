@@ -54,6 +54,11 @@ class FastMathClass {
     return VeryFastExp2(f * kLogBase2OfE);
   }
 
+  // Computes VeryFastExp() of the 'size' values of 'input' into 'output',
+  // which may be the same array. Uses SIMD instructions where available, with
+  // the same results as the scalar version.
+  void VeryFastExp(const float* input, int size, float* output) const;
+
  private:
   static const Table cache_;
 };
@@ -62,6 +67,10 @@ extern FastMathClass FastMathInstance;
 
 inline float VeryFastExp(float f) { return FastMathInstance.VeryFastExp(f); }
 
+inline void VeryFastExp(const float* input, int size, float* output) {
+  FastMathInstance.VeryFastExp(input, size, output);
+}
+
 }  // namespace libtextclassifier3
 
 #endif  // LIBTEXTCLASSIFIER_UTILS_MATH_FASTEXP_H_
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/math/fastexp.h"
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+std::vector<float> TestValues() {
+  std::vector<float> values;
+  for (float value = -87.0f; value <= 87.0f; value += 0.0173f) {
+    values.push_back(value);
+  }
+  return values;
+}
+
+TEST(FastExpTest, IsWithinRelativeErrorBound) {
+  for (const float value : TestValues()) {
+    const float expected = std::exp(value);
+    EXPECT_NEAR(VeryFastExp(value), expected, 3e-3f * expected) << value;
+  }
+}
+
+TEST(FastExpTest, BatchMatchesScalar) {
+  const std::vector<float> values = TestValues();
+  std::vector<float> results(values.size());
+  VeryFastExp(values.data(), values.size(), results.data());
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(results[i], VeryFastExp(values[i])) << values[i];
+  }
+}
+
+TEST(FastExpTest, BatchHandlesAllSizesInPlace) {
+  for (int size = 0; size < 20; ++size) {
+    std::vector<float> values;
+    for (int i = 0; i < size; ++i) {
+      values.push_back(i * 0.7f - 5.0f);
+    }
+    std::vector<float> results = values;
+    VeryFastExp(results.data(), size, results.data());
+    for (int i = 0; i < size; ++i) {
+      EXPECT_EQ(results[i], VeryFastExp(values[i])) << size << " " << i;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
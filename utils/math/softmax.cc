@@ -16,7 +16,8 @@
 
 #include "utils/math/softmax.h"
 
-#include <limits>
+#include <algorithm>
+#include <cmath>
 
 #include "utils/base/logging.h"
 #include "utils/math/fastexp.h"
@@ -74,31 +75,121 @@ std::vector<float> ComputeSoftmax(const std::vector<float> &scores) {
 }
 
 std::vector<float> ComputeSoftmax(const float *scores, int scores_size) {
-  std::vector<float> softmax;
-  std::vector<float> exp_scores;
-  exp_scores.reserve(scores_size);
-  softmax.reserve(scores_size);
+  std::vector<float> softmax(scores, scores + scores_size);
+  ComputeSoftmaxInPlace(softmax.data(), scores_size);
+  return softmax;
+}
+
+namespace {
+
+// Smallest argument passed to VeryFastExp, to stay within its range. The
+// result is below 1e-37, so it doesn't change a sum that includes exp(0).
+const float kMinExpArgument = -87.0f;
+
+// Results of VeryFastExp below this come from kMinExpArgument.
+const float kMinExpResult = 1e-30f;
+
+// Number of scores whose exponentials are computed at once for the
+// log-softmax.
+const int kExpChunkSize = 64;
+
+// Number of independent accumulators of the reductions below, so that they
+// don't serialize on the latency of each addition and vectorize.
+const int kNumLanes = 8;
+
+float MaxScore(const float *scores, int scores_size) {
+  float lanes[kNumLanes];
+  std::fill(lanes, lanes + kNumLanes, scores[0]);
+  int i = 0;
+  for (; i + kNumLanes <= scores_size; i += kNumLanes) {
+    for (int lane = 0; lane < kNumLanes; ++lane) {
+      lanes[lane] = lanes[lane] > scores[i + lane] ? lanes[lane]
+                                                   : scores[i + lane];
+    }
+  }
+  for (; i < scores_size; ++i) {
+    lanes[0] = std::max(lanes[0], scores[i]);
+  }
+  return *std::max_element(lanes, lanes + kNumLanes);
+}
+
+float Sum(const float *values, int size) {
+  float lanes[kNumLanes] = {0};
+  int i = 0;
+  for (; i + kNumLanes <= size; i += kNumLanes) {
+    for (int lane = 0; lane < kNumLanes; ++lane) {
+      lanes[lane] += values[i + lane];
+    }
+  }
+  for (; i < size; ++i) {
+    lanes[0] += values[i];
+  }
+  float sum = 0;
+  for (int lane = 0; lane < kNumLanes; ++lane) {
+    sum += lanes[lane];
+  }
+  return sum;
+}
 
-  // Find max value in "scores" vector and rescale to avoid overflows.
-  float max = std::numeric_limits<float>::min();
+}  // namespace
+
+void ComputeSoftmaxInPlace(float *scores, int scores_size) {
+  if (scores_size <= 0) {
+    return;
+  }
+
+  // Rescale by the max value to avoid overflows. See comments above in
+  // ComputeSoftmaxProbability for the reasoning behind treating scores 16
+  // below the max as 0.
+  const float max = MaxScore(scores, scores_size);
   for (int i = 0; i < scores_size; ++i) {
-    const float score = scores[i];
-    if (score > max) max = score;
+    const float delta_score = scores[i] - max;
+    scores[i] = delta_score < -16.0f ? kMinExpArgument : delta_score;
   }
-  float denominator = 0;
+  VeryFastExp(scores, scores_size, scores);
+
+  const float inverse_denominator = 1.0f / Sum(scores, scores_size);
   for (int i = 0; i < scores_size; ++i) {
-    const float score = scores[i];
-    // See comments above in ComputeSoftmaxProbability for the reasoning behind
-    // this approximation.
-    const float exp_score = score - max < -16.0f ? 0 : VeryFastExp(score - max);
-    exp_scores.push_back(exp_score);
-    denominator += exp_score;
+    scores[i] = scores[i] < kMinExpResult ? 0.0f
+                                          : scores[i] * inverse_denominator;
+  }
+}
+
+void ComputeLogSoftmaxInPlace(float *scores, int scores_size) {
+  if (scores_size <= 0) {
+    return;
   }
 
+  const float max = MaxScore(scores, scores_size);
+  float exp_scores[kExpChunkSize];
+  float denominator = 0;
+  for (int start = 0; start < scores_size; start += kExpChunkSize) {
+    const int chunk_size = std::min(kExpChunkSize, scores_size - start);
+    for (int i = 0; i < chunk_size; ++i) {
+      exp_scores[i] = std::max(scores[start + i] - max, kMinExpArgument);
+    }
+    VeryFastExp(exp_scores, chunk_size, exp_scores);
+    denominator += Sum(exp_scores, chunk_size);
+  }
+
+  const float log_denominator = max + std::log(denominator);
   for (int i = 0; i < scores_size; ++i) {
-    softmax.push_back(exp_scores[i] / denominator);
+    scores[i] -= log_denominator;
   }
-  return softmax;
+}
+
+bool ComputeSoftmaxRows(const TensorView<float> &logits,
+                        std::vector<float> *softmax) {
+  if (!logits.is_valid() || logits.dims() != 2) {
+    return false;
+  }
+  const int num_rows = logits.dim(0);
+  const int num_cols = logits.dim(1);
+  softmax->assign(logits.data(), logits.data() + logits.size());
+  for (int row = 0; row < num_rows; ++row) {
+    ComputeSoftmaxInPlace(softmax->data() + row * num_cols, num_cols);
+  }
+  return true;
 }
 
 }  // namespace libtextclassifier3
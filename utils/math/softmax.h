@@ -19,6 +19,8 @@
 
 #include <vector>
 
+#include "utils/tensor-view.h"
+
 namespace libtextclassifier3 {
 
 // Computes probability of a softmax label.  Parameter "scores" is the vector of
@@ -33,6 +35,18 @@ std::vector<float> ComputeSoftmax(const std::vector<float> &scores);
 // Same as above but operates on an array of floats.
 std::vector<float> ComputeSoftmax(const float *scores, int scores_size);
 
+// Replaces the softmax logits in 'scores' by their softmax, in place.
+void ComputeSoftmaxInPlace(float *scores, int scores_size);
+
+// Replaces the softmax logits in 'scores' by their log-softmax, in place.
+void ComputeLogSoftmaxInPlace(float *scores, int scores_size);
+
+// Computes the softmax of each row of the 2-D matrix of logits into 'softmax',
+// which is resized to the size of the matrix and can be reused between calls.
+// Returns false if the logits are not a valid matrix.
+bool ComputeSoftmaxRows(const TensorView<float> &logits,
+                        std::vector<float> *softmax);
+
 }  // namespace libtextclassifier3
 
 #endif  // LIBTEXTCLASSIFIER_UTILS_MATH_SOFTMAX_H_
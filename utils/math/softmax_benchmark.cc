@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the exponential and softmax functions, for the numbers of labels
+// of the selection and classification models and larger.
+
+#include <vector>
+
+#include "utils/math/fastexp.h"
+#include "utils/math/softmax.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+std::vector<float> BenchmarkScores(int size) {
+  std::vector<float> scores;
+  for (int i = 0; i < size; ++i) {
+    scores.push_back((i * 37 % 23) / 3.0f - 2.0f);
+  }
+  return scores;
+}
+
+void BM_VeryFastExpScalar(benchmark::State& state) {
+  const std::vector<float> scores = BenchmarkScores(state.range(0));
+  std::vector<float> results(scores.size());
+  for (auto _ : state) {
+    for (int i = 0; i < scores.size(); ++i) {
+      results[i] = VeryFastExp(scores[i]);
+    }
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(state.iterations() * scores.size());
+}
+BENCHMARK(BM_VeryFastExpScalar)->RangeMultiplier(4)->Range(8, 512);
+
+void BM_VeryFastExpBatch(benchmark::State& state) {
+  const std::vector<float> scores = BenchmarkScores(state.range(0));
+  std::vector<float> results(scores.size());
+  for (auto _ : state) {
+    VeryFastExp(scores.data(), scores.size(), results.data());
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(state.iterations() * scores.size());
+}
+BENCHMARK(BM_VeryFastExpBatch)->RangeMultiplier(4)->Range(8, 512);
+
+void BM_ComputeSoftmax(benchmark::State& state) {
+  const std::vector<float> scores = BenchmarkScores(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ComputeSoftmax(scores));
+  }
+  state.SetItemsProcessed(state.iterations() * scores.size());
+}
+BENCHMARK(BM_ComputeSoftmax)->RangeMultiplier(4)->Range(8, 512);
+
+void BM_ComputeSoftmaxInPlace(benchmark::State& state) {
+  const std::vector<float> scores = BenchmarkScores(state.range(0));
+  std::vector<float> softmax(scores.size());
+  for (auto _ : state) {
+    softmax = scores;
+    ComputeSoftmaxInPlace(softmax.data(), softmax.size());
+    benchmark::DoNotOptimize(softmax.data());
+  }
+  state.SetItemsProcessed(state.iterations() * scores.size());
+}
+BENCHMARK(BM_ComputeSoftmaxInPlace)->RangeMultiplier(4)->Range(8, 512);
+
+void BM_ComputeLogSoftmaxInPlace(benchmark::State& state) {
+  const std::vector<float> scores = BenchmarkScores(state.range(0));
+  std::vector<float> log_softmax(scores.size());
+  for (auto _ : state) {
+    log_softmax = scores;
+    ComputeLogSoftmaxInPlace(log_softmax.data(), log_softmax.size());
+    benchmark::DoNotOptimize(log_softmax.data());
+  }
+  state.SetItemsProcessed(state.iterations() * scores.size());
+}
+BENCHMARK(BM_ComputeLogSoftmaxInPlace)->RangeMultiplier(4)->Range(8, 512);
+
+// Softmax of a batch of rows, as for the selection model's batched inference.
+// Args: number of rows, number of labels per row.
+void BM_ComputeSoftmaxRows(benchmark::State& state) {
+  const std::vector<float> logits =
+      BenchmarkScores(state.range(0) * state.range(1));
+  const TensorView<float> logits_view(
+      logits.data(),
+      {static_cast<int>(state.range(0)), static_cast<int>(state.range(1))});
+  std::vector<float> softmax;
+  for (auto _ : state) {
+    ComputeSoftmaxRows(logits_view, &softmax);
+    benchmark::DoNotOptimize(softmax.data());
+  }
+  state.SetItemsProcessed(state.iterations() * logits.size());
+}
+BENCHMARK(BM_ComputeSoftmaxRows)->Args({32, 21})->Args({32, 64});
+
+}  // namespace
+}  // namespace libtextclassifier3
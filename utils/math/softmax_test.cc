@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/math/softmax.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+std::vector<float> ExactSoftmax(const std::vector<float>& scores) {
+  double denominator = 0.0;
+  for (const float score : scores) {
+    denominator += std::exp(static_cast<double>(score));
+  }
+  std::vector<float> softmax;
+  for (const float score : scores) {
+    softmax.push_back(std::exp(static_cast<double>(score)) / denominator);
+  }
+  return softmax;
+}
+
+std::vector<float> TestScores(int size) {
+  std::vector<float> scores;
+  for (int i = 0; i < size; ++i) {
+    scores.push_back((i * 37 % 23) / 3.0f - 2.0f);
+  }
+  return scores;
+}
+
+TEST(SoftmaxTest, IsWithinErrorBoundOfExactSoftmax) {
+  for (const int size : {1, 2, 7, 8, 9, 33, 100}) {
+    const std::vector<float> scores = TestScores(size);
+    std::vector<float> softmax = scores;
+    ComputeSoftmaxInPlace(softmax.data(), size);
+    const std::vector<float> expected = ExactSoftmax(scores);
+    float sum = 0.0f;
+    for (int i = 0; i < size; ++i) {
+      EXPECT_NEAR(softmax[i], expected[i], 6e-3f * expected[i] + 1e-6f)
+          << size << " " << i;
+      sum += softmax[i];
+    }
+    EXPECT_NEAR(sum, 1.0f, 1e-5f);
+  }
+}
+
+TEST(SoftmaxTest, MatchesComputeSoftmax) {
+  const std::vector<float> scores = TestScores(50);
+  std::vector<float> softmax = scores;
+  ComputeSoftmaxInPlace(softmax.data(), softmax.size());
+  EXPECT_EQ(softmax, ComputeSoftmax(scores));
+}
+
+TEST(SoftmaxTest, IgnoresScoresFarBelowMax) {
+  std::vector<float> scores = {0.0f, -16.5f, -100.0f, -1000.0f};
+  ComputeSoftmaxInPlace(scores.data(), scores.size());
+  EXPECT_THAT(scores, testing::ElementsAre(1.0f, 0.0f, 0.0f, 0.0f));
+}
+
+TEST(SoftmaxTest, HandlesNegativeScores) {
+  std::vector<float> scores = {-100.0f, -101.0f};
+  ComputeSoftmaxInPlace(scores.data(), scores.size());
+  EXPECT_NEAR(scores[0], 0.731f, 5e-3f);
+  EXPECT_NEAR(scores[1], 0.269f, 5e-3f);
+}
+
+TEST(SoftmaxTest, HandlesEmptyScores) {
+  EXPECT_TRUE(ComputeSoftmax({}).empty());
+  ComputeSoftmaxInPlace(nullptr, 0);
+  ComputeLogSoftmaxInPlace(nullptr, 0);
+}
+
+TEST(LogSoftmaxTest, IsWithinErrorBoundOfExactLogSoftmax) {
+  for (const int size : {1, 2, 63, 64, 65, 200}) {
+    std::vector<float> scores = TestScores(size);
+    scores[0] = -200.0f;
+    std::vector<float> log_softmax = scores;
+    ComputeLogSoftmaxInPlace(log_softmax.data(), size);
+    const float max = *std::max_element(scores.begin(), scores.end());
+    double denominator = 0.0;
+    for (const float score : scores) {
+      denominator += std::exp(static_cast<double>(score - max));
+    }
+    for (int i = 0; i < size; ++i) {
+      EXPECT_NEAR(log_softmax[i], scores[i] - max - std::log(denominator),
+                  6e-3f)
+          << size << " " << i;
+    }
+  }
+}
+
+TEST(SoftmaxRowsTest, MatchesSoftmaxOfEachRow) {
+  const std::vector<float> logits = TestScores(12);
+  std::vector<float> softmax;
+  ASSERT_TRUE(
+      ComputeSoftmaxRows(TensorView<float>(logits.data(), {3, 4}), &softmax));
+  ASSERT_EQ(softmax.size(), 12);
+  for (int row = 0; row < 3; ++row) {
+    EXPECT_EQ(std::vector<float>(softmax.begin() + row * 4,
+                                 softmax.begin() + (row + 1) * 4),
+              ComputeSoftmax(logits.data() + row * 4, 4));
+  }
+}
+
+TEST(SoftmaxRowsTest, FailsForInvalidLogits) {
+  const std::vector<float> logits = TestScores(12);
+  std::vector<float> softmax;
+  EXPECT_FALSE(
+      ComputeSoftmaxRows(TensorView<float>(logits.data(), {12}), &softmax));
+  EXPECT_FALSE(ComputeSoftmaxRows(TensorView<float>::Invalid(), &softmax));
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
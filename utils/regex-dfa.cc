@@ -0,0 +1,692 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/regex-dfa.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "utils/base/logging.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+constexpr char32 kMaxCodepoint = 0x10FFFF;
+
+// Limits on the size of the compiled patterns. Patterns that exceed them are
+// reported as not supported.
+constexpr int kMaxRepetitions = 32;
+constexpr int kMaxNfaStates = 2048;
+constexpr int kMaxDfaStates = 512;
+
+// Sorted, non-overlapping, inclusive ranges of codepoints.
+using CodepointRanges = std::vector<std::pair<char32, char32>>;
+
+CodepointRanges NormalizeRanges(CodepointRanges ranges) {
+  std::sort(ranges.begin(), ranges.end());
+  CodepointRanges result;
+  for (const auto& range : ranges) {
+    if (!result.empty() && range.first <= result.back().second + 1) {
+      result.back().second = std::max(result.back().second, range.second);
+    } else {
+      result.push_back(range);
+    }
+  }
+  return result;
+}
+
+CodepointRanges ComplementRanges(const CodepointRanges& ranges) {
+  CodepointRanges result;
+  char32 start = 0;
+  for (const auto& range : NormalizeRanges(ranges)) {
+    if (range.first > start) {
+      result.push_back({start, range.first - 1});
+    }
+    start = range.second + 1;
+  }
+  if (start <= kMaxCodepoint) {
+    result.push_back({start, kMaxCodepoint});
+  }
+  return result;
+}
+
+bool RangesContain(const CodepointRanges& ranges, char32 codepoint) {
+  for (const auto& range : ranges) {
+    if (codepoint >= range.first && codepoint <= range.second) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Abstract syntax tree of a parsed pattern.
+struct RegexNode {
+  enum Type { SET, CONCAT, ALTERNATE, REPEAT };
+
+  explicit RegexNode(Type arg_type) : type(arg_type) {}
+
+  Type type;
+
+  // Codepoints matched by a SET node.
+  CodepointRanges set;
+
+  // Sub-expressions of CONCAT and ALTERNATE nodes, the repeated expression of
+  // a REPEAT node.
+  std::vector<std::unique_ptr<RegexNode>> children;
+
+  // Bounds of a REPEAT node, max_repetitions is -1 if unbounded.
+  int min_repetitions = 0;
+  int max_repetitions = -1;
+};
+
+// Recursive descent parser of the supported subset of the Java regular
+// expression syntax. All the parsing methods return nullptr/false if the
+// pattern is not supported.
+class RegexParser {
+ public:
+  explicit RegexParser(const std::string& pattern) {
+    for (const char32 codepoint : UTF8ToUnicodeText(pattern,
+                                                    /*do_copy=*/false)) {
+      codepoints_.push_back(codepoint);
+    }
+  }
+
+  std::unique_ptr<RegexNode> Parse() {
+    std::unique_ptr<RegexNode> node = ParseAlternation(/*top_level=*/true);
+    if (node == nullptr || !AtEnd()) {
+      return nullptr;
+    }
+    return node;
+  }
+
+ private:
+  bool AtEnd() const { return pos_ >= codepoints_.size(); }
+  char32 Peek(int offset = 0) const {
+    return pos_ + offset < codepoints_.size() ? codepoints_[pos_ + offset]
+                                              : -1;
+  }
+
+  std::unique_ptr<RegexNode> ParseAlternation(bool top_level) {
+    std::unique_ptr<RegexNode> node(new RegexNode(RegexNode::ALTERNATE));
+    while (true) {
+      std::unique_ptr<RegexNode> sequence = ParseSequence(top_level);
+      if (sequence == nullptr) {
+        return nullptr;
+      }
+      node->children.push_back(std::move(sequence));
+      if (Peek() != '|') {
+        break;
+      }
+      ++pos_;
+    }
+    if (node->children.size() == 1) {
+      return std::move(node->children[0]);
+    }
+    return node;
+  }
+
+  // Parses a sequence up to the next '|', ')' or the end of the pattern.
+  // Anchors are only supported at the start and end of the top-level
+  // alternatives, where they are no-ops for a full match.
+  std::unique_ptr<RegexNode> ParseSequence(bool top_level) {
+    std::unique_ptr<RegexNode> node(new RegexNode(RegexNode::CONCAT));
+    if (top_level && Peek() == '^') {
+      ++pos_;
+    }
+    while (!AtEnd() && Peek() != '|' && Peek() != ')') {
+      if (top_level && Peek() == '$' &&
+          (pos_ + 1 == codepoints_.size() || Peek(1) == '|')) {
+        ++pos_;
+        break;
+      }
+      std::unique_ptr<RegexNode> repetition = ParseRepetition();
+      if (repetition == nullptr) {
+        return nullptr;
+      }
+      node->children.push_back(std::move(repetition));
+    }
+    return node;
+  }
+
+  std::unique_ptr<RegexNode> ParseRepetition() {
+    std::unique_ptr<RegexNode> atom = ParseAtom();
+    if (atom == nullptr) {
+      return nullptr;
+    }
+    int min_repetitions;
+    int max_repetitions;
+    switch (Peek()) {
+      case '*':
+        min_repetitions = 0;
+        max_repetitions = -1;
+        ++pos_;
+        break;
+      case '+':
+        min_repetitions = 1;
+        max_repetitions = -1;
+        ++pos_;
+        break;
+      case '?':
+        min_repetitions = 0;
+        max_repetitions = 1;
+        ++pos_;
+        break;
+      case '{':
+        if (!ParseBounds(&min_repetitions, &max_repetitions)) {
+          return nullptr;
+        }
+        break;
+      default:
+        return atom;
+    }
+
+    // Reluctant quantifiers match the same texts when matching the whole
+    // text, possessive ones don't.
+    if (Peek() == '?') {
+      ++pos_;
+    }
+    if (Peek() == '+' || Peek() == '*' || Peek() == '?' || Peek() == '{') {
+      return nullptr;
+    }
+
+    std::unique_ptr<RegexNode> node(new RegexNode(RegexNode::REPEAT));
+    node->min_repetitions = min_repetitions;
+    node->max_repetitions = max_repetitions;
+    node->children.push_back(std::move(atom));
+    return node;
+  }
+
+  // Parses {n}, {n,} or {n,m}.
+  bool ParseBounds(int* min_repetitions, int* max_repetitions) {
+    ++pos_;  // '{'
+    if (!ParseNumber(min_repetitions)) {
+      return false;
+    }
+    *max_repetitions = *min_repetitions;
+    if (Peek() == ',') {
+      ++pos_;
+      if (Peek() == '}') {
+        *max_repetitions = -1;
+      } else if (!ParseNumber(max_repetitions) ||
+                 *max_repetitions < *min_repetitions) {
+        return false;
+      }
+    }
+    if (Peek() != '}') {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  bool ParseNumber(int* value) {
+    *value = 0;
+    const int start = pos_;
+    while (Peek() >= '0' && Peek() <= '9') {
+      *value = *value * 10 + (Peek() - '0');
+      if (*value > kMaxRepetitions) {
+        return false;
+      }
+      ++pos_;
+    }
+    return pos_ > start;
+  }
+
+  std::unique_ptr<RegexNode> ParseAtom() {
+    const char32 codepoint = Peek();
+    std::unique_ptr<RegexNode> node(new RegexNode(RegexNode::SET));
+    switch (codepoint) {
+      case '(': {
+        ++pos_;
+        if (Peek() == '?') {
+          // Only non-capturing groups are supported, no flags or lookaround.
+          if (Peek(1) != ':') {
+            return nullptr;
+          }
+          pos_ += 2;
+        }
+        std::unique_ptr<RegexNode> group =
+            ParseAlternation(/*top_level=*/false);
+        if (group == nullptr || Peek() != ')') {
+          return nullptr;
+        }
+        ++pos_;
+        return group;
+      }
+      case '[':
+        if (!ParseClass(&node->set)) {
+          return nullptr;
+        }
+        return node;
+      case '.':
+        // Any codepoint but the line terminators, as with ICU.
+        node->set = ComplementRanges(
+            {{'\n', '\r'}, {0x85, 0x85}, {0x2028, 0x2029}});
+        ++pos_;
+        return node;
+      case '\\':
+        if (!ParseEscape(&node->set)) {
+          return nullptr;
+        }
+        return node;
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+      case '^':
+      case '$':
+        return nullptr;
+      default:
+        node->set = {{codepoint, codepoint}};
+        ++pos_;
+        return node;
+    }
+  }
+
+  // Parses an escape sequence: a control character or escaped punctuation.
+  // The predefined character classes \d \w \s and their negations are not
+  // supported: the regexes of UniLib match them on Unicode properties.
+  bool ParseEscape(CodepointRanges* ranges) {
+    ++pos_;  // '\'
+    if (AtEnd()) {
+      return false;
+    }
+    const char32 codepoint = Peek();
+    ++pos_;
+    switch (codepoint) {
+      case 't':
+        *ranges = {{'\t', '\t'}};
+        break;
+      case 'n':
+        *ranges = {{'\n', '\n'}};
+        break;
+      case 'r':
+        *ranges = {{'\r', '\r'}};
+        break;
+      case 'f':
+        *ranges = {{'\f', '\f'}};
+        break;
+      case 'a':
+        *ranges = {{0x07, 0x07}};
+        break;
+      case 'e':
+        *ranges = {{0x1B, 0x1B}};
+        break;
+      default:
+        // A backslash before a non-alphanumeric ASCII character quotes it.
+        if (codepoint >= 0x80 || (codepoint >= '0' && codepoint <= '9') ||
+            (codepoint >= 'A' && codepoint <= 'Z') ||
+            (codepoint >= 'a' && codepoint <= 'z')) {
+          return false;
+        }
+        *ranges = {{codepoint, codepoint}};
+        return true;
+    }
+    return true;
+  }
+
+  // Parses one element of a character class: a codepoint or an escape
+  // sequence.
+  bool ParseClassElement(CodepointRanges* ranges) {
+    const char32 codepoint = Peek();
+    if (codepoint == '\\') {
+      return ParseEscape(ranges);
+    }
+    // Nested classes, unions and intersections are not supported.
+    if (codepoint == '[' || (codepoint == '&' && Peek(1) == '&')) {
+      return false;
+    }
+    *ranges = {{codepoint, codepoint}};
+    ++pos_;
+    return true;
+  }
+
+  bool ParseClass(CodepointRanges* ranges) {
+    ++pos_;  // '['
+    bool negated = false;
+    if (Peek() == '^') {
+      negated = true;
+      ++pos_;
+    }
+    if (Peek() == ']') {
+      return false;
+    }
+    CodepointRanges result;
+    while (true) {
+      if (AtEnd()) {
+        return false;
+      }
+      if (Peek() == ']') {
+        ++pos_;
+        break;
+      }
+      CodepointRanges element;
+      if (!ParseClassElement(&element)) {
+        return false;
+      }
+      const bool single_codepoint =
+          element.size() == 1 && element[0].first == element[0].second;
+      if (single_codepoint && Peek() == '-' && Peek(1) != ']' &&
+          Peek(1) != -1) {
+        ++pos_;  // '-'
+        CodepointRanges range_end;
+        if (!ParseClassElement(&range_end) || range_end.size() != 1 ||
+            range_end[0].first != range_end[0].second ||
+            range_end[0].first < element[0].first) {
+          return false;
+        }
+        element[0].second = range_end[0].first;
+      }
+      result.insert(result.end(), element.begin(), element.end());
+    }
+    *ranges = negated ? ComplementRanges(result) : NormalizeRanges(result);
+    return true;
+  }
+
+  std::vector<char32> codepoints_;
+  int pos_ = 0;
+};
+
+struct NfaState {
+  // Codepoints on which the state transitions to 'next'.
+  CodepointRanges ranges;
+  int next = -1;
+  std::vector<int> epsilons;
+};
+
+// Thompson construction of an NFA from the parsed patterns.
+class NfaBuilder {
+ public:
+  std::vector<NfaState>* states() { return &states_; }
+
+  // Compiles 'node' to a fragment of the NFA. Returns false if the NFA gets
+  // too large.
+  bool Compile(const RegexNode& node, int* start, int* end) {
+    switch (node.type) {
+      case RegexNode::SET:
+        if (!AddState(start) || !AddState(end)) {
+          return false;
+        }
+        states_[*start].ranges = node.set;
+        states_[*start].next = *end;
+        return true;
+      case RegexNode::CONCAT: {
+        if (!AddState(start)) {
+          return false;
+        }
+        *end = *start;
+        for (const auto& child : node.children) {
+          int child_start, child_end;
+          if (!Compile(*child, &child_start, &child_end)) {
+            return false;
+          }
+          states_[*end].epsilons.push_back(child_start);
+          *end = child_end;
+        }
+        return true;
+      }
+      case RegexNode::ALTERNATE:
+        if (!AddState(start) || !AddState(end)) {
+          return false;
+        }
+        for (const auto& child : node.children) {
+          int child_start, child_end;
+          if (!Compile(*child, &child_start, &child_end)) {
+            return false;
+          }
+          states_[*start].epsilons.push_back(child_start);
+          states_[child_end].epsilons.push_back(*end);
+        }
+        return true;
+      case RegexNode::REPEAT:
+        return CompileRepeat(node, start, end);
+    }
+    return false;
+  }
+
+ private:
+  bool AddState(int* state) {
+    if (states_.size() >= kMaxNfaStates) {
+      return false;
+    }
+    *state = states_.size();
+    states_.emplace_back();
+    return true;
+  }
+
+  bool CompileRepeat(const RegexNode& node, int* start, int* end) {
+    if (!AddState(start)) {
+      return false;
+    }
+    *end = *start;
+    const RegexNode& child = *node.children[0];
+    int child_start, child_end;
+    for (int i = 0; i < node.min_repetitions; ++i) {
+      if (!Compile(child, &child_start, &child_end)) {
+        return false;
+      }
+      states_[*end].epsilons.push_back(child_start);
+      *end = child_end;
+    }
+    if (node.max_repetitions < 0) {
+      int loop;
+      if (!AddState(&loop) || !Compile(child, &child_start, &child_end)) {
+        return false;
+      }
+      states_[*end].epsilons.push_back(loop);
+      states_[loop].epsilons.push_back(child_start);
+      states_[child_end].epsilons.push_back(loop);
+      *end = loop;
+      return true;
+    }
+    for (int i = node.min_repetitions; i < node.max_repetitions; ++i) {
+      int next_end;
+      if (!Compile(child, &child_start, &child_end) || !AddState(&next_end)) {
+        return false;
+      }
+      states_[*end].epsilons.push_back(child_start);
+      states_[*end].epsilons.push_back(next_end);
+      states_[child_end].epsilons.push_back(next_end);
+      *end = next_end;
+    }
+    return true;
+  }
+
+  std::vector<NfaState> states_;
+};
+
+// Extends 'states' with the states reachable by epsilon transitions, and
+// sorts it.
+void EpsilonClosure(const std::vector<NfaState>& nfa,
+                    std::vector<int>* states) {
+  std::vector<bool> visited(nfa.size(), false);
+  std::vector<int> stack(*states);
+  states->clear();
+  while (!stack.empty()) {
+    const int state = stack.back();
+    stack.pop_back();
+    if (visited[state]) {
+      continue;
+    }
+    visited[state] = true;
+    states->push_back(state);
+    for (const int next : nfa[state].epsilons) {
+      stack.push_back(next);
+    }
+  }
+  std::sort(states->begin(), states->end());
+}
+
+// The compiled tables of a RegexDfaSet.
+struct DfaTables {
+  std::vector<char32> class_starts;
+  std::vector<int> transitions;
+  std::vector<uint64> accepting_patterns;
+};
+
+// Compiles the given patterns, indexed by their pattern index, into a DFA.
+// Returns false if the DFA gets too large.
+bool BuildDfa(const std::vector<std::pair<int, const RegexNode*>>& patterns,
+              DfaTables* tables) {
+  NfaBuilder builder;
+  std::vector<int> start_states;
+  std::map<int, uint64> accepting_states;
+  for (const auto& pattern : patterns) {
+    int start, end;
+    if (!builder.Compile(*pattern.second, &start, &end)) {
+      return false;
+    }
+    start_states.push_back(start);
+    accepting_states[end] |= 1ULL << pattern.first;
+  }
+  const std::vector<NfaState>& nfa = *builder.states();
+
+  // Partition the codepoints into classes the patterns don't distinguish.
+  tables->class_starts = {0};
+  for (const NfaState& state : nfa) {
+    for (const auto& range : state.ranges) {
+      tables->class_starts.push_back(range.first);
+      if (range.second < kMaxCodepoint) {
+        tables->class_starts.push_back(range.second + 1);
+      }
+    }
+  }
+  std::sort(tables->class_starts.begin(), tables->class_starts.end());
+  tables->class_starts.erase(
+      std::unique(tables->class_starts.begin(), tables->class_starts.end()),
+      tables->class_starts.end());
+  const int num_classes = tables->class_starts.size();
+
+  // Subset construction.
+  std::map<std::vector<int>, int> dfa_state_ids;
+  std::vector<std::vector<int>> dfa_states;
+  EpsilonClosure(nfa, &start_states);
+  dfa_state_ids[start_states] = 0;
+  dfa_states.push_back(start_states);
+  tables->transitions.clear();
+  tables->accepting_patterns.clear();
+  for (int id = 0; id < dfa_states.size(); ++id) {
+    uint64 accepting = 0;
+    for (const int state : dfa_states[id]) {
+      const auto it = accepting_states.find(state);
+      if (it != accepting_states.end()) {
+        accepting |= it->second;
+      }
+    }
+    tables->accepting_patterns.push_back(accepting);
+
+    for (int c = 0; c < num_classes; ++c) {
+      std::vector<int> next_states;
+      for (const int state : dfa_states[id]) {
+        if (RangesContain(nfa[state].ranges, tables->class_starts[c])) {
+          next_states.push_back(nfa[state].next);
+        }
+      }
+      if (next_states.empty()) {
+        tables->transitions.push_back(-1);
+        continue;
+      }
+      EpsilonClosure(nfa, &next_states);
+      const auto it = dfa_state_ids.find(next_states);
+      if (it != dfa_state_ids.end()) {
+        tables->transitions.push_back(it->second);
+        continue;
+      }
+      if (dfa_states.size() >= kMaxDfaStates) {
+        return false;
+      }
+      const int next_id = dfa_states.size();
+      dfa_state_ids[next_states] = next_id;
+      dfa_states.push_back(std::move(next_states));
+      tables->transitions.push_back(next_id);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+RegexDfaSet::RegexDfaSet(const std::vector<std::string>& patterns) {
+  std::vector<std::unique_ptr<RegexNode>> parsed_patterns;
+  std::vector<std::pair<int, const RegexNode*>> supported;
+  DfaTables tables;
+  for (int i = 0; i < patterns.size() && i < kMaxPatterns; ++i) {
+    parsed_patterns.push_back(RegexParser(patterns[i]).Parse());
+    if (parsed_patterns.back() == nullptr) {
+      TC3_VLOG(1) << "Regex not supported by the DFA: " << patterns[i];
+      continue;
+    }
+
+    // Add the patterns one by one, so that a pattern that makes the DFA too
+    // large is left out.
+    supported.push_back({i, parsed_patterns.back().get()});
+    DfaTables candidate_tables;
+    if (!BuildDfa(supported, &candidate_tables)) {
+      TC3_VLOG(1) << "Regex too large for the DFA: " << patterns[i];
+      supported.pop_back();
+      continue;
+    }
+    tables = std::move(candidate_tables);
+    supported_patterns_ |= 1ULL << i;
+  }
+  if (supported.empty()) {
+    return;
+  }
+
+  class_starts_ = std::move(tables.class_starts);
+  transitions_ = std::move(tables.transitions);
+  accepting_patterns_ = std::move(tables.accepting_patterns);
+  ascii_classes_.resize(128);
+  int ascii_class = 0;
+  for (int codepoint = 0; codepoint < 128; ++codepoint) {
+    while (ascii_class + 1 < class_starts_.size() &&
+           class_starts_[ascii_class + 1] <= codepoint) {
+      ++ascii_class;
+    }
+    ascii_classes_[codepoint] = ascii_class;
+  }
+}
+
+int RegexDfaSet::CodepointClass(char32 codepoint) const {
+  if (codepoint >= 0 && codepoint < 128) {
+    return ascii_classes_[codepoint];
+  }
+  if (codepoint < 0) {
+    return 0;
+  }
+  return std::upper_bound(class_starts_.begin(), class_starts_.end(),
+                          codepoint) -
+         class_starts_.begin() - 1;
+}
+
+uint64 RegexDfaSet::FullMatch(const UnicodeText& text) const {
+  if (supported_patterns_ == 0) {
+    return 0;
+  }
+  const int num_classes = class_starts_.size();
+  int state = 0;
+  for (const char32 codepoint : text) {
+    state = transitions_[state * num_classes + CodepointClass(codepoint)];
+    if (state < 0) {
+      return 0;
+    }
+  }
+  return accepting_patterns_[state];
+}
+
+}  // namespace libtextclassifier3
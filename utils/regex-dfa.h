@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBTEXTCLASSIFIER_UTILS_REGEX_DFA_H_
+#define LIBTEXTCLASSIFIER_UTILS_REGEX_DFA_H_
+
+#include <string>
+#include <vector>
+
+#include "utils/base/integral_types.h"
+#include "utils/utf8/unicodetext.h"
+
+namespace libtextclassifier3 {
+
+// A set of regular expressions compiled into a single native DFA, that full
+// matches a short text (e.g. a token) against all the expressions in one pass
+// over its codepoints.
+//
+// Only a subset of the Java regular expression syntax is supported: literals,
+// escaped punctuation, '.', character classes with ranges and negation,
+// groups, alternation, the quantifiers * + ? {n} {n,} {n,m} and '^'/'$' at the
+// start/end of the expression. Expressions using anything else (or too large
+// to be compiled) are not supported and need to be matched by other means, see
+// IsSupported(). This includes \d \w \s and their negations, which UniLib
+// matches on Unicode properties. The expressions match as with the ICU-backed
+// regexes of Android.
+class RegexDfaSet {
+ public:
+  // Maximum number of patterns in a set.
+  static constexpr int kMaxPatterns = 64;
+
+  RegexDfaSet() = default;
+  explicit RegexDfaSet(const std::vector<std::string>& patterns);
+
+  // Returns whether the pattern at 'pattern_index' is compiled in the DFA.
+  bool IsSupported(int pattern_index) const {
+    return pattern_index < kMaxPatterns &&
+           (supported_patterns_ & (1ULL << pattern_index)) != 0;
+  }
+
+  // Returns a bit mask with the bit i set if the supported pattern i matches
+  // the whole 'text'.
+  uint64 FullMatch(const UnicodeText& text) const;
+
+ private:
+  // Returns the index of the alphabet class of 'codepoint'.
+  int CodepointClass(char32 codepoint) const;
+
+  // Bit mask of the supported patterns.
+  uint64 supported_patterns_ = 0;
+
+  // Start codepoints of the alphabet classes: the codepoints are partitioned
+  // into ranges that the patterns don't distinguish between.
+  std::vector<char32> class_starts_;
+
+  // Alphabet classes of the ASCII codepoints.
+  std::vector<int> ascii_classes_;
+
+  // Transitions from a state on an alphabet class, indexed by
+  // state * num_classes + class. -1 denotes the dead state. The start state is
+  // 0.
+  std::vector<int> transitions_;
+
+  // Bit masks of the patterns that accept in each state.
+  std::vector<uint64> accepting_patterns_;
+};
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_UTILS_REGEX_DFA_H_
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/regex-dfa.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+bool Matches(const RegexDfaSet& dfa, int pattern_index,
+             const std::string& text) {
+  return (dfa.FullMatch(UTF8ToUnicodeText(text, /*do_copy=*/false)) &
+          (1ULL << pattern_index)) != 0;
+}
+
+TEST(RegexDfaSetTest, MatchesTokenShapes) {
+  const RegexDfaSet dfa(
+      {"^[a-z]+$", "^[0-9]+$", "[A-Z][a-z]*", "[0-9]{2,4}-[0-9][0-9]",
+       "(ab|c)+"});
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(dfa.IsSupported(i));
+  }
+
+  EXPECT_TRUE(Matches(dfa, 0, "abcde"));
+  EXPECT_FALSE(Matches(dfa, 0, "abCde"));
+  EXPECT_FALSE(Matches(dfa, 0, ""));
+  EXPECT_TRUE(Matches(dfa, 1, "12345"));
+  EXPECT_FALSE(Matches(dfa, 1, "12c45"));
+  EXPECT_TRUE(Matches(dfa, 2, "Hello"));
+  EXPECT_TRUE(Matches(dfa, 2, "H"));
+  EXPECT_FALSE(Matches(dfa, 2, "hello"));
+  EXPECT_TRUE(Matches(dfa, 3, "12-34"));
+  EXPECT_TRUE(Matches(dfa, 3, "1234-56"));
+  EXPECT_FALSE(Matches(dfa, 3, "12345-67"));
+  EXPECT_FALSE(Matches(dfa, 3, "1-23"));
+  EXPECT_TRUE(Matches(dfa, 4, "abcab"));
+  EXPECT_FALSE(Matches(dfa, 4, "abca"));
+
+  // All patterns are matched in one pass.
+  EXPECT_EQ(dfa.FullMatch(UTF8ToUnicodeText("123", /*do_copy=*/false)),
+            1ULL << 1);
+}
+
+TEST(RegexDfaSetTest, MatchesClassesAndEscapes) {
+  const RegexDfaSet dfa({"[^a-z]+", "[a-z_0-9]+\\.[a-z_0-9]+", "[a\\-z]",
+                         "[^\\t ]+[\\t ][^\\t ]+", ".*", "[ěščř]+"});
+  EXPECT_TRUE(Matches(dfa, 0, "ABC123"));
+  EXPECT_TRUE(Matches(dfa, 0, "ŘÁ"));
+  EXPECT_FALSE(Matches(dfa, 0, "ABc"));
+  EXPECT_TRUE(Matches(dfa, 1, "foo.bar_1"));
+  EXPECT_FALSE(Matches(dfa, 1, "foo-bar"));
+  EXPECT_TRUE(Matches(dfa, 2, "-"));
+  EXPECT_FALSE(Matches(dfa, 2, "b"));
+  EXPECT_TRUE(Matches(dfa, 3, "a\tb"));
+  EXPECT_TRUE(Matches(dfa, 4, "anything ř"));
+  EXPECT_FALSE(Matches(dfa, 4, "line\nbreak"));
+  EXPECT_FALSE(Matches(dfa, 4, "vertical\vtab"));
+  EXPECT_FALSE(Matches(dfa, 4, "line\u2028separator"));
+  EXPECT_TRUE(Matches(dfa, 5, "ščř"));
+  EXPECT_FALSE(Matches(dfa, 5, "sc"));
+}
+
+TEST(RegexDfaSetTest, ReportsUnsupportedPatterns) {
+  const RegexDfaSet dfa({"(?i)abc", "a(?=b)", "\\p{Lu}+", "a++", "\\bfoo",
+                         "a^b", "[a-z&&[^x]]", "(a", "[0-9]+"});
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_FALSE(dfa.IsSupported(i)) << i;
+  }
+  EXPECT_TRUE(dfa.IsSupported(8));
+  EXPECT_TRUE(Matches(dfa, 8, "42"));
+  EXPECT_FALSE(Matches(dfa, 0, "abc"));
+}
+
+TEST(RegexDfaSetTest, LeavesUnicodeClassesToUniLib) {
+  const RegexDfaSet dfa({"\\d+", "\\w+", "\\s", "\\D", "\\W", "\\S",
+                         "[\\d.]+", "a[^\\s]"});
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_FALSE(dfa.IsSupported(i)) << i;
+  }
+}
+
+TEST(RegexDfaSetTest, EmptySetMatchesNothing) {
+  const RegexDfaSet dfa;
+  EXPECT_FALSE(dfa.IsSupported(0));
+  EXPECT_EQ(dfa.FullMatch(UTF8ToUnicodeText("abc", /*do_copy=*/false)), 0);
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -16,6 +16,7 @@
 
 #include "utils/regex-match.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "annotator/types.h"
@@ -31,59 +32,87 @@ extern "C" {
 #endif
 
 namespace libtextclassifier3 {
-namespace {
 
 // Provide a lua environment for running regex match post verification.
 // It sets up and exposes the match data as well as the context.
+// The verifier snippet is loaded once, so that the environment can be reused
+// to verify several matches.
 class LuaVerifier : private LuaEnvironment {
  public:
-  static std::unique_ptr<LuaVerifier> Create(
-      const std::string& context, const std::string& verifier_code,
-      const UniLib::RegexMatcher* matcher);
+  // Creates a verifier from the lua snippet, either source or precompiled
+  // bytecode.
+  static std::unique_ptr<LuaVerifier> Create(const std::string& verifier_code);
 
-  bool Verify(bool* result);
+  // Sets the context of the matches that are verified next. The context is
+  // copied to lua at most once until it is set again.
+  void SetContext(StringPiece context);
+
+  bool Verify(const UniLib::RegexMatcher* matcher, bool* result);
 
  private:
-  explicit LuaVerifier(const std::string& context,
-                       const std::string& verifier_code,
-                       const UniLib::RegexMatcher* matcher)
-      : context_(context), verifier_code_(verifier_code), matcher_(matcher) {}
-  bool Initialize();
+  LuaVerifier() = default;
+  bool Initialize(const std::string& verifier_code);
 
   // Provides details of a capturing group to lua.
   int GetCapturingGroup();
 
-  const std::string& context_;
-  const std::string& verifier_code_;
-  const UniLib::RegexMatcher* matcher_;
+  // Provides the globals that are set per verification to lua.
+  int GetGlobal();
+
+  // Reads the verification result from the lua stack.
+  int ReadResult(bool* result);
+
+  // The context and matcher of the match that is currently being verified.
+  StringPiece context_;
+  const UniLib::RegexMatcher* matcher_ = nullptr;
+
+  // Registry reference to the context as lua string, once a verifier read it.
+  int context_ref_ = LUA_NOREF;
+
+  // Registry reference to the loaded verifier snippet.
+  int verifier_ = LUA_NOREF;
 };
 
-bool LuaVerifier::Initialize() {
+bool LuaVerifier::Initialize(const std::string& verifier_code) {
   // Run protected to not lua panic in case of setup failure.
-  return RunProtected([this] {
-           LoadDefaultLibraries();
+  if (RunProtected([this] {
+        LoadDefaultLibraries();
+
+        // Expose context of the match as `context` global variable. It is
+        // provided lazily by a metatable on the globals, so that the context
+        // only gets copied to lua if the verifier actually reads it.
+        lua_pushglobaltable(state_);
+        lua_newtable(state_);
+        Bind<LuaVerifier, &LuaVerifier::GetGlobal>();
+        lua_setfield(state_, -2, kIndexKey);
+        lua_setmetatable(state_, -2);
+        lua_pop(state_, 1);
 
-           // Expose context of the match as `context` global variable.
-           PushString(context_);
-           lua_setglobal(state_, "context");
+        // Expose match array as `match` global variable.
+        // Each entry `match[i]` exposes the ith capturing group as:
+        //   * `begin`: span start
+        //   * `end`: span end
+        //   * `text`: the text
+        BindTable<LuaVerifier, &LuaVerifier::GetCapturingGroup>("match");
+        lua_setglobal(state_, "match");
+        return LUA_OK;
+      }) != LUA_OK) {
+    return false;
+  }
 
-           // Expose match array as `match` global variable.
-           // Each entry `match[i]` exposes the ith capturing group as:
-           //   * `begin`: span start
-           //   * `end`: span end
-           //   * `text`: the text
-           BindTable<LuaVerifier, &LuaVerifier::GetCapturingGroup>("match");
-           lua_setglobal(state_, "match");
-           return LUA_OK;
-         }) == LUA_OK;
+  if (luaL_loadbuffer(state_, verifier_code.data(), verifier_code.size(),
+                      /*name=*/nullptr) != LUA_OK) {
+    TC3_LOG(ERROR) << "Could not load verifier snippet.";
+    return false;
+  }
+  verifier_ = luaL_ref(state_, LUA_REGISTRYINDEX);
+  return verifier_ != LUA_REFNIL && verifier_ != LUA_NOREF;
 }
 
 std::unique_ptr<LuaVerifier> LuaVerifier::Create(
-    const std::string& context, const std::string& verifier_code,
-    const UniLib::RegexMatcher* matcher) {
-  auto verifier = std::unique_ptr<LuaVerifier>(
-      new LuaVerifier(context, verifier_code, matcher));
-  if (!verifier->Initialize()) {
+    const std::string& verifier_code) {
+  auto verifier = std::unique_ptr<LuaVerifier>(new LuaVerifier());
+  if (!verifier->Initialize(verifier_code)) {
     TC3_LOG(ERROR) << "Could not initialize lua environment.";
     return nullptr;
   }
@@ -97,6 +126,11 @@ int LuaVerifier::GetCapturingGroup() {
     lua_error(state_);
     return 0;
   }
+  if (matcher_ == nullptr) {
+    TC3_LOG(ERROR) << "No match to look up the group in.";
+    lua_error(state_);
+    return 0;
+  }
   const int group_id = static_cast<int>(lua_tonumber(state_, /*idx=*/-1));
   int status = UniLib::RegexMatcher::kNoError;
   const CodepointSpan span = {matcher_->Start(group_id, &status),
@@ -117,38 +151,63 @@ int LuaVerifier::GetCapturingGroup() {
   return 1;
 }
 
-bool LuaVerifier::Verify(bool* result) {
-  if (luaL_loadbuffer(state_, verifier_code_.data(), verifier_code_.size(),
-                      /*name=*/nullptr) != LUA_OK) {
-    TC3_LOG(ERROR) << "Could not load verifier snippet.";
-    return false;
+int LuaVerifier::GetGlobal() {
+  if (lua_type(state_, /*idx=*/-1) == LUA_TSTRING &&
+      ReadString(/*index=*/-1).Equals("context")) {
+    if (context_ref_ == LUA_NOREF) {
+      PushString(context_);
+      lua_pushvalue(state_, /*idx=*/-1);
+      context_ref_ = luaL_ref(state_, LUA_REGISTRYINDEX);
+    } else {
+      lua_rawgeti(state_, LUA_REGISTRYINDEX, context_ref_);
+    }
+  } else {
+    lua_pushnil(state_);
+  }
+  return 1;
+}
+
+int LuaVerifier::ReadResult(bool* result) {
+  if (lua_type(state_, /*idx=*/-1) != LUA_TBOOLEAN) {
+    TC3_LOG(ERROR) << "Unexpected verification result type: "
+                   << lua_type(state_, /*idx=*/-1);
+    lua_error(state_);
+    return LUA_ERRRUN;
+  }
+  *result = lua_toboolean(state_, /*idx=*/-1);
+  return LUA_OK;
+}
+
+void LuaVerifier::SetContext(StringPiece context) {
+  if (context_ref_ != LUA_NOREF) {
+    luaL_unref(state_, LUA_REGISTRYINDEX, context_ref_);
+    context_ref_ = LUA_NOREF;
   }
+  context_ = context;
+}
+
+bool LuaVerifier::Verify(const UniLib::RegexMatcher* matcher, bool* result) {
+  matcher_ = matcher;
 
+  lua_rawgeti(state_, LUA_REGISTRYINDEX, verifier_);
   if (lua_pcall(state_, /*nargs=*/0, /*nresults=*/1, /*errfunc=*/0) != LUA_OK) {
     TC3_LOG(ERROR) << "Could not run verifier snippet.";
+    lua_pop(state_, 1);
+    matcher_ = nullptr;
     return false;
   }
 
-  if (RunProtected(
-          [this, result] {
-            if (lua_type(state_, /*idx=*/-1) != LUA_TBOOLEAN) {
-              TC3_LOG(ERROR) << "Unexpected verification result type: "
-                             << lua_type(state_, /*idx=*/-1);
-              lua_error(state_);
-              return LUA_ERRRUN;
-            }
-            *result = lua_toboolean(state_, /*idx=*/-1);
-            return LUA_OK;
-          },
-          /*num_args=*/1) != LUA_OK) {
+  const bool success =
+      RunProtected([this, result] { return ReadResult(result); },
+                   /*num_args=*/1) == LUA_OK;
+  if (!success) {
     TC3_LOG(ERROR) << "Could not read lua result.";
-    return false;
+    lua_pop(state_, 1);
   }
-  return true;
+  matcher_ = nullptr;
+  return success;
 }
 
-}  // namespace
-
 bool SetFieldFromCapturingGroup(const int group_id,
                                 const FlatbufferFieldPath* field_path,
                                 const UniLib::RegexMatcher* matcher,
@@ -165,16 +224,90 @@ bool VerifyMatch(const std::string& context,
                  const UniLib::RegexMatcher* matcher,
                  const std::string& lua_verifier_code) {
   bool status = false;
-  auto verifier = LuaVerifier::Create(context, lua_verifier_code, matcher);
+  auto verifier = LuaVerifier::Create(lua_verifier_code);
   if (verifier == nullptr) {
     TC3_LOG(ERROR) << "Could not create verifier.";
     return false;
   }
-  if (!verifier->Verify(&status)) {
+  verifier->SetContext(context);
+  if (!verifier->Verify(matcher, &status)) {
     TC3_LOG(ERROR) << "Could not create verifier.";
     return false;
   }
   return status;
 }
 
+std::unique_ptr<CompiledLuaVerifier> CompiledLuaVerifier::Create(
+    const std::string& lua_verifier_code) {
+  std::string bytecode;
+  if (!Compile(lua_verifier_code, &bytecode)) {
+    TC3_LOG(ERROR) << "Could not precompile lua verifier.";
+    return nullptr;
+  }
+  return std::unique_ptr<CompiledLuaVerifier>(
+      new CompiledLuaVerifier(bytecode));
+}
+
+CompiledLuaVerifier::CompiledLuaVerifier(const std::string& bytecode)
+    : bytecode_(bytecode) {}
+
+CompiledLuaVerifier::~CompiledLuaVerifier() = default;
+
+std::unique_ptr<LuaVerifier> CompiledLuaVerifier::AcquireVerifier() const {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!verifiers_.empty()) {
+      std::unique_ptr<LuaVerifier> verifier = std::move(verifiers_.back());
+      verifiers_.pop_back();
+      return verifier;
+    }
+  }
+  return LuaVerifier::Create(bytecode_);
+}
+
+void CompiledLuaVerifier::ReleaseVerifier(
+    std::unique_ptr<LuaVerifier> verifier) const {
+  // Don't keep the context of the last request alive in the pool.
+  verifier->SetContext(StringPiece());
+  std::lock_guard<std::mutex> lock(mutex_);
+  verifiers_.push_back(std::move(verifier));
+}
+
+bool CompiledLuaVerifier::Verify(StringPiece context,
+                                 const UniLib::RegexMatcher* matcher) const {
+  ScopedLuaVerifiers verifiers(context);
+  return verifiers.Verify(*this, matcher);
+}
+
+ScopedLuaVerifiers::~ScopedLuaVerifiers() {
+  for (BorrowedVerifier& borrowed : verifiers_) {
+    borrowed.owner->ReleaseVerifier(std::move(borrowed.verifier));
+  }
+}
+
+bool ScopedLuaVerifiers::Verify(const CompiledLuaVerifier& verifier,
+                                const UniLib::RegexMatcher* matcher) {
+  auto it = std::find_if(verifiers_.begin(), verifiers_.end(),
+                         [&verifier](const BorrowedVerifier& borrowed) {
+                           return borrowed.owner == &verifier;
+                         });
+  if (it == verifiers_.end()) {
+    std::unique_ptr<LuaVerifier> lua_verifier = verifier.AcquireVerifier();
+    if (lua_verifier == nullptr) {
+      TC3_LOG(ERROR) << "Could not create verifier.";
+      return false;
+    }
+    lua_verifier->SetContext(context_);
+    verifiers_.push_back({&verifier, std::move(lua_verifier)});
+    it = verifiers_.end() - 1;
+  }
+  bool status = false;
+  if (!it->verifier->Verify(matcher, &status)) {
+    // Don't return a lua state in an unknown state to the pool.
+    verifiers_.erase(it);
+    return false;
+  }
+  return status;
+}
+
 }  // namespace libtextclassifier3
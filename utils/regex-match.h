@@ -17,11 +17,20 @@
 #ifndef LIBTEXTCLASSIFIER_UTILS_REGEX_MATCH_H_
 #define LIBTEXTCLASSIFIER_UTILS_REGEX_MATCH_H_
 
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
 #include "utils/flatbuffers.h"
 #include "utils/flatbuffers_generated.h"
+#include "utils/strings/stringpiece.h"
 #include "utils/utf8/unilib.h"
 
 namespace libtextclassifier3 {
+
+class LuaVerifier;
+
 // Sets a field in the flatbuffer from a regex match group.
 // Returns true if successful, and false if the field couldn't be set.
 bool SetFieldFromCapturingGroup(const int group_id,
@@ -43,6 +52,68 @@ bool VerifyMatch(const std::string& context,
                  const UniLib::RegexMatcher* matcher,
                  const std::string& lua_verifier_code);
 
+// A lua verifier that is compiled to bytecode once and keeps a pool of lua
+// states with the verifier already loaded. Verifying a match then only costs
+// binding the match data and a protected call of the loaded verifier.
+// Thread-safe: every concurrent caller borrows its own lua state from the
+// pool, so the pool grows to the number of threads verifying at once.
+class CompiledLuaVerifier {
+ public:
+  // Precompiles the verifier snippet. Returns nullptr if the snippet could not
+  // be compiled.
+  static std::unique_ptr<CompiledLuaVerifier> Create(
+      const std::string& lua_verifier_code);
+
+  ~CompiledLuaVerifier();
+
+  // Same semantics as VerifyMatch above. The context is only copied to lua
+  // if the verifier reads it. Use ScopedLuaVerifiers to verify several matches
+  // in the same context.
+  bool Verify(StringPiece context, const UniLib::RegexMatcher* matcher) const;
+
+ private:
+  friend class ScopedLuaVerifiers;
+
+  explicit CompiledLuaVerifier(const std::string& bytecode);
+
+  // Takes a verifier from the pool, or creates a new one if the pool is empty.
+  std::unique_ptr<LuaVerifier> AcquireVerifier() const;
+
+  // Returns a verifier to the pool.
+  void ReleaseVerifier(std::unique_ptr<LuaVerifier> verifier) const;
+
+  const std::string bytecode_;
+  mutable std::mutex mutex_;
+  mutable std::vector<std::unique_ptr<LuaVerifier>> verifiers_;
+};
+
+// Verifies the matches found in one context, e.g. during one annotation
+// request. Keeps the lua states it borrows from the compiled verifiers until
+// it is destroyed, so that the context is copied to each lua state at most
+// once, however many matches read it.
+// Not thread-safe.
+class ScopedLuaVerifiers {
+ public:
+  explicit ScopedLuaVerifiers(StringPiece context) : context_(context) {}
+
+  // Returns the borrowed lua states to the pools of their verifiers.
+  ~ScopedLuaVerifiers();
+
+  // Verifies a match in the context with the given verifier, with the same
+  // semantics as CompiledLuaVerifier::Verify.
+  bool Verify(const CompiledLuaVerifier& verifier,
+              const UniLib::RegexMatcher* matcher);
+
+ private:
+  struct BorrowedVerifier {
+    const CompiledLuaVerifier* owner;
+    std::unique_ptr<LuaVerifier> verifier;
+  };
+
+  const StringPiece context_;
+  std::vector<BorrowedVerifier> verifiers_;
+};
+
 }  // namespace libtextclassifier3
 
 #endif  // LIBTEXTCLASSIFIER_UTILS_REGEX_MATCH_H_
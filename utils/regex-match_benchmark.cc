@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks verification of many candidate regex matches with a lua
+// verifier, comparing per-match verifier creation with the precompiled,
+// pooled verifier.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "utils/regex-match.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// A luhn checksum verifier as used by the payment card regex patterns. It
+// checks the digits of the context, as the benchmark runs without matches.
+constexpr char kLuhnVerifier[] = R"(
+function luhn(candidate)
+    local sum = 0
+    local num_digits = string.len(candidate)
+    local parity = num_digits % 2
+    for pos = 1,num_digits do
+      d = tonumber(string.sub(candidate, pos, pos))
+      if pos % 2 ~= parity then
+        d = d * 2
+      end
+      if d > 9 then
+        d = d - 9
+      end
+      sum = sum + d
+    end
+    return (sum % 10) == 0
+end
+return luhn(context);
+)";
+
+// Builds candidate matches: card number like digit sequences.
+std::vector<std::string> CandidateMatches(const int num_candidates) {
+  std::vector<std::string> candidates;
+  candidates.reserve(num_candidates);
+  for (int i = 0; i < num_candidates; i++) {
+    candidates.push_back(std::to_string(4012888888881881LL + i));
+  }
+  return candidates;
+}
+
+void BM_VerifyMatch(benchmark::State& state) {
+  const std::vector<std::string> candidates = CandidateMatches(state.range(0));
+  for (auto _ : state) {
+    for (const std::string& candidate : candidates) {
+      benchmark::DoNotOptimize(
+          VerifyMatch(candidate, /*matcher=*/nullptr, kLuhnVerifier));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * candidates.size());
+}
+BENCHMARK(BM_VerifyMatch)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_CompiledLuaVerifier(benchmark::State& state) {
+  const std::vector<std::string> candidates = CandidateMatches(state.range(0));
+  std::unique_ptr<CompiledLuaVerifier> verifier =
+      CompiledLuaVerifier::Create(kLuhnVerifier);
+  for (auto _ : state) {
+    for (const std::string& candidate : candidates) {
+      benchmark::DoNotOptimize(
+          verifier->Verify(candidate, /*matcher=*/nullptr));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * candidates.size());
+}
+BENCHMARK(BM_CompiledLuaVerifier)->Arg(10)->Arg(100)->Arg(1000)->ThreadRange(
+    1, 8);
+
+// Verifies many matches in a large document with a verifier that does not read
+// the context, so the per-match cost should not depend on the document size.
+void BM_CompiledLuaVerifierLargeContext(benchmark::State& state) {
+  const std::string context(state.range(0), '4');
+  std::unique_ptr<CompiledLuaVerifier> verifier =
+      CompiledLuaVerifier::Create("return true;");
+  constexpr int kNumMatches = 1000;
+  for (auto _ : state) {
+    for (int i = 0; i < kNumMatches; i++) {
+      benchmark::DoNotOptimize(verifier->Verify(context, /*matcher=*/nullptr));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumMatches);
+}
+BENCHMARK(BM_CompiledLuaVerifierLargeContext)->Arg(1 << 10)->Arg(1 << 20);
+
+// Verifies many matches in a large document with a verifier that reads the
+// context. The context is copied to lua once for all the matches.
+void BM_ScopedLuaVerifiersReadingLargeContext(benchmark::State& state) {
+  const std::string context(state.range(0), '4');
+  std::unique_ptr<CompiledLuaVerifier> verifier =
+      CompiledLuaVerifier::Create("return string.len(context) > 0;");
+  constexpr int kNumMatches = 1000;
+  for (auto _ : state) {
+    ScopedLuaVerifiers verifiers(context);
+    for (int i = 0; i < kNumMatches; i++) {
+      benchmark::DoNotOptimize(
+          verifiers.Verify(*verifier, /*matcher=*/nullptr));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumMatches);
+}
+BENCHMARK(BM_ScopedLuaVerifiersReadingLargeContext)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20);
+
+}  // namespace
+}  // namespace libtextclassifier3
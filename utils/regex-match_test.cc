@@ -70,7 +70,82 @@ return luhn(match[1].text);
 
   EXPECT_TRUE(VerifyMatch(message.ToUTF8String(), matcher.get(), verifier));
 }
+
+TEST_F(LuaVerifierTest, HandlesCompiledVerification) {
+  UnicodeText pattern = UTF8ToUnicodeText("(\\d+)",
+                                          /*do_copy=*/true);
+  UnicodeText message = UTF8ToUnicodeText("1 22 333 4444",
+                                          /*do_copy=*/true);
+  const std::string verifier = R"(
+return string.len(match[1].text) % 2 == 0;
+  )";
+  std::unique_ptr<CompiledLuaVerifier> compiled_verifier =
+      CompiledLuaVerifier::Create(verifier);
+  ASSERT_TRUE(compiled_verifier != nullptr);
+  auto regex_pattern = unilib_.CreateRegexPattern(pattern);
+  ASSERT_TRUE(regex_pattern != nullptr);
+  auto matcher = regex_pattern->Matcher(message);
+  ASSERT_TRUE(matcher != nullptr);
+
+  // The same compiled verifier is reused for all matches.
+  std::vector<bool> verified;
+  int status = UniLib::RegexMatcher::kNoError;
+  while (matcher->Find(&status) && status == UniLib::RegexMatcher::kNoError) {
+    verified.push_back(
+        compiled_verifier->Verify(message.ToUTF8String(), matcher.get()));
+  }
+  EXPECT_THAT(verified, testing::ElementsAre(false, true, false, true));
+}
 #endif
 
+TEST_F(LuaVerifierTest, HandlesSimpleCompiledVerification) {
+  std::unique_ptr<CompiledLuaVerifier> compiled_verifier =
+      CompiledLuaVerifier::Create("return context == \"match\";");
+  ASSERT_TRUE(compiled_verifier != nullptr);
+  EXPECT_TRUE(compiled_verifier->Verify(/*context=*/"match",
+                                        /*matcher=*/nullptr));
+  EXPECT_FALSE(compiled_verifier->Verify(/*context=*/"no match",
+                                         /*matcher=*/nullptr));
+  EXPECT_TRUE(compiled_verifier->Verify(/*context=*/"match",
+                                        /*matcher=*/nullptr));
+}
+
+TEST_F(LuaVerifierTest, ScopedVerifiersReadTheContextOfTheirScope) {
+  std::unique_ptr<CompiledLuaVerifier> compiled_verifier =
+      CompiledLuaVerifier::Create(
+          "return context == \"match\" and context == \"match\";");
+  ASSERT_TRUE(compiled_verifier != nullptr);
+  {
+    ScopedLuaVerifiers verifiers(/*context=*/"match");
+    EXPECT_TRUE(verifiers.Verify(*compiled_verifier, /*matcher=*/nullptr));
+    EXPECT_TRUE(verifiers.Verify(*compiled_verifier, /*matcher=*/nullptr));
+  }
+
+  // The pooled lua state is rebound to the context of the new scope.
+  {
+    ScopedLuaVerifiers verifiers(/*context=*/"no match");
+    EXPECT_FALSE(verifiers.Verify(*compiled_verifier, /*matcher=*/nullptr));
+  }
+  EXPECT_TRUE(compiled_verifier->Verify(/*context=*/"match",
+                                        /*matcher=*/nullptr));
+}
+
+TEST_F(LuaVerifierTest, ScopedVerifiersHandleSeveralVerifiers) {
+  std::unique_ptr<CompiledLuaVerifier> short_context =
+      CompiledLuaVerifier::Create("return string.len(context) < 3;");
+  std::unique_ptr<CompiledLuaVerifier> match_context =
+      CompiledLuaVerifier::Create("return context == \"ab\";");
+  ASSERT_TRUE(short_context != nullptr);
+  ASSERT_TRUE(match_context != nullptr);
+  ScopedLuaVerifiers verifiers(/*context=*/"ab");
+  EXPECT_TRUE(verifiers.Verify(*short_context, /*matcher=*/nullptr));
+  EXPECT_TRUE(verifiers.Verify(*match_context, /*matcher=*/nullptr));
+  EXPECT_TRUE(verifiers.Verify(*short_context, /*matcher=*/nullptr));
+}
+
+TEST_F(LuaVerifierTest, FailsOnInvalidVerifierSnippet) {
+  EXPECT_EQ(CompiledLuaVerifier::Create("return ("), nullptr);
+}
+
 }  // namespace
 }  // namespace libtextclassifier3
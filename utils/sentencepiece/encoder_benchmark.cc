@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the sentence piece Encoder with a vocabulary built from the
+// benchmark corpora.
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "utils/sentencepiece/encoder.h"
+#include "utils/sentencepiece/sorted_strings_table.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "utils/testing/benchmark-utils.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Maximum length of the word prefixes added as pieces.
+constexpr int kMaxPrefixLength = 3;
+
+// A vocabulary of the words of the corpora, their short prefixes and the space,
+// with scores favoring longer pieces.
+class BenchmarkVocabulary {
+ public:
+  BenchmarkVocabulary() {
+    std::set<std::string> pieces = {" "};
+    for (int corpus = 0; corpus < kNumBenchmarkCorpora; corpus++) {
+      for (const std::string& message : GenerateBenchmarkMessages(
+               static_cast<BenchmarkCorpus>(corpus), /*num_messages=*/64)) {
+        size_t start = 0;
+        while (start < message.size()) {
+          size_t end = message.find(' ', start);
+          if (end == std::string::npos) {
+            end = message.size();
+          }
+          const std::string word = message.substr(start, end - start);
+          if (!word.empty()) {
+            pieces.insert(word);
+            const int max_prefix_length = std::min(
+                kMaxPrefixLength, static_cast<int>(word.size()) - 1);
+            for (int i = 1; i <= max_prefix_length; i++) {
+              pieces.insert(word.substr(0, i));
+            }
+          }
+          start = end + 1;
+        }
+      }
+    }
+    for (const std::string& piece : pieces) {
+      offsets_.push_back(data_.size());
+      data_.append(piece);
+      data_.push_back('\0');
+      scores_.push_back(-10.0f + piece.size());
+    }
+    matcher_.reset(new SortedStringsTable(offsets_.size(), offsets_.data(),
+                                          StringPiece(data_)));
+    encoder_.reset(new Encoder(matcher_.get(), offsets_.size(),
+                               scores_.data(), /*start_code=*/0,
+                               /*end_code=*/1, /*encoding_offset=*/3,
+                               /*unknown_code=*/2, /*unknown_score=*/-100.0f));
+  }
+
+  const Encoder& encoder() const { return *encoder_; }
+
+ private:
+  std::string data_;
+  std::vector<uint32> offsets_;
+  std::vector<float> scores_;
+  std::unique_ptr<SortedStringsTable> matcher_;
+  std::unique_ptr<Encoder> encoder_;
+};
+
+void BM_Encode(benchmark::State& state) {
+  static const BenchmarkVocabulary* vocabulary = new BenchmarkVocabulary();
+  const std::string text = CorpusTextForBenchmark(state);
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    std::vector<int> encoded_text;
+    vocabulary->encoder().Encode(text, &encoded_text);
+    benchmark::DoNotOptimize(encoded_text);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Encode)
+    ->Apply(CorpusTextArguments)
+    ->ThreadRange(1, 4);
+
+}  // namespace
+}  // namespace libtextclassifier3
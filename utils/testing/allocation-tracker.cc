@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/testing/allocation-tracker.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace libtextclassifier3 {
+namespace {
+
+// Innermost active tracker of the current thread.
+thread_local ScopedAllocationTracker* current_tracker = nullptr;
+
+std::atomic<int64> next_tracker_id(1);
+std::atomic<int64> next_thread_id(1);
+
+int64 CurrentThreadId() {
+  thread_local const int64 thread_id = next_thread_id.fetch_add(1);
+  return thread_id;
+}
+
+// Temporarily disables tracking on the current thread, for the bookkeeping
+// allocations of the trackers themselves.
+class ScopedTrackingPause {
+ public:
+  ScopedTrackingPause() : tracker_(current_tracker) {
+    current_tracker = nullptr;
+  }
+  ~ScopedTrackingPause() { current_tracker = tracker_; }
+
+ private:
+  ScopedAllocationTracker* const tracker_;
+};
+
+}  // namespace
+
+namespace internal {
+
+AllocationTag RecordAllocation(int64 num_bytes) {
+  AllocationTag tag;
+  if (current_tracker == nullptr) {
+    return tag;
+  }
+  tag.thread_id = CurrentThreadId();
+  tag.tracker_id = current_tracker->id_;
+  for (ScopedAllocationTracker* tracker = current_tracker; tracker != nullptr;
+       tracker = tracker->parent_) {
+    tracker->stats_.num_allocations++;
+    tracker->stats_.num_bytes += num_bytes;
+    tracker->live_bytes_ += num_bytes;
+    if (tracker->live_bytes_ > tracker->stats_.peak_bytes) {
+      tracker->stats_.peak_bytes = tracker->live_bytes_;
+    }
+  }
+  return tag;
+}
+
+void RecordDeallocation(int64 num_bytes, const AllocationTag& tag) {
+  if (current_tracker == nullptr || tag.tracker_id == 0 ||
+      tag.thread_id != CurrentThreadId()) {
+    return;
+  }
+  // The trackers of a thread are nested, so the active trackers that recorded
+  // the allocation are the ones created before its innermost tracker.
+  for (ScopedAllocationTracker* tracker = current_tracker; tracker != nullptr;
+       tracker = tracker->parent_) {
+    if (tracker->id_ <= tag.tracker_id) {
+      tracker->live_bytes_ -= num_bytes;
+    }
+  }
+}
+
+}  // namespace internal
+
+ScopedAllocationTracker::ScopedAllocationTracker()
+    : parent_(current_tracker), id_(next_tracker_id.fetch_add(1)),
+      active_(true) {
+  current_tracker = this;
+}
+
+ScopedAllocationTracker::~ScopedAllocationTracker() { Stop(); }
+
+void ScopedAllocationTracker::Stop() {
+  if (active_ && current_tracker == this) {
+    current_tracker = parent_;
+  }
+  active_ = false;
+}
+
+ScopedAllocationStage::ScopedAllocationStage(const char* name)
+    : enclosing_tracker_(current_tracker), name_(name) {}
+
+ScopedAllocationStage::~ScopedAllocationStage() {
+  tracker_.Stop();
+  if (enclosing_tracker_ == nullptr) {
+    return;
+  }
+  ScopedTrackingPause pause;
+  AllocationStats& stats = enclosing_tracker_->stage_stats_[name_];
+  stats.num_allocations += tracker_.stats().num_allocations;
+  stats.num_bytes += tracker_.stats().num_bytes;
+  if (tracker_.stats().peak_bytes > stats.peak_bytes) {
+    stats.peak_bytes = tracker_.stats().peak_bytes;
+  }
+}
+
+}  // namespace libtextclassifier3
+
+// Counting replacements of the global operator new and delete. Each block
+// is prefixed with its size and allocation tag, so that deallocations can be
+// accounted for.
+namespace {
+
+struct BlockHeader {
+  size_t size;
+  libtextclassifier3::internal::AllocationTag tag;
+};
+
+// Size of the prefix, keeps the blocks aligned as with malloc.
+constexpr size_t kPrefixBytes =
+    (sizeof(BlockHeader) + alignof(std::max_align_t) - 1) /
+    alignof(std::max_align_t) * alignof(std::max_align_t);
+
+void* CountingAllocate(size_t size) {
+  void* block = std::malloc(size + kPrefixBytes);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  BlockHeader* header = static_cast<BlockHeader*>(block);
+  header->size = size;
+  header->tag = libtextclassifier3::internal::RecordAllocation(size);
+  return static_cast<char*>(block) + kPrefixBytes;
+}
+
+void CountingDeallocate(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  void* block = static_cast<char*>(ptr) - kPrefixBytes;
+  const BlockHeader* header = static_cast<const BlockHeader*>(block);
+  libtextclassifier3::internal::RecordDeallocation(header->size, header->tag);
+  std::free(block);
+}
+
+// As operator new, retries via the new handler, the binaries are built without
+// exceptions so it aborts instead of throwing std::bad_alloc.
+void* CountingAllocateOrDie(size_t size) {
+  void* ptr = CountingAllocate(size);
+  while (ptr == nullptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      std::abort();
+    }
+    handler();
+    ptr = CountingAllocate(size);
+  }
+  return ptr;
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return CountingAllocateOrDie(size); }
+
+void* operator new[](size_t size) { return CountingAllocateOrDie(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return CountingAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return CountingAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept { CountingDeallocate(ptr); }
+
+void operator delete[](void* ptr) noexcept { CountingDeallocate(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  CountingDeallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  CountingDeallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept { CountingDeallocate(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { CountingDeallocate(ptr); }
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Heap allocation tracking for tests and benchmarks.
+//
+// allocation-tracker.cc replaces the global operator new and delete with
+// counting versions. It is only linked into the test and benchmark binaries,
+// the library itself is not instrumented.
+//
+// Example:
+//   ScopedAllocationTracker tracker;
+//   {
+//     ScopedAllocationStage stage("annotate");
+//     annotator->Annotate(text);
+//   }
+//   EXPECT_LT(tracker.stats().num_allocations, 1000);
+//   EXPECT_LT(tracker.stage_stats().at("annotate").peak_bytes, 1 << 20);
+
+#ifndef LIBTEXTCLASSIFIER_UTILS_TESTING_ALLOCATION_TRACKER_H_
+#define LIBTEXTCLASSIFIER_UTILS_TESTING_ALLOCATION_TRACKER_H_
+
+#include <map>
+#include <string>
+
+#include "utils/base/integral_types.h"
+
+namespace libtextclassifier3 {
+
+// Heap allocation statistics of a scope.
+struct AllocationStats {
+  // Number of allocations.
+  int64 num_allocations = 0;
+
+  // Total number of bytes requested by the allocations.
+  int64 num_bytes = 0;
+
+  // Peak number of bytes allocated in the scope and not yet freed. Freeing
+  // memory allocated before the scope doesn't lower it.
+  int64 peak_bytes = 0;
+};
+
+namespace internal {
+// Identifies the trackers that recorded an allocation, so that only they
+// account for its deallocation.
+struct AllocationTag {
+  // Thread that made the allocation.
+  int64 thread_id = 0;
+
+  // Innermost tracker of the thread at the time of the allocation, 0 if none.
+  int64 tracker_id = 0;
+};
+
+// Called by the counting operator new and delete.
+AllocationTag RecordAllocation(int64 num_bytes);
+void RecordDeallocation(int64 num_bytes, const AllocationTag& tag);
+}  // namespace internal
+
+// Tracks the allocations made via operator new by the current thread while
+// in scope. Allocations made by other threads are not tracked. Trackers can
+// be nested, allocations are recorded by all the active trackers.
+class ScopedAllocationTracker {
+ public:
+  ScopedAllocationTracker();
+  ~ScopedAllocationTracker();
+
+  // Statistics of the allocations made so far.
+  const AllocationStats& stats() const { return stats_; }
+
+  // Statistics of the stages tracked with ScopedAllocationStage while this
+  // was the innermost tracker, by stage name. Repeated stages are summed up.
+  const std::map<std::string, AllocationStats>& stage_stats() const {
+    return stage_stats_;
+  }
+
+ private:
+  friend class ScopedAllocationStage;
+  friend internal::AllocationTag internal::RecordAllocation(int64 num_bytes);
+  friend void internal::RecordDeallocation(
+      int64 num_bytes, const internal::AllocationTag& tag);
+
+  // Stops tracking, if this is still the innermost tracker.
+  void Stop();
+
+  ScopedAllocationTracker* const parent_;
+
+  // Unique and increasing in creation order, never 0.
+  const int64 id_;
+  bool active_;
+  AllocationStats stats_;
+  int64 live_bytes_ = 0;
+  std::map<std::string, AllocationStats> stage_stats_;
+};
+
+// Tracks the allocations of a named stage, e.g. model loading or a single
+// annotation call, and adds them to the stage statistics of the enclosing
+// tracker when going out of scope. The allocations are also recorded by the
+// enclosing trackers as usual.
+class ScopedAllocationStage {
+ public:
+  // `name` must outlive the stage.
+  explicit ScopedAllocationStage(const char* name);
+  ~ScopedAllocationStage();
+
+ private:
+  ScopedAllocationTracker* const enclosing_tracker_;
+  const char* const name_;
+  ScopedAllocationTracker tracker_;
+};
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_UTILS_TESTING_ALLOCATION_TRACKER_H_
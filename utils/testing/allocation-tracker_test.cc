@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/testing/allocation-tracker.h"
+
+#include <cstddef>
+#include <new>
+
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Allocates via the global operator new. Unlike with new expressions, the
+// compiler may not elide the allocation in optimized builds.
+void* Allocate(size_t num_bytes) { return ::operator new(num_bytes); }
+
+void Free(void* ptr) { ::operator delete(ptr); }
+
+TEST(AllocationTrackerTest, CountsAllocations) {
+  ScopedAllocationTracker tracker;
+  void* value = Allocate(sizeof(int));
+  void* buffer = Allocate(100);
+
+  EXPECT_EQ(tracker.stats().num_allocations, 2);
+  EXPECT_EQ(tracker.stats().num_bytes, sizeof(int) + 100);
+  EXPECT_EQ(tracker.stats().peak_bytes, sizeof(int) + 100);
+  Free(buffer);
+  Free(value);
+}
+
+TEST(AllocationTrackerTest, TracksPeakBytes) {
+  ScopedAllocationTracker tracker;
+  for (int i = 0; i < 10; i++) {
+    Free(Allocate(1000));
+  }
+
+  EXPECT_EQ(tracker.stats().num_allocations, 10);
+  EXPECT_EQ(tracker.stats().num_bytes, 10000);
+  EXPECT_EQ(tracker.stats().peak_bytes, 1000);
+}
+
+TEST(AllocationTrackerTest, DoesNotCountAllocationsOutsideOfScope) {
+  void* before = Allocate(100);
+  AllocationStats stats;
+  {
+    ScopedAllocationTracker tracker;
+    Free(before);
+    void* buffer = Allocate(10);
+    stats = tracker.stats();
+    Free(buffer);
+  }
+  void* after = Allocate(100);
+  Free(after);
+
+  EXPECT_EQ(stats.num_allocations, 1);
+  EXPECT_EQ(stats.num_bytes, 10);
+  // Freeing the block allocated before the scope doesn't offset the buffer.
+  EXPECT_EQ(stats.peak_bytes, 10);
+}
+
+TEST(AllocationTrackerTest, DoesNotCountFreesOfOuterAllocationsInNestedScope) {
+  ScopedAllocationTracker outer;
+  void* outer_buffer = Allocate(100);
+  {
+    ScopedAllocationTracker inner;
+    Free(outer_buffer);
+    void* buffer = Allocate(10);
+    Free(Allocate(20));
+    EXPECT_EQ(inner.stats().peak_bytes, 30);
+    Free(buffer);
+  }
+
+  EXPECT_EQ(outer.stats().num_allocations, 3);
+  EXPECT_EQ(outer.stats().peak_bytes, 100);
+}
+
+TEST(AllocationTrackerTest, TracksStages) {
+  ScopedAllocationTracker tracker;
+  void* loaded = nullptr;
+  {
+    ScopedAllocationStage stage("load");
+    loaded = Allocate(10 * sizeof(int));
+  }
+  for (int i = 0; i < 2; i++) {
+    ScopedAllocationStage stage("compute");
+    Free(Allocate(50));
+  }
+  Free(loaded);
+
+  ASSERT_EQ(tracker.stage_stats().size(), 2);
+  const AllocationStats& load = tracker.stage_stats().at("load");
+  EXPECT_EQ(load.num_allocations, 1);
+  EXPECT_EQ(load.num_bytes, 10 * sizeof(int));
+  EXPECT_EQ(load.peak_bytes, 10 * sizeof(int));
+  const AllocationStats& compute = tracker.stage_stats().at("compute");
+  EXPECT_EQ(compute.num_allocations, 2);
+  EXPECT_EQ(compute.num_bytes, 100);
+  EXPECT_EQ(compute.peak_bytes, 50);
+
+  // The enclosing tracker sees the allocations of the stages, but not the
+  // bookkeeping of the stage statistics.
+  EXPECT_EQ(tracker.stats().num_allocations, 3);
+  EXPECT_EQ(tracker.stats().peak_bytes, 10 * sizeof(int) + 50);
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/testing/benchmark-corpora.h"
+
+#include <random>
+
+namespace libtextclassifier3 {
+namespace {
+
+// Location of the models installed by the libtextclassifier prebuilts.
+constexpr char kBenchmarkModelsDir[] = "/etc/textclassifier/";
+
+const std::vector<std::string>& ShortChatSentences() {
+  static const std::vector<std::string>* sentences =
+      new std::vector<std::string>{
+          "hey are we still on for lunch tomorrow?",
+          "sure, see you at 12:30",
+          "can you call me at (555) 012-3456 when you land",
+          "running 10 min late sorry!!",
+          "ok",
+          "lol that's hilarious",
+          "meet me at 1600 Amphitheatre Parkway, Mountain View",
+          "did you see the game last night",
+          "my flight is LX 38, arriving at 6pm",
+          "send it to jane.doe@example.com please",
+          "thanks!",
+          "what about next friday at 3?",
+          "check this out https://www.example.com/article?id=42",
+          "happy birthday!!! 🎉",
+          "where are you?",
+          "i'll be there in 5",
+      };
+  return *sentences;
+}
+
+const std::vector<std::string>& LongEmailSentences() {
+  static const std::vector<std::string>* sentences =
+      new std::vector<std::string>{
+          "Dear team, please find attached the agenda for our quarterly "
+          "planning meeting on Thursday, March 14 at 10:00 AM.",
+          "The meeting will take place at 350 Fifth Avenue, New York, NY "
+          "10118, on the 21st floor.",
+          "If you cannot attend in person, you can join the call at "
+          "https://meet.example.com/q2-planning or dial +1 650-253-0000.",
+          "Before the meeting, please review the documents shared on "
+          "www.example.org/docs and send your comments to "
+          "planning@example.com.",
+          "We will discuss the results of the last quarter, the hiring plan "
+          "and the roadmap for the second half of the year.",
+          "Lunch will be served at 12:30 PM; let me know by Monday if you "
+          "have any dietary restrictions.",
+          "Travel arrangements: flights arriving at JFK before 9 AM will be "
+          "reimbursed, for example UA 1234 or DL 403.",
+          "The hotel reservation confirmation number is 8843-2291, check-in "
+          "is possible from 3 PM on Wednesday.",
+          "Please also remember that expense reports for February are due "
+          "on the 5th of next month.",
+          "Best regards, and looking forward to seeing all of you next "
+          "week.",
+      };
+  return *sentences;
+}
+
+const std::vector<std::string>& NumericSentences() {
+  static const std::vector<std::string>* sentences =
+      new std::vector<std::string>{
+          "Order #482130 total $1,234.56 paid with card ending 4242.",
+          "Tracking number 1Z999AA10123456784, estimated delivery 2019-04-17.",
+          "Call +41 44 668 18 00 or 044 668 1800 between 8:00 and 17:30.",
+          "Invoice 2019/0042: 3 x 19.99 EUR = 59.97 EUR, VAT 7.7%.",
+          "Your code is 839 201, it expires in 10 minutes.",
+          "IBAN CH93 0076 2011 6238 5295 7, BIC UBSWCHZH80A.",
+          "Temperature 23.5 C, humidity 45%, wind 12 km/h.",
+          "Room 4.21, building 1900, floor 2, desk 17.",
+          "The meeting is at 10/12/2019 14:45 for 1.5 hours.",
+          "ISBN 978-3-16-148410-0, 320 pages, 24.90 USD.",
+      };
+  return *sentences;
+}
+
+const std::vector<std::string>& MultiScriptSentences() {
+  static const std::vector<std::string>* sentences =
+      new std::vector<std::string>{
+          "Let's meet tomorrow at 5pm near the station.",
+          "Встретимся завтра в пять часов у вокзала.",
+          "我们明天下午五点在车站附近见面。",
+          "明日の午後5時に駅の近くで会いましょう。",
+          "내일 오후 5시에 역 근처에서 만나요.",
+          "لنلتقِ غدًا في الساعة الخامسة مساءً بالقرب من المحطة.",
+          "कल शाम पाँच बजे स्टेशन के पास मिलते हैं।",
+          "Treffen wir uns morgen um 17 Uhr am Bahnhof.",
+          "Nos vemos mañana a las cinco cerca de la estación.",
+          "Ας συναντηθούμε αύριο στις πέντε κοντά στον σταθμό.",
+          "נפגש מחר בחמש ליד התחנה.",
+          "พบกันพรุ่งนี้ห้าโมงเย็นใกล้สถานี",
+      };
+  return *sentences;
+}
+
+const std::vector<std::string>& CorpusSentences(BenchmarkCorpus corpus) {
+  switch (corpus) {
+    case BenchmarkCorpus::SHORT_CHAT:
+      return ShortChatSentences();
+    case BenchmarkCorpus::LONG_EMAIL:
+      return LongEmailSentences();
+    case BenchmarkCorpus::NUMERIC:
+      return NumericSentences();
+    case BenchmarkCorpus::MULTI_SCRIPT:
+      return MultiScriptSentences();
+  }
+  return ShortChatSentences();
+}
+
+// Returns a generator of sentence indices. The generator is seeded with the
+// corpus, so that the generated texts are the same for every run. The modulo
+// of the raw output is used instead of a distribution, as the distributions
+// are implementation defined.
+class SentenceSampler {
+ public:
+  explicit SentenceSampler(BenchmarkCorpus corpus)
+      : sentences_(CorpusSentences(corpus)),
+        random_(static_cast<unsigned int>(corpus) + 1) {}
+
+  const std::string& Next() {
+    return sentences_[random_() % sentences_.size()];
+  }
+
+ private:
+  const std::vector<std::string>& sentences_;
+  std::minstd_rand random_;
+};
+
+}  // namespace
+
+std::string BenchmarkCorpusName(BenchmarkCorpus corpus) {
+  switch (corpus) {
+    case BenchmarkCorpus::SHORT_CHAT:
+      return "short_chat";
+    case BenchmarkCorpus::LONG_EMAIL:
+      return "long_email";
+    case BenchmarkCorpus::NUMERIC:
+      return "numeric";
+    case BenchmarkCorpus::MULTI_SCRIPT:
+      return "multi_script";
+  }
+  return "unknown";
+}
+
+std::string GenerateBenchmarkText(BenchmarkCorpus corpus, int num_bytes) {
+  const char separator = (corpus == BenchmarkCorpus::LONG_EMAIL) ? '\n' : ' ';
+  SentenceSampler sampler(corpus);
+  std::string text = sampler.Next();
+  while (static_cast<int>(text.size()) < num_bytes) {
+    text.push_back(separator);
+    text.append(sampler.Next());
+  }
+  return text;
+}
+
+std::vector<std::string> GenerateBenchmarkMessages(BenchmarkCorpus corpus,
+                                                   int num_messages) {
+  SentenceSampler sampler(corpus);
+  std::vector<std::string> messages;
+  messages.reserve(num_messages);
+  for (int i = 0; i < num_messages; i++) {
+    messages.push_back(sampler.Next());
+  }
+  return messages;
+}
+
+std::string GetBenchmarkModelPath(const std::string& model_file_name) {
+  return kBenchmarkModelsDir + model_file_name;
+}
+
+}  // namespace libtextclassifier3
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Synthetic, reproducible input corpora and model locations for the
+// libtextclassifier benchmarks.
+
+#ifndef LIBTEXTCLASSIFIER_UTILS_TESTING_BENCHMARK_CORPORA_H_
+#define LIBTEXTCLASSIFIER_UTILS_TESTING_BENCHMARK_CORPORA_H_
+
+#include <string>
+#include <vector>
+
+namespace libtextclassifier3 {
+
+// Kinds of input text the benchmarks are run on.
+enum class BenchmarkCorpus {
+  // Short informal chat messages.
+  SHORT_CHAT = 0,
+  // Longer, well formed email text with addresses, urls and dates.
+  LONG_EMAIL = 1,
+  // Text dominated by numbers: prices, phone numbers, tracking numbers.
+  NUMERIC = 2,
+  // Sentences in different languages and scripts.
+  MULTI_SCRIPT = 3,
+};
+
+// Number of values of BenchmarkCorpus.
+constexpr int kNumBenchmarkCorpora = 4;
+
+// Returns a short name of the corpus, used as benchmark label.
+std::string BenchmarkCorpusName(BenchmarkCorpus corpus);
+
+// Returns deterministic text of at least `num_bytes` bytes (and at least one
+// sentence) from the corpus. The text is made of whole sentences.
+std::string GenerateBenchmarkText(BenchmarkCorpus corpus, int num_bytes);
+
+// Returns `num_messages` deterministic messages from the corpus, one sentence
+// each.
+std::vector<std::string> GenerateBenchmarkMessages(BenchmarkCorpus corpus,
+                                                   int num_messages);
+
+// Returns the path of a bundled model (e.g. "textclassifier.en.model") as
+// installed on the device alongside the benchmarks.
+std::string GetBenchmarkModelPath(const std::string& model_file_name);
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_UTILS_TESTING_BENCHMARK_CORPORA_H_
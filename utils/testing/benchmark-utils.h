@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Helpers shared by the benchmarks running the public APIs over the
+// benchmark corpora.
+
+#ifndef LIBTEXTCLASSIFIER_UTILS_TESTING_BENCHMARK_UTILS_H_
+#define LIBTEXTCLASSIFIER_UTILS_TESTING_BENCHMARK_UTILS_H_
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "utils/testing/allocation-tracker.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+
+// Returns the nearest-rank percentile of `values`, `percentile` in [0, 1].
+inline double BenchmarkPercentile(std::vector<double> values,
+                                  const double percentile) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  const int rank = static_cast<int>(percentile * (values.size() - 1) + 0.5);
+  return values[rank];
+}
+
+// Records the latency of every iteration of a benchmark loop, and reports the
+// median, 90th and 99th percentile per-call latency in nanoseconds as the
+// counters "p50_ns", "p90_ns" and "p99_ns" (averaged over the threads). Usage:
+//
+//   LatencyRecorder latencies(&state);
+//   for (auto _ : state) {
+//     const LatencyRecorder::Sample sample(&latencies);
+//     ...
+//   }
+class LatencyRecorder {
+ public:
+  // Times one iteration, from its construction to its destruction.
+  class Sample {
+   public:
+    explicit Sample(LatencyRecorder* recorder)
+        : recorder_(recorder), start_(std::chrono::steady_clock::now()) {}
+    ~Sample() {
+      const std::chrono::duration<double, std::nano> latency =
+          std::chrono::steady_clock::now() - start_;
+      recorder_->latencies_ns_.push_back(latency.count());
+    }
+
+   private:
+    LatencyRecorder* const recorder_;
+    const std::chrono::steady_clock::time_point start_;
+  };
+
+  explicit LatencyRecorder(benchmark::State* state) : state_(state) {
+    latencies_ns_.reserve(state->max_iterations);
+  }
+
+  ~LatencyRecorder() {
+    Report("p50_ns", 0.5);
+    Report("p90_ns", 0.9);
+    Report("p99_ns", 0.99);
+  }
+
+ private:
+  void Report(const std::string& name, const double percentile) {
+    state_->counters[name] =
+        benchmark::Counter(BenchmarkPercentile(latencies_ns_, percentile),
+                           benchmark::Counter::kAvgThreads);
+  }
+
+  benchmark::State* const state_;
+  std::vector<double> latencies_ns_;
+};
+
+// Registers the arguments (corpus, input size in bytes) for all the corpora
+// and input sizes of 64 bytes, 512 bytes and 4 KiB.
+inline void CorpusTextArguments(benchmark::internal::Benchmark* b) {
+  for (int corpus = 0; corpus < kNumBenchmarkCorpora; corpus++) {
+    for (int num_bytes = 64; num_bytes <= (4 << 10); num_bytes *= 8) {
+      b->Args({corpus, num_bytes});
+    }
+  }
+}
+
+// Returns the corpus text for benchmarks registered with
+// CorpusTextArguments(), and labels the benchmark with the corpus name.
+inline std::string CorpusTextForBenchmark(benchmark::State& state) {
+  const BenchmarkCorpus corpus = static_cast<BenchmarkCorpus>(state.range(0));
+  state.SetLabel(BenchmarkCorpusName(corpus));
+  return GenerateBenchmarkText(corpus, state.range(1));
+}
+
+// Runs `fn` once with allocation tracking and reports the number of
+// allocations, allocated bytes and peak allocated bytes of the call as the
+// counters "allocs_per_call", "bytes_per_call" and "peak_bytes".
+template <typename Fn>
+void ReportAllocationsPerCall(benchmark::State& state, Fn fn) {
+  AllocationStats stats;
+  {
+    ScopedAllocationTracker tracker;
+    fn();
+    stats = tracker.stats();
+  }
+  state.counters["allocs_per_call"] = stats.num_allocations;
+  state.counters["bytes_per_call"] = stats.num_bytes;
+  state.counters["peak_bytes"] = stats.peak_bytes;
+}
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_UTILS_TESTING_BENCHMARK_UTILS_H_
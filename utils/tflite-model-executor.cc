@@ -188,6 +188,15 @@ std::unique_ptr<const tflite::FlatBufferModel> TfLiteModelFromModelSpec(
 
 std::unique_ptr<const tflite::FlatBufferModel> TfLiteModelFromBuffer(
     const flatbuffers::Vector<uint8_t>* model_spec_buffer) {
+  const tflite::Model* model = VerifiedTfLiteModel(model_spec_buffer);
+  if (model == nullptr) {
+    return nullptr;
+  }
+  return TfLiteModelFromModelSpec(model);
+}
+
+const tflite::Model* VerifiedTfLiteModel(
+    const flatbuffers::Vector<uint8_t>* model_spec_buffer) {
   const tflite::Model* model =
       flatbuffers::GetRoot<tflite::Model>(model_spec_buffer->data());
   flatbuffers::Verifier verifier(model_spec_buffer->data(),
@@ -195,13 +204,20 @@ std::unique_ptr<const tflite::FlatBufferModel> TfLiteModelFromBuffer(
   if (!model->Verify(verifier)) {
     return nullptr;
   }
-  return TfLiteModelFromModelSpec(model);
+  return model;
 }
 
 TfLiteModelExecutor::TfLiteModelExecutor(
     std::unique_ptr<const tflite::FlatBufferModel> model)
     : model_(std::move(model)), resolver_(BuildOpResolver()) {}
 
+TfLiteModelExecutor::TfLiteModelExecutor(
+    std::unique_ptr<const std::string> model_buffer,
+    std::unique_ptr<const tflite::FlatBufferModel> model)
+    : owned_model_buffer_(std::move(model_buffer)),
+      model_(std::move(model)),
+      resolver_(BuildOpResolver()) {}
+
 std::unique_ptr<tflite::Interpreter> TfLiteModelExecutor::CreateInterpreter()
     const {
   std::unique_ptr<tflite::Interpreter> interpreter;
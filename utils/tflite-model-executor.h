@@ -20,6 +20,7 @@
 #define LIBTEXTCLASSIFIER_UTILS_TFLITE_MODEL_EXECUTOR_H_
 
 #include <memory>
+#include <string>
 
 #include "utils/base/logging.h"
 #include "utils/tensor-view.h"
@@ -37,6 +38,9 @@ std::unique_ptr<const tflite::FlatBufferModel> TfLiteModelFromModelSpec(
 std::unique_ptr<const tflite::FlatBufferModel> TfLiteModelFromBuffer(
     const flatbuffers::Vector<uint8_t>*);
 
+// Returns the verified model in the buffer, or nullptr.
+const tflite::Model* VerifiedTfLiteModel(const flatbuffers::Vector<uint8_t>*);
+
 // Executor for the text selection prediction and classification models.
 class TfLiteModelExecutor {
  public:
@@ -133,6 +137,13 @@ class TfLiteModelExecutor {
   explicit TfLiteModelExecutor(
       std::unique_ptr<const tflite::FlatBufferModel> model);
 
+  // For models built from a buffer created at load time, e.g. a transformed
+  // model, that the executor keeps alive.
+  TfLiteModelExecutor(std::unique_ptr<const std::string> model_buffer,
+                      std::unique_ptr<const tflite::FlatBufferModel> model);
+
+  // Declared before model_, which may reference it.
+  std::unique_ptr<const std::string> owned_model_buffer_;
   std::unique_ptr<const tflite::FlatBufferModel> model_;
   std::unique_ptr<tflite::OpResolver> resolver_;
 };
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/tflite-quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "utils/base/logging.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+const int kFullyConnectedWeightsInput = 1;
+
+// Returns the indices of the float weight tensors of the subgraph that are
+// only used as weights of FULLY_CONNECTED ops and own their buffer.
+std::vector<int> QuantizableWeights(const tflite::ModelT& model,
+                                    const tflite::SubGraphT& subgraph,
+                                    const std::vector<int>& buffer_uses) {
+  const int num_tensors = subgraph.tensors.size();
+  std::vector<int> weight_uses(num_tensors, 0);
+  std::vector<int> other_uses(num_tensors, 0);
+  for (const std::unique_ptr<tflite::OperatorT>& op : subgraph.operators) {
+    const bool fully_connected =
+        model.operator_codes[op->opcode_index]->builtin_code ==
+        tflite::BuiltinOperator_FULLY_CONNECTED;
+    for (int i = 0; i < op->inputs.size(); ++i) {
+      const int tensor = op->inputs[i];
+      if (tensor < 0) {
+        continue;
+      }
+      if (fully_connected && i == kFullyConnectedWeightsInput) {
+        ++weight_uses[tensor];
+      } else {
+        ++other_uses[tensor];
+      }
+    }
+    for (const int tensor : op->outputs) {
+      ++other_uses[tensor];
+    }
+  }
+  for (const int tensor : subgraph.inputs) {
+    ++other_uses[tensor];
+  }
+  for (const int tensor : subgraph.outputs) {
+    ++other_uses[tensor];
+  }
+
+  std::vector<int> result;
+  for (int i = 0; i < num_tensors; ++i) {
+    const tflite::TensorT& tensor = *subgraph.tensors[i];
+    if (weight_uses[i] == 0 || other_uses[i] > 0 ||
+        tensor.type != tflite::TensorType_FLOAT32 || tensor.shape.size() != 2 ||
+        buffer_uses[tensor.buffer] != 1) {
+      continue;
+    }
+    const int num_weights = tensor.shape[0] * tensor.shape[1];
+    if (num_weights == 0 ||
+        model.buffers[tensor.buffer]->data.size() !=
+            num_weights * sizeof(float)) {
+      continue;
+    }
+    result.push_back(i);
+  }
+  return result;
+}
+
+// Quantizes the weights of the tensor in place.
+void QuantizeTensor(tflite::TensorT* tensor, tflite::BufferT* buffer) {
+  const int num_weights = tensor->shape[0] * tensor->shape[1];
+
+  // The buffer isn't necessarily aligned for floats.
+  std::vector<float> weights(num_weights);
+  memcpy(weights.data(), buffer->data.data(), buffer->data.size());
+  std::vector<int8_t> quantized(num_weights);
+  const float scale =
+      QuantizeToInt8(weights.data(), num_weights, quantized.data());
+
+  buffer->data.resize(quantized.size());
+  memcpy(buffer->data.data(), quantized.data(), quantized.size());
+  tensor->type = tflite::TensorType_INT8;
+  tensor->quantization.reset(new tflite::QuantizationParametersT());
+  tensor->quantization->scale = {scale};
+  tensor->quantization->zero_point = {0};
+}
+
+}  // namespace
+
+std::string QuantizeFullyConnectedWeights(const tflite::Model* model,
+                                          int* num_quantized_tensors) {
+  std::unique_ptr<tflite::ModelT> unpacked_model(model->UnPack());
+
+  std::vector<int> buffer_uses(unpacked_model->buffers.size(), 0);
+  for (const std::unique_ptr<tflite::SubGraphT>& subgraph :
+       unpacked_model->subgraphs) {
+    for (const std::unique_ptr<tflite::TensorT>& tensor : subgraph->tensors) {
+      ++buffer_uses[tensor->buffer];
+    }
+  }
+
+  int num_quantized = 0;
+  for (const std::unique_ptr<tflite::SubGraphT>& subgraph :
+       unpacked_model->subgraphs) {
+    for (const int tensor_index :
+         QuantizableWeights(*unpacked_model, *subgraph, buffer_uses)) {
+      tflite::TensorT* tensor = subgraph->tensors[tensor_index].get();
+      QuantizeTensor(tensor, unpacked_model->buffers[tensor->buffer].get());
+      ++num_quantized;
+    }
+  }
+  TC3_VLOG(1) << "Quantized " << num_quantized
+              << " fully connected weight tensors.";
+  if (num_quantized_tensors != nullptr) {
+    *num_quantized_tensors = num_quantized;
+  }
+
+  flatbuffers::FlatBufferBuilder builder;
+  tflite::FinishModelBuffer(
+      builder, tflite::Model::Pack(builder, unpacked_model.get()));
+  return std::string(reinterpret_cast<const char*>(builder.GetBufferPointer()),
+                     builder.GetSize());
+}
+
+float QuantizeToInt8(const float* weights, int num_weights, int8_t* quantized) {
+  float max_abs = 0.0f;
+  for (int i = 0; i < num_weights; ++i) {
+    max_abs = std::max(max_abs, std::abs(weights[i]));
+  }
+  const float scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+  for (int i = 0; i < num_weights; ++i) {
+    const int value = static_cast<int>(std::round(weights[i] / scale));
+    quantized[i] = static_cast<int8_t>(std::min(127, std::max(-127, value)));
+  }
+  return scale;
+}
+
+}  // namespace libtextclassifier3
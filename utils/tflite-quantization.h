@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Load-time quantization of the weights of float TFLite models.
+
+#ifndef LIBTEXTCLASSIFIER_UTILS_TFLITE_QUANTIZATION_H_
+#define LIBTEXTCLASSIFIER_UTILS_TFLITE_QUANTIZATION_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace libtextclassifier3 {
+
+// Returns a copy of the serialized model in which the float weights of the
+// FULLY_CONNECTED ops are quantized symmetrically to int8, with one scale per
+// tensor. TFLite then runs these ops with its hybrid kernels, which quantize
+// the float activations on the fly and multiply in integers.
+// Weights shared with other ops, or whose buffer is shared with other tensors,
+// are left as they are. Sets 'num_quantized_tensors' if not nullptr.
+// NOTE: Per-channel scales would be more accurate, but the hybrid fully
+// connected kernels of older TFLite runtimes only read the first scale.
+std::string QuantizeFullyConnectedWeights(const tflite::Model* model,
+                                          int* num_quantized_tensors = nullptr);
+
+// Quantizes the 'num_weights' weights symmetrically to int8 and returns the
+// scale, such that a weight is approximately quantized[i] * scale.
+float QuantizeToInt8(const float* weights, int num_weights, int8_t* quantized);
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_UTILS_TFLITE_QUANTIZATION_H_
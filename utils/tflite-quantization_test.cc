@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/tflite-quantization.h"
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+TEST(QuantizeToInt8Test, UsesOneScaleForAllWeights) {
+  const std::vector<float> weights = {0.5f, -1.0f, 0.25f,  //
+                                      2.0f, 0.0f,  -0.5f};
+  std::vector<int8_t> quantized(weights.size());
+  EXPECT_FLOAT_EQ(
+      QuantizeToInt8(weights.data(), weights.size(), quantized.data()),
+      2.0f / 127);
+  EXPECT_THAT(quantized, testing::ElementsAre(32, -64, 16, 127, 0, -32));
+}
+
+TEST(QuantizeToInt8Test, UsesUnitScaleForZeroWeights) {
+  const std::vector<float> weights = {0.0f, 0.0f, 0.0f};
+  std::vector<int8_t> quantized(weights.size());
+  EXPECT_FLOAT_EQ(
+      QuantizeToInt8(weights.data(), weights.size(), quantized.data()), 1.0f);
+  EXPECT_THAT(quantized, testing::ElementsAre(0, 0, 0));
+}
+
+TEST(QuantizeToInt8Test, ErrorIsBoundedByHalfTheScale) {
+  std::vector<float> weights;
+  for (int i = 0; i < 200; ++i) {
+    weights.push_back((i * 37 % 101 - 50) / 17.0f);
+  }
+  std::vector<int8_t> quantized(weights.size());
+  const float scale =
+      QuantizeToInt8(weights.data(), weights.size(), quantized.data());
+
+  for (int i = 0; i < weights.size(); ++i) {
+    EXPECT_NEAR(quantized[i] * scale, weights[i], scale / 2 + 1e-6) << i;
+  }
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
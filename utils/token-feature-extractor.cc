@@ -16,6 +16,7 @@
 
 #include "utils/token-feature-extractor.h"
 
+#include <algorithm>
 #include <cctype>
 #include <string>
 
@@ -28,41 +29,46 @@ namespace libtextclassifier3 {
 
 namespace {
 
-std::string RemapTokenAscii(const std::string& token,
-                            const TokenFeatureExtractorOptions& options) {
+// Appends the token to 'word', with the digits and case remapped as
+// configured.
+void AppendRemappedAscii(StringPiece token,
+                         const TokenFeatureExtractorOptions& options,
+                         std::string* word) {
   if (!options.remap_digits && !options.lowercase_tokens) {
-    return token;
+    word->append(token.data(), token.size());
+    return;
   }
 
-  std::string copy = token;
   for (int i = 0; i < token.size(); ++i) {
-    if (options.remap_digits && isdigit(copy[i])) {
-      copy[i] = '0';
+    char c = token[i];
+    if (options.remap_digits && isdigit(c)) {
+      c = '0';
     }
     if (options.lowercase_tokens) {
-      copy[i] = tolower(copy[i]);
+      c = tolower(c);
     }
+    word->push_back(c);
   }
-  return copy;
 }
 
-void RemapTokenUnicode(const std::string& token,
-                       const TokenFeatureExtractorOptions& options,
-                       const UniLib& unilib, UnicodeText* remapped) {
+// Appends the codepoints in [begin, end) to 'word' as UTF-8, with the digits
+// and case remapped as configured.
+void AppendRemappedUnicode(const UnicodeText::const_iterator& begin,
+                           const UnicodeText::const_iterator& end,
+                           const TokenFeatureExtractorOptions& options,
+                           const UniLib& unilib, std::string* word) {
   if (!options.remap_digits && !options.lowercase_tokens) {
-    // Leave remapped untouched.
+    word->append(begin.utf8_data(), end.utf8_data() - begin.utf8_data());
     return;
   }
 
-  UnicodeText word = UTF8ToUnicodeText(token, /*do_copy=*/false);
-  remapped->clear();
-  for (auto it = word.begin(); it != word.end(); ++it) {
+  for (auto it = begin; it != end; ++it) {
     if (options.remap_digits && unilib.IsDigit(*it)) {
-      remapped->push_back('0');
+      word->push_back('0');
     } else if (options.lowercase_tokens) {
-      remapped->push_back(unilib.ToLower(*it));
+      AppendUTF8(unilib.ToLower(*it), word);
     } else {
-      remapped->push_back(*it);
+      AppendUTF8(*it, word);
     }
   }
 }
@@ -71,8 +77,18 @@ void RemapTokenUnicode(const std::string& token,
 
 TokenFeatureExtractor::TokenFeatureExtractor(
     const TokenFeatureExtractorOptions& options, const UniLib& unilib)
-    : options_(options), unilib_(unilib) {
-  for (const std::string& pattern : options.regexp_features) {
+    : options_(options),
+      regex_dfa_(options.regexp_features),
+      unilib_(unilib) {
+  for (const std::string& chargram : options.allowed_chargrams) {
+    allowed_chargram_fingerprints_.insert(tc3farmhash::Fingerprint64(chargram));
+  }
+  for (int i = 0; i < options.regexp_features.size(); ++i) {
+    if (regex_dfa_.IsSupported(i)) {
+      regex_patterns_.emplace_back(nullptr);
+      continue;
+    }
+    const std::string& pattern = options.regexp_features[i];
     regex_patterns_.push_back(std::unique_ptr<UniLib::RegexPattern>(
         unilib_.CreateRegexPattern(UTF8ToUnicodeText(
             pattern.c_str(), pattern.size(), /*do_copy=*/false))));
@@ -86,7 +102,7 @@ bool TokenFeatureExtractor::Extract(const Token& token, bool is_in_span,
     return false;
   }
   if (sparse_features) {
-    *sparse_features = ExtractCharactergramFeatures(token);
+    ExtractCharactergramFeatures(token, sparse_features);
   }
   *dense_features = ExtractDenseFeatures(token, is_in_span);
   return true;
@@ -94,10 +110,18 @@ bool TokenFeatureExtractor::Extract(const Token& token, bool is_in_span,
 
 std::vector<int> TokenFeatureExtractor::ExtractCharactergramFeatures(
     const Token& token) const {
+  std::vector<int> result;
+  ExtractCharactergramFeatures(token, &result);
+  return result;
+}
+
+void TokenFeatureExtractor::ExtractCharactergramFeatures(
+    const Token& token, std::vector<int>* result) const {
+  result->clear();
   if (options_.unicode_aware_features) {
-    return ExtractCharactergramFeaturesUnicode(token);
+    ExtractCharactergramFeaturesUnicode(token, result);
   } else {
-    return ExtractCharactergramFeaturesAscii(token);
+    ExtractCharactergramFeaturesAscii(token, result);
   }
 }
 
@@ -140,12 +164,26 @@ std::vector<float> TokenFeatureExtractor::ExtractDenseFeatures(
   if (!regex_patterns_.empty()) {
     UnicodeText token_unicode =
         UTF8ToUnicodeText(token.value, /*do_copy=*/false);
+    const uint64 dfa_matches = regex_dfa_.FullMatch(token_unicode);
+    // Prepared lazily, and shared by the patterns the DFA doesn't support.
+    std::unique_ptr<UniLib::PreparedText> prepared_token;
     for (int i = 0; i < regex_patterns_.size(); ++i) {
+      if (regex_dfa_.IsSupported(i)) {
+        dense_features.push_back((dfa_matches & (1ULL << i)) ? 1.0 : -1.0);
+        continue;
+      }
       if (!regex_patterns_[i].get()) {
         dense_features.push_back(-1.0);
         continue;
       }
-      auto matcher = regex_patterns_[i]->Matcher(token_unicode);
+      if (prepared_token == nullptr) {
+        prepared_token = unilib_.PrepareText(token_unicode);
+      }
+      if (prepared_token == nullptr) {
+        dense_features.push_back(-1.0);
+        continue;
+      }
+      auto matcher = regex_patterns_[i]->Matcher(*prepared_token);
       int status;
       if (matcher->Matches(&status)) {
         dense_features.push_back(1.0);
@@ -159,153 +197,160 @@ std::vector<float> TokenFeatureExtractor::ExtractDenseFeatures(
 }
 
 int TokenFeatureExtractor::HashToken(StringPiece token) const {
+  const uint64 fingerprint = tc3farmhash::Fingerprint64(token);
   if (options_.allowed_chargrams.empty()) {
-    return tc3farmhash::Fingerprint64(token) % options_.num_buckets;
+    return fingerprint % options_.num_buckets;
   } else {
     // Padding and out-of-vocabulary tokens have extra buckets reserved because
     // they are special and important tokens, and we don't want them to share
     // embedding with other charactergrams.
     // TODO(zilka): Experimentally verify.
     const int kNumExtraBuckets = 2;
-    const std::string token_string = token.ToString();
-    if (token_string == "<PAD>") {
+    if (token.Equals("<PAD>")) {
       return 1;
-    } else if (options_.allowed_chargrams.find(token_string) ==
-               options_.allowed_chargrams.end()) {
+    } else if (allowed_chargram_fingerprints_.find(fingerprint) ==
+               allowed_chargram_fingerprints_.end()) {
       return 0;  // Out-of-vocabulary.
     } else {
-      return (tc3farmhash::Fingerprint64(token) %
-              (options_.num_buckets - kNumExtraBuckets)) +
+      return (fingerprint % (options_.num_buckets - kNumExtraBuckets)) +
              kNumExtraBuckets;
     }
   }
 }
 
-std::vector<int> TokenFeatureExtractor::ExtractCharactergramFeaturesAscii(
-    const Token& token) const {
-  std::vector<int> result;
+void TokenFeatureExtractor::ExtractCharactergramFeaturesAscii(
+    const Token& token, std::vector<int>* result) const {
   if (token.is_padding || token.value.empty()) {
-    result.push_back(HashToken("<PAD>"));
+    result->push_back(HashToken("<PAD>"));
+    return;
+  }
+
+  // Remap the word directly into the feature word, trimming words that are
+  // over max_word_length characters. Remapping is per character, so trimming
+  // the remapped word is the same as remapping the trimmed one.
+  const std::string& word = token.value;
+  const int max_word_length = options_.max_word_length;
+  std::string feature_word;
+  feature_word.reserve(std::min<int>(word.size(), max_word_length) + 3);
+  feature_word.push_back('^');
+  if (word.size() > max_word_length) {
+    AppendRemappedAscii(StringPiece(word, /*offset=*/0, max_word_length / 2),
+                        options_, &feature_word);
+    feature_word.push_back('\1');
+    AppendRemappedAscii(StringPiece(word, word.size() - max_word_length / 2,
+                                    max_word_length / 2),
+                        options_, &feature_word);
   } else {
-    const std::string word = RemapTokenAscii(token.value, options_);
-
-    // Trim words that are over max_word_length characters.
-    const int max_word_length = options_.max_word_length;
-    std::string feature_word;
-    if (word.size() > max_word_length) {
-      feature_word =
-          "^" + word.substr(0, max_word_length / 2) + "\1" +
-          word.substr(word.size() - max_word_length / 2, max_word_length / 2) +
-          "$";
-    } else {
-      // Add a prefix and suffix to the word.
-      feature_word = "^" + word + "$";
-    }
+    AppendRemappedAscii(word, options_, &feature_word);
+  }
+  feature_word.push_back('$');
+
+  // Upper-bound the number of charactergram extracted to avoid resizing.
+  result->reserve(result->size() +
+                  options_.chargram_orders.size() * feature_word.size());
 
-    // Upper-bound the number of charactergram extracted to avoid resizing.
-    result.reserve(options_.chargram_orders.size() * feature_word.size());
+  if (options_.chargram_orders.empty()) {
+    result->push_back(HashToken(feature_word));
+    return;
+  }
 
-    if (options_.chargram_orders.empty()) {
-      result.push_back(HashToken(feature_word));
+  // Generate the character-grams. They are all views into feature_word.
+  const int feature_word_size = feature_word.size();
+  for (int chargram_order : options_.chargram_orders) {
+    if (chargram_order == 1) {
+      for (int i = 1; i < feature_word_size - 1; ++i) {
+        result->push_back(
+            HashToken(StringPiece(feature_word, /*offset=*/i, /*len=*/1)));
+      }
     } else {
-      // Generate the character-grams.
-      for (int chargram_order : options_.chargram_orders) {
-        if (chargram_order == 1) {
-          for (int i = 1; i < feature_word.size() - 1; ++i) {
-            result.push_back(
-                HashToken(StringPiece(feature_word, /*offset=*/i, /*len=*/1)));
-          }
-        } else {
-          for (int i = 0;
-               i < static_cast<int>(feature_word.size()) - chargram_order + 1;
-               ++i) {
-            result.push_back(HashToken(StringPiece(feature_word, /*offset=*/i,
-                                                   /*len=*/chargram_order)));
-          }
-        }
+      for (int i = 0; i < feature_word_size - chargram_order + 1; ++i) {
+        result->push_back(HashToken(StringPiece(feature_word, /*offset=*/i,
+                                                /*len=*/chargram_order)));
       }
     }
   }
-  return result;
 }
 
-std::vector<int> TokenFeatureExtractor::ExtractCharactergramFeaturesUnicode(
-    const Token& token) const {
-  std::vector<int> result;
+void TokenFeatureExtractor::ExtractCharactergramFeaturesUnicode(
+    const Token& token, std::vector<int>* result) const {
   if (token.is_padding || token.value.empty()) {
-    result.push_back(HashToken("<PAD>"));
-  } else {
-    UnicodeText word = UTF8ToUnicodeText(token.value, /*do_copy=*/false);
-    RemapTokenUnicode(token.value, options_, unilib_, &word);
-
-    // Trim the word if needed by finding a left-cut point and right-cut point.
-    auto left_cut = word.begin();
-    auto right_cut = word.end();
-    for (int i = 0; i < options_.max_word_length / 2; i++) {
-      if (left_cut < right_cut) {
-        ++left_cut;
-      }
-      if (left_cut < right_cut) {
-        --right_cut;
-      }
-    }
+    result->push_back(HashToken("<PAD>"));
+    return;
+  }
 
-    std::string feature_word;
-    if (left_cut == right_cut) {
-      feature_word = "^" + word.UTF8Substring(word.begin(), word.end()) + "$";
-    } else {
-      // clang-format off
-      feature_word = "^" +
-                     word.UTF8Substring(word.begin(), left_cut) +
-                     "\1" +
-                     word.UTF8Substring(right_cut, word.end()) +
-                     "$";
-      // clang-format on
+  const UnicodeText word = UTF8ToUnicodeText(token.value, /*do_copy=*/false);
+
+  // Trim the word if needed by finding a left-cut point and right-cut point.
+  // Remapping preserves the number of codepoints, so the cut points can be
+  // found on the original word.
+  auto left_cut = word.begin();
+  auto right_cut = word.end();
+  for (int i = 0; i < options_.max_word_length / 2; i++) {
+    if (left_cut < right_cut) {
+      ++left_cut;
     }
+    if (left_cut < right_cut) {
+      --right_cut;
+    }
+  }
 
-    const UnicodeText feature_word_unicode =
-        UTF8ToUnicodeText(feature_word, /*do_copy=*/false);
+  std::string feature_word;
+  feature_word.reserve(token.value.size() + 3);
+  feature_word.push_back('^');
+  if (left_cut == right_cut) {
+    AppendRemappedUnicode(word.begin(), word.end(), options_, unilib_,
+                          &feature_word);
+  } else {
+    AppendRemappedUnicode(word.begin(), left_cut, options_, unilib_,
+                          &feature_word);
+    feature_word.push_back('\1');
+    AppendRemappedUnicode(right_cut, word.end(), options_, unilib_,
+                          &feature_word);
+  }
+  feature_word.push_back('$');
 
-    // Upper-bound the number of charactergram extracted to avoid resizing.
-    result.reserve(options_.chargram_orders.size() * feature_word.size());
+  const UnicodeText feature_word_unicode =
+      UTF8ToUnicodeText(feature_word, /*do_copy=*/false);
 
-    if (options_.chargram_orders.empty()) {
-      result.push_back(HashToken(feature_word));
-    } else {
-      // Generate the character-grams.
-      for (int chargram_order : options_.chargram_orders) {
-        UnicodeText::const_iterator it_start = feature_word_unicode.begin();
-        UnicodeText::const_iterator it_end = feature_word_unicode.end();
-        if (chargram_order == 1) {
-          ++it_start;
-          --it_end;
-        }
-
-        UnicodeText::const_iterator it_chargram_start = it_start;
-        UnicodeText::const_iterator it_chargram_end = it_start;
-        bool chargram_is_complete = true;
-        for (int i = 0; i < chargram_order; ++i) {
-          if (it_chargram_end == it_end) {
-            chargram_is_complete = false;
-            break;
-          }
-          ++it_chargram_end;
-        }
-        if (!chargram_is_complete) {
-          continue;
-        }
-
-        for (; it_chargram_end <= it_end;
-             ++it_chargram_start, ++it_chargram_end) {
-          const int length_bytes =
-              it_chargram_end.utf8_data() - it_chargram_start.utf8_data();
-          result.push_back(HashToken(
-              StringPiece(it_chargram_start.utf8_data(), length_bytes)));
-        }
+  // Upper-bound the number of charactergram extracted to avoid resizing.
+  result->reserve(result->size() +
+                  options_.chargram_orders.size() * feature_word.size());
+
+  if (options_.chargram_orders.empty()) {
+    result->push_back(HashToken(feature_word));
+    return;
+  }
+
+  // Generate the character-grams.
+  for (int chargram_order : options_.chargram_orders) {
+    UnicodeText::const_iterator it_start = feature_word_unicode.begin();
+    UnicodeText::const_iterator it_end = feature_word_unicode.end();
+    if (chargram_order == 1) {
+      ++it_start;
+      --it_end;
+    }
+
+    UnicodeText::const_iterator it_chargram_start = it_start;
+    UnicodeText::const_iterator it_chargram_end = it_start;
+    bool chargram_is_complete = true;
+    for (int i = 0; i < chargram_order; ++i) {
+      if (it_chargram_end == it_end) {
+        chargram_is_complete = false;
+        break;
       }
+      ++it_chargram_end;
+    }
+    if (!chargram_is_complete) {
+      continue;
+    }
+
+    for (; it_chargram_end <= it_end; ++it_chargram_start, ++it_chargram_end) {
+      const int length_bytes =
+          it_chargram_end.utf8_data() - it_chargram_start.utf8_data();
+      result->push_back(HashToken(
+          StringPiece(it_chargram_start.utf8_data(), length_bytes)));
     }
   }
-  return result;
 }
 
 }  // namespace libtextclassifier3
@@ -22,6 +22,8 @@
 #include <vector>
 
 #include "annotator/types.h"
+#include "utils/base/integral_types.h"
+#include "utils/regex-dfa.h"
 #include "utils/strings/stringpiece.h"
 #include "utils/utf8/unilib.h"
 
@@ -80,6 +82,10 @@ class TokenFeatureExtractor {
   // Extracts the sparse (charactergram) features from the token.
   std::vector<int> ExtractCharactergramFeatures(const Token& token) const;
 
+  // Same as above, but writes the features to 'result', reusing its capacity.
+  void ExtractCharactergramFeatures(const Token& token,
+                                    std::vector<int>* result) const;
+
   // Extracts the dense features from the token. is_in_span is a bool indicator
   // whether the token is a part of the selection span (true) or not (false).
   std::vector<float> ExtractDenseFeatures(const Token& token,
@@ -88,7 +94,7 @@ class TokenFeatureExtractor {
   int DenseFeaturesCount() const {
     int feature_count =
         options_.extract_case_feature + options_.extract_selection_mask_feature;
-    feature_count += regex_patterns_.size();
+    feature_count += options_.regexp_features.size();
     return feature_count;
   }
 
@@ -97,15 +103,25 @@ class TokenFeatureExtractor {
   int HashToken(StringPiece token) const;
 
   // Extracts the charactergram features from the token in a non-unicode-aware
-  // way.
-  std::vector<int> ExtractCharactergramFeaturesAscii(const Token& token) const;
+  // way and appends them to 'result'.
+  void ExtractCharactergramFeaturesAscii(const Token& token,
+                                         std::vector<int>* result) const;
 
-  // Extracts the charactergram features from the token in a unicode-aware way.
-  std::vector<int> ExtractCharactergramFeaturesUnicode(
-      const Token& token) const;
+  // Extracts the charactergram features from the token in a unicode-aware way
+  // and appends them to 'result'.
+  void ExtractCharactergramFeaturesUnicode(const Token& token,
+                                           std::vector<int>* result) const;
 
  private:
   TokenFeatureExtractorOptions options_;
+
+  // Fingerprints of options_.allowed_chargrams, so that the charactergrams
+  // are only hashed once and never copied for the lookup.
+  std::unordered_set<uint64> allowed_chargram_fingerprints_;
+
+  // The regexp features are matched with a native DFA, except for the ones
+  // that the DFA does not support, which are matched with UniLib patterns.
+  RegexDfaSet regex_dfa_;
   std::vector<std::unique_ptr<UniLib::RegexPattern>> regex_patterns_;
   const UniLib& unilib_;
 };
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the charactergram feature extraction over the whitespace
+// separated tokens of the benchmark corpora, with the options of the annotator
+// models: all chargrams hashed, or filtered by a list of allowed chargrams.
+
+#include <string>
+#include <vector>
+
+#include "annotator/types.h"
+#include "utils/strings/split.h"
+#include "utils/testing/benchmark-utils.h"
+#include "utils/token-feature-extractor.h"
+#include "utils/utf8/unilib.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+TokenFeatureExtractorOptions BenchmarkOptions(bool unicode_aware,
+                                              bool filter_chargrams) {
+  TokenFeatureExtractorOptions options;
+  options.num_buckets = 1000;
+  options.chargram_orders = {1, 2, 3, 4, 5};
+  options.unicode_aware_features = unicode_aware;
+  options.remap_digits = true;
+  options.lowercase_tokens = true;
+  if (filter_chargrams) {
+    options.allowed_chargrams = {"^t", "th", "he", "e$", "^a", "an", "nd",
+                                 "d$", "in", "er", "on", "re", "0",  "00",
+                                 "^0", "0$", "the", "and", "ing", "ion"};
+  }
+  return options;
+}
+
+std::vector<Token> CorpusTokens(benchmark::State& state) {
+  const std::string text = CorpusTextForBenchmark(state);
+  std::vector<Token> tokens;
+  for (const StringPiece word : strings::Split(text, ' ')) {
+    tokens.emplace_back(word.ToString(), /*arg_start=*/0, /*arg_end=*/0);
+  }
+  return tokens;
+}
+
+void RunExtraction(benchmark::State& state, bool unicode_aware,
+                   bool filter_chargrams) {
+  static UniLib* unilib = new UniLib();
+  const TokenFeatureExtractor extractor(
+      BenchmarkOptions(unicode_aware, filter_chargrams), *unilib);
+  const std::vector<Token> tokens = CorpusTokens(state);
+  std::vector<int> features;
+  const auto extract_all = [&extractor, &tokens, &features]() {
+    for (const Token& token : tokens) {
+      extractor.ExtractCharactergramFeatures(token, &features);
+      benchmark::DoNotOptimize(features.data());
+    }
+  };
+  for (auto _ : state) {
+    extract_all();
+  }
+  state.SetItemsProcessed(state.iterations() * tokens.size());
+  ReportAllocationsPerCall(state, extract_all);
+}
+
+void BM_ExtractCharactergramsAscii(benchmark::State& state) {
+  RunExtraction(state, /*unicode_aware=*/false, /*filter_chargrams=*/false);
+}
+BENCHMARK(BM_ExtractCharactergramsAscii)->Apply(CorpusTextArguments);
+
+void BM_ExtractCharactergramsAsciiFiltered(benchmark::State& state) {
+  RunExtraction(state, /*unicode_aware=*/false, /*filter_chargrams=*/true);
+}
+BENCHMARK(BM_ExtractCharactergramsAsciiFiltered)->Apply(CorpusTextArguments);
+
+void BM_ExtractCharactergramsUnicode(benchmark::State& state) {
+  RunExtraction(state, /*unicode_aware=*/true, /*filter_chargrams=*/false);
+}
+BENCHMARK(BM_ExtractCharactergramsUnicode)->Apply(CorpusTextArguments);
+
+void BM_ExtractCharactergramsUnicodeFiltered(benchmark::State& state) {
+  RunExtraction(state, /*unicode_aware=*/true, /*filter_chargrams=*/true);
+}
+BENCHMARK(BM_ExtractCharactergramsUnicodeFiltered)
+    ->Apply(CorpusTextArguments);
+
+}  // namespace
+}  // namespace libtextclassifier3
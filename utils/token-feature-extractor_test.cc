@@ -394,6 +394,78 @@ TEST_F(TokenFeatureExtractorTest, RegexFeatures) {
 }
 #endif
 
+#ifdef TC3_TEST_ICU
+// The natively matched regexp features agree with the regexes of UniLib, also
+// on non-ASCII tokens.
+TEST_F(TokenFeatureExtractorTest, NativeRegexFeaturesMatchUniLib) {
+  TokenFeatureExtractorOptions options;
+  options.num_buckets = 1000;
+  options.chargram_orders = std::vector<int>{1};
+  options.unicode_aware_features = true;
+  options.extract_case_feature = false;
+  options.extract_selection_mask_feature = false;
+  options.regexp_features = {"^\\d+$",
+                             "^[0-9]+$",
+                             "\\w+",
+                             "^[A-Z][a-z]+$",
+                             ".+",
+                             "\\S+\\s\\S+",
+                             "[^a-z]+",
+                             "[a-zà-ÿ]+",
+                             "\\d{1,2}:\\d\\d",
+                             "^[^0-9]*$",
+                             "[a-z_0-9]+\\.\\w+"};
+  TestingTokenFeatureExtractor extractor(options, unilib_);
+
+  for (const std::string& token :
+       {"٤٢", "42", "۱۲:۳۰", "12:30", "Café", "café", "Ärger", "straße", "日本",
+        "a\u00A0b", "a\u2028b", "a\vb", "x.y", "x.ž", "_"}) {
+    std::vector<int> sparse_features;
+    std::vector<float> dense_features;
+    extractor.Extract(Token{token, 0, 1}, /*is_in_span=*/true, &sparse_features,
+                      &dense_features);
+    ASSERT_EQ(dense_features.size(), options.regexp_features.size()) << token;
+    const UnicodeText token_unicode =
+        UTF8ToUnicodeText(token, /*do_copy=*/false);
+    for (int i = 0; i < options.regexp_features.size(); ++i) {
+      std::unique_ptr<UniLib::RegexPattern> pattern =
+          unilib_.CreateRegexPattern(UTF8ToUnicodeText(
+              options.regexp_features[i], /*do_copy=*/false));
+      ASSERT_NE(pattern, nullptr);
+      int status;
+      const bool matches = pattern->Matcher(token_unicode)->Matches(&status);
+      EXPECT_EQ(dense_features[i], matches ? 1.0 : -1.0)
+          << token << " " << options.regexp_features[i];
+    }
+  }
+}
+#endif
+
+TEST_F(TokenFeatureExtractorTest, NativeRegexFeatures) {
+  TokenFeatureExtractorOptions options;
+  options.num_buckets = 1000;
+  options.chargram_orders = std::vector<int>{1, 2};
+  options.extract_case_feature = true;
+  options.regexp_features.push_back("^[A-Z][a-z]+$");  // capitalized.
+  options.regexp_features.push_back("[0-9]{1,2}[.:][0-9][0-9]");  // time.
+  TestingTokenFeatureExtractor extractor(options, unilib_);
+  EXPECT_EQ(extractor.DenseFeaturesCount(), 3);
+
+  std::vector<int> sparse_features;
+  std::vector<float> dense_features;
+  extractor.Extract(Token{"Hello", 0, 5}, true, &sparse_features,
+                    &dense_features);
+  EXPECT_THAT(dense_features, testing::ElementsAreArray({1.0, 1.0, -1.0}));
+
+  extractor.Extract(Token{"10:30", 0, 5}, true, &sparse_features,
+                    &dense_features);
+  EXPECT_THAT(dense_features, testing::ElementsAreArray({-1.0, -1.0, 1.0}));
+
+  extractor.Extract(Token{"HELLO", 0, 5}, true, &sparse_features,
+                    &dense_features);
+  EXPECT_THAT(dense_features, testing::ElementsAreArray({1.0, -1.0, -1.0}));
+}
+
 TEST_F(TokenFeatureExtractorTest, ExtractTooLongWord) {
   TokenFeatureExtractorOptions options;
   options.num_buckets = 1000;
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the Tokenizer configured as in the bundled English annotator
+// model over the benchmark corpora.
+
+#include <memory>
+#include <string>
+
+#include "annotator/feature-processor.h"
+#include "annotator/model_generated.h"
+#include "utils/memory/mmap.h"
+#include "utils/testing/benchmark-corpora.h"
+#include "utils/testing/benchmark-utils.h"
+#include "utils/tokenizer.h"
+#include "utils/utf8/unilib.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Returns the tokenizer of the classification model of the English annotator
+// model, nullptr if the model could not be loaded.
+const Tokenizer* GetTokenizer() {
+  static const Tokenizer* tokenizer = []() -> const Tokenizer* {
+    // The model is kept mapped, as the tokenizer references its config.
+    static ScopedMmap* mmap =
+        new ScopedMmap(GetBenchmarkModelPath("textclassifier.en.model"));
+    static UniLib* unilib = new UniLib();
+    if (!mmap->handle().ok()) {
+      return nullptr;
+    }
+    const Model* model = GetModel(mmap->handle().start());
+    if (model == nullptr ||
+        model->classification_feature_options() == nullptr) {
+      return nullptr;
+    }
+    return new Tokenizer(internal::BuildTokenizer(
+        model->classification_feature_options(), unilib));
+  }();
+  return tokenizer;
+}
+
+void BM_Tokenize(benchmark::State& state) {
+  const Tokenizer* tokenizer = GetTokenizer();
+  if (tokenizer == nullptr) {
+    state.SkipWithError("Could not load tokenizer config.");
+    return;
+  }
+  const std::string text = CorpusTextForBenchmark(state);
+  LatencyRecorder latencies(&state);
+  for (auto _ : state) {
+    const LatencyRecorder::Sample sample(&latencies);
+    benchmark::DoNotOptimize(tokenizer->Tokenize(text));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Tokenize)
+    ->Apply(CorpusTextArguments)
+    ->ThreadRange(1, 4);
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -324,4 +324,10 @@ UnicodeText UTF8ToUnicodeText(const std::string& str) {
   return UTF8ToUnicodeText(str, /*do_copy=*/true);
 }
 
+void AppendUTF8(char32 codepoint, std::string* utf8) {
+  char str[4];
+  const int char_len = runetochar(codepoint, str);
+  utf8->append(str, char_len);
+}
+
 }  // namespace libtextclassifier3
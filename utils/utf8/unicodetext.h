@@ -223,6 +223,9 @@ UnicodeText UTF8ToUnicodeText(const char* utf8_buf, bool do_copy = true);
 UnicodeText UTF8ToUnicodeText(const std::string& str, bool do_copy = true);
 UnicodeText UTF8ToUnicodeText(const std::string& str);
 
+// Appends the UTF-8 encoding of the codepoint to 'utf8'.
+void AppendUTF8(char32 codepoint, std::string* utf8);
+
 }  // namespace libtextclassifier3
 
 #endif  // LIBTEXTCLASSIFIER_UTILS_UTF8_UNICODETEXT_H_
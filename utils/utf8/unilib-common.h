@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Native implementations of the character classes and mappings of UniLib.
+
+#ifndef LIBTEXTCLASSIFIER_UTILS_UTF8_UNILIB_COMMON_H_
+#define LIBTEXTCLASSIFIER_UTILS_UTF8_UNILIB_COMMON_H_
+
+#include <vector>
+
+#include "utils/base/integral_types.h"
+
+namespace libtextclassifier3 {
+
+// Two-level lookup table of the character classes and mappings of the
+// codepoints, generated from the sorted Unicode data arrays on first use.
+// The first level maps a block of codepoints to a block of entries, which is
+// shared by all the blocks with the same entries. An entry holds the property
+// bits of the codepoint and the index of its mapping delta: to its lowercase
+// for uppercase codepoints and to its counterpart for brackets.
+class UnicodePropertyTable {
+ public:
+  enum Property {
+    OPENING_BRACKET = 1 << 0,
+    CLOSING_BRACKET = 1 << 1,
+    WHITESPACE = 1 << 2,
+    DIGIT = 1 << 3,
+    UPPER = 1 << 4,
+  };
+
+  // Returns the table shared by all UniLib instances.
+  static const UnicodePropertyTable* Get();
+
+  bool Has(char32 codepoint, Property property) const {
+    return Entry(codepoint) & property;
+  }
+
+  char32 ToLower(char32 codepoint) const {
+    const uint16 entry = Entry(codepoint);
+    return (entry & UPPER) ? codepoint + MappingDelta(entry) : codepoint;
+  }
+
+  char32 GetPairedBracket(char32 codepoint) const {
+    const uint16 entry = Entry(codepoint);
+    return (entry & (OPENING_BRACKET | CLOSING_BRACKET))
+               ? codepoint + MappingDelta(entry)
+               : codepoint;
+  }
+
+  // Size of the table in bytes.
+  int MemoryBytes() const;
+
+ private:
+  // Codepoints from kTableEnd on have no properties.
+  static constexpr char32 kTableEnd = 0x20000;
+  static constexpr int kBlockBits = 7;
+  static constexpr int kBlockSize = 1 << kBlockBits;
+  static constexpr int kNumPropertyBits = 5;
+
+  UnicodePropertyTable();
+
+  uint16 Entry(char32 codepoint) const {
+    // ASCII and Latin-1 are the first two blocks of entries.
+    if (static_cast<uint32>(codepoint) < 2 * kBlockSize) {
+      return entries_[codepoint];
+    }
+    if (static_cast<uint32>(codepoint) >= kTableEnd) {
+      return 0;
+    }
+    return entries_[(block_ids_[codepoint >> kBlockBits] << kBlockBits) |
+                    (codepoint & (kBlockSize - 1))];
+  }
+
+  char32 MappingDelta(uint16 entry) const {
+    return mapping_deltas_[entry >> kNumPropertyBits];
+  }
+
+  // Index of the block of entries of each block of codepoints.
+  std::vector<uint16> block_ids_;
+  std::vector<uint16> entries_;
+  std::vector<char32> mapping_deltas_;
+};
+
+namespace unilib_internal {
+
+// Lookups that binary search the sorted Unicode data arrays. The property
+// table is generated from them.
+bool IsOpeningBracket(char32 codepoint);
+bool IsClosingBracket(char32 codepoint);
+bool IsWhitespace(char32 codepoint);
+bool IsDigit(char32 codepoint);
+bool IsUpper(char32 codepoint);
+char32 ToLower(char32 codepoint);
+char32 GetPairedBracket(char32 codepoint);
+
+}  // namespace unilib_internal
+
+}  // namespace libtextclassifier3
+
+#endif  // LIBTEXTCLASSIFIER_UTILS_UTF8_UNILIB_COMMON_H_
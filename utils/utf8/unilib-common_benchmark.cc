@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the throughput of the character classes and mappings of UniLib
+// over the codepoints of the benchmark corpora, with the property table and
+// with the binary searches of the Unicode data it is generated from.
+
+#include <string>
+#include <vector>
+
+#include "utils/testing/benchmark-corpora.h"
+#include "utils/testing/benchmark-utils.h"
+#include "utils/utf8/unicodetext.h"
+#include "utils/utf8/unilib-common.h"
+#include "benchmark/benchmark.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+std::vector<char32> CorpusCodepoints(benchmark::State& state) {
+  const std::string text = CorpusTextForBenchmark(state);
+  const UnicodeText unicode = UTF8ToUnicodeText(text, /*do_copy=*/false);
+  return std::vector<char32>(unicode.begin(), unicode.end());
+}
+
+// Runs the lookups of the tokenizer, the token features and the bracket
+// stripping on every codepoint.
+template <typename IsUpper, typename ToLower, typename IsDigit,
+          typename IsWhitespace, typename GetPairedBracket>
+void RunLookups(benchmark::State& state, const std::vector<char32>& codepoints,
+                IsUpper is_upper, ToLower to_lower, IsDigit is_digit,
+                IsWhitespace is_whitespace,
+                GetPairedBracket get_paired_bracket) {
+  for (auto _ : state) {
+    for (const char32 codepoint : codepoints) {
+      benchmark::DoNotOptimize(is_upper(codepoint));
+      benchmark::DoNotOptimize(to_lower(codepoint));
+      benchmark::DoNotOptimize(is_digit(codepoint));
+      benchmark::DoNotOptimize(is_whitespace(codepoint));
+      benchmark::DoNotOptimize(get_paired_bracket(codepoint));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * codepoints.size());
+}
+
+// Args: corpus arguments.
+void BM_PropertyTableLookups(benchmark::State& state) {
+  const std::vector<char32> codepoints = CorpusCodepoints(state);
+  const UnicodePropertyTable* table = UnicodePropertyTable::Get();
+  state.counters["table_bytes"] = table->MemoryBytes();
+  RunLookups(
+      state, codepoints,
+      [table](char32 c) { return table->Has(c, UnicodePropertyTable::UPPER); },
+      [table](char32 c) { return table->ToLower(c); },
+      [table](char32 c) { return table->Has(c, UnicodePropertyTable::DIGIT); },
+      [table](char32 c) {
+        return table->Has(c, UnicodePropertyTable::WHITESPACE);
+      },
+      [table](char32 c) { return table->GetPairedBracket(c); });
+}
+BENCHMARK(BM_PropertyTableLookups)->Apply(CorpusTextArguments);
+
+// Args: corpus arguments.
+void BM_BinarySearchLookups(benchmark::State& state) {
+  const std::vector<char32> codepoints = CorpusCodepoints(state);
+  RunLookups(state, codepoints, unilib_internal::IsUpper,
+             unilib_internal::ToLower, unilib_internal::IsDigit,
+             unilib_internal::IsWhitespace, unilib_internal::GetPairedBracket);
+}
+BENCHMARK(BM_BinarySearchLookups)->Apply(CorpusTextArguments);
+
+}  // namespace
+}  // namespace libtextclassifier3
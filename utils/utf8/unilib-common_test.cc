@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/utf8/unilib-common.h"
+
+#include "gtest/gtest.h"
+
+namespace libtextclassifier3 {
+namespace {
+
+// Past the last valid codepoint, and some invalid ones.
+const char32 kMaxTestedCodepoint = 0x10FFFF + 0x100;
+
+TEST(UnicodePropertyTableTest, MatchesUnicodeDataForAllCodepoints) {
+  const UnicodePropertyTable* table = UnicodePropertyTable::Get();
+  for (char32 codepoint = -0x100; codepoint <= kMaxTestedCodepoint;
+       ++codepoint) {
+    ASSERT_EQ(table->Has(codepoint, UnicodePropertyTable::OPENING_BRACKET),
+              unilib_internal::IsOpeningBracket(codepoint))
+        << codepoint;
+    ASSERT_EQ(table->Has(codepoint, UnicodePropertyTable::CLOSING_BRACKET),
+              unilib_internal::IsClosingBracket(codepoint))
+        << codepoint;
+    ASSERT_EQ(table->Has(codepoint, UnicodePropertyTable::WHITESPACE),
+              unilib_internal::IsWhitespace(codepoint))
+        << codepoint;
+    ASSERT_EQ(table->Has(codepoint, UnicodePropertyTable::DIGIT),
+              unilib_internal::IsDigit(codepoint))
+        << codepoint;
+    ASSERT_EQ(table->Has(codepoint, UnicodePropertyTable::UPPER),
+              unilib_internal::IsUpper(codepoint))
+        << codepoint;
+    ASSERT_EQ(table->ToLower(codepoint), unilib_internal::ToLower(codepoint))
+        << codepoint;
+    ASSERT_EQ(table->GetPairedBracket(codepoint),
+              unilib_internal::GetPairedBracket(codepoint))
+        << codepoint;
+  }
+}
+
+TEST(UnicodePropertyTableTest, IsCompact) {
+  EXPECT_LT(UnicodePropertyTable::Get()->MemoryBytes(), 64 << 10);
+}
+
+}  // namespace
+}  // namespace libtextclassifier3
@@ -22,9 +22,11 @@
 #define LIBTEXTCLASSIFIER_UTILS_UTF8_UNILIB_JAVAICU_H_
 
 #include <jni.h>
+#include <atomic>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
+#include <utility>
 
 #include "utils/base/integral_types.h"
 #include "utils/java/jni-cache.h"
@@ -32,6 +34,7 @@
 #include "utils/java/scoped_local_ref.h"
 #include "utils/java/string_utils.h"
 #include "utils/utf8/unicodetext.h"
+#include "utils/utf8/unilib-common.h"
 
 namespace libtextclassifier3 {
 
@@ -41,18 +44,45 @@ class UniLib {
   explicit UniLib(const std::shared_ptr<JniCache>& jni_cache);
 
   bool ParseInt32(const UnicodeText& text, int* result) const;
-  bool IsOpeningBracket(char32 codepoint) const;
-  bool IsClosingBracket(char32 codepoint) const;
-  bool IsWhitespace(char32 codepoint) const;
-  bool IsDigit(char32 codepoint) const;
-  bool IsUpper(char32 codepoint) const;
-
-  char32 ToLower(char32 codepoint) const;
-  char32 GetPairedBracket(char32 codepoint) const;
+  bool IsOpeningBracket(char32 codepoint) const {
+    return properties_->Has(codepoint, UnicodePropertyTable::OPENING_BRACKET);
+  }
+  bool IsClosingBracket(char32 codepoint) const {
+    return properties_->Has(codepoint, UnicodePropertyTable::CLOSING_BRACKET);
+  }
+  bool IsWhitespace(char32 codepoint) const {
+    return properties_->Has(codepoint, UnicodePropertyTable::WHITESPACE);
+  }
+  bool IsDigit(char32 codepoint) const {
+    return properties_->Has(codepoint, UnicodePropertyTable::DIGIT);
+  }
+  bool IsUpper(char32 codepoint) const {
+    return properties_->Has(codepoint, UnicodePropertyTable::UPPER);
+  }
+
+  char32 ToLower(char32 codepoint) const {
+    return properties_->ToLower(codepoint);
+  }
+  char32 GetPairedBracket(char32 codepoint) const {
+    return properties_->GetPairedBracket(codepoint);
+  }
 
   // Forward declaration for friend.
   class RegexPattern;
 
+  // A text converted once for the JVM, so that many patterns can match it
+  // without converting it for every matcher.
+  class PreparedText {
+   private:
+    friend class UniLib;
+    friend class RegexPattern;
+    explicit PreparedText(ScopedGlobalRef<jstring> text)
+        : text_(std::move(text)) {}
+
+    // nullptr without a JNI cache.
+    ScopedGlobalRef<jstring> text_;
+  };
+
   class RegexMatcher {
    public:
     static constexpr int kError = -1;
@@ -131,19 +161,27 @@ class UniLib {
    public:
     std::unique_ptr<RegexMatcher> Matcher(const UnicodeText& context) const;
 
+    // Same as above, but reuses the converted text.
+    std::unique_ptr<RegexMatcher> Matcher(const PreparedText& context) const;
+
    private:
     friend class UniLib;
     RegexPattern(const JniCache* jni_cache, const UnicodeText& pattern,
                  bool lazy);
     void LockedInitializeIfNotAlready() const;
 
+    // Compiles the pattern. Needs to be called only once, under the lock.
+    void Initialize() const;
+
     const JniCache* jni_cache_;
 
     // These members need to be mutable because of the lazy initialization.
-    // NOTE: The Matcher method first ensures (using a lock) that the
-    // initialization was attempted (by using LockedInitializeIfNotAlready) and
-    // then can access them without locking.
+    // NOTE: The Matcher method first ensures that the initialization was
+    // attempted (by using LockedInitializeIfNotAlready) and then can access
+    // them without locking. Once the initialization was attempted, this only
+    // costs an atomic load; the lock is only taken before that.
     mutable std::mutex mutex_;
+    mutable std::atomic<bool> initialization_attempted_;
     mutable ScopedGlobalRef<jobject> pattern_;
     mutable bool initialized_;
     mutable bool initialization_failure_;
@@ -174,8 +212,19 @@ class UniLib {
   std::unique_ptr<BreakIterator> CreateBreakIterator(
       const UnicodeText& text) const;
 
+  // Converts the text for matching by many regex patterns. Returns nullptr if
+  // the text could not be converted.
+  std::unique_ptr<PreparedText> PrepareText(const UnicodeText& text) const;
+
+  // Process-wide numbers of the texts converted for matching and of the regex
+  // matchers created, for benchmarks. A matcher created from a UnicodeText
+  // converts it.
+  static int64 NumPreparedTexts();
+  static int64 NumRegexMatchers();
+
  private:
   std::shared_ptr<JniCache> jni_cache_;
+  const UnicodePropertyTable* properties_;
 };
 
 }  // namespace libtextclassifier3
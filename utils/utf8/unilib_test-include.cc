@@ -171,6 +171,43 @@ TEST_F(UniLibTest, RegexGroups) {
   EXPECT_EQ(status, UniLib::RegexMatcher::kNoError);
 }
 
+TEST_F(UniLibTest, RegexPreparedText) {
+  const UnicodeText input =
+      UTF8ToUnicodeText("hello😋😋 0123😋 world", /*do_copy=*/false);
+  std::unique_ptr<UniLib::PreparedText> prepared_input =
+      unilib_.PrepareText(input);
+  ASSERT_TRUE(prepared_input != nullptr);
+  std::unique_ptr<UniLib::RegexPattern> digits_pattern =
+      unilib_.CreateRegexPattern(
+          UTF8ToUnicodeText("[0-9]+😋", /*do_copy=*/false));
+  std::unique_ptr<UniLib::RegexPattern> word_pattern =
+      unilib_.CreateRegexPattern(
+          UTF8ToUnicodeText("w[a-z]+", /*do_copy=*/false));
+  int status;
+
+  // Matchers sharing the prepared text behave like matchers of the text.
+  std::unique_ptr<UniLib::RegexMatcher> digits_matcher =
+      digits_pattern->Matcher(*prepared_input);
+  std::unique_ptr<UniLib::RegexMatcher> word_matcher =
+      word_pattern->Matcher(*prepared_input);
+  EXPECT_TRUE(digits_matcher->Find(&status));
+  EXPECT_EQ(status, UniLib::RegexMatcher::kNoError);
+  EXPECT_EQ(digits_matcher->Start(0, &status), 8);
+  EXPECT_EQ(digits_matcher->End(0, &status), 13);
+  EXPECT_TRUE(word_matcher->Find(&status));
+  EXPECT_EQ(status, UniLib::RegexMatcher::kNoError);
+  EXPECT_EQ(word_matcher->Group(0, &status).ToUTF8String(), "world");
+  EXPECT_FALSE(digits_matcher->Find(&status));
+  EXPECT_FALSE(word_matcher->Matches(&status));
+
+  // The prepared text outlives matchers created from it.
+  digits_matcher.reset();
+  digits_matcher = digits_pattern->Matcher(*prepared_input);
+  EXPECT_TRUE(digits_matcher->Find(&status));
+  EXPECT_EQ(digits_matcher->Group(0, &status).ToUTF8String(), "0123😋");
+  EXPECT_EQ(status, UniLib::RegexMatcher::kNoError);
+}
+
 TEST_F(UniLibTest, BreakIterator) {
   const UnicodeText text = UTF8ToUnicodeText("some text", /*do_copy=*/false);
   std::unique_ptr<UniLib::BreakIterator> iterator =